@@ -8,12 +8,17 @@
 #cmakedefine HAVE_LIBEXECINFO
 #cmakedefine HAVE_CXXABI_H
 #cmakedefine HAVE_NICE
+#cmakedefine HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+#cmakedefine HAVE_SYS_PIDFD_OPEN
+#cmakedefine HAVE_IO_URING
 #cmakedefine HAVE_MALLOC_INFO
 #cmakedefine HAVE_PTHREAD_CREATE
 #cmakedefine HAVE_PTHREAD_SET_NAME_NP
 #cmakedefine HAVE_PTHREAD_SETNAME_NP
 #cmakedefine HAVE_EDITLINE
 #cmakedefine HAVE_SYSTEMD
+#cmakedefine HAVE_ZLIB
+#cmakedefine HAVE_ZSTD
 
 #cmakedefine ICINGA2_UNITY_BUILD
 #cmakedefine ICINGA2_STACKTRACE_USE_BACKTRACE_SYMBOLS
@@ -47,6 +47,7 @@ using namespace icinga;
 REGISTER_TYPE(Application);
 
 boost::signals2::signal<void ()> Application::OnReopenLogs;
+boost::signals2::signal<void (double)> Application::OnClockJumped;
 Application::Ptr Application::m_Instance = nullptr;
 bool Application::m_ShuttingDown = false;
 bool Application::m_RequestRestart = false;
@@ -346,6 +347,7 @@ void Application::RunEventLoop()
 					<< " in time: " << std::fabs(timeDiff) << " seconds";
 
 				Timer::AdjustTimers(-timeDiff);
+				OnClockJumped(-timeDiff);
 			}
 
 			lastLoop = now;
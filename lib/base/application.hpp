@@ -29,6 +29,7 @@ public:
 	DECLARE_OBJECT(Application);
 
 	static boost::signals2::signal<void ()> OnReopenLogs;
+	static boost::signals2::signal<void (double)> OnClockJumped;
 
 	~Application() override;
 
@@ -6,6 +6,7 @@
 
 #include "base/i2-base.hpp"
 #include "base/atomic.hpp"
+#include "base/object-pool.hpp"
 #include "base/objectlock.hpp"
 #include "base/value.hpp"
 #include <boost/range/iterator.hpp>
@@ -26,6 +27,7 @@ class Array final : public Object
 {
 public:
 	DECLARE_OBJECT(Array);
+	DECLARE_POOLED_ALLOCATION(Array);
 
 	/**
 	 * An iterator that can be used to iterate over array elements.
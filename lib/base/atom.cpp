@@ -0,0 +1,258 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/atom.hpp"
+#include "base/perfdatavalue.hpp"
+#include "base/statsfunction.hpp"
+#include <mutex>
+#include <unordered_map>
+
+using namespace icinga;
+
+REGISTER_STATSFUNCTION(Atom, &Atom::StatsFunc);
+
+namespace {
+
+/**
+ * The intern table is split into shards, so that threads interning different strings rarely wait for each other.
+ */
+template<class Entry>
+struct AtomShard
+{
+	std::mutex Mutex;
+	std::unordered_multimap<size_t, Entry *> Entries;
+};
+
+static constexpr size_t l_AtomShardCount = 64;
+
+}
+
+template<class Entry>
+static AtomShard<Entry>& GetAtomShard(size_t hash)
+{
+	/* Never destroyed, atoms may still be released by other static objects' destructors. */
+	static auto *shards (new AtomShard<Entry>[l_AtomShardCount]);
+
+	return shards[hash % l_AtomShardCount];
+}
+
+/**
+ * Returns how many bytes of str live on the heap, i.e. 0 if the string is short enough to be stored in place.
+ */
+static size_t GetHeapSize(const String& str)
+{
+	auto data (str.GetData().data());
+	auto self (reinterpret_cast<const char *>(&str));
+
+	if (data >= self && data < self + sizeof(str))
+		return 0;
+
+	return str.GetData().capacity() + 1u;
+}
+
+Atom::Atom(const String& str)
+	: m_Entry(Intern(str))
+{
+}
+
+Atom::Atom(const char *str)
+	: m_Entry(Intern(str))
+{
+}
+
+Atom::Atom(const Atom& other)
+	: m_Entry(other.m_Entry)
+{
+	if (m_Entry)
+		m_Entry->References.fetch_add(1, std::memory_order_relaxed);
+}
+
+Atom::Atom(Atom&& other) noexcept
+	: m_Entry(other.m_Entry)
+{
+	other.m_Entry = nullptr;
+}
+
+Atom::~Atom()
+{
+	Release(m_Entry);
+}
+
+Atom& Atom::operator=(const Atom& other)
+{
+	if (other.m_Entry)
+		other.m_Entry->References.fetch_add(1, std::memory_order_relaxed);
+
+	Release(m_Entry);
+	m_Entry = other.m_Entry;
+
+	return *this;
+}
+
+Atom& Atom::operator=(Atom&& other) noexcept
+{
+	if (this != &other) {
+		Release(m_Entry);
+		m_Entry = other.m_Entry;
+		other.m_Entry = nullptr;
+	}
+
+	return *this;
+}
+
+const String& Atom::GetString() const
+{
+	static const String empty;
+
+	return m_Entry ? m_Entry->Str : empty;
+}
+
+size_t Atom::GetHash() const
+{
+	static const size_t emptyHash = std::hash<String>()(String());
+
+	return m_Entry ? m_Entry->Hash : emptyHash;
+}
+
+bool Atom::IsEmpty() const
+{
+	return !m_Entry;
+}
+
+Atom::operator const String&() const
+{
+	return GetString();
+}
+
+bool Atom::operator==(const Atom& other) const
+{
+	return m_Entry == other.m_Entry;
+}
+
+bool Atom::operator!=(const Atom& other) const
+{
+	return m_Entry != other.m_Entry;
+}
+
+/**
+ * Looks up the entry for the specified string and takes a reference to it, creates the entry if necessary.
+ *
+ * @param str The string.
+ * @returns The entry, nullptr for the empty string.
+ */
+Atom::Entry *Atom::Intern(const String& str)
+{
+	if (str.IsEmpty())
+		return nullptr;
+
+	size_t hash = std::hash<String>()(str);
+	auto& shard (GetAtomShard<Entry>(hash));
+	std::unique_lock<std::mutex> lock (shard.Mutex);
+	auto range (shard.Entries.equal_range(hash));
+
+	for (auto it (range.first); it != range.second; ++it) {
+		if (it->second->Str == str) {
+			it->second->References.fetch_add(1, std::memory_order_relaxed);
+			return it->second;
+		}
+	}
+
+	auto entry (new Entry{str, hash, {1}});
+
+	/* Don't waste the spare capacity of the original string, every atom shares it. */
+	entry->Str.GetData().shrink_to_fit();
+
+	shard.Entries.emplace(hash, entry);
+
+	return entry;
+}
+
+/**
+ * Drops a reference to an entry and removes the entry from the table once it's not referenced anymore.
+ *
+ * Entries are only looked up and revived under their shard's lock, so dropping the last reference
+ * has to happen under that lock, too. All other references can be dropped without it.
+ *
+ * @param entry The entry, may be nullptr.
+ */
+void Atom::Release(Entry *entry)
+{
+	if (!entry)
+		return;
+
+	auto references (entry->References.load(std::memory_order_relaxed));
+
+	while (references > 1u) {
+		if (entry->References.compare_exchange_weak(references, references - 1u, std::memory_order_release, std::memory_order_relaxed))
+			return;
+	}
+
+	auto& shard (GetAtomShard<Entry>(entry->Hash));
+
+	{
+		std::unique_lock<std::mutex> lock (shard.Mutex);
+
+		if (entry->References.fetch_sub(1, std::memory_order_acq_rel) != 1u)
+			return;
+
+		auto range (shard.Entries.equal_range(entry->Hash));
+
+		for (auto it (range.first); it != range.second; ++it) {
+			if (it->second == entry) {
+				shard.Entries.erase(it);
+				break;
+			}
+		}
+	}
+
+	delete entry;
+}
+
+/**
+ * Returns the number of distinct interned strings, the number of references to them
+ * and the number of heap bytes that would have been allocated for all those references
+ * if each of them was a separate String.
+ */
+Dictionary::Ptr Atom::GetStats()
+{
+	size_t entries = 0;
+	size_t references = 0;
+	size_t bytes = 0;
+	size_t bytesSaved = 0;
+
+	for (size_t i = 0; i < l_AtomShardCount; i++) {
+		/* Any hash selects a shard, the i-th one for i. */
+		auto& shard (GetAtomShard<Entry>(i));
+		std::unique_lock<std::mutex> lock (shard.Mutex);
+
+		for (auto& kv : shard.Entries) {
+			size_t refs = kv.second->References.load(std::memory_order_relaxed);
+			size_t heapSize = GetHeapSize(kv.second->Str);
+
+			entries++;
+			references += refs;
+			bytes += sizeof(Entry) + heapSize;
+
+			if (refs > 1u)
+				bytesSaved += (refs - 1u) * heapSize;
+		}
+	}
+
+	return new Dictionary({
+		{ "entries", entries },
+		{ "references", references },
+		{ "bytes", bytes },
+		{ "bytes_saved", bytesSaved }
+	});
+}
+
+void Atom::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
+{
+	Dictionary::Ptr stats = GetStats();
+
+	status->Set("atom", stats);
+
+	perfdata->Add(new PerfdataValue("atom_entries", stats->Get("entries")));
+	perfdata->Add(new PerfdataValue("atom_references", stats->Get("references")));
+	perfdata->Add(new PerfdataValue("atom_bytes_saved", stats->Get("bytes_saved")));
+}
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include "base/string.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace icinga
+{
+
+/**
+ * An immutable, reference-counted string which is interned in a global table,
+ * so all atoms with the same content share the same memory.
+ *
+ * Two atoms are equal if and only if they point to the same table entry, so comparing
+ * them is a pointer comparison. The empty string doesn't need an entry at all.
+ *
+ * @ingroup base
+ */
+class Atom
+{
+public:
+	Atom() = default;
+	Atom(const String& str);
+	Atom(const char *str);
+	Atom(const Atom& other);
+	Atom(Atom&& other) noexcept;
+	~Atom();
+
+	Atom& operator=(const Atom& other);
+	Atom& operator=(Atom&& other) noexcept;
+
+	const String& GetString() const;
+	size_t GetHash() const;
+	bool IsEmpty() const;
+
+	operator const String&() const;
+
+	bool operator==(const Atom& other) const;
+	bool operator!=(const Atom& other) const;
+
+	static Dictionary::Ptr GetStats();
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+
+private:
+	struct Entry
+	{
+		String Str;
+		size_t Hash;
+		std::atomic<uint32_t> References;
+	};
+
+	Entry *m_Entry{nullptr};
+
+	static Entry *Intern(const String& str);
+	static void Release(Entry *entry);
+};
+
+}
+
+template<>
+struct std::hash<icinga::Atom>
+{
+	size_t operator()(const icinga::Atom& atom) const noexcept
+	{
+		return atom.GetHash();
+	}
+};
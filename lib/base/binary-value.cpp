@@ -0,0 +1,331 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/binary-value.hpp"
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include "base/objectlock.hpp"
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+using namespace icinga;
+
+/**
+ * Value tags. They're persisted in state files and sent to other nodes, so never change the existing ones.
+ */
+enum BinaryValueTag : unsigned char
+{
+	BinaryValueEmpty = 0,
+	BinaryValueFalse = 1,
+	BinaryValueTrue = 2,
+	BinaryValueInteger = 3, /**< Zigzag varint, for numbers without fraction. */
+	BinaryValueNumber = 4, /**< IEEE 754 double. */
+	BinaryValueString = 5,
+	BinaryValueArray = 6, /**< Varint count, values. */
+	BinaryValueDictionary = 7 /**< Varint count, key strings and values. */
+};
+
+static void ThrowTruncated()
+{
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid binary value (truncated)"));
+}
+
+static void ThrowTooDeep()
+{
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid binary value (nested too deeply)"));
+}
+
+void BinaryValue::EncodeVarint(std::string& buffer, uint64_t value)
+{
+	while (value >= 0x80u) {
+		buffer += char((value & 0x7fu) | 0x80u);
+		value >>= 7u;
+	}
+
+	buffer += char(value);
+}
+
+void BinaryValue::EncodeString(std::string& buffer, const String& value)
+{
+	EncodeVarint(buffer, value.GetLength());
+	buffer.append(value.GetData());
+}
+
+void BinaryValue::EncodeValue(std::string& buffer, const Value& value)
+{
+	switch (value.GetType()) {
+		case ValueEmpty:
+			buffer += char(BinaryValueEmpty);
+			return;
+
+		case ValueBoolean:
+			buffer += char(value.Get<bool>() ? BinaryValueTrue : BinaryValueFalse);
+			return;
+
+		case ValueNumber: {
+			double number = value.Get<double>();
+
+			/* Most numbers in the state are states, counters and flags. */
+			if (std::trunc(number) == number && std::fabs(number) < 9007199254740992.0 && !(number == 0 && std::signbit(number))) {
+				auto integer (static_cast<int64_t>(number));
+
+				buffer += char(BinaryValueInteger);
+				EncodeVarint(buffer, (static_cast<uint64_t>(integer) << 1u) ^ static_cast<uint64_t>(integer >> 63));
+				return;
+			}
+
+			uint64_t bits;
+			memcpy(&bits, &number, sizeof(bits));
+
+			buffer += char(BinaryValueNumber);
+
+			for (int i = 0; i < 8; i++) {
+				buffer += char((bits >> (i * 8)) & 0xffu);
+			}
+
+			return;
+		}
+
+		case ValueString:
+			buffer += char(BinaryValueString);
+			EncodeString(buffer, value.Get<String>());
+			return;
+
+		case ValueObject:
+			if (value.IsObjectType<Array>()) {
+				Array::Ptr array = value;
+				ObjectLock olock (array);
+
+				buffer += char(BinaryValueArray);
+				EncodeVarint(buffer, array->GetLength());
+
+				for (const Value& item : array) {
+					EncodeValue(buffer, item);
+				}
+
+				return;
+			}
+
+			if (value.IsObjectType<Dictionary>()) {
+				Dictionary::Ptr dict = value;
+				ObjectLock olock (dict);
+
+				buffer += char(BinaryValueDictionary);
+				EncodeVarint(buffer, dict->GetLength());
+
+				for (const Dictionary::Pair& kv : dict) {
+					EncodeString(buffer, kv.first);
+					EncodeValue(buffer, kv.second);
+				}
+
+				return;
+			}
+
+			break;
+	}
+
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Cannot encode value of type '" + value.GetTypeName() + "'"));
+}
+
+uint64_t BinaryValue::DecodeVarint(const char *& pos, const char *end)
+{
+	uint64_t value = 0;
+
+	for (unsigned shift = 0; shift < 64u; shift += 7u) {
+		if (pos == end)
+			ThrowTruncated();
+
+		auto byte (static_cast<unsigned char>(*pos++));
+		value |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+
+		if (!(byte & 0x80u))
+			return value;
+	}
+
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid binary value (varint too long)"));
+}
+
+String BinaryValue::DecodeString(const char *& pos, const char *end)
+{
+	uint64_t length = DecodeVarint(pos, end);
+
+	if (length > uint64_t(end - pos))
+		ThrowTruncated();
+
+	String value (pos, pos + length);
+	pos += length;
+
+	return value;
+}
+
+/**
+ * Decodes the next value and advances pos behind it.
+ *
+ * @param depthLimit How deep arrays and dictionaries may be nested, for untrusted input
+ */
+Value BinaryValue::DecodeValue(const char *& pos, const char *end, size_t depthLimit)
+{
+	if (pos == end)
+		ThrowTruncated();
+
+	switch (static_cast<unsigned char>(*pos++)) {
+		case BinaryValueEmpty:
+			return Empty;
+
+		case BinaryValueFalse:
+			return false;
+
+		case BinaryValueTrue:
+			return true;
+
+		case BinaryValueInteger: {
+			uint64_t zigzag = DecodeVarint(pos, end);
+
+			return static_cast<double>(static_cast<int64_t>(zigzag >> 1u) ^ -static_cast<int64_t>(zigzag & 1u));
+		}
+
+		case BinaryValueNumber: {
+			if (end - pos < 8)
+				ThrowTruncated();
+
+			uint64_t bits = 0;
+
+			for (int i = 0; i < 8; i++) {
+				bits |= static_cast<uint64_t>(static_cast<unsigned char>(*pos++)) << (i * 8);
+			}
+
+			double number;
+			memcpy(&number, &bits, sizeof(number));
+
+			return number;
+		}
+
+		case BinaryValueString:
+			return DecodeString(pos, end);
+
+		case BinaryValueArray: {
+			if (depthLimit == 0u)
+				ThrowTooDeep();
+
+			uint64_t count = DecodeVarint(pos, end);
+
+			/* Every value takes at least one byte. */
+			if (count > uint64_t(end - pos))
+				ThrowTruncated();
+
+			ArrayData items;
+			items.reserve(count);
+
+			for (uint64_t i = 0; i < count; i++) {
+				items.emplace_back(DecodeValue(pos, end, depthLimit - 1u));
+			}
+
+			return new Array(std::move(items));
+		}
+
+		case BinaryValueDictionary: {
+			if (depthLimit == 0u)
+				ThrowTooDeep();
+
+			uint64_t count = DecodeVarint(pos, end);
+
+			if (count > uint64_t(end - pos) / 2u)
+				ThrowTruncated();
+
+			DictionaryData items;
+			items.reserve(count);
+
+			for (uint64_t i = 0; i < count; i++) {
+				String key = DecodeString(pos, end);
+				items.emplace_back(std::move(key), DecodeValue(pos, end, depthLimit - 1u));
+			}
+
+			return new Dictionary(std::move(items));
+		}
+
+		default:
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid binary value (unknown tag)"));
+	}
+}
+
+/**
+ * Advances pos behind the next value without allocating anything.
+ *
+ * @param depthLimit How deep arrays and dictionaries may be nested, for untrusted input
+ */
+void BinaryValue::SkipValue(const char *& pos, const char *end, size_t depthLimit)
+{
+	if (pos == end)
+		ThrowTruncated();
+
+	switch (static_cast<unsigned char>(*pos++)) {
+		case BinaryValueEmpty:
+		case BinaryValueFalse:
+		case BinaryValueTrue:
+			return;
+
+		case BinaryValueInteger:
+			DecodeVarint(pos, end);
+			return;
+
+		case BinaryValueNumber:
+			if (end - pos < 8)
+				ThrowTruncated();
+
+			pos += 8;
+			return;
+
+		case BinaryValueString: {
+			uint64_t length = DecodeVarint(pos, end);
+
+			if (length > uint64_t(end - pos))
+				ThrowTruncated();
+
+			pos += length;
+			return;
+		}
+
+		case BinaryValueArray: {
+			if (depthLimit == 0u)
+				ThrowTooDeep();
+
+			uint64_t count = DecodeVarint(pos, end);
+
+			/* Every value takes at least one byte. */
+			if (count > uint64_t(end - pos))
+				ThrowTruncated();
+
+			for (uint64_t i = 0; i < count; i++) {
+				SkipValue(pos, end, depthLimit - 1u);
+			}
+
+			return;
+		}
+
+		case BinaryValueDictionary: {
+			if (depthLimit == 0u)
+				ThrowTooDeep();
+
+			uint64_t count = DecodeVarint(pos, end);
+
+			if (count > uint64_t(end - pos) / 2u)
+				ThrowTruncated();
+
+			for (uint64_t i = 0; i < count; i++) {
+				uint64_t length = DecodeVarint(pos, end);
+
+				if (length > uint64_t(end - pos))
+					ThrowTruncated();
+
+				pos += length;
+				SkipValue(pos, end, depthLimit - 1u);
+			}
+
+			return;
+		}
+
+		default:
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid binary value (unknown tag)"));
+	}
+}
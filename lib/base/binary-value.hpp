@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include "base/string.hpp"
+#include "base/value.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace icinga
+{
+
+/**
+ * A compact binary encoding of Values, used by the state file and the cluster protocol.
+ *
+ * Integers are LEB128 varints, strings a varint length followed by the bytes. Values are a tag
+ * byte followed by their payload: nothing for Empty and booleans, a zigzag varint for numbers
+ * without fraction, 8 little-endian bytes for other numbers, a string, or a varint count followed
+ * by the items (arrays) or by key strings and values (dictionaries).
+ *
+ * @ingroup base
+ */
+class BinaryValue
+{
+public:
+	static void EncodeVarint(std::string& buffer, uint64_t value);
+	static void EncodeString(std::string& buffer, const String& value);
+	static void EncodeValue(std::string& buffer, const Value& value);
+
+	static uint64_t DecodeVarint(const char *& pos, const char *end);
+	static String DecodeString(const char *& pos, const char *end);
+	static Value DecodeValue(const char *& pos, const char *end, size_t depthLimit = std::numeric_limits<size_t>::max());
+	static void SkipValue(const char *& pos, const char *end, size_t depthLimit = std::numeric_limits<size_t>::max());
+};
+
+}
@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/concurrency-limiter.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace icinga;
+
+/**
+ * The limit starts at max, so nothing changes until the first signs of overload.
+ * It never drops below 1, otherwise nothing would ever be started again.
+ *
+ * @param min The lower bound of the limit.
+ * @param max The upper bound of the limit.
+ */
+ConcurrencyLimiter::ConcurrencyLimiter(size_t min, size_t max)
+	: m_Min(std::max<size_t>(1, std::min(min, max))), m_Max(max), m_Limit(max), m_CurrentLimit(max)
+{
+}
+
+void ConcurrencyLimiter::SetBounds(size_t min, size_t max)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	m_Min = std::max<size_t>(1, std::min(min, max));
+	m_Max = max;
+	m_Limit = std::max<double>(m_Min, std::min<double>(m_Max, m_Limit));
+	m_CurrentLimit.store(m_Limit);
+}
+
+/**
+ * Records the latency of a finished unit of work, e.g. a check plugin's execution time.
+ *
+ * @param key Identifies the unit of work, e.g. the checkable. Its first sample is only remembered.
+ * @param latency The latency in seconds.
+ */
+void ConcurrencyLimiter::AddSample(const void *key, double latency)
+{
+	if (latency < 0)
+		return;
+
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	auto [it, inserted] = m_LastLatencies.emplace(key, latency);
+
+	if (!inserted) {
+		if (it->second > 0)
+			m_Ratios.emplace_back(latency / it->second);
+
+		it->second = latency;
+	}
+}
+
+/**
+ * Drops the last latency of a unit of work which won't be done anymore, e.g. a deleted checkable.
+ */
+void ConcurrencyLimiter::Forget(const void *key)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	m_LastLatencies.erase(key);
+}
+
+/**
+ * Computes the new limit from the samples collected since the last call. Meant to be called periodically.
+ *
+ * @param inFlight The number of units of work currently in flight.
+ * @returns The new limit.
+ */
+size_t ConcurrencyLimiter::Update(size_t inFlight)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	if (!m_Ratios.empty()) {
+		auto median (m_Ratios.begin() + m_Ratios.size() / 2u);
+
+		std::nth_element(m_Ratios.begin(), median, m_Ratios.end());
+		m_LatencyRatio = *median;
+		m_Ratios.clear();
+
+		if (m_LatencyRatio > Tolerance) {
+			m_Limit *= std::max(MaxBackoff, Tolerance / m_LatencyRatio);
+		} else if (inFlight * 2 >= m_Limit) {
+			m_Limit += std::sqrt(m_Limit);
+		}
+	}
+
+	m_Limit = std::max<double>(m_Min, std::min<double>(m_Max, m_Limit));
+
+	m_CurrentLimit.store(m_Limit);
+
+	return m_Limit;
+}
+
+/**
+ * Returns the median of the latency ratios of the last Update(), -1 if there haven't been any yet.
+ */
+double ConcurrencyLimiter::GetLatencyRatio() const
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return m_LatencyRatio;
+}
@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * Adapts a concurrency limit to the observed latency.
+ *
+ * Each unit of work, e.g. a check, is only compared to itself: every latency sample is divided by the
+ * previous sample of the same key. Check plugins differ by orders of magnitude, so an average over all
+ * of them would mostly follow which checks happen to run. Between two Update() calls, the median of these
+ * ratios tells whether the work in general got slower. While it stays within Tolerance, the limit grows
+ * additively, but only if it's actually used. Otherwise it shrinks proportionally, by at most MaxBackoff.
+ *
+ * @ingroup base
+ */
+class ConcurrencyLimiter
+{
+public:
+	static constexpr double Tolerance = 1.5;
+	static constexpr double MaxBackoff = 0.5;
+
+	ConcurrencyLimiter(size_t min, size_t max);
+
+	ConcurrencyLimiter(const ConcurrencyLimiter&) = delete;
+	ConcurrencyLimiter& operator=(const ConcurrencyLimiter&) = delete;
+
+	void SetBounds(size_t min, size_t max);
+	void AddSample(const void *key, double latency);
+	void Forget(const void *key);
+	size_t Update(size_t inFlight);
+
+	/**
+	 * Returns the current limit. Doesn't lock, so it's cheap enough for hot paths.
+	 */
+	size_t GetLimit() const
+	{
+		return m_CurrentLimit.load(std::memory_order_relaxed);
+	}
+
+	double GetLatencyRatio() const;
+
+private:
+	mutable std::mutex m_Mutex;
+	size_t m_Min;
+	size_t m_Max;
+	double m_Limit;
+	std::unordered_map<const void *, double> m_LastLatencies;
+	std::vector<double> m_Ratios;
+	double m_LatencyRatio{-1};
+
+	std::atomic<size_t> m_CurrentLimit;
+};
+
+}
@@ -6,6 +6,8 @@
 #include "base/configobject-ti.cpp"
 #include "base/configtype.hpp"
 #include "base/serializer.hpp"
+#include "base/state-file.hpp"
+#include "base/binary-value.hpp"
 #include "base/netstring.hpp"
 #include "base/json.hpp"
 #include "base/stdiostream.hpp"
@@ -18,15 +20,27 @@
 #include "base/workqueue.hpp"
 #include "base/context.hpp"
 #include "base/application.hpp"
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <unordered_map>
 #include <boost/exception/errinfo_api_function.hpp>
 #include <boost/exception/errinfo_errno.hpp>
 #include <boost/exception/errinfo_file_name.hpp>
+#include <boost/filesystem/operations.hpp>
 
 using namespace icinga;
 
 REGISTER_TYPE_WITH_PROTOTYPE(ConfigObject, ConfigObject::GetPrototype());
 
+/* Records of a state file restored by one task. */
+static const size_t l_RestoreChunkSize = 512;
+
+/* Far deeper than any state attribute, but a corrupt state file can't overflow the stack. */
+static const size_t l_StateFileDepthLimit = 128;
+
 boost::signals2::signal<void (const ConfigObject::Ptr&)> ConfigObject::OnStateChanged;
 
 bool ConfigObject::IsActive() const
@@ -477,38 +491,180 @@ void ConfigObject::DumpObjects(const String& filename, int attributeTypes)
 		Log(LogWarning, "ConfigObject") << DiagnosticInformation(ex);
 	}
 
-	AtomicFile fp (filename, 0600);
-	StdioStream::Ptr sfp = new StdioStream(&fp, false);
+	std::random_device random;
+	uint64_t snapshotId = (uint64_t(random()) << 32u) ^ random();
 
-	for (const Type::Ptr& type : Type::GetAllTypes()) {
-		auto *dtype = dynamic_cast<ConfigType *>(type.get());
+	std::vector<ConfigObject::Ptr> dumped;
 
-		if (!dtype)
-			continue;
+	try {
+		AtomicFile fp (filename, 0600);
+		StateFileWriter writer (fp);
 
-		for (const ConfigObject::Ptr& object : dtype->GetObjects()) {
-			Dictionary::Ptr update = Serialize(object, attributeTypes);
+		writer.WriteHeader(snapshotId);
 
-			if (!update)
+		for (const Type::Ptr& type : Type::GetAllTypes()) {
+			auto *dtype = dynamic_cast<ConfigType *>(type.get());
+
+			if (!dtype)
 				continue;
 
-			Dictionary::Ptr persistentObject = new Dictionary({
-				{ "type", type->GetName() },
-				{ "name", object->GetName() },
-				{ "update", update }
-			});
+			std::vector<ConfigObject::Ptr> objects = dtype->GetObjects();
 
-			String json = JsonEncode(persistentObject);
+			/* Changes from now on go into the next delta. */
+			for (const ConfigObject::Ptr& object : objects) {
+				object->ResetStateDirty();
+			}
 
-			NetString::WriteStringToStream(sfp, json);
+			dumped.insert(dumped.end(), objects.begin(), objects.end());
+			writer.WriteType(type, objects, attributeTypes);
 		}
+
+		writer.Finish();
+		fp.Commit();
+	} catch (const std::exception&) {
+		/* The old snapshot and delta log are still there, so the next delta has to catch up on all objects. */
+		for (const ConfigObject::Ptr& object : dumped) {
+			object->MarkStateDirty();
+		}
+
+		throw;
 	}
 
-	sfp->Close();
-	fp.Commit();
+	/* Its snapshot ID doesn't match anymore, so it would be ignored anyway. */
+	String deltaFilename = filename + ".delta";
+
+	if (Utility::PathExists(deltaFilename))
+		Utility::Remove(deltaFilename);
+}
+
+/**
+ * Appends the objects whose state has changed since the last dump to the delta log next to the
+ * snapshot written by DumpObjects(). Writes a new snapshot instead if there is none yet,
+ * or if the delta log has grown larger than half of the snapshot.
+ *
+ * An incomplete last batch left behind by a crash is cut off first, as the batches are only
+ * found by their lengths.
+ */
+void ConfigObject::DumpObjectsDelta(const String& filename, int attributeTypes)
+{
+	String deltaFilename = filename + ".delta";
+	uint64_t snapshotId = 0;
+	size_t snapshotSize = 0;
+	bool newDelta = true;
+	size_t deltaSize = 0;
+
+	if (Utility::PathExists(filename) && StateFileReader::IsStateFile(filename)) {
+		StateFileReader snapshot (filename);
+
+		snapshotId = snapshot.GetSnapshotId();
+		snapshotSize = snapshot.GetSize();
+	}
+
+	if (Utility::PathExists(deltaFilename)) {
+		try {
+			bool append = false;
+			bool truncated = false;
+
+			/* Unmapped before it's cut off. */
+			{
+				StateFileReader delta (deltaFilename);
+
+				if (delta.IsDelta() && delta.GetSnapshotId() == snapshotId) {
+					append = true;
+					deltaSize = delta.SkipBatches();
+					truncated = delta.IsTruncated();
+				}
+			}
+
+			if (truncated) {
+				Log(LogWarning, "ConfigObject")
+					<< "Cutting off the incomplete last batch of delta log '" << deltaFilename << "'.";
+
+				boost::filesystem::resize_file(deltaFilename.GetData(), deltaSize);
+			}
+
+			newDelta = !append;
+		} catch (const std::exception& ex) {
+			deltaSize = 0;
+
+			Log(LogWarning, "ConfigObject")
+				<< "Replacing invalid delta log '" << deltaFilename << "': " << DiagnosticInformation(ex, false);
+		}
+	}
+
+	if (!snapshotId || deltaSize > snapshotSize / 2u) {
+		DumpObjects(filename, attributeTypes);
+		return;
+	}
+
+	std::vector<ConfigObject::Ptr> changed;
+	std::string buffer;
+
+	/* The flags are reset before the objects are encoded, so that changes made meanwhile aren't lost.
+	 * They're set again unless the batch has been written.
+	 */
+	try {
+		std::ostringstream batch;
+		StateFileWriter writer (batch);
+
+		for (const Type::Ptr& type : Type::GetAllTypes()) {
+			auto *dtype = dynamic_cast<ConfigType *>(type.get());
+
+			if (!dtype)
+				continue;
+
+			std::vector<ConfigObject::Ptr> objects;
+
+			for (const ConfigObject::Ptr& object : dtype->GetObjects()) {
+				if (object->ResetStateDirty())
+					objects.emplace_back(object);
+			}
+
+			if (!objects.empty()) {
+				changed.insert(changed.end(), objects.begin(), objects.end());
+				writer.WriteType(type, objects, attributeTypes);
+			}
+		}
+
+		if (changed.empty())
+			return;
+
+		writer.Finish();
+
+		if (newDelta)
+			StateFile::EncodeHeader(buffer, StateFile::DeltaMagic, snapshotId);
+
+		std::string body = batch.str();
+		BinaryValue::EncodeVarint(buffer, body.size());
+		buffer.append(body);
+
+		if (newDelta) {
+			AtomicFile::Write(deltaFilename, 0600, buffer);
+		} else {
+			std::ofstream fp (deltaFilename.CStr(), std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+			fp.write(buffer.data(), buffer.size());
+			fp.flush();
+
+			if (!fp) {
+				BOOST_THROW_EXCEPTION(posix_error()
+					<< boost::errinfo_api_function("write")
+					<< boost::errinfo_errno(errno)
+					<< boost::errinfo_file_name(deltaFilename));
+			}
+		}
+	} catch (const std::exception&) {
+		for (const ConfigObject::Ptr& object : changed) {
+			object->MarkStateDirty();
+		}
+
+		throw;
+	}
+
+	Log(LogNotice, "ConfigObject")
+		<< "Appended " << changed.size() << " changed objects (" << buffer.size() << " bytes) to delta log '" << deltaFilename << "'";
 }
 
-void ConfigObject::RestoreObject(const String& message, int attributeTypes)
+void ConfigObject::RestoreNetStringObject(const String& message, int attributeTypes)
 {
 	Dictionary::Ptr persistentObject = JsonDecode(message, std::numeric_limits<size_t>::max());
 
@@ -530,14 +686,149 @@ void ConfigObject::RestoreObject(const String& message, int attributeTypes)
 	object->SetStateLoaded(true);
 }
 
-void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
+void ConfigObject::RestoreStateFileObject(const StateFileRecord& record, int attributeTypes)
 {
-	if (!Utility::PathExists(filename))
+	const StateFileSection& section = *record.Section;
+	const char *pos = record.Begin;
+
+	if (!section.ObjectType)
 		return;
 
-	Log(LogInformation, "ConfigObject")
-		<< "Restoring program state from file '" << filename << "'";
+	ConfigObject::Ptr object = section.ObjectConfigType->GetObject(BinaryValue::DecodeString(pos, record.End));
 
+	if (!object)
+		return;
+
+#ifdef I2_DEBUG
+	Log(LogDebug, "ConfigObject")
+		<< "Restoring object '" << object->GetName() << "' of type '" << section.TypeName << "'.";
+#endif /* I2_DEBUG */
+
+	/* Like Deserialize(), but the field names have been resolved once per type. */
+	for (int fid : section.FieldIds) {
+		if (fid < 0 || (section.ObjectType->GetFieldInfo(fid).Attributes & attributeTypes) == 0) {
+			BinaryValue::SkipValue(pos, record.End, l_StateFileDepthLimit);
+			continue;
+		}
+
+		Value value = BinaryValue::DecodeValue(pos, record.End, l_StateFileDepthLimit);
+
+		try {
+			object->SetField(fid, Deserialize(value, false, attributeTypes), true);
+		} catch (const std::exception&) {
+			object->SetField(fid, Empty);
+		}
+	}
+
+	object->OnStateLoaded();
+	object->SetStateLoaded(true);
+}
+
+/**
+ * Restores the snapshot and the objects of its delta log, if any. Only the last record of each object is restored.
+ *
+ * This thread only splits the mapped files into records, by skipping their lengths. The records are handed to
+ * the workers in chunks of the same type, which decode and deserialize them straight from the mapping.
+ */
+unsigned long ConfigObject::RestoreStateFile(const String& filename, int attributeTypes, size_t& bytes)
+{
+	StateFileReader reader (filename);
+	std::unique_ptr<StateFileReader> delta;
+	std::unordered_map<String, std::unordered_map<String, StateFileRecord>> deltaRecords;
+	String deltaFilename = filename + ".delta";
+	StateFileRecord record;
+
+	bytes = reader.GetSize();
+
+	if (Utility::PathExists(deltaFilename)) {
+		delta.reset(new StateFileReader(deltaFilename));
+
+		if (!delta->IsDelta() || delta->GetSnapshotId() != reader.GetSnapshotId()) {
+			Log(LogWarning, "ConfigObject")
+				<< "Ignoring delta log '" << deltaFilename << "' which doesn't belong to the state file.";
+
+			delta.reset();
+		} else {
+			bytes += delta->GetSize();
+
+			while (delta->ReadRecord(record)) {
+				const char *pos = record.Begin;
+				deltaRecords[record.Section->TypeName][BinaryValue::DecodeString(pos, record.End)] = record;
+			}
+
+			if (delta->IsTruncated()) {
+				Log(LogWarning, "ConfigObject")
+					<< "Ignoring the incomplete last batch of delta log '" << deltaFilename << "'.";
+			}
+		}
+	}
+
+	unsigned long restored = 0;
+
+	/* Only a few chunks per worker are waiting at any time, the records themselves stay in the mapping. */
+	WorkQueue upq(Configuration::Concurrency * 4u, Configuration::Concurrency);
+	upq.SetName("ConfigObject::RestoreObjects");
+
+	std::vector<StateFileRecord> chunk;
+
+	auto flush ([&upq, &chunk, attributeTypes]() {
+		upq.Enqueue([chunk = std::move(chunk), attributeTypes]() {
+			/* A corrupt record must not take the rest of the chunk with it. */
+			for (auto& record : chunk) {
+				try {
+					RestoreStateFileObject(record, attributeTypes);
+				} catch (const std::exception& ex) {
+					Log(LogWarning, "ConfigObject")
+						<< "Skipping a corrupt record of type '" << record.Section->TypeName << "' in the state file: "
+						<< DiagnosticInformation(ex, false);
+				}
+			}
+		});
+
+		chunk.clear();
+	});
+
+	/* Each batch of the delta log has its own sections, so chunks are split by type instead. */
+	auto enqueue ([&chunk, &flush, &restored](const StateFileRecord& record) {
+		if (!chunk.empty() && (chunk.size() >= l_RestoreChunkSize || chunk.front().Section->ObjectType != record.Section->ObjectType))
+			flush();
+
+		chunk.emplace_back(record);
+		restored++;
+	});
+
+	while (reader.ReadRecord(record)) {
+		if (!deltaRecords.empty()) {
+			auto type (deltaRecords.find(record.Section->TypeName));
+
+			if (type != deltaRecords.end()) {
+				const char *pos = record.Begin;
+
+				if (type->second.find(BinaryValue::DecodeString(pos, record.End)) != type->second.end())
+					continue;
+			}
+		}
+
+		enqueue(record);
+	}
+
+	for (auto& type : deltaRecords) {
+		for (auto& object : type.second) {
+			enqueue(object.second);
+		}
+	}
+
+	if (!chunk.empty())
+		flush();
+
+	/* The records point into the readers' mappings. */
+	upq.Join();
+
+	return restored;
+}
+
+unsigned long ConfigObject::RestoreNetStringFile(const String& filename, int attributeTypes, size_t& bytes)
+{
 	std::fstream fp;
 	fp.open(filename.CStr(), std::ios_base::in);
 
@@ -545,6 +836,8 @@ void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
 
 	unsigned long restored = 0;
 
+	bytes = 0;
+
 	WorkQueue upq(25000, Configuration::Concurrency);
 	upq.SetName("ConfigObject::RestoreObjects");
 
@@ -559,7 +852,9 @@ void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
 		if (srs != StatusNewItem)
 			continue;
 
-		upq.Enqueue([message, attributeTypes]() { RestoreObject(message, attributeTypes); });
+		bytes += message.GetLength();
+
+		upq.Enqueue([message, attributeTypes]() { RestoreNetStringObject(message, attributeTypes); });
 		restored++;
 	}
 
@@ -567,6 +862,42 @@ void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
 
 	upq.Join();
 
+	return restored;
+}
+
+/**
+ * Restores a state file (and its delta log) written by DumpObjects() and DumpObjectsDelta(),
+ * or one written in the netstring format of v2.16 and older.
+ * The latter is converted by the next DumpObjects().
+ */
+void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
+{
+	if (!Utility::PathExists(filename))
+		return;
+
+	Log(LogInformation, "ConfigObject")
+		<< "Restoring program state from file '" << filename << "'";
+
+	double start = Utility::GetTime();
+	unsigned long restored;
+	size_t bytes;
+
+	if (StateFileReader::IsStateFile(filename)) {
+		restored = RestoreStateFile(filename, attributeTypes, bytes);
+	} else {
+		Log(LogInformation, "ConfigObject")
+			<< "State file '" << filename << "' uses the old format, it will be converted on the next dump.";
+
+		restored = RestoreNetStringFile(filename, attributeTypes, bytes);
+	}
+
+	double duration = std::max(Utility::GetTime() - start, 0.001);
+
+	Log(LogInformation, "ConfigObject")
+		<< "Restored " << restored << " objects (" << bytes / 1024 / 1024 << " MiB) in " << duration << "s: "
+		<< static_cast<unsigned long>(restored / duration) << " objects/s, "
+		<< std::fixed << std::setprecision(1) << bytes / duration / 1024 / 1024 << " MiB/s.";
+
 	unsigned long no_state = 0;
 
 	for (const Type::Ptr& type : Type::GetAllTypes()) {
@@ -582,11 +913,14 @@ void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
 
 				no_state++;
 			}
+
+			/* Restoring has marked it as changed. */
+			object->ResetStateDirty();
 		}
 	}
 
 	Log(LogInformation, "ConfigObject")
-		<< "Restored " << restored << " objects. Loaded " << no_state << " new objects without state.";
+		<< "Loaded " << no_state << " new objects without state.";
 }
 
 void ConfigObject::StopObjects()
@@ -15,6 +15,7 @@ namespace icinga
 {
 
 class ConfigType;
+struct StateFileRecord;
 
 /**
  * A dynamic object that can be instantiated from the configuration file.
@@ -75,6 +76,7 @@ public:
 	static ConfigObject::Ptr GetObject(const String& type, const String& name);
 
 	static void DumpObjects(const String& filename, int attributeTypes = FAState);
+	static void DumpObjectsDelta(const String& filename, int attributeTypes = FAState);
 	static void RestoreObjects(const String& filename, int attributeTypes = FAState);
 	static void StopObjects();
 
@@ -85,7 +87,10 @@ public:
 private:
 	ConfigObject::Ptr m_Zone;
 
-	static void RestoreObject(const String& message, int attributeTypes);
+	static void RestoreNetStringObject(const String& message, int attributeTypes);
+	static void RestoreStateFileObject(const StateFileRecord& record, int attributeTypes);
+	static unsigned long RestoreNetStringFile(const String& filename, int attributeTypes, size_t& bytes);
+	static unsigned long RestoreStateFile(const String& filename, int attributeTypes, size_t& bytes);
 };
 
 #define DECLARE_OBJECTNAME(klass)						\
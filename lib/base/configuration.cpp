@@ -39,6 +39,7 @@ String Configuration::ObjectsPath;
 String Configuration::PidPath;
 String Configuration::PkgDataDir;
 String Configuration::PrefixDir;
+String Configuration::ProcessEventEngine;
 String Configuration::ProgramData;
 int Configuration::RLimitFiles;
 int Configuration::RLimitProcesses;
@@ -229,6 +230,16 @@ void Configuration::SetPrefixDir(const String& val, [[maybe_unused]] bool suppre
 	HandleUserWrite("PrefixDir", &Configuration::PrefixDir, val, m_ReadOnly);
 }
 
+String Configuration::GetProcessEventEngine() const
+{
+	return Configuration::ProcessEventEngine;
+}
+
+void Configuration::SetProcessEventEngine(const String& val, [[maybe_unused]] bool suppress_events, [[maybe_unused]] const Value& cookie)
+{
+	HandleUserWrite("ProcessEventEngine", &Configuration::ProcessEventEngine, val, m_ReadOnly);
+}
+
 String Configuration::GetProgramData() const
 {
 	return Configuration::ProgramData;
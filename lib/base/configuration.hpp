@@ -68,6 +68,9 @@ public:
 	String GetPrefixDir() const override;
 	void SetPrefixDir(const String& value, bool suppress_events = false, const Value& cookie = Empty) override;
 
+	String GetProcessEventEngine() const override;
+	void SetProcessEventEngine(const String& value, bool suppress_events = false, const Value& cookie = Empty) override;
+
 	String GetProgramData() const override;
 	void SetProgramData(const String& value, bool suppress_events = false, const Value& cookie = Empty) override;
 
@@ -131,6 +134,7 @@ public:
 	static String PidPath;
 	static String PkgDataDir;
 	static String PrefixDir;
+	static String ProcessEventEngine;
 	static String ProgramData;
 	static int RLimitFiles;
 	static int RLimitProcesses;
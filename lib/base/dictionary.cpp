@@ -5,29 +5,190 @@
 #include "base/debug.hpp"
 #include "base/primitivetype.hpp"
 #include "base/configwriter.hpp"
+#include <algorithm>
+#include <functional>
 #include <sstream>
 
 using namespace icinga;
 
-template class std::map<String, Value>;
+template class std::vector<std::pair<String, Value> >;
 
 REGISTER_PRIMITIVE_TYPE(Dictionary, Object, Dictionary::GetPrototype());
 
+static bool KeyLess(const Dictionary::Pair& kv, const String& key)
+{
+	return kv.first < key;
+}
+
 Dictionary::Dictionary(const DictionaryData& other)
+	: m_Data(other)
 {
-	for (const auto& kv : other)
-		m_Data.insert(kv);
+	Normalize();
 }
 
 Dictionary::Dictionary(DictionaryData&& other)
+	: m_Data(std::move(other))
 {
-	for (auto& kv : other)
-		m_Data.insert(std::move(kv));
+	Normalize();
 }
 
 Dictionary::Dictionary(std::initializer_list<Dictionary::Pair> init)
 	: m_Data(init)
-{ }
+{
+	Normalize();
+}
+
+/**
+ * Sorts the initial data by key. Of multiple pairs with the same key, only the first one is kept.
+ */
+void Dictionary::Normalize()
+{
+	auto less ([](const Pair& a, const Pair& b) { return a.first < b.first; });
+
+	if (!std::is_sorted(m_Data.begin(), m_Data.end(), less))
+		std::stable_sort(m_Data.begin(), m_Data.end(), less);
+
+	m_Data.erase(std::unique(m_Data.begin(), m_Data.end(), [](const Pair& a, const Pair& b) { return a.first == b.first; }), m_Data.end());
+
+	RebuildIndex();
+}
+
+/**
+ * Looks up a key. The caller must hold m_DataMutex.
+ *
+ * @param key The key.
+ * @param insert Whether to compute the insert position for keys which don't exist.
+ * @returns The key's position and true if it exists, otherwise the position to insert it at and false.
+ */
+std::pair<size_t, bool> Dictionary::Find(const String& key, bool insert) const
+{
+	if (!m_Index.empty()) {
+		size_t mask = m_Index.size() - 1u;
+
+		for (size_t slot = std::hash<String>()(key) & mask; m_Index[slot]; slot = (slot + 1u) & mask) {
+			size_t position = m_Index[slot] - 1u;
+
+			if (m_Data[position].first == key)
+				return { position, true };
+		}
+
+		if (!insert)
+			return { 0, false };
+
+		if (m_Data.back().first < key)
+			return { m_Data.size(), false };
+	}
+
+	auto it (std::lower_bound(m_Data.begin(), m_Data.end(), key, KeyLess));
+
+	return { it - m_Data.begin(), it != m_Data.end() && it->first == key };
+}
+
+/**
+ * Rebuilds the hash index after positions have changed, or drops it if the dictionary has become small.
+ * The caller must hold m_DataMutex exclusively.
+ */
+void Dictionary::RebuildIndex()
+{
+	if (m_Data.size() < IndexThreshold) {
+		m_Index.clear();
+		m_Index.shrink_to_fit();
+		return;
+	}
+
+	/* Keep the load factor at or below 1/2, so that probe sequences stay short. */
+	size_t size = 1;
+
+	while (size < m_Data.size() * 2u)
+		size <<= 1u;
+
+	m_Index.assign(size, 0);
+
+	for (size_t i = 0; i < m_Data.size(); i++)
+		AddToIndex(i);
+}
+
+/**
+ * Adds an element to the hash index. The caller must hold m_DataMutex exclusively.
+ *
+ * @param position The element's position in m_Data.
+ */
+void Dictionary::AddToIndex(size_t position)
+{
+	if (m_Index.size() < m_Data.size() * 2u) {
+		RebuildIndex();
+		return;
+	}
+
+	size_t mask = m_Index.size() - 1u;
+	size_t slot = std::hash<String>()(m_Data[position].first) & mask;
+
+	while (m_Index[slot])
+		slot = (slot + 1u) & mask;
+
+	m_Index[slot] = position + 1u;
+}
+
+/**
+ * Updates the positions in the hash index after an element has been inserted into or removed from
+ * m_Data, so that the keys don't have to be hashed again. The caller must hold m_DataMutex exclusively.
+ *
+ * @param position Where the element has been inserted or removed.
+ * @param inserted Whether it has been inserted, i.e. the following elements have moved back by one.
+ */
+void Dictionary::ShiftIndex(size_t position, bool inserted)
+{
+	uint32_t first = position + 1u;
+
+	if (inserted) {
+		for (auto& entry : m_Index)
+			entry += entry >= first;
+	} else {
+		for (auto& entry : m_Index)
+			entry -= entry > first;
+	}
+}
+
+/**
+ * Removes an element from m_Data and from the hash index. The caller must hold m_DataMutex exclusively.
+ *
+ * @param position The element's position in m_Data.
+ */
+void Dictionary::EraseAt(size_t position)
+{
+	if (!m_Index.empty() && m_Data.size() > IndexThreshold / 2u) {
+		std::hash<String> hash;
+		size_t mask = m_Index.size() - 1u;
+		size_t slot = hash(m_Data[position].first) & mask;
+
+		while (m_Index[slot] != position + 1u)
+			slot = (slot + 1u) & mask;
+
+		/* Instead of leaving a tombstone, move back the entries after the free slot which probed past it. */
+		for (size_t next = (slot + 1u) & mask; m_Index[next]; next = (next + 1u) & mask) {
+			size_t home = hash(m_Data[m_Index[next] - 1u].first) & mask;
+
+			if (((next - home) & mask) >= ((next - slot) & mask)) {
+				m_Index[slot] = m_Index[next];
+				slot = next;
+			}
+		}
+
+		m_Index[slot] = 0;
+
+		m_Data.erase(m_Data.begin() + position);
+		ShiftIndex(position, false);
+		return;
+	}
+
+	m_Data.erase(m_Data.begin() + position);
+
+	/* Drops the index once the dictionary has become small, not right below IndexThreshold,
+	 * so that alternately adding and removing an element doesn't rebuild it every time.
+	 */
+	if (!m_Index.empty())
+		RebuildIndex();
+}
 
 /**
  * Retrieves a value from a dictionary.
@@ -39,12 +200,12 @@ Value Dictionary::Get(const String& key) const
 {
 	std::shared_lock<std::shared_timed_mutex> lock (m_DataMutex);
 
-	auto it = m_Data.find(key);
+	auto pos (Find(key));
 
-	if (it == m_Data.end())
+	if (!pos.second)
 		return Empty;
 
-	return it->second;
+	return m_Data[pos.first].second;
 }
 
 /**
@@ -58,27 +219,29 @@ bool Dictionary::Get(const String& key, Value *result) const
 {
 	std::shared_lock<std::shared_timed_mutex> lock (m_DataMutex);
 
-	auto it = m_Data.find(key);
+	auto pos (Find(key));
 
-	if (it == m_Data.end())
+	if (!pos.second)
 		return false;
 
-	*result = it->second;
+	*result = m_Data[pos.first].second;
 	return true;
 }
 
 /**
  * Retrieves a value's address from a dictionary.
  *
+ * The address is only valid until the dictionary is modified.
+ *
  * @param key The key whose value's address should be retrieved.
  * @returns nullptr if the key was not found.
  */
 const Value * Dictionary::GetRef(const String& key) const
 {
 	std::shared_lock<std::shared_timed_mutex> lock (m_DataMutex);
-	auto it (m_Data.find(key));
+	auto pos (Find(key));
 
-	return it == m_Data.end() ? nullptr : &it->second;
+	return pos.second ? &m_Data[pos.first].second : nullptr;
 }
 
 /**
@@ -95,7 +258,24 @@ void Dictionary::Set(const String& key, Value value)
 	if (m_Frozen)
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Value in dictionary must not be modified."));
 
-	m_Data[key] = std::move(value);
+	auto pos (Find(key, true));
+
+	if (pos.second) {
+		m_Data[pos.first].second = std::move(value);
+		return;
+	}
+
+	m_Data.emplace(m_Data.begin() + pos.first, key, std::move(value));
+
+	if (!m_Index.empty()) {
+		/* Appending doesn't move any other element, e.g. when decoding JSON objects with sorted keys. */
+		if (pos.first + 1u < m_Data.size())
+			ShiftIndex(pos.first, true);
+
+		AddToIndex(pos.first);
+	} else if (m_Data.size() >= IndexThreshold) {
+		RebuildIndex();
+	}
 }
 
 /**
@@ -120,7 +300,7 @@ bool Dictionary::Contains(const String& key) const
 {
 	std::shared_lock<std::shared_timed_mutex> lock (m_DataMutex);
 
-	return (m_Data.find(key) != m_Data.end());
+	return Find(key).second;
 }
 
 /**
@@ -155,8 +335,9 @@ Dictionary::Iterator Dictionary::End()
  * Removes the item specified by the iterator from the dictionary.
  *
  * @param it The iterator.
+ * @returns An iterator to the item after the removed one.
  */
-void Dictionary::Remove(Dictionary::Iterator it)
+Dictionary::Iterator Dictionary::Remove(Dictionary::Iterator it)
 {
 	ASSERT(OwnsLock());
 	std::unique_lock<std::shared_timed_mutex> lock (m_DataMutex);
@@ -164,7 +345,11 @@ void Dictionary::Remove(Dictionary::Iterator it)
 	if (m_Frozen)
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Dictionary must not be modified."));
 
-	m_Data.erase(it);
+	auto position (it - m_Data.begin());
+
+	EraseAt(position);
+
+	return m_Data.begin() + position;
 }
 
 /**
@@ -180,13 +365,12 @@ void Dictionary::Remove(const String& key)
 	if (m_Frozen)
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Dictionary must not be modified."));
 
-	Dictionary::Iterator it;
-	it = m_Data.find(key);
+	auto pos (Find(key));
 
-	if (it == m_Data.end())
+	if (!pos.second)
 		return;
 
-	m_Data.erase(it);
+	EraseAt(pos.first);
 }
 
 /**
@@ -201,6 +385,8 @@ void Dictionary::Clear()
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Dictionary must not be modified."));
 
 	m_Data.clear();
+	m_Data.shrink_to_fit();
+	RebuildIndex();
 }
 
 void Dictionary::CopyTo(const Dictionary::Ptr& dest) const
@@ -276,6 +462,13 @@ String Dictionary::ToString() const
 void Dictionary::Freeze()
 {
 	ObjectLock olock(this);
+
+	if (!m_Frozen) {
+		/* Nothing will be added anymore, so drop the spare capacity. */
+		std::unique_lock<std::shared_timed_mutex> lock (m_DataMutex);
+		m_Data.shrink_to_fit();
+	}
+
 	m_Frozen.store(true, std::memory_order_release);
 }
 
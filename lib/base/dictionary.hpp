@@ -7,11 +7,14 @@
 #include "base/i2-base.hpp"
 #include "base/atomic.hpp"
 #include "base/object.hpp"
+#include "base/object-pool.hpp"
 #include "base/objectlock.hpp"
 #include "base/value.hpp"
 #include <boost/range/iterator.hpp>
+#include <cstdint>
 #include <map>
 #include <shared_mutex>
+#include <utility>
 #include <vector>
 
 namespace icinga
@@ -22,21 +25,32 @@ typedef std::vector<std::pair<String, Value> > DictionaryData;
 /**
  * A container that holds key-value pairs.
  *
+ * The pairs are stored in a vector sorted by their keys, which costs much less memory
+ * and fewer cache misses than a node-based tree. Small dictionaries are searched with
+ * a binary search, large ones additionally get an open-addressing hash index.
+ *
  * @ingroup base
  */
 class Dictionary final : public Object
 {
 public:
 	DECLARE_OBJECT(Dictionary);
+	DECLARE_POOLED_ALLOCATION(Dictionary);
 
 	/**
 	 * An iterator that can be used to iterate over dictionary elements.
+	 * It's invalidated by any modification of the dictionary.
 	 */
-	typedef std::map<String, Value>::iterator Iterator;
+	typedef DictionaryData::iterator Iterator;
 
-	typedef std::map<String, Value>::size_type SizeType;
+	typedef DictionaryData::size_type SizeType;
 
-	typedef std::map<String, Value>::value_type Pair;
+	typedef DictionaryData::value_type Pair;
+
+	/**
+	 * Dictionaries with at least this many elements get a hash index.
+	 */
+	static constexpr size_t IndexThreshold = 64;
 
 	Dictionary() = default;
 	Dictionary(const DictionaryData& other);
@@ -56,7 +70,7 @@ public:
 
 	void Remove(const String& key);
 
-	void Remove(Iterator it);
+	Iterator Remove(Iterator it);
 
 	void Clear();
 
@@ -81,9 +95,17 @@ public:
 	bool GetOwnField(const String& field, Value *result) const override;
 
 private:
-	std::map<String, Value> m_Data; /**< The data for the dictionary. */
+	DictionaryData m_Data; /**< The data for the dictionary, sorted by key. */
+	std::vector<uint32_t> m_Index; /**< Open-addressing hash table of m_Data positions + 1, 0 means free. */
 	mutable std::shared_timed_mutex m_DataMutex;
 	Atomic<bool> m_Frozen{false};
+
+	std::pair<size_t, bool> Find(const String& key, bool insert = false) const;
+	void Normalize();
+	void RebuildIndex();
+	void AddToIndex(size_t position);
+	void ShiftIndex(size_t position, bool inserted);
+	void EraseAt(size_t position);
 };
 
 Dictionary::Iterator begin(const Dictionary::Ptr& x);
@@ -91,6 +113,6 @@ Dictionary::Iterator end(const Dictionary::Ptr& x);
 
 }
 
-extern template class std::map<icinga::String, icinga::Value>;
+extern template class std::vector<std::pair<icinga::String, icinga::Value> >;
 
 #endif /* DICTIONARY_H */
@@ -116,6 +116,16 @@ public:
 		return strand.running_in_this_thread();
 	}
 
+	/**
+	 * Checks whether the calling thread is one of the I/O threads, which must never block.
+	 *
+	 * Not inlined for the same reason as IsStrandRunningOnThisThread().
+	 */
+	BOOST_NOINLINE static bool IsRunningOnIoThread()
+	{
+		return Get().m_IoContext.get_executor().running_in_this_thread();
+	}
+
 	boost::asio::io_context& GetIoContext();
 
 	static inline size_t GetCoroutineStackSize() {
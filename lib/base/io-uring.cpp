@@ -0,0 +1,302 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/io-uring.hpp"
+
+#ifdef HAVE_IO_URING
+#include "base/exception.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace icinga;
+
+static void *MapRing(int fd, size_t size, off_t offset)
+{
+	void *ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+
+	if (ring == MAP_FAILED) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("mmap")
+			<< boost::errinfo_errno(errno));
+	}
+
+	return ring;
+}
+
+/**
+ * Creates an io_uring instance.
+ *
+ * @param entries The size of the submission queue.
+ * @param completions The size of the completion queue.
+ */
+IoUring::IoUring(unsigned entries, unsigned completions)
+{
+	io_uring_params params{};
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = completions;
+
+	m_FD = syscall(SYS_io_uring_setup, entries, &params);
+
+	if (m_FD < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("io_uring_setup")
+			<< boost::errinfo_errno(errno));
+	}
+
+	/* Waiting with a timeout needs IORING_ENTER_EXT_ARG (Linux 5.11). */
+	if (!(params.features & IORING_FEAT_EXT_ARG)) {
+		(void)close(m_FD);
+
+		BOOST_THROW_EXCEPTION(std::runtime_error("The kernel's io_uring doesn't support IORING_FEAT_EXT_ARG."));
+	}
+
+	m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+	try {
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+			m_SqRing = m_CqRing = MapRing(m_FD, m_SqRingSize, IORING_OFF_SQ_RING);
+		} else {
+			m_SqRing = MapRing(m_FD, m_SqRingSize, IORING_OFF_SQ_RING);
+			m_CqRing = MapRing(m_FD, m_CqRingSize, IORING_OFF_CQ_RING);
+		}
+
+		m_Sqes = static_cast<io_uring_sqe *>(MapRing(m_FD, m_SqesSize, IORING_OFF_SQES));
+	} catch (...) {
+		(void)close(m_FD);
+		throw;
+	}
+
+	auto sq (static_cast<char *>(m_SqRing));
+	auto cq (static_cast<char *>(m_CqRing));
+
+	m_SqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+	m_SqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	m_SqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	m_SqEntries = params.sq_entries;
+
+	/* Submission queue entries are always used in order. */
+	auto array (reinterpret_cast<unsigned *>(sq + params.sq_off.array));
+
+	for (unsigned i = 0; i < m_SqEntries; i++) {
+		array[i] = i;
+	}
+
+	m_CqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	m_CqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	m_CqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	m_Cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring()
+{
+	/* Closing the ring unregisters the buffer ring as well. */
+	(void)close(m_FD);
+
+	(void)munmap(m_Sqes, m_SqesSize);
+
+	if (m_CqRing != m_SqRing)
+		(void)munmap(m_CqRing, m_CqRingSize);
+
+	(void)munmap(m_SqRing, m_SqRingSize);
+
+	if (m_BufRing)
+		(void)munmap(m_BufRing, m_BufRingSize);
+}
+
+/**
+ * Registers a ring of provided buffers (Linux 5.19) which reads prepared with
+ * PrepareRead() pick their buffer from once data is available.
+ *
+ * @param group The buffer group ID reads refer to.
+ * @param count The number of buffers, must be a power of two.
+ * @param size The size of each buffer.
+ */
+void IoUring::RegisterBuffers(uint16_t group, uint16_t count, uint32_t size)
+{
+	m_BufRingSize = count * sizeof(io_uring_buf);
+
+	void *ring = mmap(nullptr, m_BufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (ring == MAP_FAILED) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("mmap")
+			<< boost::errinfo_errno(errno));
+	}
+
+	m_BufRing = static_cast<io_uring_buf_ring *>(ring);
+
+	io_uring_buf_reg reg{};
+	reg.ring_addr = reinterpret_cast<uintptr_t>(ring);
+	reg.ring_entries = count;
+	reg.bgid = group;
+
+	if (syscall(SYS_io_uring_register, m_FD, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("io_uring_register")
+			<< boost::errinfo_errno(errno));
+	}
+
+	m_BufMask = count - 1;
+	m_BufSize = size;
+	m_Buffers.resize(static_cast<size_t>(count) * size);
+
+	for (uint16_t id = 0; id < count; id++) {
+		AddBuffer(id);
+	}
+
+	__atomic_store_n(&m_BufRing->tail, m_BufTail, __ATOMIC_RELEASE);
+}
+
+/**
+ * Returns the buffer a completion with IORING_CQE_F_BUFFER refers to.
+ */
+const char *IoUring::GetBuffer(uint16_t id) const
+{
+	return m_Buffers.data() + static_cast<size_t>(id) * m_BufSize;
+}
+
+/**
+ * Hands a buffer which has been picked by a read back to the kernel.
+ */
+void IoUring::RecycleBuffer(uint16_t id)
+{
+	AddBuffer(id);
+
+	__atomic_store_n(&m_BufRing->tail, m_BufTail, __ATOMIC_RELEASE);
+}
+
+void IoUring::AddBuffer(uint16_t id)
+{
+	io_uring_buf& buf (m_BufRing->bufs[m_BufTail & m_BufMask]);
+
+	buf.addr = reinterpret_cast<uintptr_t>(GetBuffer(id));
+	buf.len = m_BufSize;
+	buf.bid = id;
+
+	m_BufTail++;
+}
+
+/**
+ * Queues a read from the current position of fd into one of the buffers of the specified group.
+ */
+void IoUring::PrepareRead(int fd, uint16_t group, uint64_t userData)
+{
+	io_uring_sqe *sqe = GetSqe();
+
+	sqe->opcode = IORING_OP_READ;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->fd = fd;
+	sqe->off = -1;
+	sqe->len = m_BufSize;
+	sqe->buf_group = group;
+	sqe->user_data = userData;
+
+	__atomic_store_n(m_SqTail, *m_SqTail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Queues a one-shot poll for the specified events of fd.
+ */
+void IoUring::PreparePoll(int fd, uint32_t events, uint64_t userData)
+{
+	io_uring_sqe *sqe = GetSqe();
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = events;
+	sqe->user_data = userData;
+
+	__atomic_store_n(m_SqTail, *m_SqTail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Queues a no-op, e.g. to wake up the thread which waits for completions.
+ */
+void IoUring::PrepareNop(uint64_t userData)
+{
+	io_uring_sqe *sqe = GetSqe();
+
+	sqe->opcode = IORING_OP_NOP;
+	sqe->user_data = userData;
+
+	__atomic_store_n(m_SqTail, *m_SqTail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Queues the cancellation of a pending request. The cancelled request completes with -ECANCELED.
+ */
+void IoUring::PrepareCancel(uint64_t target, uint64_t userData)
+{
+	io_uring_sqe *sqe = GetSqe();
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = target;
+	sqe->user_data = userData;
+
+	__atomic_store_n(m_SqTail, *m_SqTail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Submits all queued requests and optionally waits for completions.
+ *
+ * @param waitFor The number of completions to wait for.
+ * @param timeout How long to wait at most in seconds, -1 waits indefinitely.
+ */
+void IoUring::Submit(unsigned waitFor, double timeout)
+{
+	unsigned toSubmit = __atomic_load_n(m_SqTail, __ATOMIC_RELAXED) - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE);
+	unsigned flags = 0;
+	__kernel_timespec ts{};
+	io_uring_getevents_arg arg{};
+
+	if (waitFor > 0)
+		flags |= IORING_ENTER_GETEVENTS;
+
+	if (waitFor > 0 && timeout >= 0) {
+		ts.tv_sec = static_cast<int64_t>(timeout);
+		ts.tv_nsec = static_cast<int64_t>((timeout - std::floor(timeout)) * 1e9);
+
+		arg.sigmask_sz = _NSIG / 8;
+		arg.ts = reinterpret_cast<uintptr_t>(&ts);
+
+		flags |= IORING_ENTER_EXT_ARG;
+	}
+
+	if (toSubmit == 0 && flags == 0)
+		return;
+
+	int rc = syscall(SYS_io_uring_enter, m_FD, toSubmit, waitFor, flags,
+		flags & IORING_ENTER_EXT_ARG ? &arg : nullptr, flags & IORING_ENTER_EXT_ARG ? sizeof(arg) : 0);
+
+	/* Timeouts, signals and a full completion queue just make us look at the completions earlier. */
+	if (rc < 0 && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("io_uring_enter")
+			<< boost::errinfo_errno(errno));
+	}
+}
+
+io_uring_sqe *IoUring::GetSqe()
+{
+	/* The submission queue is full, let the kernel consume it. */
+	while (*m_SqTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE) >= m_SqEntries) {
+		Submit();
+	}
+
+	io_uring_sqe *sqe = &m_Sqes[*m_SqTail & m_SqMask];
+
+	memset(sqe, 0, sizeof(*sqe));
+
+	return sqe;
+}
+
+#endif /* HAVE_IO_URING */
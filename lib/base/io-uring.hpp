@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+
+#ifdef HAVE_IO_URING
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * A minimal io_uring instance which talks to the kernel directly rather than through liburing.
+ *
+ * Submissions may be queued from any thread as long as the caller serializes them,
+ * completions must only be reaped by a single thread.
+ *
+ * @ingroup base
+ */
+class IoUring
+{
+public:
+	IoUring(unsigned entries, unsigned completions);
+	IoUring(const IoUring&) = delete;
+	IoUring& operator=(const IoUring&) = delete;
+	~IoUring();
+
+	void RegisterBuffers(uint16_t group, uint16_t count, uint32_t size);
+	const char *GetBuffer(uint16_t id) const;
+	void RecycleBuffer(uint16_t id);
+
+	void PrepareRead(int fd, uint16_t group, uint64_t userData);
+	void PreparePoll(int fd, uint32_t events, uint64_t userData);
+	void PrepareNop(uint64_t userData);
+	void PrepareCancel(uint64_t target, uint64_t userData);
+
+	void Submit(unsigned waitFor = 0, double timeout = -1);
+
+	/**
+	 * Calls func for every completion which is available and hands the entries back to the kernel.
+	 *
+	 * @returns The number of completions.
+	 */
+	template<typename F>
+	size_t ForEachCompletion(const F& func)
+	{
+		unsigned head = *m_CqHead;
+		unsigned tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+		size_t count = tail - head;
+
+		for (; head != tail; head++) {
+			func(m_Cqes[head & m_CqMask]);
+		}
+
+		__atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+
+		return count;
+	}
+
+private:
+	int m_FD;
+
+	void *m_SqRing;
+	size_t m_SqRingSize;
+	void *m_CqRing;
+	size_t m_CqRingSize;
+	io_uring_sqe *m_Sqes;
+	size_t m_SqesSize;
+
+	unsigned *m_SqHead;
+	unsigned *m_SqTail;
+	unsigned m_SqMask;
+	unsigned m_SqEntries;
+
+	unsigned *m_CqHead;
+	unsigned *m_CqTail;
+	unsigned m_CqMask;
+	io_uring_cqe *m_Cqes;
+
+	io_uring_buf_ring *m_BufRing{nullptr};
+	size_t m_BufRingSize{0};
+	uint16_t m_BufTail{0};
+	uint16_t m_BufMask{0};
+	uint32_t m_BufSize{0};
+	std::vector<char> m_Buffers;
+
+	io_uring_sqe *GetSqe();
+	void AddBuffer(uint16_t id);
+};
+
+}
+
+#endif /* HAVE_IO_URING */
@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace icinga
+{
+
+/**
+ * A bounded lock-free multi-producer multi-consumer queue.
+ *
+ * Every cell carries a sequence number which tells producers and consumers whose turn it is,
+ * so neither of them ever waits for the other one. See Dmitry Vyukov's bounded MPMC queue.
+ *
+ * @ingroup base
+ */
+template<typename T>
+class MpmcRing
+{
+public:
+	/**
+	 * @param capacity The maximum number of items, rounded up to the next power of two.
+	 */
+	explicit MpmcRing(size_t capacity)
+	{
+		size_t size = 1;
+
+		while (size < capacity) {
+			size <<= 1u;
+		}
+
+		m_Cells.reset(new Cell[size]);
+		m_Mask = size - 1u;
+
+		for (size_t i = 0; i < size; i++) {
+			m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	MpmcRing(const MpmcRing&) = delete;
+	MpmcRing& operator=(const MpmcRing&) = delete;
+
+	size_t GetCapacity() const
+	{
+		return m_Mask + 1u;
+	}
+
+	/**
+	 * Appends an item unless the queue is full.
+	 *
+	 * @returns Whether the item has been appended. If not, it hasn't been moved from.
+	 */
+	bool TryPush(T&& item)
+	{
+		Cell *cell;
+		size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+
+		for (;;) {
+			cell = &m_Cells[pos & m_Mask];
+
+			auto diff (static_cast<intptr_t>(cell->Sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos));
+
+			if (diff == 0) {
+				if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = m_EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->Item = std::move(item);
+		cell->Sequence.store(pos + 1u, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * Takes up to max consecutive items from the front of the queue with a single CAS.
+	 *
+	 * @param out Where to move the items to.
+	 * @param max The maximum number of items.
+	 * @returns The number of items taken.
+	 */
+	template<typename OutputIt>
+	size_t TryPopBatch(OutputIt out, size_t max)
+	{
+		size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+		size_t count;
+
+		for (;;) {
+			for (count = 0; count < max; count++) {
+				size_t next = pos + count;
+
+				if (m_Cells[next & m_Mask].Sequence.load(std::memory_order_acquire) != next + 1u)
+					break;
+			}
+
+			if (count == 0) {
+				auto diff (static_cast<intptr_t>(m_Cells[pos & m_Mask].Sequence.load(std::memory_order_acquire))
+					- static_cast<intptr_t>(pos + 1u));
+
+				/* The next item hasn't been published yet. */
+				if (diff < 0)
+					return 0;
+
+				/* Someone else has taken it, try again with the current position. */
+				pos = m_DequeuePos.load(std::memory_order_relaxed);
+				continue;
+			}
+
+			if (m_DequeuePos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+				break;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			Cell& cell (m_Cells[(pos + i) & m_Mask]);
+
+			*out = std::move(cell.Item);
+			++out;
+
+			cell.Item = T();
+			cell.Sequence.store(pos + i + m_Mask + 1u, std::memory_order_release);
+		}
+
+		return count;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> Sequence;
+		T Item;
+	};
+
+	std::unique_ptr<Cell[]> m_Cells;
+	size_t m_Mask;
+
+	alignas(64) std::atomic<size_t> m_EnqueuePos{0};
+	alignas(64) std::atomic<size_t> m_DequeuePos{0};
+};
+
+}
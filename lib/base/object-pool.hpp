@@ -0,0 +1,229 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace icinga
+{
+
+/**
+ * Allocation counters of an ObjectPool, per thread.
+ *
+ * @ingroup base
+ */
+struct ObjectPoolStats
+{
+	uint64_t Allocations; /**< All allocations of the pooled type. */
+	uint64_t HeapAllocations; /**< Allocations which weren't served from the pool, but the heap. */
+	uint64_t BatchesTaken; /**< Batches of free blocks taken from the depot, i.e. freed by other threads. */
+};
+
+/**
+ * Recycles the memory of frequently allocated objects of type T, e.g. the ones created for every check result.
+ *
+ * Freed blocks are kept in a free list of the freeing thread (up to MaxCached of them) and handed out again
+ * by the next allocation on that thread instead of going through malloc(3). Blocks are still allocated and
+ * freed one by one with ::operator new and ::operator delete, so they may be freed on any thread.
+ *
+ * Objects are often created on one thread and freed on another one, e.g. check results are created by the
+ * checker and freed by the API or the next check result. A full free list therefore hands half of its blocks
+ * over to a global depot as a batch, and an empty one takes a batch from there before falling back to the heap.
+ * The depot holds up to MaxDepotBatches batches, everything beyond is given back to the heap.
+ *
+ * Use DECLARE_POOLED_ALLOCATION() in the class T to route its new and delete through the pool.
+ *
+ * @ingroup base
+ */
+template<typename T, size_t MaxCached = 1024>
+class ObjectPool
+{
+public:
+	static constexpr size_t BatchSize = MaxCached / 2u;
+	static constexpr size_t MaxDepotBatches = 16;
+
+	static void *Allocate(size_t size)
+	{
+		auto& list (l_FreeList);
+
+		list.Stats.Allocations++;
+
+		/* Derived classes with a different size aren't pooled. */
+		if (size == sizeof(T)) {
+			if (!list.Head && !list.Drained && l_DepotBatches.load(std::memory_order_relaxed))
+				TakeBatch(list);
+
+			if (list.Head) {
+				auto block (list.Head);
+
+				list.Head = block->Next;
+				list.Count--;
+
+				return block;
+			}
+		}
+
+		list.Stats.HeapAllocations++;
+
+		return ::operator new(size < sizeof(Block) ? sizeof(Block) : size);
+	}
+
+	static void Deallocate(void *ptr, size_t size) noexcept
+	{
+		static_assert(sizeof(T) >= sizeof(Block), "T is too small to be pooled");
+
+		auto& list (l_FreeList);
+
+		if (size != sizeof(T) || list.Drained) {
+			::operator delete(ptr);
+			return;
+		}
+
+		/* Hands the cached blocks over to the depot or frees them once the thread exits. */
+		static thread_local Drain drain;
+		(void)drain;
+
+		if (list.Count >= MaxCached)
+			GiveBatch(list);
+
+		list.Head = new (ptr) Block{list.Head, nullptr};
+		list.Count++;
+	}
+
+	/**
+	 * @returns The counters of the calling thread.
+	 */
+	static ObjectPoolStats GetStats()
+	{
+		return l_FreeList.Stats;
+	}
+
+private:
+	struct Block
+	{
+		Block *Next;
+		Block *NextBatch; /**< Only used by the first block of a batch in the depot. */
+	};
+
+	/* Trivially destructible, so that objects freed after Drain has run (e.g. by other thread_local
+	 * destructors) can still check Drained. */
+	struct FreeList
+	{
+		Block *Head;
+		size_t Count;
+		bool Drained;
+		ObjectPoolStats Stats;
+	};
+
+	struct Drain
+	{
+		~Drain()
+		{
+			auto& list (l_FreeList);
+
+			while (list.Count >= BatchSize)
+				GiveBatch(list);
+
+			while (list.Head) {
+				auto block (list.Head);
+
+				list.Head = block->Next;
+				::operator delete(block);
+			}
+
+			list.Count = 0;
+			list.Drained = true;
+		}
+	};
+
+	static thread_local FreeList l_FreeList;
+
+	static std::mutex l_DepotMutex;
+	static Block *l_DepotHead;
+	static std::atomic<size_t> l_DepotBatches;
+
+	/**
+	 * Moves BatchSize blocks from the free list to the depot, or to the heap if the depot is full.
+	 */
+	static void GiveBatch(FreeList& list) noexcept
+	{
+		auto batch (list.Head);
+		auto last (batch);
+
+		for (size_t i = 1; i < BatchSize; i++)
+			last = last->Next;
+
+		list.Head = last->Next;
+		list.Count -= BatchSize;
+		last->Next = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock (l_DepotMutex);
+
+			if (l_DepotBatches.load(std::memory_order_relaxed) < MaxDepotBatches) {
+				batch->NextBatch = l_DepotHead;
+				l_DepotHead = batch;
+				l_DepotBatches.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+
+		while (batch) {
+			auto block (batch);
+
+			batch = block->Next;
+			::operator delete(block);
+		}
+	}
+
+	/**
+	 * Moves a batch of blocks from the depot to the (empty) free list, if there's any.
+	 */
+	static void TakeBatch(FreeList& list)
+	{
+		std::unique_lock<std::mutex> lock (l_DepotMutex);
+
+		if (!l_DepotHead)
+			return;
+
+		list.Head = l_DepotHead;
+		list.Count = BatchSize;
+		list.Stats.BatchesTaken++;
+
+		l_DepotHead = l_DepotHead->NextBatch;
+		l_DepotBatches.fetch_sub(1, std::memory_order_relaxed);
+	}
+};
+
+template<typename T, size_t MaxCached>
+thread_local typename ObjectPool<T, MaxCached>::FreeList ObjectPool<T, MaxCached>::l_FreeList {};
+
+template<typename T, size_t MaxCached>
+std::mutex ObjectPool<T, MaxCached>::l_DepotMutex;
+
+template<typename T, size_t MaxCached>
+typename ObjectPool<T, MaxCached>::Block *ObjectPool<T, MaxCached>::l_DepotHead = nullptr;
+
+template<typename T, size_t MaxCached>
+std::atomic<size_t> ObjectPool<T, MaxCached>::l_DepotBatches (0);
+
+/**
+ * Allocates objects of the (final) class klass from an ObjectPool.
+ */
+#define DECLARE_POOLED_ALLOCATION(klass) \
+	static void *operator new(size_t size) \
+	{ \
+		return ObjectPool<klass>::Allocate(size); \
+	} \
+	static void operator delete(void *ptr, size_t size) noexcept \
+	{ \
+		ObjectPool<klass>::Deallocate(ptr, size); \
+	}
+
+}
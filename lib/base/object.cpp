@@ -58,10 +58,25 @@ String Object::ToString() const
  */
 bool Object::OwnsLock() const
 {
+	if (auto state = GetSharedLockState(); state)
+		return state->Owner.load() == std::this_thread::get_id();
+
 	return m_LockOwner.load() == std::this_thread::get_id();
 }
 #endif /* I2_DEBUG */
 
+/**
+ * Types whose objects are read under a SharedObjectLock a lot return their own
+ * SharedLockState, which ObjectLock and SharedObjectLock take instead of the
+ * object's recursive mutex. Other objects don't pay for a shared mutex.
+ *
+ * @returns nullptr, i.e. SharedObjectLock locks the object exclusively.
+ */
+SharedLockState *Object::GetSharedLockState() const
+{
+	return nullptr;
+}
+
 void Object::SetField(int id, const Value&, bool, const Value&)
 {
 	if (id == 0)
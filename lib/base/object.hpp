@@ -12,6 +12,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <vector>
 
@@ -150,6 +151,18 @@ private:
 	friend struct Lazy;
 };
 
+/**
+ * The reader/writer lock of an Object which supports SharedObjectLock, see Object::GetSharedLockState().
+ *
+ * @ingroup base
+ */
+struct SharedLockState
+{
+	std::shared_mutex Mutex;
+	std::atomic<std::thread::id> Owner{std::thread::id()};
+	uint32_t Count = 0;
+};
+
 /**
  * Base class for all heap-allocated objects. At least one of its methods
  * has to be virtual for RTTI to work.
@@ -190,6 +203,15 @@ public:
 
 	static intrusive_ptr<Type> TypeInstance;
 
+protected:
+	/**
+	 * Called by the setters of [state] attributes. Hidden by ConfigObjectBase::MarkStateDirty().
+	 */
+	inline void MarkStateDirty()
+	{ }
+
+	virtual SharedLockState *GetSharedLockState() const;
+
 private:
 	Object(const Object& other) = delete;
 	Object& operator=(const Object& rhs) = delete;
@@ -203,6 +225,7 @@ private:
 #endif /* I2_DEBUG */
 
 	friend struct ObjectLock;
+	friend struct SharedObjectLock;
 
 	friend void intrusive_ptr_add_ref(const Object *object);
 	friend void intrusive_ptr_release(const Object *object);
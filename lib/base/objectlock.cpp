@@ -2,12 +2,22 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "base/objectlock.hpp"
+#include <algorithm>
 #include <thread>
+#include <vector>
 
 using namespace icinga;
 
-#define I2MUTEX_UNLOCKED 0
-#define I2MUTEX_LOCKED 1
+/**
+ * The objects the current thread holds shared locks on, once per SharedObjectLock.
+ * There are only a few at a time, so a vector is fine.
+ */
+static thread_local std::vector<const Object *> l_SharedLocks;
+
+static bool HoldsSharedLock(const Object *object)
+{
+	return std::find(l_SharedLocks.begin(), l_SharedLocks.end(), object) != l_SharedLocks.end();
+}
 
 ObjectLock::~ObjectLock()
 {
@@ -47,42 +57,116 @@ bool ObjectLock::TryLock() noexcept
 {
 	ASSERT(!m_Locked && m_Object);
 
-	m_Locked = m_Object->m_Mutex.try_lock();
+	m_State = m_Object->GetSharedLockState();
+
+	if (!m_State) {
+		m_Locked = m_Object->m_Mutex.try_lock();
 #ifdef I2_DEBUG
-	if (m_Locked && ++m_Object->m_LockCount == 1u) {
-		m_Object->m_LockOwner.store(std::this_thread::get_id());
-	}
+		if (m_Locked && ++m_Object->m_LockCount == 1u) {
+			m_Object->m_LockOwner.store(std::this_thread::get_id());
+		}
 #endif /* I2_DEBUG */
-	return m_Locked;
+		return m_Locked;
+	}
+
+	auto self (std::this_thread::get_id());
+
+	if (m_State->Owner.load(std::memory_order_relaxed) == self) {
+		++m_State->Count;
+		m_Locked = true;
+		return true;
+	}
+
+	/* Upgrading a shared lock would mean releasing it, which isn't what the caller expects from a try. */
+	if (HoldsSharedLock(m_Object) || !m_State->Mutex.try_lock())
+		return false;
+
+	m_State->Owner.store(self, std::memory_order_relaxed);
+	m_State->Count = 1;
+	m_Locked = true;
+
+	return true;
 }
 
 void ObjectLock::Lock()
 {
 	ASSERT(!m_Locked && m_Object);
 
-	m_Object->m_Mutex.lock();
-
+	m_State = m_Object->GetSharedLockState();
+	LockExclusive(m_Object, m_State);
 	m_Locked = true;
+}
 
-#ifdef I2_DEBUG
-	if (++m_Object->m_LockCount == 1u) {
-		m_Object->m_LockOwner.store(std::this_thread::get_id());
+void ObjectLock::Unlock()
+{
+	if (m_Locked) {
+		ReleaseExclusive(m_Object, m_State);
+		m_Locked = false;
 	}
-#endif /* I2_DEBUG */
 }
 
-void ObjectLock::Unlock()
+/**
+ * Locks the object exclusively and recursively for the calling thread.
+ *
+ * @param state The object's SharedLockState, nullptr if it has none
+ */
+void ObjectLock::LockExclusive(const Object *object, SharedLockState *state)
 {
+	if (!state) {
+		object->m_Mutex.lock();
+
 #ifdef I2_DEBUG
-	if (m_Locked && !--m_Object->m_LockCount) {
-		m_Object->m_LockOwner.store(decltype(m_Object->m_LockOwner.load())());
+		if (++object->m_LockCount == 1u) {
+			object->m_LockOwner.store(std::this_thread::get_id());
+		}
+#endif /* I2_DEBUG */
+		return;
+	}
+
+	auto self (std::this_thread::get_id());
+
+	if (state->Owner.load(std::memory_order_relaxed) == self) {
+		++state->Count;
+		return;
 	}
+
+	/* The shared lock is given up for the exclusive one and re-acquired once the latter is released. */
+	if (HoldsSharedLock(object))
+		state->Mutex.unlock_shared();
+
+	state->Mutex.lock();
+
+	state->Owner.store(self, std::memory_order_relaxed);
+	state->Count = 1;
+}
+
+/**
+ * Drops one level of the calling thread's exclusive lock on the object and
+ * re-acquires its shared lock, if any, once the exclusive one is released.
+ *
+ * @param state The object's SharedLockState, nullptr if it has none
+ */
+void ObjectLock::ReleaseExclusive(const Object *object, SharedLockState *state)
+{
+	if (!state) {
+#ifdef I2_DEBUG
+		if (!--object->m_LockCount) {
+			object->m_LockOwner.store(decltype(object->m_LockOwner.load())());
+		}
 #endif /* I2_DEBUG */
 
-	if (m_Locked) {
-		m_Object->m_Mutex.unlock();
-		m_Locked = false;
+		object->m_Mutex.unlock();
+		return;
 	}
+
+	if (--state->Count)
+		return;
+
+	state->Owner.store(std::thread::id(), std::memory_order_relaxed);
+	state->Mutex.unlock();
+
+	if (HoldsSharedLock(object))
+		state->Mutex.lock_shared();
 }
 
 /**
@@ -96,3 +180,91 @@ ObjectLock::operator bool() const
 {
 	return m_Locked;
 }
+
+SharedObjectLock::SharedObjectLock(const Object::Ptr& object)
+	: SharedObjectLock(object.get())
+{
+}
+
+/**
+ * Constructs a shared lock for the given object without locking it immediately.
+ *
+ * The user must call Lock() explicitly when needed.
+ *
+ * @param object The object to lock.
+ */
+SharedObjectLock::SharedObjectLock(const Object::Ptr& object, std::defer_lock_t)
+	: m_Object(object.get())
+{
+}
+
+SharedObjectLock::SharedObjectLock(const Object *object)
+	: m_Object(object)
+{
+	if (m_Object)
+		Lock();
+}
+
+SharedObjectLock::~SharedObjectLock()
+{
+	Unlock();
+}
+
+void SharedObjectLock::Lock()
+{
+	ASSERT(!m_Locked && m_Object);
+
+	m_State = m_Object->GetSharedLockState();
+
+	if (!m_State || m_State->Owner.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+		/* Objects without a SharedLockState can only be locked exclusively. An exclusive lock covers reading, too. */
+		ObjectLock::LockExclusive(m_Object, m_State);
+		m_Exclusive = true;
+	} else {
+		if (!HoldsSharedLock(m_Object))
+			m_State->Mutex.lock_shared();
+
+		l_SharedLocks.emplace_back(m_Object);
+		m_Exclusive = false;
+	}
+
+	m_Locked = true;
+}
+
+void SharedObjectLock::Unlock()
+{
+	if (!m_Locked)
+		return;
+
+	m_Locked = false;
+
+	if (m_Exclusive) {
+		ObjectLock::ReleaseExclusive(m_Object, m_State);
+		return;
+	}
+
+	l_SharedLocks.erase(std::find(l_SharedLocks.rbegin(), l_SharedLocks.rend(), m_Object).base() - 1);
+
+	/* If an ObjectLock has taken over, it has released the shared lock already. */
+	if (!HoldsSharedLock(m_Object) && m_State->Owner.load(std::memory_order_relaxed) != std::this_thread::get_id())
+		m_State->Mutex.unlock_shared();
+}
+
+/**
+ * Returns true if the object is locked, false otherwise.
+ *
+ * @returns true if the object is locked, false otherwise.
+ */
+SharedObjectLock::operator bool() const
+{
+	return m_Locked;
+}
+
+/**
+ * Returns whether multiple threads may hold a SharedObjectLock on the object at the same time,
+ * i.e. whether a SharedObjectLock doesn't lock it exclusively.
+ */
+bool SharedObjectLock::IsShareable(const Object::Ptr& object)
+{
+	return object->GetSharedLockState() != nullptr;
+}
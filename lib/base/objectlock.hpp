@@ -32,7 +32,50 @@ public:
 
 private:
 	const Object *m_Object{nullptr};
+	SharedLockState *m_State{nullptr};
 	bool m_Locked{false};
+
+	static void LockExclusive(const Object *object, SharedLockState *state);
+	static void ReleaseExclusive(const Object *object, SharedLockState *state);
+
+	friend struct SharedObjectLock;
+};
+
+/**
+ * A scoped shared lock for Objects, for read-only access.
+ *
+ * Multiple threads may hold a shared lock on the same object, while ObjectLock excludes all of them.
+ * Shared locks may be nested, also within an ObjectLock on the same object. An ObjectLock taken while
+ * the same thread holds a shared lock on the object temporarily releases the shared lock, i.e. other
+ * writers may get in between.
+ *
+ * Only objects which return a SharedLockState from Object::GetSharedLockState() can be shared,
+ * all others are locked exclusively like by ObjectLock.
+ */
+struct SharedObjectLock
+{
+public:
+	SharedObjectLock(const Object::Ptr& object);
+	SharedObjectLock(const Object::Ptr& object, std::defer_lock_t);
+	SharedObjectLock(const Object *object);
+
+	SharedObjectLock(const SharedObjectLock&) = delete;
+	SharedObjectLock& operator=(const SharedObjectLock&) = delete;
+
+	~SharedObjectLock();
+
+	void Lock();
+	void Unlock();
+
+	operator bool() const;
+
+	static bool IsShareable(const Object::Ptr& object);
+
+private:
+	const Object *m_Object{nullptr};
+	SharedLockState *m_State{nullptr};
+	bool m_Locked{false};
+	bool m_Exclusive{false}; /**< Whether the calling thread held an ObjectLock already, which has been nested into. */
 };
 
 }
@@ -7,7 +7,9 @@
 #include "base/exception.hpp"
 #include "base/logger.hpp"
 #include "base/function.hpp"
+#include "base/objectlock.hpp"
 #include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast/try_lexical_convert.hpp>
 #include <cmath>
 #include <stdexcept>
 #include <string>
@@ -226,101 +228,17 @@ PerfdataValue::PerfdataValue(const String& label, double value, bool counter,
 	SetMax(max, true);
 }
 
-PerfdataValue::Ptr PerfdataValue::Parse(const String& perfdata)
+static std::string_view ToStringView(const String& str)
 {
-	size_t eqp = perfdata.FindLastOf('=');
-
-	if (eqp == String::NPos)
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid performance data value: " + perfdata));
-
-	String label = perfdata.SubStr(0, eqp);
-
-	if (label.GetLength() > 2 && label[0] == '\'' && label[label.GetLength() - 1] == '\'')
-		label = label.SubStr(1, label.GetLength() - 2);
-
-	size_t spq = perfdata.FindFirstOf(' ', eqp);
-
-	if (spq == String::NPos)
-		spq = perfdata.GetLength();
-
-	String valueStr = perfdata.SubStr(eqp + 1, spq - eqp - 1);
-	std::vector<String> tokens = valueStr.Split(";");
-
-	if (valueStr.FindFirstOf(',') != String::NPos || tokens.empty()) {
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid performance data value: " + perfdata));
-	}
-
-	// Find the position where to split value and unit. Possible values of tokens[0] include:
-	// "1000", "1.0", "1.", "-.1", "+1", "1e10", "1GB", "1e10GB", "1e10EB", "1E10EB", "1.5GB", "1.GB", "+1.E-1EW"
-	// Consider everything up to and including the last digit or decimal point as part of the value.
-	size_t pos = tokens[0].FindLastOf("0123456789.");
-	if (pos != String::NPos) {
-		pos++;
-	}
-
-	double value = Convert::ToDouble(tokens[0].SubStr(0, pos));
-
-	if (!std::isfinite(value)) {
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid performance data value: " + perfdata + " is outside of any reasonable range"));
-	}
-
-	bool counter = false;
-	String unit;
-	Value warn, crit, min, max;
-
-	if (pos != String::NPos)
-		unit = tokens[0].SubStr(pos, String::NPos);
-
-	// UoM.Out is an empty string for "c". So set counter before parsing.
-	if (unit == "c") {
-		counter = true;
-	}
-
-	double base;
-
-	{
-		auto uom (l_CsUoMs.find(unit.GetData()));
-
-		if (uom == l_CsUoMs.end()) {
-			auto ciUnit (unit.ToLower());
-			auto uom (l_CiUoMs.find(ciUnit.GetData()));
-
-			if (uom == l_CiUoMs.end()) {
-				Log(LogDebug, "PerfdataValue")
-					<< "Invalid performance data unit: " << unit;
-
-				unit = "";
-				base = 1.0;
-			} else {
-				unit = uom->second.Out;
-				base = uom->second.Factor;
-			}
-		} else {
-			unit = uom->second.Out;
-			base = uom->second.Factor;
-		}
-	}
-
-	warn = ParseWarnCritMinMaxToken(tokens, 1, "warning");
-	crit = ParseWarnCritMinMaxToken(tokens, 2, "critical");
-	min = ParseWarnCritMinMaxToken(tokens, 3, "minimum");
-	max = ParseWarnCritMinMaxToken(tokens, 4, "maximum");
-
-	value = value * base;
-
-	if (!warn.IsEmpty())
-		warn = warn * base;
-
-	if (!crit.IsEmpty())
-		crit = crit * base;
-
-	if (!min.IsEmpty())
-		min = min * base;
+	return std::string_view(str.CStr(), str.GetLength());
+}
 
-	if (!max.IsEmpty())
-		max = max * base;
+PerfdataValue::Ptr PerfdataValue::Parse(const String& perfdata)
+{
+	PerfdataMetrics metrics;
+	metrics.Add(ToStringView(perfdata));
 
-	return new PerfdataValue(label, value, counter, unit, warn, crit, min, max);
+	return metrics.GetPerfdataValue(0);
 }
 
 static const std::unordered_map<std::string, const char*> l_FormatUoMs ({
@@ -395,14 +313,294 @@ String PerfdataValue::Format() const
 	return result.str();
 }
 
-Value PerfdataValue::ParseWarnCritMinMaxToken(const std::vector<String>& tokens, std::vector<String>::size_type index, const String& description)
+static void ThrowInvalidPerfdata(std::string_view perfdata, const char *reason = "")
+{
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid performance data value: " + std::string(perfdata) + reason));
+}
+
+/**
+ * Parses a warning, critical, minimum or maximum token.
+ *
+ * @returns Whether the token holds a number at all.
+ */
+static bool ParseWarnCritMinMaxToken(std::string_view token, const char *description, double& result)
+{
+	if (token.empty())
+		return false;
+
+	if (token == "U" || token.find_first_not_of("+-0123456789.eE") != std::string_view::npos) {
+		Log(LogDebug, "PerfdataValue")
+			<< "Ignoring unsupported perfdata " << description << " range, value: '" << token << "'.";
+		return false;
+	}
+
+	if (!boost::conversion::try_lexical_convert(token.data(), token.size(), result))
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Can't convert '" + std::string(token) + "' to a floating point number."));
+
+	return true;
+}
+
+/**
+ * Keeps a reference to the performance data and parses all of its values.
+ * Invalid ones are recorded as such, so that the indices match the ones of the array.
+ *
+ * @param perfdata The performance data of a check result, must be frozen.
+ */
+PerfdataMetrics::PerfdataMetrics(const Array::Ptr& perfdata)
+	: m_Source(perfdata)
+{
+	ObjectLock olock (perfdata);
+	size_t length = perfdata->GetLength();
+
+	m_Flags.reserve(length);
+	m_Labels.reserve(length);
+	m_Units.reserve(length);
+	m_Values.reserve(length);
+	m_Crits.reserve(length);
+	m_Warns.reserve(length);
+	m_Mins.reserve(length);
+	m_Maxs.reserve(length);
+
+	for (const Value& val : perfdata) {
+		try {
+			if (val.IsObjectType<PerfdataValue>()) {
+				Add(PerfdataValue::Ptr(val));
+			} else if (val.IsString()) {
+				/* The array is frozen, so the string stays where it is. */
+				Add(ToStringView(val.Get<String>()));
+			} else {
+				Add(ToStringView(m_Strings.emplace_back(static_cast<String>(val))));
+			}
+		} catch (const std::exception&) {
+			AddInvalid();
+		}
+	}
+}
+
+/**
+ * Parses a single performance data value, e.g. "'free space'=12.5GB;50;80;0;100", without copying it.
+ *
+ * @param perfdata The value, the label of which is referenced and must outlive this object.
+ */
+void PerfdataMetrics::Add(std::string_view perfdata)
 {
-	if (tokens.size() > index && tokens[index] != "U" && tokens[index] != "" && tokens[index].FindFirstNotOf("+-0123456789.eE") == String::NPos)
-		return Convert::ToDouble(tokens[index]);
-	else {
-		if (tokens.size() > index && tokens[index] != "")
+	size_t eqp = perfdata.rfind('=');
+
+	if (eqp == std::string_view::npos)
+		ThrowInvalidPerfdata(perfdata);
+
+	std::string_view label = perfdata.substr(0, eqp);
+
+	if (label.size() > 2 && label.front() == '\'' && label.back() == '\'')
+		label = label.substr(1, label.size() - 2);
+
+	size_t spq = perfdata.find(' ', eqp);
+
+	if (spq == std::string_view::npos)
+		spq = perfdata.size();
+
+	std::string_view valueStr = perfdata.substr(eqp + 1, spq - eqp - 1);
+
+	if (valueStr.find(',') != std::string_view::npos)
+		ThrowInvalidPerfdata(perfdata);
+
+	std::string_view tokens[5];
+
+	for (auto& token : tokens) {
+		size_t semicolon = valueStr.find(';');
+
+		token = valueStr.substr(0, semicolon);
+
+		if (semicolon == std::string_view::npos)
+			break;
+
+		valueStr.remove_prefix(semicolon + 1);
+	}
+
+	// Find the position where to split value and unit. Possible values of tokens[0] include:
+	// "1000", "1.0", "1.", "-.1", "+1", "1e10", "1GB", "1e10GB", "1e10EB", "1E10EB", "1.5GB", "1.GB", "+1.E-1EW"
+	// Consider everything up to and including the last digit or decimal point as part of the value.
+	size_t pos = tokens[0].find_last_of("0123456789.");
+	if (pos != std::string_view::npos) {
+		pos++;
+	}
+
+	double value;
+	std::string_view number = tokens[0].substr(0, pos);
+
+	if (!boost::conversion::try_lexical_convert(number.data(), number.size(), value))
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Can't convert '" + std::string(number) + "' to a floating point number."));
+
+	if (!std::isfinite(value))
+		ThrowInvalidPerfdata(perfdata, " is outside of any reasonable range");
+
+	std::string_view unit;
+
+	if (pos != std::string_view::npos)
+		unit = tokens[0].substr(pos);
+
+	// UoM.Out is an empty string for "c". So set counter before parsing.
+	uint8_t flags = unit == "c" ? FlagCounter : 0;
+	double base;
+
+	{
+		const UoM *uom = nullptr;
+		std::string in (unit);
+		auto csUom (l_CsUoMs.find(in));
+
+		if (csUom == l_CsUoMs.end()) {
+			boost::algorithm::to_lower(in);
+			auto ciUom (l_CiUoMs.find(in));
+
+			if (ciUom != l_CiUoMs.end())
+				uom = &ciUom->second;
+		} else {
+			uom = &csUom->second;
+		}
+
+		if (uom) {
+			unit = uom->Out;
+			base = uom->Factor;
+		} else {
 			Log(LogDebug, "PerfdataValue")
-				<< "Ignoring unsupported perfdata " << description << " range, value: '" << tokens[index] << "'.";
-		return Empty;
+				<< "Invalid performance data unit: " << unit;
+
+			unit = "";
+			base = 1.0;
+		}
 	}
+
+	double crit = 0, warn = 0, min = 0, max = 0;
+
+	if (ParseWarnCritMinMaxToken(tokens[1], "warning", warn))
+		flags |= FlagWarn;
+
+	if (ParseWarnCritMinMaxToken(tokens[2], "critical", crit))
+		flags |= FlagCrit;
+
+	if (ParseWarnCritMinMaxToken(tokens[3], "minimum", min))
+		flags |= FlagMin;
+
+	if (ParseWarnCritMinMaxToken(tokens[4], "maximum", max))
+		flags |= FlagMax;
+
+	m_Flags.emplace_back(flags);
+	m_Labels.emplace_back(label);
+	m_Units.emplace_back(unit);
+	m_Values.emplace_back(value * base);
+	m_Crits.emplace_back(crit * base);
+	m_Warns.emplace_back(warn * base);
+	m_Mins.emplace_back(min * base);
+	m_Maxs.emplace_back(max * base);
+}
+
+void PerfdataMetrics::Add(const PerfdataValue::Ptr& pdv)
+{
+	uint8_t flags = pdv->GetCounter() ? FlagCounter : 0;
+	double thresholds[4] = { 0, 0, 0, 0 };
+	Value values[4] = { pdv->GetCrit(), pdv->GetWarn(), pdv->GetMin(), pdv->GetMax() };
+	Flag valueFlags[4] = { FlagCrit, FlagWarn, FlagMin, FlagMax };
+
+	for (int i = 0; i < 4; i++) {
+		if (!values[i].IsEmpty()) {
+			thresholds[i] = values[i];
+			flags |= valueFlags[i];
+		}
+	}
+
+	m_Flags.emplace_back(flags);
+	m_Labels.emplace_back(ToStringView(m_Strings.emplace_back(pdv->GetLabel())));
+	m_Units.emplace_back(ToStringView(m_Strings.emplace_back(pdv->GetUnit())));
+	m_Values.emplace_back(pdv->GetValue());
+	m_Crits.emplace_back(thresholds[0]);
+	m_Warns.emplace_back(thresholds[1]);
+	m_Mins.emplace_back(thresholds[2]);
+	m_Maxs.emplace_back(thresholds[3]);
+}
+
+void PerfdataMetrics::AddInvalid()
+{
+	m_Flags.emplace_back(FlagInvalid);
+	m_Labels.emplace_back();
+	m_Units.emplace_back();
+	m_Values.emplace_back(0);
+	m_Crits.emplace_back(0);
+	m_Warns.emplace_back(0);
+	m_Mins.emplace_back(0);
+	m_Maxs.emplace_back(0);
+}
+
+/**
+ * @returns The performance data this was created from, nullptr for values added one by one.
+ */
+const Array::Ptr& PerfdataMetrics::GetSource() const
+{
+	return m_Source;
+}
+
+size_t PerfdataMetrics::GetLength() const
+{
+	return m_Flags.size();
+}
+
+bool PerfdataMetrics::IsValid(size_t index) const
+{
+	return !(m_Flags[index] & FlagInvalid);
+}
+
+std::string_view PerfdataMetrics::GetLabel(size_t index) const
+{
+	return m_Labels[index];
+}
+
+double PerfdataMetrics::GetValue(size_t index) const
+{
+	return m_Values[index];
+}
+
+bool PerfdataMetrics::GetCounter(size_t index) const
+{
+	return m_Flags[index] & FlagCounter;
+}
+
+std::string_view PerfdataMetrics::GetUnit(size_t index) const
+{
+	return m_Units[index];
+}
+
+Value PerfdataMetrics::GetThreshold(const std::vector<double>& thresholds, Flag flag, size_t index) const
+{
+	if (m_Flags[index] & flag)
+		return thresholds[index];
+
+	return Empty;
+}
+
+Value PerfdataMetrics::GetCrit(size_t index) const
+{
+	return GetThreshold(m_Crits, FlagCrit, index);
+}
+
+Value PerfdataMetrics::GetWarn(size_t index) const
+{
+	return GetThreshold(m_Warns, FlagWarn, index);
+}
+
+Value PerfdataMetrics::GetMin(size_t index) const
+{
+	return GetThreshold(m_Mins, FlagMin, index);
+}
+
+Value PerfdataMetrics::GetMax(size_t index) const
+{
+	return GetThreshold(m_Maxs, FlagMax, index);
+}
+
+/**
+ * Creates a PerfdataValue object of a valid value, e.g. for the DSL.
+ */
+PerfdataValue::Ptr PerfdataMetrics::GetPerfdataValue(size_t index) const
+{
+	return new PerfdataValue(String(m_Labels[index].begin(), m_Labels[index].end()), m_Values[index], GetCounter(index),
+		String(m_Units[index].begin(), m_Units[index].end()), GetWarn(index), GetCrit(index), GetMin(index), GetMax(index));
 }
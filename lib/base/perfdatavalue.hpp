@@ -6,6 +6,11 @@
 
 #include "base/i2-base.hpp"
 #include "base/perfdatavalue-ti.hpp"
+#include "base/array.hpp"
+#include <cstdint>
+#include <deque>
+#include <string_view>
+#include <vector>
 
 namespace icinga
 {
@@ -29,9 +34,68 @@ public:
 	static PerfdataValue::Ptr Parse(const String& perfdata);
 	String Format() const;
 
+};
+
+/**
+ * The parsed performance data of a check result, stored as one array per attribute.
+ *
+ * Labels point into the (frozen) performance data array instead of being copied, and the
+ * units into the static UoM tables. PerfdataValue objects are only created on demand.
+ *
+ * @ingroup base
+ */
+class PerfdataMetrics
+{
+public:
+	PerfdataMetrics() = default;
+	explicit PerfdataMetrics(const Array::Ptr& perfdata);
+
+	PerfdataMetrics(const PerfdataMetrics&) = delete;
+	PerfdataMetrics& operator=(const PerfdataMetrics&) = delete;
+
+	void Add(std::string_view perfdata);
+	void Add(const PerfdataValue::Ptr& pdv);
+
+	const Array::Ptr& GetSource() const;
+
+	size_t GetLength() const;
+	bool IsValid(size_t index) const;
+	std::string_view GetLabel(size_t index) const;
+	double GetValue(size_t index) const;
+	bool GetCounter(size_t index) const;
+	std::string_view GetUnit(size_t index) const;
+	Value GetCrit(size_t index) const;
+	Value GetWarn(size_t index) const;
+	Value GetMin(size_t index) const;
+	Value GetMax(size_t index) const;
+
+	PerfdataValue::Ptr GetPerfdataValue(size_t index) const;
+
 private:
-	static Value ParseWarnCritMinMaxToken(const std::vector<String>& tokens,
-		std::vector<String>::size_type index, const String& description);
+	enum Flag : uint8_t
+	{
+		FlagInvalid = 1,
+		FlagCounter = 2,
+		FlagCrit = 4,
+		FlagWarn = 8,
+		FlagMin = 16,
+		FlagMax = 32
+	};
+
+	Array::Ptr m_Source;
+	std::deque<String> m_Strings; /**< Labels and units of PerfdataValue objects. */
+
+	std::vector<uint8_t> m_Flags;
+	std::vector<std::string_view> m_Labels;
+	std::vector<std::string_view> m_Units;
+	std::vector<double> m_Values;
+	std::vector<double> m_Crits;
+	std::vector<double> m_Warns;
+	std::vector<double> m_Mins;
+	std::vector<double> m_Maxs;
+
+	void AddInvalid();
+	Value GetThreshold(const std::vector<double>& thresholds, Flag flag, size_t index) const;
 };
 
 }
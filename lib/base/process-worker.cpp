@@ -0,0 +1,589 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/process-worker.hpp"
+
+#ifndef _WIN32
+#include "base/array.hpp"
+#include "base/convert.hpp"
+#include "base/exception.hpp"
+#include "base/json.hpp"
+#include "base/logger.hpp"
+#include "base/objectlock.hpp"
+#include "base/utility.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace icinga;
+
+/**
+ * Creates a worker pool, its threads and workers are started by Start().
+ *
+ * @param worker The command line of the worker processes.
+ * @param size The number of worker processes.
+ */
+ProcessWorkerPool::ProcessWorkerPool(Process::Arguments worker, size_t size)
+	: m_Worker(std::move(worker)), m_Size(size)
+{ }
+
+ProcessWorkerPool::~ProcessWorkerPool()
+{
+	Stop();
+}
+
+void ProcessWorkerPool::Start()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (m_Started || m_Stopped)
+		return;
+
+	if (pipe(m_WakeupFDs) < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("pipe")
+			<< boost::errinfo_errno(errno));
+	}
+
+	Utility::SetCloExec(m_WakeupFDs[0]);
+	Utility::SetCloExec(m_WakeupFDs[1]);
+
+	for (size_t i = 0; i < m_Size; i++) {
+		m_Threads.emplace_back([this, i]() { ThreadProc(i); });
+	}
+
+	m_Started = true;
+}
+
+/**
+ * Stops the threads, kills the workers and fails all requests which haven't been executed yet.
+ */
+void ProcessWorkerPool::Stop()
+{
+	std::deque<Request> requests;
+
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		if (m_Stopped.exchange(true))
+			return;
+
+		requests.swap(m_Requests);
+	}
+
+	m_CV.notify_all();
+
+	if (m_Started) {
+		/* Interrupts the threads which are waiting for their workers. */
+		(void)write(m_WakeupFDs[1], "T", 1);
+
+		for (auto& thread : m_Threads) {
+			thread.join();
+		}
+
+		(void)close(m_WakeupFDs[0]);
+		(void)close(m_WakeupFDs[1]);
+	}
+
+	m_Threads.clear();
+
+	for (auto& request : requests) {
+		if (request.Callback) {
+			ProcessResult pr = MakeErrorResult(request.Enqueued, "<Worker pool stopped.>");
+
+			Utility::QueueAsyncCallback([callback = std::move(request.Callback), pr]() { callback(pr); });
+		}
+	}
+}
+
+/**
+ * Executes a command with the next idle worker and calls the callback with its result, just like Process::Run().
+ *
+ * @param arguments The command line.
+ * @param extraEnvironment Additional environment variables for the command.
+ * @param timeout The timeout in seconds from now on, including the time the request is queued, 0 for none.
+ * @param adjustPriority Whether the worker should lower the priority of the command, see Process::SetAdjustPriority().
+ * @param callback The callback.
+ */
+void ProcessWorkerPool::Run(Process::Arguments arguments, Dictionary::Ptr extraEnvironment, double timeout, bool adjustPriority,
+	std::function<void(const ProcessResult&)> callback)
+{
+	double now = Utility::GetTime();
+	String error;
+
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		if (m_Stopped) {
+			error = "<Worker pool stopped.>";
+		} else if (m_Requests.size() >= m_Size * MaxQueuedPerWorker) {
+			/* The workers can't keep up, queueing even more checks would only make all of them time out. */
+			error = "<Worker pool queue full.>";
+
+			if (!m_QueueFull) {
+				m_QueueFull = true;
+
+				Log(LogWarning, "ProcessWorkerPool")
+					<< "Rejecting commands, " << m_Requests.size() << " commands are already waiting for the "
+					<< m_Size << " workers " << Process::PrettyPrintArguments(m_Worker);
+			}
+		} else {
+			m_QueueFull = false;
+			m_Requests.push_back({ std::move(arguments), std::move(extraEnvironment), timeout, adjustPriority, now, std::move(callback) });
+			m_CV.notify_one();
+			return;
+		}
+	}
+
+	if (callback) {
+		ProcessResult pr = MakeErrorResult(now, error);
+
+		Utility::QueueAsyncCallback([callback = std::move(callback), pr]() { callback(pr); });
+	}
+}
+
+/**
+ * How long a worker may take to respond after the timeout. Process kills the plugin's process group
+ * once it has ignored SIGTERM for a tenth of the timeout, the worker should be done by then.
+ *
+ * @param timeout The time which is left of the timeout when the request is sent to the worker.
+ */
+double ProcessWorkerPool::GetGracePeriod(double timeout)
+{
+	return timeout * 0.1 + 1;
+}
+
+ProcessResult ProcessWorkerPool::MakeErrorResult(double executionStart, const String& output)
+{
+	ProcessResult pr;
+	pr.PID = -1;
+	pr.ExecutionStart = executionStart;
+	pr.ExecutionEnd = Utility::GetTime();
+	pr.ExitStatus = 128;
+	pr.Output = output;
+
+	return pr;
+}
+
+void ProcessWorkerPool::ThreadProc(size_t index)
+{
+	Utility::SetThreadName("Process Worker " + Convert::ToString(index));
+
+	Worker worker;
+
+	for (;;) {
+		Request request;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_CV.wait(lock, [this]() { return m_Stopped || !m_Requests.empty(); });
+
+			if (m_Stopped)
+				break;
+
+			request = std::move(m_Requests.front());
+			m_Requests.pop_front();
+		}
+
+		ProcessResult pr = Execute(worker, request);
+
+		if (request.Callback)
+			Utility::QueueAsyncCallback([callback = std::move(request.Callback), pr]() { callback(pr); });
+	}
+
+	StopWorker(worker);
+}
+
+ProcessResult ProcessWorkerPool::Execute(Worker& worker, const Request& request)
+{
+	ProcessResult pr;
+	pr.PID = -1;
+	pr.ExecutionStart = request.Enqueued;
+	pr.ExitStatus = 128;
+
+	double now = Utility::GetTime();
+	double deadline = request.Timeout > 0
+		? request.Enqueued + request.Timeout
+		: std::numeric_limits<double>::infinity();
+
+	if (deadline <= now) {
+		Log(LogWarning, "ProcessWorkerPool")
+			<< "Timeout of " << request.Timeout << " seconds exceeded while waiting for a worker to execute "
+			<< Process::PrettyPrintArguments(request.Arguments);
+
+		pr.ExecutionEnd = now;
+		pr.Output = "<Timeout exceeded.>";
+
+		return pr;
+	}
+
+	try {
+		/* An idle worker has nothing to say, it has either exited or is out of sync with us. */
+		if (worker.PID != -1 && WaitForWorker(worker, POLLIN, now)) {
+			Log(LogWarning, "ProcessWorkerPool")
+				<< "Worker PID " << worker.PID << " (" << Process::PrettyPrintArguments(m_Worker)
+				<< ") terminated or wrote unexpected output, restarting it";
+
+			StopWorker(worker);
+		}
+
+		if (worker.PID == -1)
+			StartWorker(worker);
+
+		pr.PID = worker.PID;
+
+		Dictionary::Ptr message = new Dictionary({
+			{ "command", Array::FromVector(request.Arguments) },
+			{ "env", request.ExtraEnvironment ? request.ExtraEnvironment : Dictionary::Ptr(new Dictionary()) },
+			{ "timeout", request.Timeout > 0 ? deadline - now : 0 },
+			{ "adjust_priority", request.AdjustPriority }
+		});
+
+		String response;
+		double killDeadline = deadline + GetGracePeriod(deadline - now);
+
+		if (WriteMessage(worker, JsonEncode(message), killDeadline) && ReadMessage(worker, &response, killDeadline)) {
+			Value result = JsonDecode(response);
+
+			if (!result.IsObjectType<Dictionary>() || !Dictionary::Ptr(result)->Contains("exit_status"))
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Response from worker is missing the exit status."));
+
+			pr.ExitStatus = Dictionary::Ptr(result)->Get("exit_status");
+			pr.Output = Dictionary::Ptr(result)->Get("output");
+		} else if (m_Stopped) {
+			pr.Output = "<Worker pool stopped.>";
+			StopWorker(worker);
+		} else {
+			Log(LogWarning, "ProcessWorkerPool")
+				<< "Killing worker PID " << worker.PID << " (" << Process::PrettyPrintArguments(m_Worker)
+				<< ") which didn't respond within the timeout of " << request.Timeout << " seconds (including "
+				<< (now - request.Enqueued) << " seconds in the queue) and the grace period executing "
+				<< Process::PrettyPrintArguments(request.Arguments);
+
+			pr.Output = "<Timeout exceeded.>";
+			StopWorker(worker);
+		}
+	} catch (const std::exception& ex) {
+		String error = DiagnosticInformation(ex, false);
+
+		Log(LogWarning, "ProcessWorkerPool")
+			<< "Worker " << Process::PrettyPrintArguments(m_Worker) << " failed to execute "
+			<< Process::PrettyPrintArguments(request.Arguments) << ": " << error;
+
+		pr.PID = worker.PID;
+		pr.ExitStatus = 128;
+		pr.Output = "<Worker failed: " + error + ">";
+		StopWorker(worker);
+	}
+
+	pr.ExecutionEnd = Utility::GetTime();
+
+	return pr;
+}
+
+void ProcessWorkerPool::StartWorker(Worker& worker)
+{
+	int fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("socketpair")
+			<< boost::errinfo_errno(errno));
+	}
+
+	Utility::SetCloExec(fds[0]);
+	Utility::SetCloExec(fds[1]);
+
+	pid_t pid = Process::SpawnWorker(m_Worker, fds[1]);
+	int error = errno;
+
+	(void)close(fds[1]);
+
+	if (pid == -1) {
+		(void)close(fds[0]);
+
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("posix_spawn")
+			<< boost::errinfo_errno(error));
+	}
+
+	Utility::SetNonBlocking(fds[0]);
+
+	worker.PID = pid;
+	worker.FD = fds[0];
+	worker.Buffer.clear();
+
+	Log(LogNotice, "ProcessWorkerPool")
+		<< "Started worker " << Process::PrettyPrintArguments(m_Worker) << ": PID " << pid;
+}
+
+void ProcessWorkerPool::StopWorker(Worker& worker)
+{
+	if (worker.FD != -1) {
+		(void)close(worker.FD);
+		worker.FD = -1;
+	}
+
+	if (worker.PID != -1) {
+		Process::KillWorker(worker.PID);
+		worker.PID = -1;
+	}
+
+	worker.Buffer.clear();
+}
+
+/**
+ * Waits until the worker's FD is ready for the specified events.
+ *
+ * @returns false if the deadline has passed or the pool has been stopped, true otherwise.
+ */
+bool ProcessWorkerPool::WaitForWorker(const Worker& worker, short events, double deadline)
+{
+	pollfd pfds[2];
+	pfds[0].fd = worker.FD;
+	pfds[0].events = events;
+	pfds[1].fd = m_WakeupFDs[0];
+	pfds[1].events = POLLIN;
+
+	for (;;) {
+		int timeout = -1;
+
+		if (deadline != std::numeric_limits<double>::infinity())
+			timeout = static_cast<int>(std::max(0.0, std::ceil((deadline - Utility::GetTime()) * 1000)));
+
+		int rc = poll(pfds, 2, timeout);
+
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+
+			BOOST_THROW_EXCEPTION(posix_error()
+				<< boost::errinfo_api_function("poll")
+				<< boost::errinfo_errno(errno));
+		}
+
+		if (pfds[1].revents)
+			return false;
+
+		if (pfds[0].revents)
+			return true;
+
+		if (rc == 0)
+			return false;
+	}
+}
+
+/**
+ * Sends a message to the worker, framed as a netstring.
+ *
+ * @returns false if the deadline has passed or the pool has been stopped, true otherwise.
+ */
+bool ProcessWorkerPool::WriteMessage(Worker& worker, const String& message, double deadline)
+{
+	String frame = Convert::ToString(message.GetLength()) + ":" + message + ",";
+	const char *data = frame.CStr();
+	size_t length = frame.GetLength();
+
+	while (length > 0) {
+		ssize_t rc = write(worker.FD, data, length);
+
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				BOOST_THROW_EXCEPTION(posix_error()
+					<< boost::errinfo_api_function("write")
+					<< boost::errinfo_errno(errno));
+			}
+
+			if (!WaitForWorker(worker, POLLOUT, deadline))
+				return false;
+
+			continue;
+		}
+
+		data += rc;
+		length -= rc;
+	}
+
+	return true;
+}
+
+/**
+ * Reads a netstring-framed message from the worker.
+ *
+ * @returns false if the deadline has passed or the pool has been stopped, true otherwise.
+ */
+bool ProcessWorkerPool::ReadMessage(Worker& worker, String *message, double deadline)
+{
+	for (;;) {
+		if (ParseMessage(worker.Buffer, message))
+			return true;
+
+		char buffer[4096];
+		ssize_t rc = read(worker.FD, buffer, sizeof(buffer));
+
+		if (rc > 0) {
+			worker.Buffer.append(buffer, rc);
+			continue;
+		}
+
+		if (rc == 0)
+			BOOST_THROW_EXCEPTION(std::runtime_error("Worker closed the connection."));
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			BOOST_THROW_EXCEPTION(posix_error()
+				<< boost::errinfo_api_function("read")
+				<< boost::errinfo_errno(errno));
+		}
+
+		if (!WaitForWorker(worker, POLLIN, deadline))
+			return false;
+	}
+}
+
+/**
+ * Takes the first netstring-framed message out of the buffer.
+ *
+ * @returns false if the buffer doesn't contain a complete message yet.
+ */
+bool ProcessWorkerPool::ParseMessage(std::string& buffer, String *message)
+{
+	size_t colon = buffer.find(':');
+
+	if (colon == std::string::npos) {
+		if (buffer.size() > 8)
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid message length."));
+
+		return false;
+	}
+
+	if (colon == 0 || buffer.find_first_not_of("0123456789") != colon)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid message length."));
+
+	size_t length = std::stoul(buffer.substr(0, colon));
+
+	if (length > MaxMessageLength)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Message exceeds the maximum length."));
+
+	if (buffer.size() <= colon + length + 1)
+		return false;
+
+	if (buffer[colon + length + 1] != ',')
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Message is missing the trailing comma."));
+
+	*message = buffer.substr(colon + 1, length);
+	buffer.erase(0, colon + length + 2);
+
+	return true;
+}
+
+/**
+ * The worker side of the protocol: Executes each request as a plugin process, just like
+ * Icinga does without a worker pool, until the input is closed.
+ *
+ * @param inFD The FD to read the requests from.
+ * @param outFD The FD to write the responses to.
+ *
+ * @returns An exit status.
+ */
+int ProcessWorkerPool::Serve(int inFD, int outFD)
+{
+	std::string input;
+
+	try {
+		for (;;) {
+			String message;
+
+			while (!ParseMessage(input, &message)) {
+				char buffer[4096];
+				ssize_t rc = read(inFD, buffer, sizeof(buffer));
+
+				if (rc < 0) {
+					if (errno == EINTR)
+						continue;
+
+					BOOST_THROW_EXCEPTION(posix_error()
+						<< boost::errinfo_api_function("read")
+						<< boost::errinfo_errno(errno));
+				}
+
+				if (rc == 0) {
+					if (!input.empty())
+						BOOST_THROW_EXCEPTION(std::runtime_error("Input ends with an incomplete message."));
+
+					return 0;
+				}
+
+				input.append(buffer, rc);
+			}
+
+			Value value = JsonDecode(message);
+
+			if (!value.IsObjectType<Dictionary>())
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Request is not an object."));
+
+			Dictionary::Ptr request = value;
+			Array::Ptr command = request->Get("command");
+
+			if (!command || command->GetLength() == 0)
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Request is missing the command."));
+
+			Process::Arguments arguments;
+
+			{
+				ObjectLock olock(command);
+				for (const Value& argument : command) {
+					arguments.emplace_back(argument);
+				}
+			}
+
+			Process::Ptr process = new Process(std::move(arguments), request->Get("env"));
+			process->SetTimeout(request->Get("timeout"));
+			process->SetAdjustPriority(request->Get("adjust_priority").ToBool());
+			process->Run();
+
+			auto& pr (process->WaitForResult());
+
+			String response = JsonEncode(new Dictionary({
+				{ "exit_status", pr.ExitStatus },
+				{ "output", pr.Output }
+			}));
+
+			String frame = Convert::ToString(response.GetLength()) + ":" + response + ",";
+			const char *data = frame.CStr();
+			size_t length = frame.GetLength();
+
+			while (length > 0) {
+				ssize_t rc = write(outFD, data, length);
+
+				if (rc < 0) {
+					if (errno == EINTR)
+						continue;
+
+					BOOST_THROW_EXCEPTION(posix_error()
+						<< boost::errinfo_api_function("write")
+						<< boost::errinfo_errno(errno));
+				}
+
+				data += rc;
+				length -= rc;
+			}
+		}
+	} catch (const std::exception& ex) {
+		Log(LogCritical, "ProcessWorkerPool")
+			<< "Worker failed: " << DiagnosticInformation(ex, false);
+
+		return 1;
+	}
+}
+
+#endif /* _WIN32 */
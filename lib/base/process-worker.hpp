@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include "base/process.hpp"
+
+#ifndef _WIN32
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * A pool of long-lived worker processes which execute commands on our behalf,
+ * so executing a command doesn't need a fork(2) and exec(2) of its own.
+ *
+ * Requests and responses are JSON objects framed as netstrings which are exchanged
+ * over the worker's stdin and stdout. Every worker handles one request at a time:
+ *
+ *   -> {"command":["check_foo","-H","localhost"],"env":{"FOO":"bar"},"timeout":60,"adjust_priority":true}
+ *   <- {"exit_status":0,"output":"OK - foo is fine|time=0.1s"}
+ *
+ * The timeout starts once the request is queued, the worker gets the time which is left of it.
+ * Plugins run in sessions of their own, so killing a worker doesn't kill them. Workers have to kill
+ * plugins which exceed the timeout on their own, like Process does, and get a grace period for that.
+ * Workers are killed and replaced if they exceed the grace period or violate the protocol.
+ * Serve() implements the worker side by executing the commands as plugin processes,
+ * see the "internal process-worker" CLI command.
+ *
+ * @ingroup base
+ */
+class ProcessWorkerPool final : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(ProcessWorkerPool);
+
+	static const size_t MaxMessageLength = 16 * 1024 * 1024;
+	static const size_t MaxQueuedPerWorker = 64;
+
+	static double GetGracePeriod(double timeout);
+
+	ProcessWorkerPool(Process::Arguments worker, size_t size);
+	~ProcessWorkerPool() override;
+
+	void Start();
+	void Stop();
+
+	void Run(Process::Arguments arguments, Dictionary::Ptr extraEnvironment, double timeout, bool adjustPriority,
+		std::function<void(const ProcessResult&)> callback);
+
+	static int Serve(int inFD, int outFD);
+
+private:
+	struct Request
+	{
+		Process::Arguments Arguments;
+		Dictionary::Ptr ExtraEnvironment;
+		double Timeout;
+		bool AdjustPriority;
+		double Enqueued;
+		std::function<void(const ProcessResult&)> Callback;
+	};
+
+	struct Worker
+	{
+		pid_t PID = -1;
+		int FD = -1;
+		std::string Buffer; /**< Data which has been read but doesn't form a complete message yet. */
+	};
+
+	Process::Arguments m_Worker;
+	size_t m_Size;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_CV;
+	std::deque<Request> m_Requests;
+	std::atomic<bool> m_Stopped{false};
+	bool m_Started{false};
+	bool m_QueueFull{false}; /**< Whether requests have been rejected since the last one has been queued. */
+	int m_WakeupFDs[2]{-1, -1}; /**< Becomes readable once the pool is stopped. */
+	std::vector<std::thread> m_Threads;
+
+	void ThreadProc(size_t index);
+	ProcessResult Execute(Worker& worker, const Request& request);
+
+	void StartWorker(Worker& worker);
+	void StopWorker(Worker& worker);
+
+	bool WaitForWorker(const Worker& worker, short events, double deadline);
+	bool WriteMessage(Worker& worker, const String& message, double deadline);
+	bool ReadMessage(Worker& worker, String *message, double deadline);
+
+	static bool ParseMessage(std::string& buffer, String *message);
+	static ProcessResult MakeErrorResult(double executionStart, const String& output);
+};
+
+}
+
+#endif /* _WIN32 */
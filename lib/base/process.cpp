@@ -12,6 +12,8 @@
 #include "base/utility.hpp"
 #include "base/scriptglobal.hpp"
 #include "base/json.hpp"
+#include "base/configuration.hpp"
+#include "base/io-uring.hpp"
 #include <boost/algorithm/string/join.hpp>
 #include <boost/thread/once.hpp>
 #include <thread>
@@ -26,6 +28,24 @@
 #	include <unistd.h>
 #endif /* _WIN32 */
 
+#ifdef __linux__
+#	include "base/timing-wheel.hpp"
+#	include <cmath>
+#	include <limits>
+#	include <memory>
+#	include <sys/epoll.h>
+#endif /* __linux__ */
+
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+#	include <spawn.h>
+#	include <sys/resource.h>
+#	include <sys/wait.h>
+#endif /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+
+#ifdef HAVE_SYS_PIDFD_OPEN
+#	include <sys/syscall.h>
+#endif /* HAVE_SYS_PIDFD_OPEN */
+
 using namespace icinga;
 
 #define IOTHREADS 4
@@ -42,6 +62,14 @@ static std::mutex l_ProcessControlMutex;
 static int l_ProcessControlFD = -1;
 static pid_t l_ProcessControlPID;
 #endif /* _WIN32 */
+#ifdef __linux__
+static int l_EpollFDs[IOTHREADS];
+static std::unique_ptr<TimingWheel<Process::ProcessHandle>> l_Deadlines[IOTHREADS];
+#endif /* __linux__ */
+#ifdef HAVE_IO_URING
+static std::unique_ptr<IoUring> l_Rings[IOTHREADS];
+static double l_RingWaitUntil[IOTHREADS];
+#endif /* HAVE_IO_URING */
 static boost::once_flag l_ProcessOnceFlag = BOOST_ONCE_INIT;
 static boost::once_flag l_SpawnHelperOnceFlag = BOOST_ONCE_INIT;
 
@@ -51,7 +79,7 @@ Process::Process(Process::Arguments arguments, Dictionary::Ptr extraEnvironment)
 #ifdef _WIN32
 	, m_ReadPending(false), m_ReadFailed(false), m_Overlapped()
 #else /* _WIN32 */
-	, m_SentSigterm(false)
+	, m_SentSigterm(false), m_SpawnedDirectly(false), m_PidFD(-1), m_Exited(false), m_OutputEOF(false), m_RingOutput(false)
 #endif /* _WIN32 */
 	, m_AdjustPriority(false), m_ResultAvailable(false)
 {
@@ -64,6 +92,9 @@ Process::~Process()
 {
 #ifdef _WIN32
 	CloseHandle(m_Overlapped.hEvent);
+#else /* _WIN32 */
+	if (m_PidFD != -1)
+		(void)close(m_PidFD);
 #endif /* _WIN32 */
 }
 
@@ -367,6 +398,7 @@ static void StartSpawnProcessHelper()
 	l_ProcessControlPID = pid;
 }
 
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
 static pid_t ProcessSpawn(const std::vector<String>& arguments, const Dictionary::Ptr& extraEnvironment, bool adjustPriority, int fds[3])
 {
 	Dictionary::Ptr request = new Dictionary({
@@ -426,6 +458,7 @@ static pid_t ProcessSpawn(const std::vector<String>& arguments, const Dictionary
 
 	return response->Get("rc");
 }
+#endif /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
 
 static int ProcessKill(pid_t pid, int signum)
 {
@@ -493,9 +526,119 @@ static int ProcessWaitPID(pid_t pid, int *status)
 
 void Process::InitializeSpawnHelper()
 {
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
 	if (l_ProcessControlFD == -1)
 		StartSpawnProcessHelper();
+#endif /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+}
+
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+/**
+ * Spawns a process from this process rather than from the spawn helper.
+ *
+ * posix_spawn(3) uses clone(CLONE_VFORK) on Linux, so unlike fork(2) this doesn't
+ * copy the page tables of our address space and is safe to use from any thread.
+ * The child is set up just like ProcessSpawnImpl() does it.
+ *
+ * @param arguments The command line.
+ * @param extraEnvironment Additional environment variables.
+ * @param adjustPriority Whether to increase the niceness of the child.
+ * @param fds The FDs which should become the child's stdin, stdout and stderr.
+ * @returns The PID of the child or -1 (and errno set) on failure.
+ */
+static pid_t ProcessSpawnDirect(const std::vector<String>& arguments, const Dictionary::Ptr& extraEnvironment, bool adjustPriority, int fds[3])
+{
+	std::vector<char *> argv;
+	argv.reserve(arguments.size() + 1u);
+
+	for (auto& argument : arguments) {
+		argv.emplace_back(const_cast<char *>(argument.CStr()));
+	}
+
+	argv.emplace_back(nullptr);
+
+	std::vector<String> env;
+
+	for (char **envVar = environ; *envVar; envVar++) {
+		const char *eq = strchr(*envVar, '=');
+
+		if (!eq)
+			continue;
+
+		String key (static_cast<const char *>(*envVar), eq);
+
+		if (key == "NOTIFY_SOCKET" || key == "LC_NUMERIC" || (extraEnvironment && extraEnvironment->Contains(key)))
+			continue;
+
+		env.emplace_back(*envVar);
+	}
+
+	if (!extraEnvironment || !extraEnvironment->Contains("LC_NUMERIC"))
+		env.emplace_back("LC_NUMERIC=C");
+
+	if (extraEnvironment) {
+		ObjectLock oLock (extraEnvironment);
+
+		for (auto& kv : extraEnvironment) {
+			env.emplace_back(kv.first + "=" + Convert::ToString(kv.second));
+		}
+	}
+
+	std::vector<char *> envp;
+	envp.reserve(env.size() + 1u);
+
+	for (auto& envVar : env) {
+		envp.emplace_back(const_cast<char *>(envVar.CStr()));
+	}
+
+	envp.emplace_back(nullptr);
+
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init(&fileActions);
+	for (int fd = STDIN_FILENO; fd <= STDERR_FILENO; fd++) {
+		if (fds[fd] != fd)
+			posix_spawn_file_actions_adddup2(&fileActions, fds[fd], fd);
+	}
+
+	posix_spawn_file_actions_addclosefrom_np(&fileActions, STDERR_FILENO + 1);
+
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+
+	sigset_t mask;
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attr, &mask);
+
+	sigset_t defaultSignals;
+	sigfillset(&defaultSignals);
+	posix_spawnattr_setsigdefault(&attr, &defaultSignals);
+
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+	pid_t pid;
+	int rc = posix_spawnp(&pid, argv[0], &fileActions, &attr, argv.data(), envp.data());
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&fileActions);
+
+	if (rc) {
+		errno = rc;
+		return -1;
+	}
+
+	if (adjustPriority) {
+		/* posix_spawn(3) has no equivalent of nice(2), so do it from the outside. The child
+		 * runs with our own niceness until it gets here which is only a few microseconds. */
+		errno = 0;
+		int prio = getpriority(PRIO_PROCESS, 0);
+
+		if (prio != -1 || errno == 0)
+			(void)setpriority(PRIO_PROCESS, pid, std::min(prio + 5, 19));
+	}
+
+	return pid;
 }
+#endif /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
 #endif /* _WIN32 */
 
 static void InitializeProcess()
@@ -532,11 +675,124 @@ static void InitializeProcess()
 
 INITIALIZE_ONCE(InitializeProcess);
 
+#ifdef __linux__
+/**
+ * Identifies an FD in the epoll set of an IO thread. The lowest bit tells pidfds and output FDs apart.
+ */
+static inline uint64_t EpollTag(int fd, bool pidFD)
+{
+	return (static_cast<uint64_t>(fd) << 1u) | (pidFD ? 1u : 0u);
+}
+
+static void EpollAdd(int tid, int fd, bool pidFD)
+{
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.u64 = EpollTag(fd, pidFD);
+
+	if (epoll_ctl(l_EpollFDs[tid], EPOLL_CTL_ADD, fd, &event) < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+			<< boost::errinfo_api_function("epoll_ctl")
+			<< boost::errinfo_errno(errno));
+	}
+}
+
+/**
+ * Removes an FD from the epoll set of an IO thread and closes it.
+ *
+ * Closing the FD alone isn't enough, the registration lives as long as the open file
+ * description which a child that is just being spawned might still have a reference to.
+ */
+static void EpollClose(int tid, int fd)
+{
+	(void)epoll_ctl(l_EpollFDs[tid], EPOLL_CTL_DEL, fd, nullptr);
+	(void)close(fd);
+}
+#endif /* __linux__ */
+
+#ifdef HAVE_IO_URING
+/**
+ * The kinds of io_uring requests of an IO thread, stored in the lowest two bits of their user data.
+ */
+enum IoUringRequest : uint64_t
+{
+	IoUringRead = 0,
+	IoUringPidFD = 1,
+	IoUringWakeup = 2,
+	IoUringCancel = 3
+};
+
+static const uint16_t l_IoUringBufferGroup = 0;
+
+/**
+ * Identifies an io_uring request by the process it belongs to. Unlike FDs, PIDs are only reused
+ * after wrapping around, so completions of cancelled requests can't be mistaken for new ones.
+ */
+static inline uint64_t IoUringTag(Process::ProcessHandle process, IoUringRequest request)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(process)) << 2u) | request;
+}
+#endif /* HAVE_IO_URING */
+
 void Process::ThreadInitialize()
 {
+#ifdef HAVE_IO_URING
+	if (Configuration::ProcessEventEngine == "io_uring") {
+		try {
+			for (auto& ring : l_Rings) {
+				ring.reset(new IoUring(1024, 16384));
+				ring->RegisterBuffers(l_IoUringBufferGroup, 256, 4096);
+			}
+
+			Log(LogNotice, "Process", "Using io_uring to collect the output of processes.");
+		} catch (const std::exception& ex) {
+			Log(LogWarning, "Process")
+				<< "Can't use io_uring, falling back to epoll: " << DiagnosticInformation(ex, false);
+
+			for (auto& ring : l_Rings) {
+				ring.reset();
+			}
+		}
+	}
+#else /* HAVE_IO_URING */
+	if (Configuration::ProcessEventEngine == "io_uring")
+		Log(LogWarning, "Process", "This build doesn't support io_uring, falling back to the default event engine.");
+#endif /* HAVE_IO_URING */
+
+#ifdef __linux__
+	/* The epoll instances must not be shared with the processes we've been forked from. */
+	for (int tid = 0; tid < IOTHREADS; tid++) {
+		l_Deadlines[tid].reset(new TimingWheel<Process::ProcessHandle>(0.01, Utility::GetTime()));
+
+#	ifdef HAVE_IO_URING
+		if (l_Rings[tid])
+			continue;
+#	endif /* HAVE_IO_URING */
+
+		l_EpollFDs[tid] = epoll_create1(EPOLL_CLOEXEC);
+
+		if (l_EpollFDs[tid] < 0) {
+			BOOST_THROW_EXCEPTION(posix_error()
+				<< boost::errinfo_api_function("epoll_create1")
+				<< boost::errinfo_errno(errno));
+		}
+
+		EpollAdd(tid, l_EventFDs[tid][0], false);
+	}
+#endif /* __linux__ */
+
 	/* Note to self: Make sure this runs _after_ we've daemonized. */
 	for (int tid = 0; tid < IOTHREADS; tid++) {
-		std::thread t([tid]() { IOThreadProc(tid); });
+		std::thread t([tid]() {
+#ifdef HAVE_IO_URING
+			if (l_Rings[tid]) {
+				IoUringThreadProc(tid);
+				return;
+			}
+#endif /* HAVE_IO_URING */
+
+			IOThreadProc(tid);
+		});
 		t.detach();
 	}
 }
@@ -594,6 +850,276 @@ bool Process::GetAdjustPriority() const
 	return m_AdjustPriority;
 }
 
+#ifdef __linux__
+/**
+ * Waits for the output and termination of this IO thread's processes.
+ *
+ * The FDs stay in a persistent epoll set from Run() until the process is done
+ * and the timeouts are kept in a timing wheel, so the cost of an iteration
+ * only depends on the number of processes which actually need attention.
+ */
+void Process::IOThreadProc(int tid)
+{
+	Utility::SetThreadName("ProcessIO");
+
+	auto& processes (l_Processes[tid]);
+	auto& fds (l_FDs[tid]);
+	auto& deadlines (*l_Deadlines[tid]);
+
+	auto handleEvents ([tid, &processes, &fds, &deadlines](decltype(processes.begin()) it) {
+		const Process::Ptr& process = it->second;
+
+		if (!process->DoEvents()) {
+			if (process->m_FD != -1) {
+				fds.erase(process->m_FD);
+				EpollClose(tid, process->m_FD);
+			}
+
+			if (process->m_PidFD != -1) {
+				fds.erase(process->m_PidFD);
+				EpollClose(tid, process->m_PidFD);
+				process->m_PidFD = -1;
+			}
+
+			deadlines.Erase(it->first);
+			processes.erase(it);
+			return;
+		}
+
+		if (process->m_OutputEOF && process->m_FD != -1) {
+			fds.erase(process->m_FD);
+			EpollClose(tid, process->m_FD);
+			process->m_FD = -1;
+		}
+
+		if (process->m_Timeout != 0) {
+			/* Timing wheels may fire up to one tick early, DoEvents() must see the deadline as passed. */
+			deadlines.Insert(it->first, process->m_Result.ExecutionStart + process->GetNextTimeout() + 0.01);
+		}
+	});
+
+	epoll_event events[64];
+
+	for (;;) {
+		int timeout = -1;
+
+		{
+			std::unique_lock<std::mutex> lock(l_ProcessMutex[tid]);
+
+			double next = deadlines.GetNextExpiry();
+
+			if (next != std::numeric_limits<double>::infinity())
+				timeout = std::max(0.0, std::ceil((next - Utility::GetTime()) * 1000));
+		}
+
+		int rc = epoll_wait(l_EpollFDs[tid], events, sizeof(events) / sizeof(events[0]), timeout);
+
+		if (rc < 0)
+			continue;
+
+		double now = Utility::GetTime();
+
+		std::unique_lock<std::mutex> lock(l_ProcessMutex[tid]);
+
+		for (int i = 0; i < rc; i++) {
+			int fd = events[i].data.u64 >> 1u;
+			bool isPidFD = events[i].data.u64 & 1u;
+
+			if (fd == l_EventFDs[tid][0]) {
+				char buffer[512];
+				if (read(l_EventFDs[tid][0], buffer, sizeof(buffer)) < 0)
+					Log(LogCritical, "base", "Read from event FD failed.");
+
+				continue;
+			}
+
+			auto it2 = fds.find(fd);
+
+			if (it2 == fds.end())
+				continue; /* The FD has been closed while handling a previous event. */
+
+			auto it = processes.find(it2->second);
+
+			if (it == processes.end())
+				continue; /* This should never happen. */
+
+			const Process::Ptr& process = it->second;
+
+			if (isPidFD) {
+				if (process->m_PidFD != fd)
+					continue;
+
+				/* The pidfd stays readable, so don't watch it anymore. */
+				(void)epoll_ctl(l_EpollFDs[tid], EPOLL_CTL_DEL, fd, nullptr);
+				process->m_Exited = true;
+
+				/* Still waiting for the output, e.g. a grandchild keeps the pipe open. */
+				if (!process->m_OutputEOF)
+					continue;
+			} else if (process->m_FD != fd) {
+				continue;
+			}
+
+			handleEvents(it);
+		}
+
+		deadlines.Advance(now);
+
+		std::vector<Process::ProcessHandle> timedOut;
+
+		while (deadlines.HasDue()) {
+			timedOut.push_back(deadlines.PopDue());
+		}
+
+		for (auto handle : timedOut) {
+			auto it = processes.find(handle);
+
+			if (it != processes.end())
+				handleEvents(it);
+		}
+	}
+}
+
+#ifdef HAVE_IO_URING
+/**
+ * Collects the output of this IO thread's processes through io_uring.
+ *
+ * Every process has a pending read for its output and a pending poll for its pidfd.
+ * Reads pick a buffer from a ring shared by all processes only once data is available,
+ * so the outputs of all processes which wrote something are read and the reads are
+ * re-armed with a single io_uring_enter(2) per iteration.
+ */
+void Process::IoUringThreadProc(int tid)
+{
+	Utility::SetThreadName("ProcessIO");
+
+	auto& ring (*l_Rings[tid]);
+	auto& processes (l_Processes[tid]);
+	auto& fds (l_FDs[tid]);
+	auto& deadlines (*l_Deadlines[tid]);
+
+	auto handleEvents ([&ring, &processes, &fds, &deadlines](decltype(processes.begin()) it) {
+		const Process::Ptr& process = it->second;
+
+		if (!process->DoEvents()) {
+			/* Closing the FDs doesn't cancel pending requests, they hold their own references. */
+			if (!process->m_OutputEOF)
+				ring.PrepareCancel(IoUringTag(it->first, IoUringRead), IoUringTag(it->first, IoUringCancel));
+
+			if (process->m_PidFD != -1 && !process->m_Exited)
+				ring.PrepareCancel(IoUringTag(it->first, IoUringPidFD), IoUringTag(it->first, IoUringCancel));
+
+			if (process->m_FD != -1) {
+				fds.erase(process->m_FD);
+				(void)close(process->m_FD);
+			}
+
+			if (process->m_PidFD != -1) {
+				(void)close(process->m_PidFD);
+				process->m_PidFD = -1;
+			}
+
+			deadlines.Erase(it->first);
+			processes.erase(it);
+			return;
+		}
+
+		if (process->m_OutputEOF && process->m_FD != -1) {
+			fds.erase(process->m_FD);
+			(void)close(process->m_FD);
+			process->m_FD = -1;
+		}
+
+		if (process->m_Timeout != 0) {
+			/* Timing wheels may fire up to one tick early, DoEvents() must see the deadline as passed. */
+			deadlines.Insert(it->first, process->m_Result.ExecutionStart + process->GetNextTimeout() + 0.01);
+		}
+	});
+
+	std::vector<Process::ProcessHandle> rearm, ready;
+
+	for (;;) {
+		double timeout = -1;
+
+		{
+			std::unique_lock<std::mutex> lock(l_ProcessMutex[tid]);
+
+			double next = deadlines.GetNextExpiry();
+
+			l_RingWaitUntil[tid] = next;
+
+			if (next != std::numeric_limits<double>::infinity())
+				timeout = std::max(0.0, next - Utility::GetTime());
+		}
+
+		/* Submits the re-armed reads and cancellations of the previous iteration as well. */
+		ring.Submit(1, timeout);
+
+		double now = Utility::GetTime();
+
+		std::unique_lock<std::mutex> lock(l_ProcessMutex[tid]);
+
+		rearm.clear();
+		ready.clear();
+
+		ring.ForEachCompletion([&ring, &processes, &rearm, &ready](const io_uring_cqe& cqe) {
+			auto request (static_cast<IoUringRequest>(cqe.user_data & 3u));
+			auto handle (static_cast<Process::ProcessHandle>(static_cast<uint32_t>(cqe.user_data >> 2u)));
+			bool hasBuffer = cqe.flags & IORING_CQE_F_BUFFER;
+			auto buffer (static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+
+			auto it (processes.find(handle));
+
+			if (request == IoUringRead && it != processes.end() && !it->second->m_OutputEOF) {
+				const Process::Ptr& process = it->second;
+
+				if (cqe.res > 0) {
+					process->m_OutputStream.write(ring.GetBuffer(buffer), cqe.res);
+					rearm.push_back(handle);
+				} else if (cqe.res == -ENOBUFS || cqe.res == -EAGAIN || cqe.res == -EINTR) {
+					/* All buffers were in use, they have been given back by the time we re-arm. */
+					rearm.push_back(handle);
+				} else if (cqe.res != -ECANCELED) {
+					process->m_OutputEOF = true;
+					ready.push_back(handle);
+				}
+			} else if (request == IoUringPidFD && it != processes.end() && cqe.res != -ECANCELED) {
+				const Process::Ptr& process = it->second;
+
+				process->m_Exited = true;
+
+				/* Still waiting for the output, e.g. a grandchild keeps the pipe open. */
+				if (process->m_OutputEOF)
+					ready.push_back(handle);
+			}
+
+			if (hasBuffer)
+				ring.RecycleBuffer(buffer);
+		});
+
+		for (auto handle : rearm) {
+			auto it (processes.find(handle));
+
+			if (it != processes.end() && it->second->m_FD != -1)
+				ring.PrepareRead(it->second->m_FD, l_IoUringBufferGroup, IoUringTag(handle, IoUringRead));
+		}
+
+		deadlines.Advance(now);
+
+		while (deadlines.HasDue()) {
+			ready.push_back(deadlines.PopDue());
+		}
+
+		for (auto handle : ready) {
+			auto it (processes.find(handle));
+
+			if (it != processes.end())
+				handleEvents(it);
+		}
+	}
+}
+#endif /* HAVE_IO_URING */
+#else /* __linux__ */
 void Process::IOThreadProc(int tid)
 {
 #ifdef _WIN32
@@ -738,6 +1264,7 @@ void Process::IOThreadProc(int tid)
 		}
 	}
 }
+#endif /* __linux__ */
 
 String Process::PrettyPrintArguments(const Process::Arguments& arguments)
 {
@@ -979,6 +1506,23 @@ void Process::Run(const std::function<void(const ProcessResult&)>& callback)
 	fds[1] = outfds[1];
 	fds[2] = outfds[1];
 
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+	m_Process = ProcessSpawnDirect(m_Arguments, m_ExtraEnvironment, m_AdjustPriority, fds);
+	m_PID = m_Process;
+	m_SpawnedDirectly = true;
+
+	if (m_PID == -1) {
+		/* Same message the spawn helper's child would have written to the pipe. */
+		m_OutputStream << "execvp(" << m_Arguments[0] << ") failed: " << Utility::FormatErrorNumber(errno) << "\n";
+	}
+
+#	ifdef HAVE_SYS_PIDFD_OPEN
+	/* Not every libc has a wrapper for pidfd_open(2). If the kernel doesn't know it,
+	 * the process is reaped as soon as its output has been read completely. */
+	if (m_PID != -1)
+		m_PidFD = syscall(SYS_pidfd_open, m_PID, 0);
+#	endif /* HAVE_SYS_PIDFD_OPEN */
+#else /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
 	m_Process = ProcessSpawn(m_Arguments, m_ExtraEnvironment, m_AdjustPriority, fds);
 	m_PID = m_Process;
 
@@ -986,6 +1530,7 @@ void Process::Run(const std::function<void(const ProcessResult&)>& callback)
 		m_OutputStream << "Fork failed with error code " << errno << " (" << Utility::FormatErrorNumber(errno) << ")";
 		Log(LogCritical, "Process", m_OutputStream.str());
 	}
+#endif /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
 
 	Log(LogNotice, "Process")
 		<< "Running command " << PrettyPrintArguments(m_Arguments) << ": PID " << m_PID;
@@ -1007,6 +1552,41 @@ void Process::Run(const std::function<void(const ProcessResult&)>& callback)
 #ifndef _WIN32
 		l_FDs[tid][m_FD] = m_Process;
 #endif /* _WIN32 */
+#ifdef __linux__
+		double deadline = m_Result.ExecutionStart + GetNextTimeout() + 0.01;
+
+		if (m_Timeout != 0)
+			l_Deadlines[tid]->Insert(m_Process, deadline);
+
+#	ifdef HAVE_IO_URING
+		if (l_Rings[tid]) {
+			auto& ring (*l_Rings[tid]);
+
+			m_RingOutput = true;
+
+			ring.PrepareRead(m_FD, l_IoUringBufferGroup, IoUringTag(m_Process, IoUringRead));
+
+			if (m_PidFD != -1)
+				ring.PreparePoll(m_PidFD, POLLIN, IoUringTag(m_Process, IoUringPidFD));
+
+			/* The IO thread is waiting for a later deadline. */
+			if (m_Timeout != 0 && deadline < l_RingWaitUntil[tid])
+				ring.PrepareNop(IoUringTag(m_Process, IoUringWakeup));
+
+			ring.Submit();
+
+			/* The completions wake up the IO thread. */
+			return;
+		}
+#	endif /* HAVE_IO_URING */
+
+		EpollAdd(tid, m_FD, false);
+
+		if (m_PidFD != -1) {
+			l_FDs[tid][m_PidFD] = m_Process;
+			EpollAdd(tid, m_PidFD, true);
+		}
+#endif /* __linux__ */
 	}
 
 #ifdef _WIN32
@@ -1045,7 +1625,7 @@ bool Process::DoEvents()
 
 				m_OutputStream << "<Timeout exceeded.>";
 
-				int error = ProcessKill(m_Process, SIGTERM);
+				int error = Kill(m_Process, SIGTERM);
 				if (error) {
 					Log(LogWarning, "Process")
 						<< "Couldn't terminate the process " << m_PID << " (" << PrettyPrintArguments(m_Arguments)
@@ -1069,7 +1649,7 @@ bool Process::DoEvents()
 			m_OutputStream << "<Timeout exceeded.>";
 			TerminateProcess(m_Process, 3);
 #else /* _WIN32 */
-			int error = ProcessKill(-m_Process, SIGKILL);
+			int error = Kill(-m_Process, SIGKILL);
 			if (error) {
 				Log(LogWarning, "Process")
 					<< "Couldn't kill the process group " << m_PID << " (" << PrettyPrintArguments(m_Arguments)
@@ -1095,7 +1675,11 @@ bool Process::DoEvents()
 		}
 #else /* _WIN32 */
 		char buffer[512];
-		for (;;) {
+		while (!m_OutputEOF) {
+			/* The IO thread collects the output as it comes in. */
+			if (m_RingOutput)
+				return true;
+
 			int rc = read(m_FD, buffer, sizeof(buffer));
 
 			if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
@@ -1108,6 +1692,12 @@ bool Process::DoEvents()
 
 			break;
 		}
+
+		if (m_PidFD != -1 && !m_Exited) {
+			/* Don't block in waitpid(), the pidfd tells us when the process has terminated. */
+			m_OutputEOF = true;
+			return true;
+		}
 #endif /* _WIN32 */
 	}
 
@@ -1126,7 +1716,7 @@ bool Process::DoEvents()
 	int exitcode = 0;
 	if (could_not_kill || m_PID == -1) {
 		exitcode = 128;
-	} else if (ProcessWaitPID(m_Process, &status) != m_Process) {
+	} else if (WaitPID(m_Process, &status) != m_Process) {
 		exitcode = 128;
 
 		Log(LogWarning, "Process")
@@ -1188,6 +1778,80 @@ bool Process::DoEvents()
 	return false;
 }
 
+#ifndef _WIN32
+/**
+ * Sends a signal to the process (group), either directly or through the spawn helper.
+ *
+ * @returns 0 on success, the error number otherwise.
+ */
+int Process::Kill(pid_t pid, int signum) const
+{
+	if (!m_SpawnedDirectly)
+		return ProcessKill(pid, signum);
+
+	return kill(pid, signum) < 0 ? errno : 0;
+}
+
+/**
+ * Reaps the process, either directly or through the spawn helper
+ * depending on which one is the parent of the process.
+ */
+pid_t Process::WaitPID(pid_t pid, int *status) const
+{
+	if (!m_SpawnedDirectly)
+		return ProcessWaitPID(pid, status);
+
+	pid_t rc;
+
+	do {
+		rc = waitpid(pid, status, 0);
+	} while (rc < 0 && errno == EINTR);
+
+	return rc;
+}
+
+/**
+ * Spawns a long-lived process, e.g. for a ProcessWorkerPool, the same way as Run() spawns its children.
+ *
+ * @param arguments The command line.
+ * @param fd The FD which should become the child's stdin and stdout. Its stderr is ours.
+ * @returns The PID of the child or -1 (and errno set) on failure.
+ */
+pid_t Process::SpawnWorker(const Arguments& arguments, int fd)
+{
+	int fds[3];
+	fds[0] = fd;
+	fds[1] = fd;
+	fds[2] = STDERR_FILENO;
+
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+	return ProcessSpawnDirect(arguments, nullptr, false, fds);
+#else /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+	return ProcessSpawn(arguments, nullptr, false, fds);
+#endif /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+}
+
+/**
+ * Kills the process group of a process spawned by SpawnWorker() and reaps the process.
+ */
+void Process::KillWorker(pid_t pid)
+{
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+	(void)kill(-pid, SIGKILL);
+
+	int status;
+
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+		;
+#else /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+	int status;
+
+	(void)ProcessKill(-pid, SIGKILL);
+	(void)ProcessWaitPID(pid, &status);
+#endif /* HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+}
+#endif /* _WIN32 */
+
 pid_t Process::GetPID() const
 {
 	return m_PID;
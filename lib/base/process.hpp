@@ -77,6 +77,9 @@ public:
 
 #ifndef _WIN32
 	static void InitializeSpawnHelper();
+
+	static pid_t SpawnWorker(const Arguments& arguments, int fd);
+	static void KillWorker(pid_t pid);
 #endif /* _WIN32 */
 
 private:
@@ -86,6 +89,11 @@ private:
 	double m_Timeout;
 #ifndef _WIN32
 	bool m_SentSigterm;
+	bool m_SpawnedDirectly; /**< Whether this process is the parent of the child rather than the spawn helper. */
+	int m_PidFD; /**< A pidfd for the child or -1 if there is none. */
+	bool m_Exited; /**< Whether the pidfd has signalled the termination of the child. */
+	bool m_OutputEOF; /**< Whether the child's output has been read completely. */
+	bool m_RingOutput; /**< Whether the IO thread's io_uring reads the output rather than DoEvents(). */
 #endif /* _WIN32 */
 
 	bool m_AdjustPriority;
@@ -109,9 +117,17 @@ private:
 	std::condition_variable m_ResultCondition;
 
 	static void IOThreadProc(int tid);
+#ifdef HAVE_IO_URING
+	static void IoUringThreadProc(int tid);
+#endif /* HAVE_IO_URING */
 	bool DoEvents();
 	int GetTID() const;
 	double GetNextTimeout() const;
+
+#ifndef _WIN32
+	int Kill(pid_t pid, int signum) const;
+	pid_t WaitPID(pid_t pid, int *status) const;
+#endif /* _WIN32 */
 };
 
 }
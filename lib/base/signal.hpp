@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * A handle for disconnecting a slot from a Signal.
+ *
+ * @ingroup base
+ */
+class SignalConnection
+{
+public:
+	SignalConnection() = default;
+
+	explicit SignalConnection(std::shared_ptr<std::atomic<bool>> connected)
+		: m_Connected(std::move(connected))
+	{ }
+
+	/**
+	 * Stops the slot from being called by subsequent emissions. Emissions already in progress may still call it.
+	 */
+	void disconnect()
+	{
+		if (m_Connected)
+			m_Connected->store(false, std::memory_order_release);
+	}
+
+	bool connected() const
+	{
+		return m_Connected && m_Connected->load(std::memory_order_acquire);
+	}
+
+private:
+	std::shared_ptr<std::atomic<bool>> m_Connected;
+};
+
+template<typename Signature>
+class Signal;
+
+/**
+ * A replacement for boost::signals2::signal for signals which are emitted very often,
+ * e.g. on every check result, but are rarely connected to.
+ *
+ * Emitting doesn't lock or allocate anything, it just iterates the current array of slots.
+ * Connecting copies that array (copy on write). The replaced arrays are kept until the signal
+ * is destroyed, as other threads may still be iterating them. As slots are usually connected
+ * once at startup, that's only a few.
+ *
+ * @ingroup base
+ */
+template<typename... Args>
+class Signal<void (Args...)>
+{
+public:
+	typedef std::function<void (Args...)> SlotType;
+
+	Signal() = default;
+
+	Signal(const Signal&) = delete;
+	Signal& operator=(const Signal&) = delete;
+
+	~Signal()
+	{
+		delete m_Slots.load();
+	}
+
+	template<typename F>
+	SignalConnection connect(F&& slot)
+	{
+		auto entry (std::make_shared<Entry>(Entry{SlotType(std::forward<F>(slot)), std::make_shared<std::atomic<bool>>(true)}));
+
+		std::unique_lock<std::mutex> lock (m_Mutex);
+
+		auto current (m_Slots.load(std::memory_order_relaxed));
+		auto slots (new SlotArray());
+
+		if (current) {
+			slots->Entries.reserve(current->Entries.size() + 1u);
+
+			for (auto& other : current->Entries) {
+				if (other->Connected->load(std::memory_order_relaxed))
+					slots->Entries.emplace_back(other);
+			}
+		}
+
+		slots->Entries.emplace_back(entry);
+		slots->Previous.reset(current);
+
+		m_Slots.store(slots, std::memory_order_release);
+
+		return SignalConnection(entry->Connected);
+	}
+
+	void operator()(Args... args) const
+	{
+		auto slots (m_Slots.load(std::memory_order_acquire));
+
+		if (!slots)
+			return;
+
+		for (auto& entry : slots->Entries) {
+			if (entry->Connected->load(std::memory_order_acquire))
+				entry->Slot(args...);
+		}
+	}
+
+	bool empty() const
+	{
+		auto slots (m_Slots.load(std::memory_order_acquire));
+
+		if (!slots)
+			return true;
+
+		for (auto& entry : slots->Entries) {
+			if (entry->Connected->load(std::memory_order_acquire))
+				return false;
+		}
+
+		return true;
+	}
+
+private:
+	struct Entry
+	{
+		SlotType Slot;
+		std::shared_ptr<std::atomic<bool>> Connected;
+	};
+
+	struct SlotArray
+	{
+		std::vector<std::shared_ptr<Entry>> Entries;
+		std::unique_ptr<SlotArray> Previous;
+	};
+
+	std::mutex m_Mutex;
+	std::atomic<SlotArray *> m_Slots{nullptr};
+};
+
+}
@@ -0,0 +1,375 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/state-file.hpp"
+#include "base/array.hpp"
+#include "base/binary-value.hpp"
+#include "base/dictionary.hpp"
+#include "base/objectlock.hpp"
+#include "base/serializer.hpp"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifndef _WIN32
+#	include <sys/mman.h>
+#endif /* _WIN32 */
+
+using namespace icinga;
+
+static const size_t l_StateFileFlushSize = 64 * 1024;
+
+static void ThrowTruncated()
+{
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid state file (truncated)"));
+}
+
+/**
+ * Checks the structure of a delta batch, without decoding the records.
+ */
+static void CheckBatch(const char *pos, const char *end)
+{
+	for (;;) {
+		if (pos == end)
+			ThrowTruncated();
+
+		switch (*pos++) {
+			case 'E':
+				if (pos != end)
+					BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid state file (batch length mismatch)"));
+
+				return;
+
+			case 'T':
+				break;
+
+			default:
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid state file (unknown section)"));
+		}
+
+		BinaryValue::DecodeString(pos, end);
+
+		uint64_t columns = BinaryValue::DecodeVarint(pos, end);
+
+		if (columns > uint64_t(end - pos))
+			ThrowTruncated();
+
+		for (uint64_t i = 0; i < columns; i++) {
+			BinaryValue::DecodeString(pos, end);
+		}
+
+		uint64_t records = BinaryValue::DecodeVarint(pos, end);
+
+		if (records > uint64_t(end - pos))
+			ThrowTruncated();
+
+		for (uint64_t i = 0; i < records; i++) {
+			uint64_t length = BinaryValue::DecodeVarint(pos, end);
+
+			if (length > uint64_t(end - pos))
+				ThrowTruncated();
+
+			pos += length;
+		}
+	}
+}
+
+void StateFile::EncodeHeader(std::string& buffer, const char (&magic)[8], uint64_t snapshotId)
+{
+	buffer.append(magic, sizeof(magic));
+
+	for (int i = 0; i < 4; i++) {
+		buffer += char((Version >> (i * 8)) & 0xffu);
+	}
+
+	for (int i = 0; i < 8; i++) {
+		buffer += char((snapshotId >> (i * 8)) & 0xffu);
+	}
+}
+
+StateFileWriter::StateFileWriter(std::ostream& stream)
+	: m_Stream(stream)
+{
+	m_Buffer.reserve(l_StateFileFlushSize * 2u);
+}
+
+void StateFileWriter::WriteHeader(uint64_t snapshotId)
+{
+	StateFile::EncodeHeader(m_Buffer, StateFile::Magic, snapshotId);
+}
+
+/**
+ * Writes the given objects' attributes which match attributeTypes, see Serialize().
+ */
+void StateFileWriter::WriteType(const Type::Ptr& type, const std::vector<ConfigObject::Ptr>& objects, int attributeTypes)
+{
+	std::vector<int> fieldIds;
+
+	m_Buffer += 'T';
+	BinaryValue::EncodeString(m_Buffer, type->GetName());
+
+	for (int i = 0; i < type->GetFieldCount(); i++) {
+		Field field = type->GetFieldInfo(i);
+
+		if ((attributeTypes == 0 || (field.Attributes & attributeTypes)) && strcmp(field.Name, "type") != 0)
+			fieldIds.emplace_back(i);
+	}
+
+	BinaryValue::EncodeVarint(m_Buffer, fieldIds.size());
+
+	for (int fid : fieldIds) {
+		BinaryValue::EncodeString(m_Buffer, type->GetFieldInfo(fid).Name);
+	}
+
+	BinaryValue::EncodeVarint(m_Buffer, objects.size());
+
+	for (const ConfigObject::Ptr& object : objects) {
+		m_Record.clear();
+
+		{
+			ObjectLock olock (object);
+
+			BinaryValue::EncodeString(m_Record, object->GetName());
+
+			for (int fid : fieldIds) {
+				BinaryValue::EncodeValue(m_Record, Serialize(object->GetField(fid), attributeTypes));
+			}
+		}
+
+		BinaryValue::EncodeVarint(m_Buffer, m_Record.size());
+		m_Buffer.append(m_Record);
+
+		Flush();
+	}
+}
+
+void StateFileWriter::Finish()
+{
+	m_Buffer += 'E';
+	Flush(true);
+	m_Stream.flush();
+
+	if (!m_Stream)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Failed to write the state file"));
+}
+
+void StateFileWriter::Flush(bool force)
+{
+	if (m_Buffer.size() < l_StateFileFlushSize && !force)
+		return;
+
+	m_Stream.write(m_Buffer.data(), m_Buffer.size());
+	m_Buffer.clear();
+
+	if (!m_Stream)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Failed to write the state file"));
+}
+
+/**
+ * Whether the file starts like a binary state file. The old format, netstrings, starts with a digit.
+ */
+bool StateFileReader::IsStateFile(const String& path)
+{
+	std::ifstream fp (path.CStr(), std::ios_base::in | std::ios_base::binary);
+	char magic[sizeof(StateFile::Magic)];
+
+	return fp.read(magic, sizeof(magic)) && memcmp(magic, StateFile::Magic, sizeof(magic)) == 0;
+}
+
+StateFileReader::StateFileReader(const String& path)
+	: m_File(path.GetData()), m_Pos(m_File.data()), m_End(m_File.data() + m_File.size()), m_BatchEnd(m_End),
+	m_Delta(false), m_Truncated(false), m_SnapshotId(0), m_SectionRecords(0)
+{
+	const size_t headerSize = sizeof(StateFile::Magic) + 4u + 8u;
+
+	if (size_t(m_End - m_Pos) < headerSize)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid state file '" + path + "' (truncated header)"));
+
+	if (memcmp(m_Pos, StateFile::DeltaMagic, sizeof(StateFile::DeltaMagic)) == 0)
+		m_Delta = true;
+	else if (memcmp(m_Pos, StateFile::Magic, sizeof(StateFile::Magic)) != 0)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid state file '" + path + "' (bad magic)"));
+
+	m_Pos += sizeof(StateFile::Magic);
+
+	uint32_t version = 0;
+
+	for (int i = 0; i < 4; i++) {
+		version |= uint32_t(static_cast<unsigned char>(*m_Pos++)) << (i * 8);
+	}
+
+	if (version > StateFile::Version) {
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Unsupported version " + std::to_string(version) + " of state file '" + path + "'"));
+	}
+
+	for (int i = 0; i < 8; i++) {
+		m_SnapshotId |= uint64_t(static_cast<unsigned char>(*m_Pos++)) << (i * 8);
+	}
+
+	if (m_Delta)
+		m_BatchEnd = m_Pos;
+
+#ifndef _WIN32
+	/* The records are split front to back and decoded soon after. */
+	(void)posix_madvise(const_cast<char *>(m_File.data()), m_File.size(), POSIX_MADV_SEQUENTIAL);
+#endif /* _WIN32 */
+}
+
+size_t StateFileReader::GetSize() const
+{
+	return m_File.size();
+}
+
+bool StateFileReader::IsDelta() const
+{
+	return m_Delta;
+}
+
+/**
+ * The ID of the snapshot, or for a delta log the one of the snapshot it belongs to.
+ */
+uint64_t StateFileReader::GetSnapshotId() const
+{
+	return m_SnapshotId;
+}
+
+/**
+ * Whether the last batch of a delta log was incomplete or garbled and has been ignored.
+ */
+bool StateFileReader::IsTruncated() const
+{
+	return m_Truncated;
+}
+
+/**
+ * Finds the next object. Its attributes are decoded later, possibly by another thread.
+ *
+ * @returns false once the end of the file has been reached.
+ */
+bool StateFileReader::ReadRecord(StateFileRecord& record)
+{
+	while (!m_SectionRecords) {
+		if (!ReadSection())
+			return false;
+	}
+
+	uint64_t length = BinaryValue::DecodeVarint(m_Pos, m_BatchEnd);
+
+	if (length > uint64_t(m_BatchEnd - m_Pos))
+		ThrowTruncated();
+
+	record.Section = m_Section;
+	record.Begin = m_Pos;
+	record.End = m_Pos + length;
+
+	m_Pos += length;
+	m_SectionRecords--;
+
+	return true;
+}
+
+/**
+ * Skips all complete batches of a delta log, without splitting them into records.
+ *
+ * @returns The size of the log up to the end of its last complete batch.
+ */
+size_t StateFileReader::SkipBatches()
+{
+	while (m_Pos == m_BatchEnd && ReadBatch()) {
+		m_Pos = m_BatchEnd;
+	}
+
+	return m_Pos - m_File.data();
+}
+
+/**
+ * Starts the next batch of a delta log. A crash may have left only a part of the last batch behind,
+ * or garbage in place of it, so that one is checked as a whole before any of its records are read.
+ *
+ * @returns false at the end of the log, or if the last batch is incomplete.
+ */
+bool StateFileReader::ReadBatch()
+{
+	if (m_Pos == m_End)
+		return false;
+
+	const char *pos = m_Pos;
+	uint64_t length;
+
+	try {
+		length = BinaryValue::DecodeVarint(pos, m_End);
+	} catch (const std::invalid_argument&) {
+		m_Truncated = true;
+		return false;
+	}
+
+	if (length > uint64_t(m_End - pos)) {
+		m_Truncated = true;
+		return false;
+	}
+
+	if (length == uint64_t(m_End - pos)) {
+		try {
+			CheckBatch(pos, m_End);
+		} catch (const std::invalid_argument&) {
+			m_Truncated = true;
+			return false;
+		}
+	}
+
+	m_Pos = pos;
+	m_BatchEnd = pos + length;
+
+	return true;
+}
+
+bool StateFileReader::ReadSection()
+{
+	if (m_Delta && m_Pos == m_BatchEnd && !ReadBatch())
+		return false;
+
+	if (m_Pos == m_BatchEnd)
+		ThrowTruncated();
+
+	switch (*m_Pos++) {
+		case 'E':
+			if (!m_Delta)
+				return false;
+
+			if (m_Pos != m_BatchEnd)
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid state file (batch length mismatch)"));
+
+			return ReadSection();
+
+		case 'T':
+			break;
+
+		default:
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid state file (unknown section)"));
+	}
+
+	auto section (std::make_shared<StateFileSection>());
+
+	section->TypeName = BinaryValue::DecodeString(m_Pos, m_BatchEnd);
+	section->ObjectType = Type::GetByName(section->TypeName);
+	section->ObjectConfigType = dynamic_cast<ConfigType *>(section->ObjectType.get());
+
+	if (!section->ObjectConfigType)
+		section->ObjectType = nullptr;
+
+	uint64_t columns = BinaryValue::DecodeVarint(m_Pos, m_BatchEnd);
+
+	if (columns > uint64_t(m_BatchEnd - m_Pos))
+		ThrowTruncated();
+
+	for (uint64_t i = 0; i < columns; i++) {
+		section->Columns.emplace_back(BinaryValue::DecodeString(m_Pos, m_BatchEnd));
+		section->FieldIds.emplace_back(section->ObjectType ? section->ObjectType->GetFieldId(section->Columns.back()) : -1);
+	}
+
+	m_SectionRecords = BinaryValue::DecodeVarint(m_Pos, m_BatchEnd);
+	m_Section = std::move(section);
+
+	return true;
+}
@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include "base/configobject.hpp"
+#include "base/configtype.hpp"
+#include "base/string.hpp"
+#include "base/value.hpp"
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * Constants of the binary state file (icinga2.state v2).
+ *
+ * File layout, all integers are little-endian, "varint" means LEB128:
+ *
+ *   magic "i2state\0", uint32 version, uint64 snapshot ID
+ *   per type:   'T', string type name, varint column count, string column names..., varint record count
+ *   per object: varint record length, string object name, one value per column
+ *   'E'
+ *
+ * Strings and values are encoded by BinaryValue. The columns are the names of the type's state
+ * attributes at the time of the dump, so attributes which have been added or removed since are
+ * handled when restoring.
+ *
+ * The delta log next to a snapshot starts with "i2delta\0", the version and the ID of the snapshot it
+ * belongs to. Then batches are appended, each a varint length followed by type sections like above
+ * and 'E'. An incomplete last batch (e.g. after a crash) is ignored when restoring and cut off before appending.
+ *
+ * @ingroup base
+ */
+class StateFile
+{
+public:
+	static constexpr char Magic[8] = { 'i', '2', 's', 't', 'a', 't', 'e', '\0' };
+	static constexpr char DeltaMagic[8] = { 'i', '2', 'd', 'e', 'l', 't', 'a', '\0' };
+	static constexpr uint32_t Version = 2;
+
+	static void EncodeHeader(std::string& buffer, const char (&magic)[8], uint64_t snapshotId);
+};
+
+/**
+ * A type section of a binary state file.
+ *
+ * @ingroup base
+ */
+struct StateFileSection
+{
+	String TypeName;
+	Type::Ptr ObjectType; /**< nullptr if the type doesn't exist (anymore). */
+	ConfigType *ObjectConfigType;
+	std::vector<String> Columns;
+	std::vector<int> FieldIds; /**< Per column, -1 if the type has no such field (anymore). */
+};
+
+/**
+ * A not yet decoded object of a binary state file. It points into the file's mapping.
+ *
+ * @ingroup base
+ */
+struct StateFileRecord
+{
+	std::shared_ptr<const StateFileSection> Section;
+	const char *Begin;
+	const char *End;
+};
+
+/**
+ * Writes a binary state file (or a delta batch) type by type, buffering only a few KiB at a time.
+ *
+ * @ingroup base
+ */
+class StateFileWriter
+{
+public:
+	explicit StateFileWriter(std::ostream& stream);
+
+	void WriteHeader(uint64_t snapshotId);
+
+	StateFileWriter(const StateFileWriter&) = delete;
+	StateFileWriter& operator=(const StateFileWriter&) = delete;
+
+	void WriteType(const Type::Ptr& type, const std::vector<ConfigObject::Ptr>& objects, int attributeTypes);
+	void Finish();
+
+private:
+	std::ostream& m_Stream;
+	std::string m_Buffer;
+	std::string m_Record;
+
+	void Flush(bool force = false);
+};
+
+/**
+ * Maps a binary state file or delta log into memory and splits it into records.
+ *
+ * @ingroup base
+ */
+class StateFileReader
+{
+public:
+	static bool IsStateFile(const String& path);
+
+	explicit StateFileReader(const String& path);
+
+	StateFileReader(const StateFileReader&) = delete;
+	StateFileReader& operator=(const StateFileReader&) = delete;
+
+	size_t GetSize() const;
+	bool IsDelta() const;
+	uint64_t GetSnapshotId() const;
+	bool IsTruncated() const;
+
+	size_t SkipBatches();
+	bool ReadRecord(StateFileRecord& record);
+
+private:
+	boost::iostreams::mapped_file_source m_File;
+	const char *m_Pos;
+	const char *m_End;
+	const char *m_BatchEnd;
+	bool m_Delta;
+	bool m_Truncated;
+	uint64_t m_SnapshotId;
+	std::shared_ptr<const StateFileSection> m_Section;
+	uint64_t m_SectionRecords;
+
+	bool ReadBatch();
+	bool ReadSection();
+};
+
+}
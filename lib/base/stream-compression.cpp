@@ -0,0 +1,394 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/stream-compression.hpp"
+#include "base/exception.hpp"
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+#ifdef HAVE_ZLIB
+#	include <zlib.h>
+#endif /* HAVE_ZLIB */
+
+#ifdef HAVE_ZSTD
+#	include <zstd.h>
+#endif /* HAVE_ZSTD */
+
+using namespace icinga;
+
+/* Decompressed output is produced in chunks of this size, so that a message exceeding the limit
+ * is detected after allocating at most one more chunk. */
+static const size_t l_DecompressChunkSize = 16 * 1024;
+
+static void ThrowTooLarge(size_t maxSize)
+{
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Decompressed message exceeds the limit of " + std::to_string(maxSize) + " bytes"));
+}
+
+/**
+ * @param name "none", "deflate" or "zstd"
+ *
+ * @return The algorithm, whether this build supports it or not
+ */
+CompressionAlgorithm icinga::ParseCompressionAlgorithm(const String& name)
+{
+	if (name == "none")
+		return CompressionAlgorithm::None;
+
+	if (name == "deflate")
+		return CompressionAlgorithm::Deflate;
+
+	if (name == "zstd")
+		return CompressionAlgorithm::Zstd;
+
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Unknown compression algorithm '" + name + "', expected 'none', 'deflate' or 'zstd'"));
+}
+
+bool icinga::IsCompressionAvailable(CompressionAlgorithm algorithm)
+{
+	switch (algorithm) {
+		case CompressionAlgorithm::None:
+			return true;
+		case CompressionAlgorithm::Deflate:
+#ifdef HAVE_ZLIB
+			return true;
+#else /* HAVE_ZLIB */
+			return false;
+#endif /* HAVE_ZLIB */
+		case CompressionAlgorithm::Zstd:
+#ifdef HAVE_ZSTD
+			return true;
+#else /* HAVE_ZSTD */
+			return false;
+#endif /* HAVE_ZSTD */
+	}
+
+	return false;
+}
+
+#ifdef HAVE_ZLIB
+/* The empty stored block which ends every Z_SYNC_FLUSH. It's left out of the output and appended
+ * again by the decompressor, as done by WebSocket's permessage-deflate. */
+static const unsigned char l_DeflateFlushTrailer[] = { 0x00, 0x00, 0xff, 0xff };
+
+/**
+ * Raw deflate (without zlib header and checksum), the TLS layer takes care of integrity.
+ */
+class DeflateCompressor final : public StreamCompressor
+{
+public:
+	explicit DeflateCompressor(const String& dictionary)
+		: m_Stream()
+	{
+		if (deflateInit2(&m_Stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			BOOST_THROW_EXCEPTION(std::bad_alloc());
+
+		if (!dictionary.IsEmpty() && deflateSetDictionary(&m_Stream,
+			reinterpret_cast<const Bytef *>(dictionary.CStr()), dictionary.GetLength()) != Z_OK) {
+			deflateEnd(&m_Stream);
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid deflate dictionary"));
+		}
+	}
+
+	~DeflateCompressor() override
+	{
+		deflateEnd(&m_Stream);
+	}
+
+	CompressionAlgorithm GetAlgorithm() const override
+	{
+		return CompressionAlgorithm::Deflate;
+	}
+
+	void Compress(const char *data, size_t size, std::string& output) override
+	{
+		if (size > std::numeric_limits<uInt>::max())
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Message too large to be compressed"));
+
+		size_t begin = output.size();
+
+		m_Stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+		m_Stream.avail_in = size;
+
+		/* As long as deflate() fills the whole output buffer, there may be more output pending. */
+		do {
+			size_t offset = output.size();
+			size_t chunk = size_t(m_Stream.avail_in) + 64u;
+
+			output.resize(offset + chunk);
+			m_Stream.next_out = reinterpret_cast<Bytef *>(&output[offset]);
+			m_Stream.avail_out = chunk;
+
+			int rc = deflate(&m_Stream, Z_SYNC_FLUSH);
+
+			output.resize(output.size() - m_Stream.avail_out);
+
+			if (rc != Z_OK && rc != Z_BUF_ERROR)
+				BOOST_THROW_EXCEPTION(std::runtime_error("deflate() failed"));
+		} while (m_Stream.avail_out == 0u);
+
+		if (output.size() - begin >= sizeof(l_DeflateFlushTrailer)
+			&& output.compare(output.size() - sizeof(l_DeflateFlushTrailer), sizeof(l_DeflateFlushTrailer),
+				reinterpret_cast<const char *>(l_DeflateFlushTrailer), sizeof(l_DeflateFlushTrailer)) == 0) {
+			output.resize(output.size() - sizeof(l_DeflateFlushTrailer));
+		}
+	}
+
+private:
+	z_stream m_Stream;
+};
+
+class DeflateDecompressor final : public StreamDecompressor
+{
+public:
+	explicit DeflateDecompressor(const String& dictionary)
+		: m_Stream()
+	{
+		if (inflateInit2(&m_Stream, -MAX_WBITS) != Z_OK)
+			BOOST_THROW_EXCEPTION(std::bad_alloc());
+
+		/* Raw inflate accepts the dictionary right away rather than after Z_NEED_DICT. */
+		if (!dictionary.IsEmpty() && inflateSetDictionary(&m_Stream,
+			reinterpret_cast<const Bytef *>(dictionary.CStr()), dictionary.GetLength()) != Z_OK) {
+			inflateEnd(&m_Stream);
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid deflate dictionary"));
+		}
+	}
+
+	~DeflateDecompressor() override
+	{
+		inflateEnd(&m_Stream);
+	}
+
+	CompressionAlgorithm GetAlgorithm() const override
+	{
+		return CompressionAlgorithm::Deflate;
+	}
+
+	void Decompress(const char *data, size_t size, std::string& output, size_t maxSize) override
+	{
+		if (size > std::numeric_limits<uInt>::max())
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Compressed message too large"));
+
+		/* Without new input, deflate() flushes nothing, not even the trailer. */
+		if (!size)
+			return;
+
+		size_t begin = output.size();
+
+		Inflate(reinterpret_cast<const unsigned char *>(data), size, output, begin, maxSize);
+		Inflate(l_DeflateFlushTrailer, sizeof(l_DeflateFlushTrailer), output, begin, maxSize);
+	}
+
+private:
+	z_stream m_Stream;
+
+	void Inflate(const unsigned char *data, size_t size, std::string& output, size_t begin, size_t maxSize)
+	{
+		m_Stream.next_in = const_cast<Bytef *>(data);
+		m_Stream.avail_in = size;
+
+		for (;;) {
+			size_t offset = output.size();
+
+			output.resize(offset + l_DecompressChunkSize);
+			m_Stream.next_out = reinterpret_cast<Bytef *>(&output[offset]);
+			m_Stream.avail_out = l_DecompressChunkSize;
+
+			int rc = inflate(&m_Stream, Z_SYNC_FLUSH);
+
+			output.resize(output.size() - m_Stream.avail_out);
+
+			switch (rc) {
+				case Z_OK:
+				case Z_BUF_ERROR: // No progress possible, i.e. all input consumed and all output produced
+					break;
+				case Z_STREAM_END:
+					BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid compressed message (end of stream)"));
+				default:
+					BOOST_THROW_EXCEPTION(std::invalid_argument(String("Invalid compressed message: ")
+						+ (m_Stream.msg ? m_Stream.msg : "inflate() failed")));
+			}
+
+			if (output.size() - begin > maxSize)
+				ThrowTooLarge(maxSize);
+
+			if (m_Stream.avail_in == 0u && m_Stream.avail_out != 0u)
+				break;
+		}
+	}
+};
+#endif /* HAVE_ZLIB */
+
+#ifdef HAVE_ZSTD
+/* 1 MiB of history per direction and connection. The decompressor rejects streams which need more. */
+static const int l_ZstdWindowLog = 20;
+
+static void CheckZstd(size_t rc)
+{
+	if (ZSTD_isError(rc))
+		BOOST_THROW_EXCEPTION(std::invalid_argument(String("Invalid compressed message: ") + ZSTD_getErrorName(rc)));
+}
+
+/**
+ * One endless zstd frame, flushed after every message.
+ */
+class ZstdCompressor final : public StreamCompressor
+{
+public:
+	explicit ZstdCompressor(const String& dictionary)
+		: m_Context(ZSTD_createCCtx())
+	{
+		if (!m_Context)
+			BOOST_THROW_EXCEPTION(std::bad_alloc());
+
+		try {
+			CheckZstd(ZSTD_CCtx_setParameter(m_Context, ZSTD_c_windowLog, l_ZstdWindowLog));
+
+			if (!dictionary.IsEmpty())
+				CheckZstd(ZSTD_CCtx_loadDictionary(m_Context, dictionary.CStr(), dictionary.GetLength()));
+		} catch (...) {
+			ZSTD_freeCCtx(m_Context);
+			throw;
+		}
+	}
+
+	~ZstdCompressor() override
+	{
+		ZSTD_freeCCtx(m_Context);
+	}
+
+	CompressionAlgorithm GetAlgorithm() const override
+	{
+		return CompressionAlgorithm::Zstd;
+	}
+
+	void Compress(const char *data, size_t size, std::string& output) override
+	{
+		ZSTD_inBuffer in { data, size, 0 };
+
+		for (;;) {
+			size_t offset = output.size();
+			size_t chunk = size + 64u;
+
+			output.resize(offset + chunk);
+
+			ZSTD_outBuffer out { &output[offset], chunk, 0 };
+			size_t rc = ZSTD_compressStream2(m_Context, &out, &in, ZSTD_e_flush);
+
+			output.resize(offset + out.pos);
+			CheckZstd(rc);
+
+			/* 0 means the input is consumed and flushed completely. */
+			if (rc == 0u)
+				break;
+		}
+	}
+
+private:
+	ZSTD_CCtx *m_Context;
+};
+
+class ZstdDecompressor final : public StreamDecompressor
+{
+public:
+	explicit ZstdDecompressor(const String& dictionary)
+		: m_Context(ZSTD_createDCtx())
+	{
+		if (!m_Context)
+			BOOST_THROW_EXCEPTION(std::bad_alloc());
+
+		try {
+			CheckZstd(ZSTD_DCtx_setParameter(m_Context, ZSTD_d_windowLogMax, l_ZstdWindowLog));
+
+			if (!dictionary.IsEmpty())
+				CheckZstd(ZSTD_DCtx_loadDictionary(m_Context, dictionary.CStr(), dictionary.GetLength()));
+		} catch (...) {
+			ZSTD_freeDCtx(m_Context);
+			throw;
+		}
+	}
+
+	~ZstdDecompressor() override
+	{
+		ZSTD_freeDCtx(m_Context);
+	}
+
+	CompressionAlgorithm GetAlgorithm() const override
+	{
+		return CompressionAlgorithm::Zstd;
+	}
+
+	void Decompress(const char *data, size_t size, std::string& output, size_t maxSize) override
+	{
+		size_t begin = output.size();
+		ZSTD_inBuffer in { data, size, 0 };
+
+		for (;;) {
+			size_t offset = output.size();
+
+			output.resize(offset + l_DecompressChunkSize);
+
+			ZSTD_outBuffer out { &output[offset], l_DecompressChunkSize, 0 };
+			size_t rc = ZSTD_decompressStream(m_Context, &out, &in);
+
+			output.resize(offset + out.pos);
+			CheckZstd(rc);
+
+			if (output.size() - begin > maxSize)
+				ThrowTooLarge(maxSize);
+
+			if (in.pos == in.size && out.pos < out.size)
+				break;
+		}
+	}
+
+private:
+	ZSTD_DCtx *m_Context;
+};
+#endif /* HAVE_ZSTD */
+
+/**
+ * @return A compressor for the algorithm, nullptr for CompressionAlgorithm::None
+ */
+std::unique_ptr<StreamCompressor> StreamCompressor::Create(CompressionAlgorithm algorithm, const String& dictionary)
+{
+	switch (algorithm) {
+#ifdef HAVE_ZLIB
+		case CompressionAlgorithm::Deflate:
+			return std::make_unique<DeflateCompressor>(dictionary);
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+		case CompressionAlgorithm::Zstd:
+			return std::make_unique<ZstdCompressor>(dictionary);
+#endif /* HAVE_ZSTD */
+		case CompressionAlgorithm::None:
+			return nullptr;
+		default:
+			(void)dictionary;
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Compression algorithm not supported by this build"));
+	}
+}
+
+/**
+ * @return A decompressor for the algorithm, nullptr for CompressionAlgorithm::None
+ */
+std::unique_ptr<StreamDecompressor> StreamDecompressor::Create(CompressionAlgorithm algorithm, const String& dictionary)
+{
+	switch (algorithm) {
+#ifdef HAVE_ZLIB
+		case CompressionAlgorithm::Deflate:
+			return std::make_unique<DeflateDecompressor>(dictionary);
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+		case CompressionAlgorithm::Zstd:
+			return std::make_unique<ZstdDecompressor>(dictionary);
+#endif /* HAVE_ZSTD */
+		case CompressionAlgorithm::None:
+			return nullptr;
+		default:
+			(void)dictionary;
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Compression algorithm not supported by this build"));
+	}
+}
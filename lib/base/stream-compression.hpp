@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "base/i2-base.hpp"
+#include "base/string.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace icinga
+{
+
+/**
+ * @ingroup base
+ */
+enum class CompressionAlgorithm
+{
+	None,
+	Deflate,
+	Zstd
+};
+
+CompressionAlgorithm ParseCompressionAlgorithm(const String& name);
+bool IsCompressionAvailable(CompressionAlgorithm algorithm);
+
+/**
+ * Compresses a sequence of messages as one stream, so that every message benefits from the ones before.
+ *
+ * Every call to Compress() ends with a flush, i.e. the peer's StreamDecompressor can restore the
+ * message as soon as it has received the output, without waiting for further data. Both ends have
+ * to use the same algorithm and dictionary.
+ *
+ * @ingroup base
+ */
+class StreamCompressor
+{
+public:
+	static std::unique_ptr<StreamCompressor> Create(CompressionAlgorithm algorithm, const String& dictionary = String());
+
+	StreamCompressor() = default;
+	StreamCompressor(const StreamCompressor&) = delete;
+	StreamCompressor& operator=(const StreamCompressor&) = delete;
+	virtual ~StreamCompressor() = default;
+
+	virtual CompressionAlgorithm GetAlgorithm() const = 0;
+	virtual void Compress(const char *data, size_t size, std::string& output) = 0;
+};
+
+/**
+ * Restores the messages compressed by a StreamCompressor, in the order they were compressed.
+ *
+ * @ingroup base
+ */
+class StreamDecompressor
+{
+public:
+	static std::unique_ptr<StreamDecompressor> Create(CompressionAlgorithm algorithm, const String& dictionary = String());
+
+	StreamDecompressor() = default;
+	StreamDecompressor(const StreamDecompressor&) = delete;
+	StreamDecompressor& operator=(const StreamDecompressor&) = delete;
+	virtual ~StreamDecompressor() = default;
+
+	virtual CompressionAlgorithm GetAlgorithm() const = 0;
+	virtual void Decompress(const char *data, size_t size, std::string& output, size_t maxSize) = 0;
+};
+
+}
@@ -48,7 +48,7 @@ String::String(Value&& other)
 String& String::operator=(Value&& other)
 {
 	if (other.IsString())
-		*this = std::move(other.Get<String>()); // Will atomically bind to the move assignment operator below.
+		*this = std::move(other.GetMutableString()); // Will atomically bind to the move assignment operator below.
 	else
 		*this = static_cast<String>(other);
 
@@ -2,12 +2,29 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "base/threadpool.hpp"
-#include <boost/thread/locks.hpp>
+#include "base/application.hpp"
+#include "base/perfdatavalue.hpp"
+#include "base/statsfunction.hpp"
+#include <algorithm>
 
 using namespace icinga;
 
+REGISTER_STATSFUNCTION(ThreadPool, &ThreadPool::StatsFunc);
+
+/**
+ * The pool the current thread is a worker of, if any, and the worker's index.
+ */
+static thread_local ThreadPool *l_CurrentPool = nullptr;
+static thread_local size_t l_CurrentWorker = 0;
+
 ThreadPool::ThreadPool() : m_Pending(0)
 {
+	size_t workers = std::max(Configuration::Concurrency * 2u, 1u);
+
+	for (size_t i = 0; i < workers; i++) {
+		m_Workers.emplace_back(new Worker());
+	}
+
 	Start();
 }
 
@@ -18,35 +35,202 @@ ThreadPool::~ThreadPool()
 
 void ThreadPool::Start()
 {
-	boost::unique_lock<decltype(m_Mutex)> lock (m_Mutex);
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	if (m_Running)
+		return;
 
-	if (!m_Pool) {
-		InitializePool();
+	m_Stopping = false;
+
+	for (size_t i = 0; i < m_Workers.size(); i++) {
+		m_Workers[i]->Thread = std::thread([this, i]() { WorkerThreadProc(i); });
 	}
-}
 
-void ThreadPool::InitializePool()
-{
-	m_Pool = decltype(m_Pool)(new boost::asio::thread_pool(Configuration::Concurrency * 2u));
+	m_Running = true;
 }
 
+/**
+ * Waits for all queued work items to finish and stops the worker threads.
+ */
 void ThreadPool::Stop()
 {
-	boost::unique_lock<decltype(m_Mutex)> lock (m_Mutex);
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	if (!m_Running)
+		return;
 
-	if (m_Pool) {
-		m_Pool->join();
-		m_Pool = nullptr;
+	{
+		std::unique_lock<std::mutex> parkLock (m_ParkMutex);
+		m_Stopping = true;
 	}
+
+	m_ParkCV.notify_all();
+
+	for (auto& worker : m_Workers) {
+		worker->Thread.join();
+	}
+
+	m_Running = false;
 }
 
 void ThreadPool::Restart()
 {
-	boost::unique_lock<decltype(m_Mutex)> lock (m_Mutex);
+	Stop();
+	Start();
+}
+
+bool ThreadPool::Enqueue(Task task, SchedulerPolicy policy)
+{
+	/* Items are refused once the pool has stopped. The ones posted while Stop() waits for the workers
+	 * are still run, unless all workers have exited already. Those stay queued until the next Start(). */
+	if (!m_Running)
+		return false;
+
+	m_Pending.fetch_add(1);
+
+	if (policy == LowLatencyScheduler) {
+		std::unique_lock<std::mutex> lock (m_PriorityMutex);
+		m_PriorityTasks.emplace_back(std::move(task));
+		m_PrioritySize.fetch_add(1);
+	} else {
+		size_t index = l_CurrentPool == this
+			? l_CurrentWorker
+			: m_NextWorker.fetch_add(1, std::memory_order_relaxed) % m_Workers.size();
+
+		auto& worker (*m_Workers[index]);
+
+		std::unique_lock<std::mutex> lock (worker.Mutex);
+		worker.Tasks.emplace_back(std::move(task));
+		worker.Size.fetch_add(1);
+	}
+
+	/* Pairs with the m_Parked increment in WorkerThreadProc(). Taking the mutex makes sure
+	 * a worker which has seen no pending items is already waiting for the notification. */
+	if (m_Parked.load() > 0) {
+		std::unique_lock<std::mutex> lock (m_ParkMutex);
+		m_ParkCV.notify_one();
+	}
+
+	return true;
+}
+
+/**
+ * Takes the next work item for a worker: a LowLatencyScheduler one, one of its own
+ * or one stolen from another worker, in that order.
+ *
+ * @returns Whether there was a work item.
+ */
+bool ThreadPool::Dequeue(Worker& worker, size_t index, Task& task)
+{
+	if (m_PrioritySize.load() > 0) {
+		std::unique_lock<std::mutex> lock (m_PriorityMutex);
 
-	if (m_Pool) {
-		m_Pool->join();
+		if (!m_PriorityTasks.empty()) {
+			task = std::move(m_PriorityTasks.front());
+			m_PriorityTasks.pop_front();
+			m_PrioritySize.fetch_sub(1);
+			return true;
+		}
 	}
 
-	InitializePool();
+	if (worker.Size.load() > 0) {
+		std::unique_lock<std::mutex> lock (worker.Mutex);
+
+		if (!worker.Tasks.empty()) {
+			task = std::move(worker.Tasks.front());
+			worker.Tasks.pop_front();
+			worker.Size.fetch_sub(1);
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < m_Workers.size(); i++) {
+		auto& victim (*m_Workers[(index + i) % m_Workers.size()]);
+
+		if (victim.Size.load() == 0)
+			continue;
+
+		std::unique_lock<std::mutex> lock (victim.Mutex, std::try_to_lock);
+
+		/* Someone else is busy with this queue, don't wait for them. */
+		if (!lock || victim.Tasks.empty())
+			continue;
+
+		task = std::move(victim.Tasks.front());
+		victim.Tasks.pop_front();
+		victim.Size.fetch_sub(1);
+		worker.Steals.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::WorkerThreadProc(size_t index)
+{
+	auto& worker (*m_Workers[index]);
+
+	l_CurrentPool = this;
+	l_CurrentWorker = index;
+
+	for (;;) {
+		Task task;
+
+		if (!Dequeue(worker, index, task)) {
+			std::unique_lock<std::mutex> lock (m_ParkMutex);
+
+			m_Parked.fetch_add(1);
+
+			if (m_Pending.load() == 0) {
+				if (m_Stopping) {
+					m_Parked.fetch_sub(1);
+					break;
+				}
+
+				m_ParkCV.wait(lock);
+			}
+
+			m_Parked.fetch_sub(1);
+			continue;
+		}
+
+		m_Pending.fetch_sub(1);
+
+		try {
+			task();
+		} catch (const std::exception& ex) {
+			Log(LogCritical, "ThreadPool")
+				<< "Exception thrown in event handler:\n"
+				<< DiagnosticInformation(ex);
+		} catch (...) {
+			Log(LogCritical, "ThreadPool", "Exception of unknown type thrown in event handler.");
+		}
+	}
+
+	l_CurrentPool = nullptr;
+}
+
+void ThreadPool::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
+{
+	auto& tp (Application::GetTP());
+	size_t maxDepth = 0;
+	uint_fast64_t steals = 0;
+
+	for (auto& worker : tp.m_Workers) {
+		maxDepth = std::max(maxDepth, worker->Size.load());
+		steals += worker->Steals.load();
+	}
+
+	status->Set("threadpool", new Dictionary({
+		{ "workers", tp.m_Workers.size() },
+		{ "pending", tp.GetPending() },
+		{ "pending_low_latency", tp.m_PrioritySize.load() },
+		{ "max_worker_queue_depth", maxDepth },
+		{ "steals", steals }
+	}));
+
+	perfdata->Add(new PerfdataValue("threadpool_pending", tp.GetPending()));
+	perfdata->Add(new PerfdataValue("threadpool_pending_low_latency", tp.m_PrioritySize.load()));
+	perfdata->Add(new PerfdataValue("threadpool_max_worker_queue_depth", maxDepth));
+	perfdata->Add(new PerfdataValue("threadpool_steals", steals));
 }
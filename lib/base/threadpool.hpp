@@ -5,19 +5,23 @@
 #define THREADPOOL_H
 
 #include "base/atomic.hpp"
+#include "base/array.hpp"
 #include "base/configuration.hpp"
+#include "base/dictionary.hpp"
 #include "base/exception.hpp"
 #include "base/logger.hpp"
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
-#include <exception>
-#include <functional>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <thread>
-#include <boost/asio/post.hpp>
-#include <boost/asio/thread_pool.hpp>
-#include <boost/thread/locks.hpp>
-#include <boost/thread/shared_mutex.hpp>
-#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace icinga
 {
@@ -29,14 +33,132 @@ enum SchedulerPolicy
 };
 
 /**
- * A thread pool.
+ * A work-stealing thread pool.
+ *
+ * Every worker thread has a queue of its own. Work items posted by a worker thread go to its own
+ * queue, all others are distributed round-robin. Idle workers steal from the other workers' queues.
+ * Work items posted with LowLatencyScheduler go to a separate queue which workers always look at first.
  *
  * @ingroup base
  */
 class ThreadPool
 {
 public:
-	typedef std::function<void ()> WorkFunction;
+	/**
+	 * A move-only nullary callable which stores callables of up to InlineSize bytes in place
+	 * rather than on the heap, unlike std::function.
+	 */
+	class Task
+	{
+	public:
+		static constexpr size_t InlineSize = 64;
+
+		Task() = default;
+
+		template<class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+		Task(F&& func)
+		{
+			using Fn = std::decay_t<F>;
+
+			if constexpr (IsInline<Fn>()) {
+				new (&m_Storage) Fn(std::forward<F>(func));
+				m_Ops = &InlineOps<Fn>::Table;
+			} else {
+				new (&m_Storage) Fn*(new Fn(std::forward<F>(func)));
+				m_Ops = &HeapOps<Fn>::Table;
+			}
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		Task(Task&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other) {
+				Reset();
+
+				if (other.m_Ops) {
+					other.m_Ops->Move(&m_Storage, &other.m_Storage);
+					m_Ops = other.m_Ops;
+					other.m_Ops = nullptr;
+				}
+			}
+
+			return *this;
+		}
+
+		~Task()
+		{
+			Reset();
+		}
+
+		explicit operator bool() const
+		{
+			return m_Ops;
+		}
+
+		void operator()()
+		{
+			m_Ops->Invoke(&m_Storage);
+		}
+
+	private:
+		struct Ops
+		{
+			void (*Invoke)(void *storage);
+			void (*Move)(void *to, void *from);
+			void (*Destroy)(void *storage);
+		};
+
+		template<class Fn>
+		static constexpr bool IsInline()
+		{
+			return sizeof(Fn) <= InlineSize && alignof(Fn) <= alignof(std::max_align_t)
+				&& std::is_nothrow_move_constructible<Fn>::value;
+		}
+
+		template<class Fn>
+		struct InlineOps
+		{
+			static void Invoke(void *storage) { (*static_cast<Fn *>(storage))(); }
+
+			static void Move(void *to, void *from)
+			{
+				new (to) Fn(std::move(*static_cast<Fn *>(from)));
+				static_cast<Fn *>(from)->~Fn();
+			}
+
+			static void Destroy(void *storage) { static_cast<Fn *>(storage)->~Fn(); }
+
+			static constexpr Ops Table { &Invoke, &Move, &Destroy };
+		};
+
+		template<class Fn>
+		struct HeapOps
+		{
+			static void Invoke(void *storage) { (**static_cast<Fn **>(storage))(); }
+			static void Move(void *to, void *from) { new (to) Fn*(*static_cast<Fn **>(from)); }
+			static void Destroy(void *storage) { delete *static_cast<Fn **>(storage); }
+
+			static constexpr Ops Table { &Invoke, &Move, &Destroy };
+		};
+
+		void Reset()
+		{
+			if (m_Ops) {
+				m_Ops->Destroy(&m_Storage);
+				m_Ops = nullptr;
+			}
+		}
+
+		const Ops *m_Ops{nullptr};
+		std::aligned_storage_t<InlineSize, alignof(std::max_align_t)> m_Storage;
+	};
 
 	ThreadPool();
 	~ThreadPool();
@@ -46,37 +168,17 @@ public:
 	void Restart();
 
 	/**
-	 * Appends a work item to the work queue. Work items will be processed in FIFO order.
+	 * Appends a work item to a work queue. Work items posted by the same thread are started in FIFO order
+	 * unless they are stolen by another worker, LowLatencyScheduler work items before all other ones.
 	 *
 	 * @param callback The callback function for the work item.
+	 * @param policy The scheduler policy.
 	 * @returns true if the item was queued, false otherwise.
 	 */
 	template<class T>
-	bool Post(T callback, SchedulerPolicy)
+	bool Post(T callback, SchedulerPolicy policy)
 	{
-		boost::shared_lock<decltype(m_Mutex)> lock (m_Mutex);
-
-		if (m_Pool) {
-			m_Pending.fetch_add(1);
-
-			boost::asio::post(*m_Pool, [this, callback]() {
-				m_Pending.fetch_sub(1);
-
-				try {
-					callback();
-				} catch (const std::exception& ex) {
-					Log(LogCritical, "ThreadPool")
-						<< "Exception thrown in event handler:\n"
-						<< DiagnosticInformation(ex);
-				} catch (...) {
-					Log(LogCritical, "ThreadPool", "Exception of unknown type thrown in event handler.");
-				}
-			});
-
-			return true;
-		} else {
-			return false;
-		}
+		return Enqueue(Task(std::move(callback)), policy);
 	}
 
 	/**
@@ -89,12 +191,37 @@ public:
 		return m_Pending.load();
 	}
 
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+
 private:
-	boost::shared_mutex m_Mutex;
-	std::unique_ptr<boost::asio::thread_pool> m_Pool;
+	struct Worker
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+		std::atomic<size_t> Size{0};
+		std::atomic<uint_fast64_t> Steals{0};
+		std::thread Thread;
+	};
+
+	std::mutex m_Mutex; /**< Serializes Start() and Stop(). */
+	std::vector<std::unique_ptr<Worker>> m_Workers;
+	std::atomic<bool> m_Running{false};
+	std::atomic<bool> m_Stopping{false};
+	std::atomic<size_t> m_NextWorker{0};
+
+	std::mutex m_PriorityMutex;
+	std::deque<Task> m_PriorityTasks;
+	std::atomic<size_t> m_PrioritySize{0};
+
+	std::mutex m_ParkMutex;
+	std::condition_variable m_ParkCV;
+	std::atomic<size_t> m_Parked{0};
+
 	Atomic<uint_fast64_t> m_Pending;
 
-	void InitializePool();
+	bool Enqueue(Task task, SchedulerPolicy policy);
+	bool Dequeue(Worker& worker, size_t index, Task& task);
+	void WorkerThreadProc(size_t index);
 };
 
 }
@@ -6,66 +6,145 @@
 #include "base/debug.hpp"
 #include "base/logger.hpp"
 #include "base/utility.hpp"
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/key_extractors.hpp>
+#include "base/convert.hpp"
+#include "base/perfdatavalue.hpp"
+#include "base/statsfunction.hpp"
+#include "base/timing-wheel.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <utility>
+#include <vector>
 
 using namespace icinga;
 
+REGISTER_STATSFUNCTION(Timer, &Timer::StatsFunc);
+
 namespace icinga {
 
+/**
+ * A shard of the timer subsystem. Keeps the started timers which have been assigned
+ * to it in a timing wheel and fires them from its own thread.
+ */
 class TimerHolder {
 public:
-	TimerHolder(Timer *timer)
-		: m_Timer(timer)
+	/* Upper bounds (in seconds) of the lateness histogram buckets, the last bucket is unbounded. */
+	static constexpr std::array<double, 5> LatenessBuckets {{ 0.001, 0.01, 0.1, 1, 10 }};
+
+	std::mutex Mutex;
+	std::condition_variable CV;
+	std::thread Thread;
+	bool Stopped{false};
+	int AliveTimers{0};
+
+	/* Timers fire up to 10ms early, just like they always did. */
+	TimingWheel<Timer *> Timers{0.01, Utility::GetTime()};
+
+	std::array<uint64_t, LatenessBuckets.size() + 1> Lateness{};
+	double MaxLateness{0};
+
+	TimerHolder(size_t index)
+		: m_Index(index)
 	{ }
 
-	inline Timer *GetObject() const
+	/**
+	 * Starts the worker thread unless it's running already. The caller must hold the holder's lock.
+	 */
+	void InitializeThread()
 	{
-		return m_Timer;
+		Stopped = false;
+
+		if (!Thread.joinable())
+			Thread = std::thread([this]() { ThreadProc(); });
 	}
 
-	inline double GetNextUnlocked() const
+	/**
+	 * Stops the worker thread. The caller must hold the holder's lock.
+	 */
+	void UninitializeThread(std::unique_lock<std::mutex>& lock)
 	{
-		return m_Timer->m_Next;
+		Stopped = true;
+		CV.notify_all();
+
+		lock.unlock();
+
+		if (Thread.joinable())
+			Thread.join();
+
+		lock.lock();
 	}
 
-	operator Timer *() const
+	void RecordLateness(double lateness)
 	{
-		return m_Timer;
+		size_t bucket = 0;
+
+		while (bucket < LatenessBuckets.size() && lateness > LatenessBuckets[bucket])
+			bucket++;
+
+		Lateness[bucket]++;
+		MaxLateness = std::max(MaxLateness, lateness);
 	}
 
+	static std::vector<std::unique_ptr<TimerHolder>>& GetHolders();
+	static TimerHolder *GetNextHolder();
+
 private:
-	Timer *m_Timer;
+	size_t m_Index;
+
+	void ThreadProc();
 };
 
 }
 
-typedef boost::multi_index_container<
-	TimerHolder,
-	boost::multi_index::indexed_by<
-		boost::multi_index::ordered_unique<boost::multi_index::const_mem_fun<TimerHolder, Timer *, &TimerHolder::GetObject> >,
-		boost::multi_index::ordered_non_unique<boost::multi_index::const_mem_fun<TimerHolder, double, &TimerHolder::GetNextUnlocked> >
-	>
-> TimerSet;
-
-static std::mutex l_TimerMutex;
-static std::condition_variable l_TimerCV;
-static std::thread l_TimerThread;
-static bool l_StopTimerThread;
-static TimerSet l_Timers;
-static int l_AliveTimers = 0;
+constexpr std::array<double, 5> TimerHolder::LatenessBuckets;
 
 static Defer l_ShutdownTimersCleanlyOnExit (&Timer::Uninitialize);
 
+/**
+ * Returns all timer shards, one per CPU.
+ *
+ * The shards are intentionally never destroyed, they have to outlive the static
+ * destructors which may still stop timers.
+ */
+std::vector<std::unique_ptr<TimerHolder>>& TimerHolder::GetHolders()
+{
+	static auto *holders = [] {
+		auto *holders = new std::vector<std::unique_ptr<TimerHolder>>();
+		size_t count = std::min(std::max(std::thread::hardware_concurrency(), 1u), 16u);
+
+		for (size_t i = 0; i < count; i++)
+			holders->emplace_back(new TimerHolder(i));
+
+		return holders;
+	}();
+
+	return *holders;
+}
+
+/**
+ * Picks the shard for a new timer in a round-robin fashion.
+ */
+TimerHolder *TimerHolder::GetNextHolder()
+{
+	static std::atomic<size_t> next (0);
+
+	auto& holders (GetHolders());
+
+	return holders[next.fetch_add(1, std::memory_order_relaxed) % holders.size()].get();
+}
+
+Timer::Timer(TimerHolder *holder)
+	: m_Holder(holder)
+{ }
+
 Timer::Ptr Timer::Create()
 {
-	Ptr t (new Timer());
+	Ptr t (new Timer(TimerHolder::GetNextHolder()));
 
 	t->m_Self = t;
 
@@ -82,41 +161,25 @@ Timer::~Timer()
 
 void Timer::Initialize()
 {
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
-
-	if (l_AliveTimers > 0) {
-		InitializeThread();
+	for (auto& holder : TimerHolder::GetHolders()) {
+		std::unique_lock<std::mutex> lock(holder->Mutex);
+
+		if (holder->AliveTimers > 0) {
+			holder->InitializeThread();
+		} else {
+			/* The thread is started by the next Start(). */
+			holder->Stopped = false;
+		}
 	}
 }
 
 void Timer::Uninitialize()
 {
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
-
-	if (l_AliveTimers > 0) {
-		UninitializeThread();
-	}
-}
-
-void Timer::InitializeThread()
-{
-	l_StopTimerThread = false;
-	l_TimerThread = std::thread(&Timer::TimerThreadProc);
-}
+	for (auto& holder : TimerHolder::GetHolders()) {
+		std::unique_lock<std::mutex> lock(holder->Mutex);
 
-void Timer::UninitializeThread()
-{
-	{
-		l_StopTimerThread = true;
-		l_TimerCV.notify_all();
+		holder->UninitializeThread(lock);
 	}
-
-	l_TimerMutex.unlock();
-
-	if (l_TimerThread.joinable())
-		l_TimerThread.join();
-
-	l_TimerMutex.lock();
 }
 
 /**
@@ -142,7 +205,7 @@ void Timer::Call()
  */
 void Timer::SetInterval(double interval)
 {
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
+	std::unique_lock<std::mutex> lock(m_Holder->Mutex);
 	m_Interval = interval;
 }
 
@@ -153,7 +216,7 @@ void Timer::SetInterval(double interval)
  */
 double Timer::GetInterval() const
 {
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
+	std::unique_lock<std::mutex> lock(m_Holder->Mutex);
 	return m_Interval;
 }
 
@@ -162,10 +225,12 @@ double Timer::GetInterval() const
  */
 void Timer::Start()
 {
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
+	std::unique_lock<std::mutex> lock(m_Holder->Mutex);
 
-	if (!m_Started && ++l_AliveTimers == 1) {
-		InitializeThread();
+	/* A shard's thread is started along with its first timer. Between Uninitialize()
+	 * and Initialize() it's started by the latter. */
+	if (!m_Started && ++m_Holder->AliveTimers == 1 && !m_Holder->Stopped) {
+		m_Holder->InitializeThread();
 	}
 
 	m_Started = true;
@@ -178,23 +243,25 @@ void Timer::Start()
  */
 void Timer::Stop(bool wait)
 {
-	if (l_StopTimerThread)
+	if (m_Holder->Stopped)
 		return;
 
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
+	std::unique_lock<std::mutex> lock(m_Holder->Mutex);
 
-	if (m_Started && --l_AliveTimers == 0) {
-		UninitializeThread();
+	/* The shard's thread just waits for the next timer, instead of being joined and recreated
+	 * whenever its timers come and go. */
+	if (m_Started) {
+		m_Holder->AliveTimers--;
 	}
 
 	m_Started = false;
-	l_Timers.erase(this);
+	m_Holder->Timers.Erase(this);
 
 	/* Notify the worker thread that we've disabled a timer. */
-	l_TimerCV.notify_all();
+	m_Holder->CV.notify_all();
 
 	while (wait && m_Running)
-		l_TimerCV.wait(lock);
+		m_Holder->CV.wait(lock);
 }
 
 void Timer::Reschedule(double next)
@@ -204,7 +271,7 @@ void Timer::Reschedule(double next)
 
 void Timer::InternalReschedule(bool completed, double next)
 {
-	std::unique_lock<std::mutex> lock (l_TimerMutex);
+	std::unique_lock<std::mutex> lock (m_Holder->Mutex);
 
 	InternalRescheduleUnlocked(completed, next);
 }
@@ -232,12 +299,11 @@ void Timer::InternalRescheduleUnlocked(bool completed, double next)
 	m_Next = next;
 
 	if (m_Started && !m_Running) {
-		/* Remove and re-add the timer to update the index. */
-		l_Timers.erase(this);
-		l_Timers.insert(this);
+		/* Insert the timer or update its position in the wheel. */
+		m_Holder->Timers.Insert(this, m_Next);
 
 		/* Notify the worker that we've rescheduled a timer. */
-		l_TimerCV.notify_all();
+		m_Holder->CV.notify_all();
 	}
 }
 
@@ -248,7 +314,7 @@ void Timer::InternalRescheduleUnlocked(bool completed, double next)
  */
 double Timer::GetNext() const
 {
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
+	std::unique_lock<std::mutex> lock(m_Holder->Mutex);
 	return m_Next;
 }
 
@@ -260,81 +326,125 @@ double Timer::GetNext() const
  */
 void Timer::AdjustTimers(double adjustment)
 {
-	std::unique_lock<std::mutex> lock(l_TimerMutex);
-
 	double now = Utility::GetTime();
 
-	typedef boost::multi_index::nth_index<TimerSet, 1>::type TimerView;
-	TimerView& idx = boost::get<1>(l_Timers);
+	for (auto& holder : TimerHolder::GetHolders()) {
+		std::unique_lock<std::mutex> lock(holder->Mutex);
 
-	std::vector<Timer *> timers;
+		std::vector<Timer *> timers;
 
-	for (Timer *timer : idx) {
-		/* Don't schedule the next call if this is not a periodic timer. */
-		if (timer->m_Interval <= 0) {
-			continue;
-		}
+		holder->Timers.ForEach([&timers](Timer *timer, double) { timers.push_back(timer); });
+
+		/* The clock jumped, re-place all timers relative to the current time. */
+		holder->Timers.Rebase(now);
+
+		for (Timer *timer : timers) {
+			/* Don't schedule the next call if this is not a periodic timer. */
+			if (timer->m_Interval <= 0) {
+				continue;
+			}
 
-		if (std::fabs(now - (timer->m_Next + adjustment)) <
-			std::fabs(now - timer->m_Next)) {
-			timer->m_Next += adjustment;
-			timers.push_back(timer);
+			if (std::fabs(now - (timer->m_Next + adjustment)) <
+				std::fabs(now - timer->m_Next)) {
+				timer->m_Next += adjustment;
+				holder->Timers.Insert(timer, timer->m_Next);
+			}
 		}
+
+		/* Notify the worker that we've rescheduled some timers. */
+		holder->CV.notify_all();
+	}
+}
+
+/**
+ * Returns the number of timers and a histogram of how late they have fired.
+ */
+void Timer::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
+{
+	std::array<uint64_t, TimerHolder::LatenessBuckets.size() + 1> lateness{};
+	double maxLateness = 0;
+	size_t timers = 0;
+	auto& holders (TimerHolder::GetHolders());
+
+	for (auto& holder : holders) {
+		std::unique_lock<std::mutex> lock(holder->Mutex);
+
+		for (size_t i = 0; i < lateness.size(); i++)
+			lateness[i] += holder->Lateness[i];
+
+		maxLateness = std::max(maxLateness, holder->MaxLateness);
+		timers += holder->AliveTimers;
 	}
 
-	for (Timer *timer : timers) {
-		l_Timers.erase(timer);
-		l_Timers.insert(timer);
+	DictionaryData histogram;
+
+	for (size_t i = 0; i < lateness.size(); i++) {
+		String bucket = i < TimerHolder::LatenessBuckets.size() ? "le_" + Convert::ToString(TimerHolder::LatenessBuckets[i]) : "inf";
+
+		histogram.emplace_back(bucket, lateness[i]);
+		perfdata->Add(new PerfdataValue("timer_lateness_" + bucket, lateness[i]));
 	}
 
-	/* Notify the worker that we've rescheduled some timers. */
-	l_TimerCV.notify_all();
+	status->Set("timer", new Dictionary({
+		{ "shards", holders.size() },
+		{ "timers", timers },
+		{ "max_lateness", maxLateness },
+		{ "lateness", new Dictionary(std::move(histogram)) }
+	}));
+
+	perfdata->Add(new PerfdataValue("timer_max_lateness", maxLateness));
 }
 
 /**
  * Worker thread proc for Timer objects.
  */
-void Timer::TimerThreadProc()
+void TimerHolder::ThreadProc()
 {
 	namespace ch = std::chrono;
 
 	Log(LogDebug, "Timer", "TimerThreadProc started.");
 
-	Utility::SetThreadName("Timer Thread");
+	if (GetHolders().size() > 1)
+		Utility::SetThreadName("Timer Thread " + Convert::ToString(m_Index));
+	else
+		Utility::SetThreadName("Timer Thread");
 
-	std::unique_lock<std::mutex> lock (l_TimerMutex);
+	std::unique_lock<std::mutex> lock (Mutex);
 
 	for (;;) {
-		typedef boost::multi_index::nth_index<TimerSet, 1>::type NextTimerView;
-		NextTimerView& idx = boost::get<1>(l_Timers);
-
 		/* Wait until there is at least one timer. */
-		while (idx.empty() && !l_StopTimerThread)
-			l_TimerCV.wait(lock);
+		while (Timers.IsEmpty() && !Stopped)
+			CV.wait(lock);
 
-		if (l_StopTimerThread)
+		if (Stopped)
 			break;
 
-		auto it = idx.begin();
+		double now = Utility::GetTime();
 
-		// timer->~Timer() may be called at any moment (if the last
-		// smart pointer gets destroyed) or even already waiting for
-		// l_TimerMutex (before doing anything else) which we have
-		// locked at the moment. Until our unlock using *timer is safe.
-		Timer *timer = *it;
+		/* The clock went backwards, don't let the timers fire too early. */
+		if (now < Timers.GetCursorTime() - 1)
+			Timers.Rebase(now);
 
-		ch::time_point<ch::system_clock, ch::duration<double>> next (ch::duration<double>(timer->m_Next));
+		Timers.Advance(now);
+
+		if (!Timers.HasDue()) {
+			ch::time_point<ch::system_clock, ch::duration<double>> next (ch::duration<double>(Timers.GetNextExpiry()));
 
-		if (next - ch::system_clock::now() > ch::duration<double>(0.01)) {
 			/* Wait for the next timer. */
-			l_TimerCV.wait_until(lock, next);
+			CV.wait_until(lock, next);
 
 			continue;
 		}
 
-		/* Remove the timer from the list so it doesn't get called again
+		// timer->~Timer() may be called at any moment (if the last
+		// smart pointer gets destroyed) or even already waiting for
+		// Mutex (before doing anything else) which we have
+		// locked at the moment. Until our unlock using *timer is safe.
+		Timer *timer = Timers.GetFirstDue();
+
+		/* Remove the timer from the wheel so it doesn't get called again
 		 * until the current call is completed. */
-		l_Timers.erase(timer);
+		Timers.PopDue();
 
 		auto keepAlive (timer->m_Self.lock());
 
@@ -343,6 +453,8 @@ void Timer::TimerThreadProc()
 			continue;
 		}
 
+		RecordLateness(now - timer->m_Next);
+
 		timer->m_Running = true;
 
 		lock.unlock();
@@ -5,6 +5,8 @@
 #define TIMER_H
 
 #include "base/i2-base.hpp"
+#include "base/dictionary.hpp"
+#include "base/array.hpp"
 #include <boost/signals2.hpp>
 #include <memory>
 
@@ -15,6 +17,9 @@ class TimerHolder;
 /**
  * A timer that periodically triggers an event.
  *
+ * Timers are distributed across a number of shards (one per CPU) which each
+ * keep their timers in a timing wheel and fire them from their own thread.
+ *
  * @ingroup base
  */
 class Timer final
@@ -28,8 +33,6 @@ public:
 
 	static void Initialize();
 	static void Uninitialize();
-	static void InitializeThread();
-	static void UninitializeThread();
 
 	void SetInterval(double interval);
 	double GetInterval() const;
@@ -42,6 +45,8 @@ public:
 	void Reschedule(double next = -1);
 	double GetNext() const;
 
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+
 	boost::signals2::signal<void(const Timer * const&)> OnTimerExpired;
 
 private:
@@ -50,14 +55,13 @@ private:
 	bool m_Started{false}; /**< Whether the timer is enabled. */
 	bool m_Running{false}; /**< Whether the timer proc is currently running. */
 	std::weak_ptr<Timer> m_Self;
+	TimerHolder *m_Holder; /**< The shard this timer belongs to. */
 
-	Timer() = default;
+	explicit Timer(TimerHolder *holder);
 	void Call();
 	void InternalReschedule(bool completed, double next = -1);
 	void InternalRescheduleUnlocked(bool completed, double next = -1);
 
-	static void TimerThreadProc();
-
 	friend class TimerHolder;
 };
 
@@ -0,0 +1,513 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif /* _MSC_VER */
+
+namespace icinga
+{
+
+/**
+ * A hierarchical timing wheel which keeps a set of unique items ordered by a timestamp.
+ *
+ * Timestamps are quantized into ticks of the given resolution. Each of the wheel's levels
+ * consists of 64 slots and a slot of level n spans 64^n ticks. Items are placed into the
+ * lowest level that covers their due time and cascade down to the lower levels while the
+ * wheel advances. Inserting, rescheduling and removing items are O(1) operations and don't
+ * allocate memory once the wheel has grown to its working set size.
+ *
+ * Advance() moves all items which are due into a FIFO list from which they can be retrieved
+ * in tick order. Items which are due within the same tick aren't ordered.
+ *
+ * This class is not thread-safe.
+ *
+ * @ingroup base
+ */
+template<typename T, typename Hash = std::hash<T>>
+class TimingWheel
+{
+public:
+	/**
+	 * Creates an empty timing wheel.
+	 *
+	 * @param resolution The length of a tick in seconds.
+	 * @param now The current time, i.e. the first tick the wheel will expire.
+	 */
+	TimingWheel(double resolution, double now)
+		: m_Resolution(resolution), m_Cursor(ToTick(now))
+	{
+		for (auto& level : m_Slots) {
+			level.fill(npos);
+		}
+
+		m_Bitmaps.fill(0);
+	}
+
+	TimingWheel(const TimingWheel&) = delete;
+	TimingWheel& operator=(const TimingWheel&) = delete;
+
+	/**
+	 * Inserts an item into the wheel or reschedules it if it's already part of the wheel.
+	 *
+	 * @param item The item.
+	 * @param when The time the item is due.
+	 */
+	void Insert(const T& item, double when)
+	{
+		uint32_t node;
+		auto it (m_Index.find(item));
+
+		if (it == m_Index.end()) {
+			node = AllocateNode(item);
+			m_Index.emplace(item, node);
+		} else {
+			node = it->second;
+			Unlink(node);
+		}
+
+		m_Nodes[node].When = when;
+		Place(node);
+	}
+
+	/**
+	 * Removes an item from the wheel.
+	 *
+	 * @param item The item.
+	 * @returns Whether the item was part of the wheel.
+	 */
+	bool Erase(const T& item)
+	{
+		auto it (m_Index.find(item));
+
+		if (it == m_Index.end()) {
+			return false;
+		}
+
+		uint32_t node = it->second;
+
+		m_Index.erase(it);
+		Unlink(node);
+		FreeNode(node);
+
+		return true;
+	}
+
+	bool Contains(const T& item) const
+	{
+		return m_Index.find(item) != m_Index.end();
+	}
+
+	size_t GetLength() const
+	{
+		return m_Index.size();
+	}
+
+	bool IsEmpty() const
+	{
+		return m_Index.empty();
+	}
+
+	/**
+	 * Moves all items which are due at the specified time into the list of due items.
+	 *
+	 * @param now The current time.
+	 */
+	void Advance(double now)
+	{
+		uint64_t target = ToTick(now);
+
+		while (m_Cursor <= target) {
+			/* Expire all non-empty level 0 slots up to the target or the end of the current round. */
+			uint64_t stop = std::min(target + 1u, (m_Cursor | (SlotCount - 1)) + 1u);
+			unsigned first = m_Cursor & (SlotCount - 1);
+			unsigned last = (stop - 1u) & (SlotCount - 1);
+			uint64_t mask = m_Bitmaps[0] & (~uint64_t(0) >> (SlotCount - 1 - last)) & (~uint64_t(0) << first);
+
+			while (mask) {
+				unsigned slot = CountTrailingZeros(mask);
+				mask &= mask - 1u;
+
+				uint32_t node = TakeSlot(0, slot);
+
+				while (node != npos) {
+					uint32_t next = m_Nodes[node].Next;
+					LinkDue(node);
+					node = next;
+				}
+			}
+
+			m_Cursor = stop;
+
+			if ((m_Cursor & (SlotCount - 1)) == 0) {
+				Cascade(1);
+			}
+		}
+	}
+
+	/**
+	 * Re-places all items relative to the specified time. Use this if the clock
+	 * went backwards, so that items aren't considered due too early.
+	 *
+	 * @param now The current time.
+	 */
+	void Rebase(double now)
+	{
+		std::vector<uint32_t> due;
+
+		for (auto& level : m_Slots) {
+			level.fill(npos);
+		}
+
+		m_Bitmaps.fill(0);
+		m_DueHead = npos;
+		m_DueTail = npos;
+		m_Cursor = ToTick(now);
+
+		for (auto& entry : m_Index) {
+			if (ToTick(m_Nodes[entry.second].When) < m_Cursor) {
+				due.emplace_back(entry.second);
+			} else {
+				Place(entry.second);
+			}
+		}
+
+		/* The index isn't ordered, but the due list has to be. */
+		std::sort(due.begin(), due.end(), [this](uint32_t a, uint32_t b) { return m_Nodes[a].When < m_Nodes[b].When; });
+
+		for (uint32_t node : due) {
+			LinkDue(node);
+		}
+	}
+
+	/**
+	 * Returns the beginning of the first tick which hasn't been expired yet.
+	 */
+	double GetCursorTime() const
+	{
+		return m_Cursor * m_Resolution;
+	}
+
+	/**
+	 * Calls the specified function for every item and its due time.
+	 *
+	 * @param func The function, must not modify the wheel.
+	 */
+	template<typename F>
+	void ForEach(const F& func) const
+	{
+		for (auto& entry : m_Index) {
+			func(entry.first, m_Nodes[entry.second].When);
+		}
+	}
+
+	bool HasDue() const
+	{
+		return m_DueHead != npos;
+	}
+
+	/**
+	 * Returns the earliest time an item might become due.
+	 *
+	 * If there are due items, this is the time of the first due item. Otherwise this is
+	 * the beginning of the next non-empty slot, i.e. a lower bound for the next item.
+	 *
+	 * @returns The timestamp or +Inf if the wheel is empty.
+	 */
+	double GetNextExpiry() const
+	{
+		if (m_DueHead != npos) {
+			return m_Nodes[m_DueHead].When;
+		}
+
+		uint64_t next = std::numeric_limits<uint64_t>::max();
+
+		for (unsigned level = 0; level < LevelCount; level++) {
+			if (!m_Bitmaps[level]) {
+				continue;
+			}
+
+			unsigned shift = level * SlotBits;
+			unsigned current = (m_Cursor >> shift) & (SlotCount - 1);
+			uint64_t rotated = RotateRight(m_Bitmaps[level], current);
+			uint64_t distance;
+
+			if (level == 0) {
+				distance = CountTrailingZeros(rotated);
+				next = std::min(next, m_Cursor + distance);
+			} else {
+				/* The current slot of the upper levels has already been cascaded, items in it are due in the next round. */
+				rotated &= ~uint64_t(1);
+				distance = rotated ? CountTrailingZeros(rotated) : SlotCount;
+				next = std::min(next, ((m_Cursor >> shift) + distance) << shift);
+			}
+		}
+
+		if (next == std::numeric_limits<uint64_t>::max()) {
+			return std::numeric_limits<double>::infinity();
+		}
+
+		return next * m_Resolution;
+	}
+
+	/**
+	 * Returns the first due item. Must not be called unless HasDue() is true.
+	 */
+	const T& GetFirstDue() const
+	{
+		return m_Nodes[m_DueHead].Item;
+	}
+
+	/**
+	 * Returns the time the first due item was scheduled for. Must not be called unless HasDue() is true.
+	 */
+	double GetFirstDueTime() const
+	{
+		return m_Nodes[m_DueHead].When;
+	}
+
+	/**
+	 * Removes the first due item from the wheel. Must not be called unless HasDue() is true.
+	 *
+	 * @returns The item.
+	 */
+	T PopDue()
+	{
+		uint32_t node = m_DueHead;
+		T item (std::move(m_Nodes[node].Item));
+
+		m_Index.erase(item);
+		Unlink(node);
+		FreeNode(node);
+
+		return item;
+	}
+
+private:
+	static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+	static constexpr unsigned SlotBits = 6;
+	static constexpr unsigned SlotCount = 1u << SlotBits;
+	static constexpr unsigned LevelCount = 6;
+	static constexpr uint8_t DueLevel = LevelCount;
+
+	struct Node
+	{
+		T Item;
+		double When;
+		uint32_t Prev;
+		uint32_t Next;
+		uint8_t Level;
+		uint8_t Slot;
+	};
+
+	double m_Resolution;
+	uint64_t m_Cursor; /**< The next tick which hasn't been expired yet. */
+
+	std::vector<Node> m_Nodes;
+	uint32_t m_FreeNodes{npos};
+	std::unordered_map<T, uint32_t, Hash> m_Index;
+
+	std::array<std::array<uint32_t, SlotCount>, LevelCount> m_Slots;
+	std::array<uint64_t, LevelCount> m_Bitmaps;
+	uint32_t m_DueHead{npos};
+	uint32_t m_DueTail{npos};
+
+	static unsigned CountTrailingZeros(uint64_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+#else /* _MSC_VER */
+		return __builtin_ctzll(value);
+#endif /* _MSC_VER */
+	}
+
+	static uint64_t RotateRight(uint64_t value, unsigned count)
+	{
+		return count ? (value >> count) | (value << (SlotCount - count)) : value;
+	}
+
+	uint64_t ToTick(double when) const
+	{
+		/* Allow for rounding errors, so that GetNextExpiry() results map to the tick they were calculated from. */
+		double tick = std::floor(when / m_Resolution + 1e-6);
+
+		if (!(tick > 0)) {
+			return 0;
+		}
+
+		/* Keep a safety margin so that we can still add the span of the top level without overflowing. */
+		if (tick >= 1e18) {
+			return uint64_t(1e18);
+		}
+
+		return static_cast<uint64_t>(tick);
+	}
+
+	uint32_t AllocateNode(const T& item)
+	{
+		uint32_t node;
+
+		if (m_FreeNodes != npos) {
+			node = m_FreeNodes;
+			m_FreeNodes = m_Nodes[node].Next;
+			m_Nodes[node].Item = item;
+		} else {
+			node = m_Nodes.size();
+			m_Nodes.push_back(Node{item, 0, npos, npos, 0, 0});
+		}
+
+		return node;
+	}
+
+	void FreeNode(uint32_t node)
+	{
+		/* Release any resources held by the item. */
+		m_Nodes[node].Item = T();
+		m_Nodes[node].Next = m_FreeNodes;
+		m_FreeNodes = node;
+	}
+
+	uint32_t& GetHead(const Node& n)
+	{
+		return n.Level == DueLevel ? m_DueHead : m_Slots[n.Level][n.Slot];
+	}
+
+	/**
+	 * Puts a node into the slot matching its due time relative to the current cursor.
+	 */
+	void Place(uint32_t node)
+	{
+		Node& n = m_Nodes[node];
+		uint64_t tick = ToTick(n.When);
+
+		if (tick < m_Cursor) {
+			LinkDue(node);
+			return;
+		}
+
+		uint64_t delta = tick - m_Cursor;
+		unsigned level = 0;
+
+		while (level < LevelCount - 1 && delta >> (SlotBits * (level + 1))) {
+			level++;
+		}
+
+		if (level == LevelCount - 1) {
+			uint64_t span = uint64_t(1) << (SlotBits * LevelCount);
+
+			/* Items beyond the wheel's range are parked in the farthest slot of the top level. */
+			if (delta >= span) {
+				tick = m_Cursor + span - 1u;
+			}
+		}
+
+		unsigned slot = (tick >> (SlotBits * level)) & (SlotCount - 1);
+		uint32_t& head = m_Slots[level][slot];
+
+		n.Level = level;
+		n.Slot = slot;
+		n.Prev = npos;
+		n.Next = head;
+
+		if (head != npos) {
+			m_Nodes[head].Prev = node;
+		}
+
+		head = node;
+		m_Bitmaps[level] |= uint64_t(1) << slot;
+	}
+
+	void LinkDue(uint32_t node)
+	{
+		Node& n = m_Nodes[node];
+
+		n.Level = DueLevel;
+		n.Slot = 0;
+		n.Prev = m_DueTail;
+		n.Next = npos;
+
+		if (m_DueTail != npos) {
+			m_Nodes[m_DueTail].Next = node;
+		} else {
+			m_DueHead = node;
+		}
+
+		m_DueTail = node;
+	}
+
+	void Unlink(uint32_t node)
+	{
+		Node& n = m_Nodes[node];
+
+		if (n.Prev != npos) {
+			m_Nodes[n.Prev].Next = n.Next;
+		} else {
+			GetHead(n) = n.Next;
+		}
+
+		if (n.Next != npos) {
+			m_Nodes[n.Next].Prev = n.Prev;
+		} else if (n.Level == DueLevel) {
+			m_DueTail = n.Prev;
+		}
+
+		if (n.Level != DueLevel && m_Slots[n.Level][n.Slot] == npos) {
+			m_Bitmaps[n.Level] &= ~(uint64_t(1) << n.Slot);
+		}
+	}
+
+	/**
+	 * Detaches all nodes from a slot.
+	 *
+	 * @returns The first node of the detached list.
+	 */
+	uint32_t TakeSlot(unsigned level, unsigned slot)
+	{
+		uint32_t node = m_Slots[level][slot];
+
+		m_Slots[level][slot] = npos;
+		m_Bitmaps[level] &= ~(uint64_t(1) << slot);
+
+		return node;
+	}
+
+	/**
+	 * Redistributes the current slot of the specified level into the lower levels.
+	 */
+	void Cascade(unsigned level)
+	{
+		if (level >= LevelCount) {
+			return;
+		}
+
+		unsigned slot = (m_Cursor >> (SlotBits * level)) & (SlotCount - 1);
+
+		if (slot == 0) {
+			Cascade(level + 1);
+		}
+
+		uint32_t node = TakeSlot(level, slot);
+
+		while (node != npos) {
+			uint32_t next = m_Nodes[node].Next;
+			Place(node);
+			node = next;
+		}
+	}
+};
+
+}
@@ -5,106 +5,97 @@
 #include "base/array.hpp"
 #include "base/dictionary.hpp"
 #include "base/type.hpp"
+#include <typeinfo>
 
 using namespace icinga;
 
-template class boost::variant<boost::blank, double, bool, String, Object::Ptr>;
-template const double& Value::Get<double>() const;
-template double& Value::Get<double>();
-template const bool& Value::Get<bool>() const;
-template bool& Value::Get<bool>();
-template const String& Value::Get<String>() const;
-template String& Value::Get<String>();
-template const Object::Ptr& Value::Get<Object::Ptr>() const;
-template Object::Ptr& Value::Get<Object::Ptr>();
+static_assert(sizeof(Value) <= 16, "Value should consist of two machine words at most");
 
 const Value icinga::Empty;
 
 Value::Value(std::nullptr_t)
+	: Value()
 { }
 
 Value::Value(int value)
-	: m_Value(double(value))
+	: Value(double(value))
 { }
 
 Value::Value(unsigned int value)
-	: m_Value(double(value))
+	: Value(double(value))
 { }
 
 Value::Value(long value)
-	: m_Value(double(value))
+	: Value(double(value))
 { }
 
 Value::Value(unsigned long value)
-	: m_Value(double(value))
+	: Value(double(value))
 { }
 
 Value::Value(long long value)
-	: m_Value(double(value))
+	: Value(double(value))
 { }
 
 Value::Value(unsigned long long value)
-	: m_Value(double(value))
+	: Value(double(value))
 { }
 
 Value::Value(double value)
-	: m_Value(value)
+	: m_Number(value), m_Type(ValueNumber)
 { }
 
 Value::Value(bool value)
-	: m_Value(value)
+	: m_Boolean(value), m_Type(ValueBoolean)
 { }
 
 Value::Value(const String& value)
-	: m_Value(value)
+	: m_String(new StringBuffer{{1}, value}), m_Type(ValueString)
 { }
 
 Value::Value(String&& value)
-	: m_Value(value)
+	: m_String(new StringBuffer{{1}, std::move(value)}), m_Type(ValueString)
 { }
 
 Value::Value(const char *value)
-	: m_Value(String(value))
+	: Value(String(value))
 { }
 
-Value::Value(const Value& other)
-	: m_Value(other.m_Value)
-{ }
-
-Value::Value(Value&& other)
-{
-#if BOOST_VERSION >= 105400
-	m_Value = std::move(other.m_Value);
-#else /* BOOST_VERSION */
-	m_Value.swap(other.m_Value);
-#endif /* BOOST_VERSION */
-}
-
 Value::Value(Object *value)
 	: Value(Object::Ptr(value))
 { }
 
 Value::Value(const intrusive_ptr<Object>& value)
+	: Value()
 {
-	if (value)
-		m_Value = value;
+	if (value) {
+		new (&m_Object) Object::Ptr(value);
+		m_Type = ValueObject;
+	}
 }
 
-Value& Value::operator=(const Value& other)
+/**
+ * Makes sure the string buffer isn't shared with other values, so that it can be modified.
+ *
+ * @returns The string.
+ */
+String& Value::UnshareString()
 {
-	m_Value = other.m_Value;
-	return *this;
+	if (m_String->References.load(std::memory_order_acquire) > 1u) {
+		auto buffer (new StringBuffer{{1}, m_String->Str});
+
+		if (m_String->References.fetch_sub(1, std::memory_order_acq_rel) == 1u)
+			delete m_String;
+
+		m_String = buffer;
+	}
+
+	return m_String->Str;
 }
 
-Value& Value::operator=(Value&& other)
+void Value::ThrowBadGet()
 {
-#if BOOST_VERSION >= 105400
-	m_Value = std::move(other.m_Value);
-#else /* BOOST_VERSION */
-	m_Value.swap(other.m_Value);
-#endif /* BOOST_VERSION */
-
-	return *this;
+	BOOST_THROW_EXCEPTION(std::bad_cast());
 }
 
 /**
@@ -114,7 +105,7 @@ Value& Value::operator=(Value&& other)
  */
 bool Value::IsEmpty() const
 {
-	return (GetType() == ValueEmpty || (IsString() && boost::get<String>(m_Value).IsEmpty()));
+	return (GetType() == ValueEmpty || (IsString() && m_String->Str.IsEmpty()));
 }
 
 /**
@@ -167,32 +158,22 @@ bool Value::IsObject() const
 	return  (GetType() == ValueObject);
 }
 
-/**
- * Returns the type of the value.
- *
- * @returns The type.
- */
-ValueType Value::GetType() const
-{
-	return static_cast<ValueType>(m_Value.which());
-}
-
 void Value::Swap(Value& other)
 {
-	m_Value.swap(other.m_Value);
+	std::swap(*this, other);
 }
 
 bool Value::ToBool() const
 {
 	switch (GetType()) {
 		case ValueNumber:
-			return static_cast<bool>(boost::get<double>(m_Value));
+			return static_cast<bool>(m_Number);
 
 		case ValueBoolean:
-			return boost::get<bool>(m_Value);
+			return m_Boolean;
 
 		case ValueString:
-			return !boost::get<String>(m_Value).IsEmpty();
+			return !m_String->Str.IsEmpty();
 
 		case ValueObject:
 			if (IsObjectType<Dictionary>()) {
@@ -227,7 +208,7 @@ String Value::GetTypeName() const
 		case ValueString:
 			return "String";
 		case ValueObject:
-			t = boost::get<Object::Ptr>(m_Value)->GetReflectionType();
+			t = m_Object->GetReflectionType();
 			if (!t) {
 				if (IsObjectType<Array>())
 					return "Array";
@@ -254,7 +235,7 @@ Type::Ptr Value::GetReflectionType() const
 		case ValueString:
 			return Type::GetByName("String");
 		case ValueObject:
-			return boost::get<Object::Ptr>(m_Value)->GetReflectionType();
+			return m_Object->GetReflectionType();
 		default:
 			return nullptr;
 	}
@@ -5,10 +5,14 @@
 #define VALUE_H
 
 #include "base/object.hpp"
+#include "base/object-pool.hpp"
 #include "base/string.hpp"
-#include <boost/variant/variant.hpp>
-#include <boost/variant/get.hpp>
 #include <boost/throw_exception.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace icinga
 {
@@ -32,12 +36,19 @@ enum ValueType
 /**
  * A type that can hold an arbitrary value.
  *
+ * It's a tagged union of two machine words. Numbers and booleans are stored in place,
+ * strings in a reference-counted buffer shared by all copies of a value, so that copying
+ * a value never copies a string. Such a buffer is only copied once a copy of the value
+ * is modified via GetMutableString(). Get<String>() never modifies the value, not even
+ * on a non-const one, so that values shared between threads may be read concurrently.
+ *
  * @ingroup base
  */
 class Value
 {
 public:
-	Value() = default;
+	Value() noexcept;
+	~Value();
 	Value(std::nullptr_t);
 	Value(int value);
 	Value(unsigned int value);
@@ -51,7 +62,7 @@ public:
 	Value(String&& value);
 	Value(const char *value);
 	Value(const Value& other);
-	Value(Value&& other);
+	Value(Value&& other) noexcept;
 	Value(Object *value);
 	Value(const intrusive_ptr<Object>& value);
 
@@ -68,7 +79,7 @@ public:
 	operator String() const;
 
 	Value& operator=(const Value& other);
-	Value& operator=(Value&& other);
+	Value& operator=(Value&& other) noexcept;
 
 	bool operator==(bool rhs) const;
 	bool operator!=(bool rhs) const;
@@ -136,29 +147,239 @@ public:
 	Value Clone() const;
 
 	template<typename T>
-	const T& Get() const
+	const T& Get() const;
+
+	template<typename T, typename = std::enable_if_t<!std::is_same<T, String>::value>>
+	T& Get();
+
+	String& GetMutableString();
+
+private:
+	/**
+	 * The string of a value, shared by all of its copies.
+	 */
+	struct StringBuffer
 	{
-		return boost::get<T>(m_Value);
+		DECLARE_POOLED_ALLOCATION(StringBuffer);
+
+		std::atomic<uint32_t> References;
+		String Str;
+	};
+
+	union {
+		double m_Number;
+		bool m_Boolean;
+		StringBuffer *m_String;
+		Object::Ptr m_Object;
+	};
+
+	ValueType m_Type;
+
+	void CopyFrom(const Value& other);
+	void MoveFrom(Value&& other) noexcept;
+	void Reset() noexcept;
+	String& UnshareString();
+
+	[[noreturn]] static void ThrowBadGet();
+};
+
+inline Value::Value() noexcept
+	: m_Number(0), m_Type(ValueEmpty)
+{
+}
+
+inline Value::~Value()
+{
+	Reset();
+}
+
+inline Value::Value(const Value& other)
+	: m_Number(0)
+{
+	CopyFrom(other);
+}
+
+inline Value::Value(Value&& other) noexcept
+	: m_Number(0)
+{
+	MoveFrom(std::move(other));
+}
+
+/* The other value may be owned by this one, e.g. be an element of an array held by it,
+ * so it's taken over before releasing this one's string or object. */
+
+inline Value& Value::operator=(const Value& other)
+{
+	if (this != &other) {
+		Value copy (other);
+
+		Reset();
+		MoveFrom(std::move(copy));
 	}
 
-	template<typename T>
-	T& Get()
-	{
-		return boost::get<T>(m_Value);
+	return *this;
+}
+
+inline Value& Value::operator=(Value&& other) noexcept
+{
+	if (this != &other) {
+		Value temp (std::move(other));
+
+		Reset();
+		MoveFrom(std::move(temp));
 	}
 
-private:
-	boost::variant<boost::blank, double, bool, String, Object::Ptr> m_Value;
-};
+	return *this;
+}
+
+inline ValueType Value::GetType() const
+{
+	return m_Type;
+}
+
+inline void Value::CopyFrom(const Value& other)
+{
+	switch (other.m_Type) {
+		case ValueNumber:
+			m_Number = other.m_Number;
+			break;
+		case ValueBoolean:
+			m_Boolean = other.m_Boolean;
+			break;
+		case ValueString:
+			m_String = other.m_String;
+			m_String->References.fetch_add(1, std::memory_order_relaxed);
+			break;
+		case ValueObject:
+			new (&m_Object) Object::Ptr(other.m_Object);
+			break;
+		default:
+			break;
+	}
+
+	m_Type = other.m_Type;
+}
+
+inline void Value::MoveFrom(Value&& other) noexcept
+{
+	switch (other.m_Type) {
+		case ValueNumber:
+			m_Number = other.m_Number;
+			break;
+		case ValueBoolean:
+			m_Boolean = other.m_Boolean;
+			break;
+		case ValueString:
+			m_String = other.m_String;
+			break;
+		case ValueObject:
+			new (&m_Object) Object::Ptr(std::move(other.m_Object));
+			std::destroy_at(&other.m_Object);
+			break;
+		default:
+			break;
+	}
+
+	m_Type = other.m_Type;
+	other.m_Type = ValueEmpty;
+	other.m_Number = 0;
+}
+
+/**
+ * Releases the string or object, if any, and leaves the value empty.
+ */
+inline void Value::Reset() noexcept
+{
+	switch (m_Type) {
+		case ValueString:
+			if (m_String->References.fetch_sub(1, std::memory_order_acq_rel) == 1u)
+				delete m_String;
+
+			break;
+		case ValueObject:
+			std::destroy_at(&m_Object);
+			break;
+		default:
+			break;
+	}
 
-extern template const double& Value::Get<double>() const;
-extern template double& Value::Get<double>();
-extern template const bool& Value::Get<bool>() const;
-extern template bool& Value::Get<bool>();
-extern template const String& Value::Get<String>() const;
-extern template String& Value::Get<String>();
-extern template const Object::Ptr& Value::Get<Object::Ptr>() const;
-extern template Object::Ptr& Value::Get<Object::Ptr>();
+	m_Type = ValueEmpty;
+	m_Number = 0;
+}
+
+template<>
+inline const double& Value::Get<double>() const
+{
+	if (m_Type != ValueNumber)
+		ThrowBadGet();
+
+	return m_Number;
+}
+
+template<>
+inline double& Value::Get<double>()
+{
+	if (m_Type != ValueNumber)
+		ThrowBadGet();
+
+	return m_Number;
+}
+
+template<>
+inline const bool& Value::Get<bool>() const
+{
+	if (m_Type != ValueBoolean)
+		ThrowBadGet();
+
+	return m_Boolean;
+}
+
+template<>
+inline bool& Value::Get<bool>()
+{
+	if (m_Type != ValueBoolean)
+		ThrowBadGet();
+
+	return m_Boolean;
+}
+
+template<>
+inline const String& Value::Get<String>() const
+{
+	if (m_Type != ValueString)
+		ThrowBadGet();
+
+	return m_String->Str;
+}
+
+/**
+ * Returns the string for modification, the string buffer is copied first if it's shared with other values.
+ */
+inline String& Value::GetMutableString()
+{
+	if (m_Type != ValueString)
+		ThrowBadGet();
+
+	return UnshareString();
+}
+
+template<>
+inline const Object::Ptr& Value::Get<Object::Ptr>() const
+{
+	if (m_Type != ValueObject)
+		ThrowBadGet();
+
+	return m_Object;
+}
+
+template<>
+inline Object::Ptr& Value::Get<Object::Ptr>()
+{
+	if (m_Type != ValueObject)
+		ThrowBadGet();
+
+	return m_Object;
+}
 
 extern const Value Empty;
 
@@ -257,6 +478,4 @@ std::istream& operator>>(std::istream& stream, Value& value);
 
 }
 
-extern template class boost::variant<boost::blank, double, bool, icinga::String, icinga::Object::Ptr>;
-
 #endif /* VALUE_H */
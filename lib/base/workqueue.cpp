@@ -8,6 +8,8 @@
 #include "base/application.hpp"
 #include "base/exception.hpp"
 #include <boost/thread/tss.hpp>
+#include <algorithm>
+#include <iterator>
 #include <math.h>
 
 using namespace icinga;
@@ -15,10 +17,19 @@ using namespace icinga;
 std::atomic<int> WorkQueue::m_NextID(1);
 boost::thread_specific_ptr<WorkQueue *> l_ThreadWorkQueue;
 
-WorkQueue::WorkQueue(size_t maxItems, int threadCount, LogSeverity statsLogLevel)
+WorkQueue::WorkQueue(size_t maxItems, int threadCount, LogSeverity statsLogLevel, WorkQueueBackend backend)
 	: m_ID(m_NextID++), m_ThreadCount(threadCount), m_MaxItems(maxItems),
-	m_StatsLogLevel(statsLogLevel), m_TaskStats(15 * 60)
+	m_StatsLogLevel(statsLogLevel), m_TaskStats(15 * 60), m_Backend(backend)
 {
+	if (m_Backend == WorkQueueLockFree) {
+		size_t ringSize = m_MaxItems != 0 && m_MaxItems < LockFreeRingSize ? m_MaxItems : LockFreeRingSize;
+
+		/* PriorityImmediate, PriorityHigh, PriorityNormal, PriorityLow */
+		for (int i = 0; i < 4; i++) {
+			m_Levels.emplace_back(new LockFreeLevel(ringSize));
+		}
+	}
+
 	/* Initialize logger. */
 	m_StatusTimerTimeout = Utility::GetTime();
 
@@ -56,17 +67,14 @@ std::unique_lock<std::mutex> WorkQueue::AcquireLock()
  */
 void WorkQueue::EnqueueUnlocked(std::unique_lock<std::mutex>& lock, std::function<void ()>&& function, WorkQueuePriority priority)
 {
-	if (!m_Spawned) {
-		Log(LogNotice, "WorkQueue")
-			<< "Spawning WorkQueue threads for '" << m_Name << "'";
-
-		for (int i = 0; i < m_ThreadCount; i++) {
-			m_Threads.create_thread([this]() { WorkerThreadProc(); });
-		}
-
-		m_Spawned = true;
+	if (m_Backend == WorkQueueLockFree) {
+		EnqueueLockFree(lock, std::move(function), priority);
+		return;
 	}
 
+	if (!m_Spawned)
+		SpawnThreads();
+
 	bool wq_thread = IsWorkerThread();
 
 	if (!wq_thread) {
@@ -96,10 +104,128 @@ void WorkQueue::Enqueue(std::function<void ()>&& function, WorkQueuePriority pri
 		return;
 	}
 
+	if (m_Backend == WorkQueueLockFree) {
+		std::unique_lock<std::mutex> lock(m_Mutex, std::defer_lock);
+		EnqueueLockFree(lock, std::move(function), priority);
+		return;
+	}
+
 	auto lock = AcquireLock();
 	EnqueueUnlocked(lock, std::move(function), priority);
 }
 
+/**
+ * Starts the worker threads. The caller must hold the mutex.
+ */
+void WorkQueue::SpawnThreads()
+{
+	Log(LogNotice, "WorkQueue")
+		<< "Spawning WorkQueue threads for '" << m_Name << "'";
+
+	for (int i = 0; i < m_ThreadCount; i++) {
+		if (m_Backend == WorkQueueLockFree)
+			m_Threads.create_thread([this]() { LockFreeWorkerThreadProc(); });
+		else
+			m_Threads.create_thread([this]() { WorkerThreadProc(); });
+	}
+
+	m_Spawned = true;
+}
+
+/**
+ * Enqueues a task with the WorkQueueLockFree backend.
+ *
+ * @param lock A lock for m_Mutex which is only acquired if necessary unless the caller already holds it.
+ */
+void WorkQueue::EnqueueLockFree(std::unique_lock<std::mutex>& lock, TaskFunction&& function, WorkQueuePriority priority)
+{
+	if (!m_Spawned) {
+		if (!lock.owns_lock())
+			lock.lock();
+
+		if (!m_Spawned)
+			SpawnThreads();
+	}
+
+	/* Worker threads must not wait for themselves. */
+	if (m_MaxItems != 0 && m_Queued.load() >= m_MaxItems && !IsWorkerThread()) {
+		if (!lock.owns_lock())
+			lock.lock();
+
+		m_BlockedProducers.fetch_add(1);
+
+		while (m_Queued.load() >= m_MaxItems)
+			m_CVFull.wait(lock);
+
+		m_BlockedProducers.fetch_sub(1);
+	}
+
+	LockFreeLevel *level;
+
+	switch (priority) {
+		case PriorityImmediate:
+			level = m_Levels[0].get();
+			break;
+		case PriorityHigh:
+			level = m_Levels[1].get();
+			break;
+		case PriorityLow:
+			level = m_Levels[3].get();
+			break;
+		default:
+			level = m_Levels[2].get();
+	}
+
+	/* Counted before it's visible to the workers, so they don't go to sleep while it's on its way. */
+	m_Queued.fetch_add(1);
+
+	if (level->OverflowSize.load() != 0 || !level->Ring.TryPush(std::move(function))) {
+		std::unique_lock<std::mutex> overflowLock(level->OverflowMutex);
+		level->Overflow.emplace_back(std::move(function));
+		level->OverflowSize.fetch_add(1);
+	}
+
+	/* Pairs with the m_Parked increment in LockFreeWorkerThreadProc(). */
+	if (m_Parked.load() != 0) {
+		if (!lock.owns_lock())
+			lock.lock();
+
+		m_CVEmpty.notify_one();
+	}
+}
+
+/**
+ * Takes a batch of tasks of the highest priority there are tasks for.
+ *
+ * @returns The number of tasks.
+ */
+size_t WorkQueue::DequeueLockFree(std::vector<TaskFunction>& tasks)
+{
+	/* Share the tasks with the other worker threads rather than taking all of them. */
+	size_t batchSize = std::max<size_t>(1, std::min<size_t>(LockFreeBatchSize, m_Queued.load() / m_ThreadCount));
+
+	for (auto& level : m_Levels) {
+		size_t count = level->Ring.TryPopBatch(std::back_inserter(tasks), batchSize);
+
+		if (count == 0 && level->OverflowSize.load() != 0) {
+			std::unique_lock<std::mutex> overflowLock(level->OverflowMutex);
+
+			while (count < batchSize && !level->Overflow.empty()) {
+				tasks.emplace_back(std::move(level->Overflow.front()));
+				level->Overflow.pop_front();
+				count++;
+			}
+
+			level->OverflowSize.fetch_sub(count);
+		}
+
+		if (count != 0)
+			return count;
+	}
+
+	return 0;
+}
+
 /**
  * Waits until all currently enqueued tasks have completed. This only works reliably
  * when no other thread is enqueuing new tasks when this method is called.
@@ -110,8 +236,13 @@ void WorkQueue::Join(bool stop)
 {
 	std::unique_lock<std::mutex> lock(m_Mutex);
 
-	while (m_Processing || !m_Tasks.empty())
-		m_CVStarved.wait(lock);
+	if (m_Backend == WorkQueueLockFree) {
+		while (m_Busy.load() != 0 || m_Queued.load() != 0)
+			m_CVStarved.wait(lock);
+	} else {
+		while (m_Processing || !m_Tasks.empty())
+			m_CVStarved.wait(lock);
+	}
 
 	if (stop) {
 		m_Stopped = true;
@@ -185,6 +316,9 @@ void WorkQueue::ReportExceptions(const String& facility, bool verbose) const
 
 size_t WorkQueue::GetLength() const
 {
+	if (m_Backend == WorkQueueLockFree)
+		return m_Queued.load();
+
 	std::unique_lock<std::mutex> lock(m_Mutex);
 
 	return m_Tasks.size();
@@ -196,7 +330,7 @@ void WorkQueue::StatusTimerHandler()
 
 	ASSERT(!m_Name.IsEmpty());
 
-	size_t pending = m_Tasks.size();
+	size_t pending = m_Backend == WorkQueueLockFree ? m_Queued.load() : m_Tasks.size();
 
 	double now = Utility::GetTime();
 	double gradient = (pending - m_PendingTasks) / (now - m_PendingTasksTimestamp);
@@ -293,6 +427,69 @@ void WorkQueue::WorkerThreadProc()
 	}
 }
 
+void WorkQueue::LockFreeWorkerThreadProc()
+{
+	std::ostringstream idbuf;
+	idbuf << "WQ #" << m_ID;
+	Utility::SetThreadName(idbuf.str());
+
+	l_ThreadWorkQueue.reset(new WorkQueue *(this));
+
+	std::vector<TaskFunction> tasks;
+
+	for (;;) {
+		/* Counted as busy before the tasks leave the queue, so Join() never sees both as zero in between. */
+		m_Busy.fetch_add(1);
+
+		size_t count = DequeueLockFree(tasks);
+
+		if (count == 0) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_Busy.fetch_sub(1);
+			m_Parked.fetch_add(1);
+
+			if (m_Queued.load() == 0) {
+				if (m_Busy.load() == 0)
+					m_CVStarved.notify_all();
+
+				if (m_Stopped) {
+					m_Parked.fetch_sub(1);
+					break;
+				}
+
+				m_CVEmpty.wait(lock);
+			}
+
+			m_Parked.fetch_sub(1);
+			continue;
+		}
+
+		m_Queued.fetch_sub(count);
+
+		if (m_BlockedProducers.load() != 0) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_CVFull.notify_all();
+		}
+
+		for (auto& task : tasks) {
+			RunTaskFunction(task);
+
+			/* release whatever resources the task holds before we take the next one */
+			task = nullptr;
+
+			IncreaseTaskCount();
+		}
+
+		tasks.clear();
+
+		if (m_Busy.fetch_sub(1) == 1 && m_Queued.load() == 0) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_CVStarved.notify_all();
+		}
+	}
+}
+
 void WorkQueue::IncreaseTaskCount()
 {
 	m_TaskStats.InsertValue(Utility::GetTime(), 1);
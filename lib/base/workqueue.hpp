@@ -8,12 +8,15 @@
 #include "base/timer.hpp"
 #include "base/ringbuffer.hpp"
 #include "base/logger.hpp"
+#include "base/mpmc-ring.hpp"
 #include <boost/thread/thread.hpp>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
 #include <deque>
 #include <atomic>
+#include <memory>
+#include <vector>
 
 namespace icinga
 {
@@ -26,6 +29,19 @@ enum WorkQueuePriority
 	PriorityImmediate = 4
 };
 
+/**
+ * How a WorkQueue stores its tasks.
+ *
+ * WorkQueueLockFree keeps the tasks of every priority in a lock-free ring buffer, so enqueueing
+ * a task never waits for a worker thread holding the queue's mutex. Unless the queue is bounded
+ * and full, producers only take the mutex to wake up idle worker threads.
+ */
+enum WorkQueueBackend
+{
+	WorkQueueMutex,
+	WorkQueueLockFree
+};
+
 using TaskFunction = std::function<void ()>;
 
 struct Task
@@ -53,7 +69,8 @@ class WorkQueue
 public:
 	using ExceptionCallback = std::function<void(std::exception_ptr)>;
 
-	WorkQueue(size_t maxItems = 0, int threadCount = 1, LogSeverity statsLogLevel = LogInformation);
+	WorkQueue(size_t maxItems = 0, int threadCount = 1, LogSeverity statsLogLevel = LogInformation,
+		WorkQueueBackend backend = WorkQueueMutex);
 	~WorkQueue();
 
 	void SetName(const String& name);
@@ -119,11 +136,31 @@ protected:
 	void IncreaseTaskCount();
 
 private:
+	/**
+	 * The tasks of one priority if the WorkQueueLockFree backend is used.
+	 *
+	 * Once the ring is full, tasks spill over into a list which is drained before the ring takes
+	 * tasks again, so tasks enqueued by the same thread keep their order.
+	 */
+	struct LockFreeLevel
+	{
+		LockFreeLevel(size_t capacity) : Ring(capacity)
+		{ }
+
+		MpmcRing<TaskFunction> Ring;
+		std::mutex OverflowMutex;
+		std::deque<TaskFunction> Overflow;
+		std::atomic<size_t> OverflowSize{0};
+	};
+
+	static constexpr size_t LockFreeRingSize = 4096;
+	static constexpr size_t LockFreeBatchSize = 16;
+
 	int m_ID;
 	String m_Name;
 	static std::atomic<int> m_NextID;
 	int m_ThreadCount;
-	bool m_Spawned{false};
+	std::atomic<bool> m_Spawned{false};
 
 	mutable std::mutex m_Mutex;
 	std::condition_variable m_CVEmpty;
@@ -145,6 +182,18 @@ private:
 	size_t m_PendingTasks{0};
 	double m_PendingTasksTimestamp{0};
 
+	WorkQueueBackend m_Backend;
+	std::vector<std::unique_ptr<LockFreeLevel>> m_Levels; /**< By descending priority. */
+	std::atomic<size_t> m_Queued{0};
+	std::atomic<size_t> m_Busy{0};
+	std::atomic<size_t> m_Parked{0};
+	std::atomic<size_t> m_BlockedProducers{0};
+
+	void SpawnThreads();
+	void EnqueueLockFree(std::unique_lock<std::mutex>& lock, TaskFunction&& function, WorkQueuePriority priority);
+	size_t DequeueLockFree(std::vector<TaskFunction>& tasks);
+	void LockFreeWorkerThreadProc();
+
 	void WorkerThreadProc();
 	void StatusTimerHandler();
 
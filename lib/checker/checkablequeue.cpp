@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "checker/checkablequeue.hpp"
+#include <limits>
+
+using namespace icinga;
+
+/**
+ * Creates a queue for the specified scheduler backend.
+ *
+ * @param backend The name of the backend, either "ordered" or "timingwheel"
+ * @param now The current time
+ * @returns The queue
+ */
+std::unique_ptr<CheckableQueue> CheckableQueue::Create(const String& backend, double now)
+{
+	if (backend == "timingwheel")
+		return std::unique_ptr<CheckableQueue>(new TimingWheelCheckableQueue(now));
+
+	return std::unique_ptr<CheckableQueue>(new OrderedCheckableQueue());
+}
+
+void OrderedCheckableQueue::Insert(const CheckableScheduleInfo& csi)
+{
+	/* remove and re-insert the object from the set in order to force an index update */
+	m_Checkables.erase(csi.Object);
+	m_Checkables.insert(csi);
+}
+
+bool OrderedCheckableQueue::Erase(const Checkable::Ptr& checkable)
+{
+	return m_Checkables.erase(checkable) > 0;
+}
+
+bool OrderedCheckableQueue::Contains(const Checkable::Ptr& checkable) const
+{
+	return m_Checkables.find(checkable) != m_Checkables.end();
+}
+
+size_t OrderedCheckableQueue::GetLength() const
+{
+	return m_Checkables.size();
+}
+
+double OrderedCheckableQueue::GetNextCheck(double)
+{
+	auto& idx = boost::get<1>(m_Checkables);
+
+	if (idx.empty())
+		return std::numeric_limits<double>::infinity();
+
+	return idx.begin()->NextCheck;
+}
+
+Checkable::Ptr OrderedCheckableQueue::PopNext()
+{
+	auto& idx = boost::get<1>(m_Checkables);
+	auto it = idx.begin();
+	Checkable::Ptr checkable = it->Object;
+
+	idx.erase(it);
+
+	return checkable;
+}
+
+void OrderedCheckableQueue::Rebase(double)
+{
+	/* The set is ordered by the timestamps only, not relative to the current time. */
+}
+
+/* Checks are scheduled with sub-second offsets, 10ms ticks are fine grained enough. */
+TimingWheelCheckableQueue::TimingWheelCheckableQueue(double now)
+	: m_Wheel(0.01, now)
+{ }
+
+void TimingWheelCheckableQueue::Insert(const CheckableScheduleInfo& csi)
+{
+	m_Wheel.Insert(csi.Object, csi.NextCheck);
+}
+
+bool TimingWheelCheckableQueue::Erase(const Checkable::Ptr& checkable)
+{
+	return m_Wheel.Erase(checkable);
+}
+
+bool TimingWheelCheckableQueue::Contains(const Checkable::Ptr& checkable) const
+{
+	return m_Wheel.Contains(checkable);
+}
+
+size_t TimingWheelCheckableQueue::GetLength() const
+{
+	return m_Wheel.GetLength();
+}
+
+double TimingWheelCheckableQueue::GetNextCheck(double now)
+{
+	/* The clock went backwards, in case the application hasn't noticed yet. */
+	if (now < m_Wheel.GetCursorTime() - 1)
+		m_Wheel.Rebase(now);
+
+	m_Wheel.Advance(now);
+
+	double next = m_Wheel.GetNextExpiry();
+
+	/* Make sure rounding errors can't trick the scheduler into popping from an empty due list. */
+	if (!m_Wheel.HasDue() && next <= now)
+		next = now + 0.01;
+
+	return next;
+}
+
+Checkable::Ptr TimingWheelCheckableQueue::PopNext()
+{
+	return m_Wheel.PopDue();
+}
+
+/**
+ * Re-places all checkables relative to the current time. Otherwise the ones scheduled before the
+ * wheel's cursor would be due right away after the clock went backwards.
+ */
+void TimingWheelCheckableQueue::Rebase(double now)
+{
+	m_Wheel.Rebase(now);
+}
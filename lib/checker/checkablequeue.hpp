@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "icinga/checkable.hpp"
+#include "base/timing-wheel.hpp"
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/key_extractors.hpp>
+#include <memory>
+
+namespace icinga
+{
+
+/**
+ * @ingroup checker
+ */
+struct CheckableScheduleInfo
+{
+	Checkable::Ptr Object;
+	double NextCheck;
+};
+
+/**
+ * @ingroup checker
+ */
+struct CheckableNextCheckExtractor
+{
+	typedef double result_type;
+
+	/**
+	 * @threadsafety Always.
+	 */
+	double operator()(const CheckableScheduleInfo& csi)
+	{
+		return csi.NextCheck;
+	}
+};
+
+/**
+ * @ingroup checker
+ */
+typedef boost::multi_index_container<
+	CheckableScheduleInfo,
+	boost::multi_index::indexed_by<
+		boost::multi_index::ordered_unique<boost::multi_index::member<CheckableScheduleInfo, Checkable::Ptr, &CheckableScheduleInfo::Object> >,
+		boost::multi_index::ordered_non_unique<CheckableNextCheckExtractor>
+	>
+> CheckableSet;
+
+/**
+ * The checkables of a check scheduler which are waiting for their next check.
+ *
+ * Implementations aren't thread-safe, the check scheduler guards them with its own lock.
+ *
+ * @ingroup checker
+ */
+class CheckableQueue
+{
+public:
+	virtual ~CheckableQueue() = default;
+
+	/**
+	 * Inserts a checkable into the queue or updates its next check timestamp if it's already queued.
+	 */
+	virtual void Insert(const CheckableScheduleInfo& csi) = 0;
+	virtual bool Erase(const Checkable::Ptr& checkable) = 0;
+	virtual bool Contains(const Checkable::Ptr& checkable) const = 0;
+	virtual size_t GetLength() const = 0;
+
+	bool IsEmpty() const
+	{
+		return GetLength() == 0;
+	}
+
+	/**
+	 * Returns the time at which the next checkable is due. May be a lower bound,
+	 * i.e. the next call after that time may return a later timestamp.
+	 *
+	 * @param now The current time.
+	 */
+	virtual double GetNextCheck(double now) = 0;
+
+	/**
+	 * Removes the checkable which is due next from the queue.
+	 * Must only be called after GetNextCheck() returned a timestamp in the past.
+	 */
+	virtual Checkable::Ptr PopNext() = 0;
+
+	/**
+	 * Called after the clock jumped, so that checkables aren't considered due too early.
+	 *
+	 * @param now The current time.
+	 */
+	virtual void Rebase(double now) = 0;
+
+	static std::unique_ptr<CheckableQueue> Create(const String& backend, double now);
+};
+
+/**
+ * A queue backed by an ordered set, every operation is O(log n).
+ *
+ * @ingroup checker
+ */
+class OrderedCheckableQueue final : public CheckableQueue
+{
+public:
+	void Insert(const CheckableScheduleInfo& csi) override;
+	bool Erase(const Checkable::Ptr& checkable) override;
+	bool Contains(const Checkable::Ptr& checkable) const override;
+	size_t GetLength() const override;
+	double GetNextCheck(double now) override;
+	Checkable::Ptr PopNext() override;
+	void Rebase(double now) override;
+
+private:
+	CheckableSet m_Checkables;
+};
+
+/**
+ * A queue backed by a hierarchical timing wheel with O(1) insert, reschedule and expiry.
+ *
+ * @ingroup checker
+ */
+class TimingWheelCheckableQueue final : public CheckableQueue
+{
+public:
+	explicit TimingWheelCheckableQueue(double now);
+
+	void Insert(const CheckableScheduleInfo& csi) override;
+	bool Erase(const Checkable::Ptr& checkable) override;
+	bool Contains(const Checkable::Ptr& checkable) const override;
+	size_t GetLength() const override;
+	double GetNextCheck(double now) override;
+	Checkable::Ptr PopNext() override;
+	void Rebase(double now) override;
+
+private:
+	struct CheckableHash
+	{
+		size_t operator()(const Checkable::Ptr& checkable) const
+		{
+			return std::hash<Checkable *>()(checkable.get());
+		}
+	};
+
+	TimingWheel<Checkable::Ptr, CheckableHash> m_Wheel;
+};
+
+}
@@ -6,6 +6,7 @@
 #include "icinga/icingaapplication.hpp"
 #include "icinga/cib.hpp"
 #include "remote/apilistener.hpp"
+#include "base/application.hpp"
 #include "base/configuration.hpp"
 #include "base/configtype.hpp"
 #include "base/objectlock.hpp"
@@ -15,6 +16,7 @@
 #include "base/exception.hpp"
 #include "base/convert.hpp"
 #include "base/statsfunction.hpp"
+#include <algorithm>
 #include <chrono>
 
 using namespace icinga;
@@ -28,17 +30,42 @@ void CheckerComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr
 	DictionaryData nodes;
 
 	for (const CheckerComponent::Ptr& checker : ConfigType::GetObjectsByType<CheckerComponent>()) {
-		unsigned long idle = checker->GetIdleCheckables();
-		unsigned long pending = checker->GetPendingCheckables();
+		String perfdata_prefix = "checkercomponent_" + checker->GetName() + "_";
+		unsigned long idle = 0;
+		unsigned long pending = 0;
+		ArrayData shards;
+
+		for (size_t i = 0; i < checker->GetShardCount(); i++) {
+			unsigned long shardIdle = checker->GetIdleCheckables(i);
+			unsigned long shardPending = checker->GetPendingCheckables(i);
+
+			idle += shardIdle;
+			pending += shardPending;
+
+			shards.emplace_back(new Dictionary({
+				{ "idle", shardIdle },
+				{ "pending", shardPending }
+			}));
+
+			if (checker->GetShardCount() > 1) {
+				String shard_prefix = perfdata_prefix + "shard" + Convert::ToString(i) + "_";
+				perfdata->Add(new PerfdataValue(shard_prefix + "idle", Convert::ToDouble(shardIdle)));
+				perfdata->Add(new PerfdataValue(shard_prefix + "pending", Convert::ToDouble(shardPending)));
+			}
+		}
+
+		int limit = checker->GetConcurrencyLimit();
 
 		nodes.emplace_back(checker->GetName(), new Dictionary({
 			{ "idle", idle },
-			{ "pending", pending }
+			{ "pending", pending },
+			{ "concurrency_limit", limit },
+			{ "shards", new Array(std::move(shards)) }
 		}));
 
-		String perfdata_prefix = "checkercomponent_" + checker->GetName() + "_";
 		perfdata->Add(new PerfdataValue(perfdata_prefix + "idle", Convert::ToDouble(idle)));
 		perfdata->Add(new PerfdataValue(perfdata_prefix + "pending", Convert::ToDouble(pending)));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "concurrency_limit", limit));
 	}
 
 	status->Set("checkercomponent", new Dictionary(std::move(nodes)));
@@ -46,6 +73,14 @@ void CheckerComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr
 
 void CheckerComponent::OnConfigLoaded()
 {
+	double now = Utility::GetTime();
+
+	for (int i = 0; i < GetSchedulerShards(); i++) {
+		m_Shards.emplace_back(new Shard());
+		m_Shards.back()->Index = i;
+		m_Shards.back()->IdleCheckables = CheckableQueue::Create(GetSchedulerBackend(), now);
+	}
+
 	ConfigObject::OnActiveChanged.connect([this](const ConfigObject::Ptr& object, const Value&) {
 		ObjectHandler(object);
 	});
@@ -56,6 +91,20 @@ void CheckerComponent::OnConfigLoaded()
 	Checkable::OnNextCheckChanged.connect([this](const Checkable::Ptr& checkable, const Value&) {
 		NextCheckChangedHandler(checkable);
 	});
+
+	Checkable::OnPendingChecksDecreased.connect([this]() { WakeUpWaitingShards(); });
+
+	Application::OnClockJumped.connect([this](double) { ClockJumpedHandler(); });
+
+	if (GetConcurrencyControl() == "adaptive") {
+		m_ConcurrencyLimiter.reset(new ConcurrencyLimiter(GetMinConcurrentChecks(),
+			std::max(IcingaApplication::GetInstance()->GetMaxConcurrentChecks(), 0)));
+
+		Checkable::OnNewCheckResult.connect([this](const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr& origin) {
+			if (cr->GetActive() && (!origin || origin->IsLocal()))
+				m_ConcurrencyLimiter->AddSample(checkable.get(), cr->CalculateExecutionTime());
+		});
+	}
 }
 
 void CheckerComponent::Start(bool runtimeCreated)
@@ -66,25 +115,40 @@ void CheckerComponent::Start(bool runtimeCreated)
 		<< "'" << GetName() << "' started.";
 
 
-	m_Thread = std::thread([this]() { CheckThreadProc(); });
+	for (auto& shard : m_Shards) {
+		shard->Thread = std::thread([this, shard = shard.get()]() { CheckThreadProc(*shard); });
+	}
 
 	m_ResultTimer = Timer::Create();
 	m_ResultTimer->SetInterval(5);
 	m_ResultTimer->OnTimerExpired.connect([this](const Timer * const&) { ResultTimerHandler(); });
 	m_ResultTimer->Start();
+
+	if (m_ConcurrencyLimiter) {
+		m_ConcurrencyTimer = Timer::Create();
+		m_ConcurrencyTimer->SetInterval(1);
+		m_ConcurrencyTimer->OnTimerExpired.connect([this](const Timer * const&) { ConcurrencyTimerHandler(); });
+		m_ConcurrencyTimer->Start();
+	}
 }
 
 void CheckerComponent::Stop(bool runtimeRemoved)
 {
-	{
-		std::unique_lock<std::mutex> lock(m_Mutex);
-		m_Stopped = true;
-		m_CV.notify_all();
+	for (auto& shard : m_Shards) {
+		std::unique_lock<std::mutex> lock(shard->Mutex);
+		shard->Stopped = true;
+		shard->CV.notify_all();
 	}
 
 	m_WaitGroup->Join();
 	m_ResultTimer->Stop(true);
-	m_Thread.join();
+
+	if (m_ConcurrencyTimer)
+		m_ConcurrencyTimer->Stop(true);
+
+	for (auto& shard : m_Shards) {
+		shard->Thread.join();
+	}
 
 	Log(LogInformation, "CheckerComponent")
 		<< "'" << GetName() << "' stopped.";
@@ -92,47 +156,104 @@ void CheckerComponent::Stop(bool runtimeRemoved)
 	ObjectImpl<CheckerComponent>::Stop(runtimeRemoved);
 }
 
-void CheckerComponent::CheckThreadProc()
+void CheckerComponent::ValidateSchedulerShards(const Lazy<int>& lvalue, const ValidationUtils& utils)
 {
-	Utility::SetThreadName("Check Scheduler");
+	ObjectImpl<CheckerComponent>::ValidateSchedulerShards(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "scheduler_shards" }, "Value must be greater than 0."));
+}
+
+void CheckerComponent::ValidateSchedulerBackend(const Lazy<String>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<CheckerComponent>::ValidateSchedulerBackend(lvalue, utils);
+
+	if (lvalue() != "ordered" && lvalue() != "timingwheel")
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "scheduler_backend" }, "Value must be one of 'ordered' or 'timingwheel'."));
+}
+
+void CheckerComponent::ValidateConcurrencyControl(const Lazy<String>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<CheckerComponent>::ValidateConcurrencyControl(lvalue, utils);
+
+	if (lvalue() != "static" && lvalue() != "adaptive")
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "concurrency_control" }, "Value must be one of 'static' or 'adaptive'."));
+}
+
+void CheckerComponent::ValidateMinConcurrentChecks(const Lazy<int>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<CheckerComponent>::ValidateMinConcurrentChecks(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "min_concurrent_checks" }, "Value must be greater than 0."));
+}
+
+/**
+ * Returns the scheduler shard which is responsible for the specified checkable.
+ *
+ * @param checkable The checkable
+ * @returns The shard
+ */
+CheckerComponent::Shard& CheckerComponent::GetShard(const Checkable::Ptr& checkable)
+{
+	if (m_Shards.size() == 1)
+		return *m_Shards[0];
+
+	/* Object addresses are stable for the checkable's lifetime, but their lower bits
+	 * are always zero due to alignment. Mix them before picking the shard. */
+	auto key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(checkable.get()));
+	key ^= key >> 33;
+	key *= UINT64_C(0xff51afd7ed558ccd);
+	key ^= key >> 33;
+
+	return *m_Shards[key % m_Shards.size()];
+}
+
+void CheckerComponent::CheckThreadProc(Shard& shard)
+{
+	if (m_Shards.size() > 1)
+		Utility::SetThreadName("Check Sched " + Convert::ToString(shard.Index));
+	else
+		Utility::SetThreadName("Check Scheduler");
+
 	IcingaApplication::Ptr icingaApp = IcingaApplication::GetInstance();
 
-	std::unique_lock<std::mutex> lock(m_Mutex);
+	std::unique_lock<std::mutex> lock(shard.Mutex);
 
 	for (;;) {
-		typedef boost::multi_index::nth_index<CheckableSet, 1>::type CheckTimeView;
-		CheckTimeView& idx = boost::get<1>(m_IdleCheckables);
+		CheckableQueue& idle = *shard.IdleCheckables;
 
-		while (idx.begin() == idx.end() && !m_Stopped)
-			m_CV.wait(lock);
+		while (idle.IsEmpty() && !shard.Stopped)
+			shard.CV.wait(lock);
 
-		if (m_Stopped)
+		if (shard.Stopped)
 			break;
 
-		auto it = idx.begin();
-		CheckableScheduleInfo csi = *it;
+		double now = Utility::GetTime();
+		double wait = idle.GetNextCheck(now) - now;
 
-		double wait = csi.NextCheck - Utility::GetTime();
+		if (wait > 0) {
+			/* Wait for the next check. */
+			shard.CV.wait_for(lock, std::chrono::duration<double>(wait));
 
-//#ifdef I2_DEBUG
-//		Log(LogDebug, "CheckerComponent")
-//			<< "Pending checks " << Checkable::GetPendingChecks()
-//			<< " vs. max concurrent checks " << icingaApp->GetMaxConcurrentChecks() << ".";
-//#endif /* I2_DEBUG */
+			continue;
+		}
 
-		if (Checkable::GetPendingChecks() >= icingaApp->GetMaxConcurrentChecks())
-			wait = 0.5;
+		/* Announce the wait before looking at the pending checks, so that
+		 * WakeUpWaitingShards() can't miss a check which finishes in between. */
+		shard.WaitingForSlot.store(true);
 
-		if (wait > 0) {
-			/* Wait for the next check. */
-			m_CV.wait_for(lock, std::chrono::duration<double>(wait));
+		if (Checkable::GetPendingChecks() >= GetConcurrencyLimit()) {
+			/* Woken up as soon as a check finishes. The timeout only guards against MaxConcurrentChecks changes. */
+			shard.CV.wait_for(lock, std::chrono::seconds(1));
+			shard.WaitingForSlot.store(false);
 
 			continue;
 		}
 
-		Checkable::Ptr checkable = csi.Object;
+		shard.WaitingForSlot.store(false);
 
-		m_IdleCheckables.erase(checkable);
+		Checkable::Ptr checkable = idle.PopNext();
 
 		bool forced = checkable->GetForceNextCheck();
 		bool check = true;
@@ -185,7 +306,7 @@ void CheckerComponent::CheckThreadProc()
 
 		/* reschedule the checkable if checks are disabled */
 		if (!check) {
-			m_IdleCheckables.insert(GetCheckableScheduleInfo(checkable));
+			idle.Insert(GetCheckableScheduleInfo(checkable));
 			lock.unlock();
 
 			if (nextCheck > 0) {
@@ -203,7 +324,7 @@ void CheckerComponent::CheckThreadProc()
 		}
 
 
-		csi = GetCheckableScheduleInfo(checkable);
+		CheckableScheduleInfo csi = GetCheckableScheduleInfo(checkable);
 
 		Log(LogDebug, "CheckerComponent")
 			<< "Scheduling info for checkable '" << checkable->GetName() << "' ("
@@ -212,7 +333,7 @@ void CheckerComponent::CheckThreadProc()
 			<< Utility::FormatDateTime("%Y-%m-%d %H:%M:%S %z", csi.NextCheck)
 			<< " (" << std::fixed << std::setprecision(0) << csi.NextCheck << ").";
 
-		m_PendingCheckables.insert(csi);
+		shard.PendingCheckables.insert(csi);
 
 		lock.unlock();
 
@@ -232,13 +353,13 @@ void CheckerComponent::CheckThreadProc()
 		 */
 		CheckerComponent::Ptr checkComponent(this);
 
-		Utility::QueueAsyncCallback([this, checkComponent, checkable]() { ExecuteCheckHelper(checkable); });
+		Utility::QueueAsyncCallback([this, checkComponent, &shard, checkable]() { ExecuteCheckHelper(shard, checkable); });
 
 		lock.lock();
 	}
 }
 
-void CheckerComponent::ExecuteCheckHelper(const Checkable::Ptr& checkable)
+void CheckerComponent::ExecuteCheckHelper(Shard& shard, const Checkable::Ptr& checkable)
 {
 	try {
 		checkable->ExecuteCheck(m_WaitGroup);
@@ -263,20 +384,20 @@ void CheckerComponent::ExecuteCheckHelper(const Checkable::Ptr& checkable)
 	Checkable::DecreasePendingChecks();
 
 	{
-		std::unique_lock<std::mutex> lock(m_Mutex);
+		std::unique_lock<std::mutex> lock(shard.Mutex);
 
 		/* remove the object from the list of pending objects; if it's not in the
 		 * list this was a manual (i.e. forced) check and we must not re-add the
 		 * object to the list because it's already there. */
-		auto it = m_PendingCheckables.find(checkable);
+		auto it = shard.PendingCheckables.find(checkable);
 
-		if (it != m_PendingCheckables.end()) {
-			m_PendingCheckables.erase(it);
+		if (it != shard.PendingCheckables.end()) {
+			shard.PendingCheckables.erase(it);
 
 			if (checkable->IsActive())
-				m_IdleCheckables.insert(GetCheckableScheduleInfo(checkable));
+				shard.IdleCheckables->Insert(GetCheckableScheduleInfo(checkable));
 
-			m_CV.notify_all();
+			shard.CV.notify_all();
 		}
 	}
 
@@ -288,14 +409,69 @@ void CheckerComponent::ResultTimerHandler()
 {
 	std::ostringstream msgbuf;
 
-	{
-		std::unique_lock<std::mutex> lock(m_Mutex);
+	msgbuf << "Pending checkables: " << GetPendingCheckables() << "; Idle checkables: " << GetIdleCheckables() << "; Checks/s: "
+		<< (CIB::GetActiveHostChecksStatistics(60) + CIB::GetActiveServiceChecksStatistics(60)) / 60.0;
+
+	Log(LogNotice, "CheckerComponent", msgbuf.str());
+}
+
+/**
+ * Updates the adaptive concurrency limit from the execution times of the checks finished
+ * since the last call, each compared to the previous execution time of the same checkable.
+ */
+void CheckerComponent::ConcurrencyTimerHandler()
+{
+	m_ConcurrencyLimiter->SetBounds(GetMinConcurrentChecks(), std::max(IcingaApplication::GetInstance()->GetMaxConcurrentChecks(), 0));
+
+	size_t oldLimit = m_ConcurrencyLimiter->GetLimit();
+	size_t limit = m_ConcurrencyLimiter->Update(std::max(Checkable::GetPendingChecks(), 0));
 
-		msgbuf << "Pending checkables: " << m_PendingCheckables.size() << "; Idle checkables: " << m_IdleCheckables.size() << "; Checks/s: "
-			<< (CIB::GetActiveHostChecksStatistics(60) + CIB::GetActiveServiceChecksStatistics(60)) / 60.0;
+	if (limit != oldLimit) {
+		Log(LogDebug, "CheckerComponent")
+			<< "Adjusted concurrency limit from " << oldLimit << " to " << limit << " (median execution time ratio: "
+			<< m_ConcurrencyLimiter->GetLatencyRatio() << ").";
 	}
 
-	Log(LogNotice, "CheckerComponent", msgbuf.str());
+	if (limit > oldLimit)
+		WakeUpWaitingShards();
+}
+
+/**
+ * Wakes up the scheduler threads which wait for a free check slot.
+ */
+void CheckerComponent::WakeUpWaitingShards()
+{
+	for (auto& shard : m_Shards) {
+		if (shard->WaitingForSlot.load()) {
+			std::unique_lock<std::mutex> lock(shard->Mutex);
+			shard->CV.notify_all();
+		}
+	}
+}
+
+/**
+ * Re-places the idle checkables of all shards relative to the current time, like Timer::AdjustTimers().
+ */
+void CheckerComponent::ClockJumpedHandler()
+{
+	for (auto& shard : m_Shards) {
+		std::unique_lock<std::mutex> lock(shard->Mutex);
+
+		shard->IdleCheckables->Rebase(Utility::GetTime());
+		shard->CV.notify_all();
+	}
+}
+
+/**
+ * Returns the number of checks which may be pending at once, MaxConcurrentChecks unless
+ * concurrency_control is set to adaptive.
+ */
+int CheckerComponent::GetConcurrencyLimit() const
+{
+	if (m_ConcurrencyLimiter)
+		return m_ConcurrencyLimiter->GetLimit();
+
+	return IcingaApplication::GetInstance()->GetMaxConcurrentChecks();
 }
 
 void CheckerComponent::ObjectHandler(const ConfigObject::Ptr& object)
@@ -308,20 +484,25 @@ void CheckerComponent::ObjectHandler(const ConfigObject::Ptr& object)
 	Zone::Ptr zone = Zone::GetByName(checkable->GetZoneName());
 	bool same_zone = (!zone || Zone::GetLocalZone() == zone);
 
+	Shard& shard = GetShard(checkable);
+
 	{
-		std::unique_lock<std::mutex> lock(m_Mutex);
+		std::unique_lock<std::mutex> lock(shard.Mutex);
 
 		if (object->IsActive() && !object->IsPaused() && same_zone) {
-			if (m_PendingCheckables.find(checkable) != m_PendingCheckables.end())
+			if (shard.PendingCheckables.find(checkable) != shard.PendingCheckables.end())
 				return;
 
-			m_IdleCheckables.insert(GetCheckableScheduleInfo(checkable));
+			shard.IdleCheckables->Insert(GetCheckableScheduleInfo(checkable));
 		} else {
-			m_IdleCheckables.erase(checkable);
-			m_PendingCheckables.erase(checkable);
+			shard.IdleCheckables->Erase(checkable);
+			shard.PendingCheckables.erase(checkable);
+
+			if (m_ConcurrencyLimiter)
+				m_ConcurrencyLimiter->Forget(checkable.get());
 		}
 
-		m_CV.notify_all();
+		shard.CV.notify_all();
 	}
 }
 
@@ -335,35 +516,52 @@ CheckableScheduleInfo CheckerComponent::GetCheckableScheduleInfo(const Checkable
 
 void CheckerComponent::NextCheckChangedHandler(const Checkable::Ptr& checkable)
 {
-	std::unique_lock<std::mutex> lock(m_Mutex);
+	Shard& shard = GetShard(checkable);
+	std::unique_lock<std::mutex> lock(shard.Mutex);
 
-	/* remove and re-insert the object from the set in order to force an index update */
-	typedef boost::multi_index::nth_index<CheckableSet, 0>::type CheckableView;
-	CheckableView& idx = boost::get<0>(m_IdleCheckables);
-
-	auto it = idx.find(checkable);
-
-	if (it == idx.end())
+	if (!shard.IdleCheckables->Contains(checkable))
 		return;
 
-	idx.erase(checkable);
-
-	CheckableScheduleInfo csi = GetCheckableScheduleInfo(checkable);
-	idx.insert(csi);
+	shard.IdleCheckables->Insert(GetCheckableScheduleInfo(checkable));
 
-	m_CV.notify_all();
+	shard.CV.notify_all();
 }
 
 unsigned long CheckerComponent::GetIdleCheckables()
 {
-	std::unique_lock<std::mutex> lock(m_Mutex);
+	unsigned long count = 0;
 
-	return m_IdleCheckables.size();
+	for (size_t i = 0; i < m_Shards.size(); i++)
+		count += GetIdleCheckables(i);
+
+	return count;
 }
 
 unsigned long CheckerComponent::GetPendingCheckables()
 {
-	std::unique_lock<std::mutex> lock(m_Mutex);
+	unsigned long count = 0;
+
+	for (size_t i = 0; i < m_Shards.size(); i++)
+		count += GetPendingCheckables(i);
+
+	return count;
+}
+
+size_t CheckerComponent::GetShardCount() const
+{
+	return m_Shards.size();
+}
+
+unsigned long CheckerComponent::GetIdleCheckables(size_t shard)
+{
+	std::unique_lock<std::mutex> lock(m_Shards[shard]->Mutex);
+
+	return m_Shards[shard]->IdleCheckables->GetLength();
+}
+
+unsigned long CheckerComponent::GetPendingCheckables(size_t shard)
+{
+	std::unique_lock<std::mutex> lock(m_Shards[shard]->Mutex);
 
-	return m_PendingCheckables.size();
+	return m_Shards[shard]->PendingCheckables.size();
 }
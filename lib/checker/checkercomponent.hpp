@@ -5,46 +5,23 @@
 #define CHECKERCOMPONENT_H
 
 #include "checker/checkercomponent-ti.hpp"
+#include "checker/checkablequeue.hpp"
 #include "icinga/service.hpp"
+#include "base/concurrency-limiter.hpp"
 #include "base/configobject.hpp"
 #include "base/timer.hpp"
 #include "base/utility.hpp"
 #include "base/wait-group.hpp"
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/key_extractors.hpp>
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace icinga
 {
 
-/**
- * @ingroup checker
- */
-struct CheckableScheduleInfo
-{
-	Checkable::Ptr Object;
-	double NextCheck;
-};
-
-/**
- * @ingroup checker
- */
-struct CheckableNextCheckExtractor
-{
-	typedef double result_type;
-
-	/**
-	 * @threadsafety Always.
-	 */
-	double operator()(const CheckableScheduleInfo& csi)
-	{
-		return csi.NextCheck;
-	}
-};
-
 /**
  * @ingroup checker
  */
@@ -54,14 +31,6 @@ public:
 	DECLARE_OBJECT(CheckerComponent);
 	DECLARE_OBJECTNAME(CheckerComponent);
 
-	typedef boost::multi_index_container<
-		CheckableScheduleInfo,
-		boost::multi_index::indexed_by<
-			boost::multi_index::ordered_unique<boost::multi_index::member<CheckableScheduleInfo, Checkable::Ptr, &CheckableScheduleInfo::Object> >,
-			boost::multi_index::ordered_non_unique<CheckableNextCheckExtractor>
-		>
-	> CheckableSet;
-
 	void OnConfigLoaded() override;
 	void Start(bool runtimeCreated) override;
 	void Stop(bool runtimeRemoved) override;
@@ -70,22 +39,57 @@ public:
 	unsigned long GetIdleCheckables();
 	unsigned long GetPendingCheckables();
 
+	size_t GetShardCount() const;
+	unsigned long GetIdleCheckables(size_t shard);
+	unsigned long GetPendingCheckables(size_t shard);
+
+	int GetConcurrencyLimit() const;
+
+protected:
+	void ValidateSchedulerShards(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
+	void ValidateSchedulerBackend(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
+	void ValidateConcurrencyControl(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
+	void ValidateMinConcurrentChecks(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
+
 private:
-	std::mutex m_Mutex;
-	std::condition_variable m_CV;
-	bool m_Stopped{false};
-	std::thread m_Thread;
+	/**
+	 * A scheduler shard owns a disjoint subset of the checkables handled by this
+	 * component. Every shard has its own queues, lock and scheduler thread, so
+	 * shards never contend with each other.
+	 */
+	struct Shard
+	{
+		size_t Index;
+
+		std::mutex Mutex;
+		std::condition_variable CV;
+		bool Stopped{false};
+		std::thread Thread;
+
+		/* Set while the scheduler thread waits for a free check slot. */
+		std::atomic<bool> WaitingForSlot{false};
 
-	CheckableSet m_IdleCheckables;
-	CheckableSet m_PendingCheckables;
+		std::unique_ptr<CheckableQueue> IdleCheckables;
+		CheckableSet PendingCheckables;
+	};
+
+	std::vector<std::unique_ptr<Shard>> m_Shards;
 
 	StoppableWaitGroup::Ptr m_WaitGroup = new StoppableWaitGroup();
 	Timer::Ptr m_ResultTimer;
 
-	void CheckThreadProc();
+	std::unique_ptr<ConcurrencyLimiter> m_ConcurrencyLimiter;
+	Timer::Ptr m_ConcurrencyTimer;
+
+	Shard& GetShard(const Checkable::Ptr& checkable);
+
+	void CheckThreadProc(Shard& shard);
 	void ResultTimerHandler();
+	void ConcurrencyTimerHandler();
+	void WakeUpWaitingShards();
+	void ClockJumpedHandler();
 
-	void ExecuteCheckHelper(const Checkable::Ptr& checkable);
+	void ExecuteCheckHelper(Shard& shard, const Checkable::Ptr& checkable);
 
 	void AdjustCheckTimer();
 
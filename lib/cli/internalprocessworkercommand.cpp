@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "cli/internalprocessworkercommand.hpp"
+#include "base/logger.hpp"
+
+#ifndef _WIN32
+#include "base/process-worker.hpp"
+#include <unistd.h>
+#endif /* _WIN32 */
+
+using namespace icinga;
+
+REGISTER_CLICOMMAND("internal/process-worker", InternalProcessWorkerCommand);
+
+String InternalProcessWorkerCommand::GetDescription() const
+{
+	return "Execute check commands on behalf of a CheckCommand's worker_command";
+}
+
+String InternalProcessWorkerCommand::GetShortDescription() const
+{
+	return "Execute check commands as a worker";
+}
+
+bool InternalProcessWorkerCommand::IsHidden() const
+{
+	return true;
+}
+
+/**
+ * The entry point for the "internal process-worker" CLI command.
+ *
+ * @returns An exit status.
+ */
+int InternalProcessWorkerCommand::Run([[maybe_unused]] const boost::program_options::variables_map& vm,
+	[[maybe_unused]] const std::vector<std::string>& ap) const
+{
+#ifndef _WIN32
+	/* stdout carries the responses, log messages must not end up in between them. */
+	int outFD = dup(STDOUT_FILENO);
+
+	if (outFD < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+		Log(LogCritical, "cli", "Failed to redirect stdout.");
+		return 1;
+	}
+
+	return ProcessWorkerPool::Serve(STDIN_FILENO, outFD);
+#else /* _WIN32 */
+	Log(LogCritical, "cli", "Unsupported action on Windows.");
+	return 1;
+#endif /* _WIN32 */
+}
@@ -0,0 +1,28 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "cli/clicommand.hpp"
+
+namespace icinga
+{
+
+/**
+ * The "internal process-worker" command.
+ *
+ * @ingroup cli
+ */
+class InternalProcessWorkerCommand final : public CLICommand
+{
+public:
+	DECLARE_PTR_TYPEDEFS(InternalProcessWorkerCommand);
+
+	String GetDescription() const override;
+	String GetShortDescription() const override;
+	bool IsHidden() const override;
+	int Run(const boost::program_options::variables_map& vm, const std::vector<std::string>& ap) const override;
+
+};
+
+}
@@ -7,6 +7,7 @@
 #include "config/objectrule.hpp"
 #include "config/configcompiler.hpp"
 #include "base/application.hpp"
+#include "base/atom.hpp"
 #include "base/configtype.hpp"
 #include "base/objectlock.hpp"
 #include "base/convert.hpp"
@@ -627,6 +628,12 @@ bool ConfigItem::CommitItems(const ActivationContext::Ptr& context, WorkQueue& u
 			Log(LogInformation, "ConfigItem")
 				<< "Instantiated " << kv.second << " " << (kv.second != 1 ? kv.first->GetPluralName() : kv.first->GetName()) << ".";
 		}
+
+		Dictionary::Ptr atoms = Atom::GetStats();
+
+		Log(LogInformation, "ConfigItem")
+			<< "Interned " << atoms->Get("references") << " object names as " << atoms->Get("entries")
+			<< " distinct strings, saving " << atoms->Get("bytes_saved") << " bytes.";
 	}
 
 	return true;
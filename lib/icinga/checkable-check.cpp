@@ -5,6 +5,7 @@
 #include "icinga/service.hpp"
 #include "icinga/host.hpp"
 #include "icinga/checkcommand.hpp"
+#include "icinga/checkscheduleplanner.hpp"
 #include "icinga/icingaapplication.hpp"
 #include "icinga/cib.hpp"
 #include "icinga/clusterevents.hpp"
@@ -19,11 +20,12 @@
 
 using namespace icinga;
 
-boost::signals2::signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, const MessageOrigin::Ptr&)> Checkable::OnNewCheckResult;
-boost::signals2::signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, StateType, const MessageOrigin::Ptr&)> Checkable::OnStateChange;
+Signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, const MessageOrigin::Ptr&)> Checkable::OnNewCheckResult;
+Signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, StateType, const MessageOrigin::Ptr&)> Checkable::OnStateChange;
 boost::signals2::signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, std::set<Checkable::Ptr>, const MessageOrigin::Ptr&)> Checkable::OnReachabilityChanged;
 boost::signals2::signal<void (const Checkable::Ptr&, NotificationType, const CheckResult::Ptr&, const String&, const String&, const MessageOrigin::Ptr&)> Checkable::OnNotificationsRequested;
 boost::signals2::signal<void (const Checkable::Ptr&)> Checkable::OnNextCheckUpdated;
+Signal<void ()> Checkable::OnPendingChecksDecreased;
 
 Atomic<uint_fast64_t> Checkable::CurrentConcurrentChecks (0);
 
@@ -72,6 +74,11 @@ void Checkable::UpdateNextCheck(const MessageOrigin::Ptr& origin)
 	double nextCheck = now - adj + interval;
 	double lastCheck = GetLastCheck();
 
+	/* Postpone the check into the least loaded second close by. The next call
+	 * realigns the check with the scheduling offset, so the delay doesn't last. */
+	if (interval > 1)
+		nextCheck = CheckSchedulePlanner::GetInstance().Plan(m_PlannedCheck, nextCheck, std::min(interval * 0.05, 5.0));
+
 	Log(LogDebug, "Checkable")
 		<< std::fixed << std::setprecision(0)
 		<< "Update checkable '" << GetName() << "' with check interval '" << GetCheckInterval()
@@ -704,9 +711,13 @@ void Checkable::IncreasePendingChecks()
 
 void Checkable::DecreasePendingChecks()
 {
-	std::unique_lock<std::mutex> lock(m_StatsMutex);
-	m_PendingChecks--;
-	m_PendingChecksCV.notify_one();
+	{
+		std::unique_lock<std::mutex> lock(m_StatsMutex);
+		m_PendingChecks--;
+		m_PendingChecksCV.notify_one();
+	}
+
+	OnPendingChecksDecreased();
 }
 
 int Checkable::GetPendingChecks()
@@ -3,6 +3,7 @@
 
 #include "icinga/checkable.hpp"
 #include "icinga/checkable-ti.cpp"
+#include "icinga/checkscheduleplanner.hpp"
 #include "icinga/host.hpp"
 #include "icinga/service.hpp"
 #include "base/objectlock.hpp"
@@ -60,6 +61,11 @@ void Checkable::StaticInitialize()
 	Downtime::OnDowntimeTriggered.connect([](const Downtime::Ptr& downtime) { Checkable::NotifyFlexibleDowntimeStart(downtime); });
 	/* fixed/flexible downtime end */
 	Downtime::OnDowntimeRemoved.connect([](const Downtime::Ptr& downtime) { Checkable::NotifyDowntimeEnd(downtime); });
+
+	/* Keep the planner up to date with next checks set by other means, e.g. the API or the cluster. */
+	Checkable::OnNextCheckChanged.connect([](const Checkable::Ptr& checkable, const Value&) {
+		CheckSchedulePlanner::GetInstance().Reserve(checkable->m_PlannedCheck, checkable->GetNextCheck());
+	});
 }
 
 Checkable::Checkable()
@@ -67,6 +73,11 @@ Checkable::Checkable()
 	SetSchedulingOffset(Utility::Random());
 }
 
+SharedLockState *Checkable::GetSharedLockState() const
+{
+	return &m_SharedLock;
+}
+
 void Checkable::OnConfigLoaded()
 {
 	ObjectImpl<Checkable>::OnConfigLoaded();
@@ -126,10 +137,15 @@ void Checkable::Start(bool runtimeCreated)
 		}
 	}
 
+	auto& planner (CheckSchedulePlanner::GetInstance());
+
 	if (GetNextCheck() < now + 60) {
-		double delta = std::min(GetCheckInterval(), 60.0);
-		delta *= (double)std::rand() / RAND_MAX;
-		SetNextCheck(now + delta);
+		/* Spread the checks evenly across their check interval rather than randomly, so that they don't
+		 * cluster after a restart. Checks which have never been executed still run within a minute. */
+		double window = HasBeenChecked() ? GetCheckInterval() : std::min(GetCheckInterval(), 60.0);
+		SetNextCheck(planner.Plan(m_PlannedCheck, now, window));
+	} else {
+		planner.Reserve(m_PlannedCheck, GetNextCheck());
 	}
 
 	ObjectImpl<Checkable>::Start(runtimeCreated);
@@ -149,6 +165,13 @@ void Checkable::Start(bool runtimeCreated)
 	});
 }
 
+void Checkable::Stop(bool runtimeRemoved)
+{
+	CheckSchedulePlanner::GetInstance().Release(m_PlannedCheck);
+
+	ObjectImpl<Checkable>::Stop(runtimeRemoved);
+}
+
 void Checkable::AddGroup(const String& name)
 {
 	std::unique_lock<std::mutex> lock(m_CheckableMutex);
@@ -6,9 +6,11 @@
 
 #include "base/atomic.hpp"
 #include "base/timer.hpp"
+#include "base/signal.hpp"
 #include "base/process.hpp"
 #include "icinga/i2-icinga.hpp"
 #include "icinga/checkable-ti.hpp"
+#include "icinga/checkscheduleplanner.hpp"
 #include "icinga/timeperiod.hpp"
 #include "icinga/notification.hpp"
 #include "icinga/comment.hpp"
@@ -132,8 +134,8 @@ public:
 
 	Endpoint::Ptr GetCommandEndpoint() const;
 
-	static boost::signals2::signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, const MessageOrigin::Ptr&)> OnNewCheckResult;
-	static boost::signals2::signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, StateType, const MessageOrigin::Ptr&)> OnStateChange;
+	static Signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, const MessageOrigin::Ptr&)> OnNewCheckResult;
+	static Signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, StateType, const MessageOrigin::Ptr&)> OnStateChange;
 	static boost::signals2::signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, std::set<Checkable::Ptr>, const MessageOrigin::Ptr&)> OnReachabilityChanged;
 	static boost::signals2::signal<void (const Checkable::Ptr&, NotificationType, const CheckResult::Ptr&,
 		const String&, const String&, const MessageOrigin::Ptr&)> OnNotificationsRequested;
@@ -148,6 +150,7 @@ public:
 	static boost::signals2::signal<void (const Checkable::Ptr&, const String&, double, const MessageOrigin::Ptr&)> OnAcknowledgementCleared;
 	static boost::signals2::signal<void (const Checkable::Ptr&, double)> OnFlappingChange;
 	static boost::signals2::signal<void (const Checkable::Ptr&)> OnNextCheckUpdated;
+	static Signal<void ()> OnPendingChecksDecreased;
 	static boost::signals2::signal<void (const Checkable::Ptr&)> OnEventCommandExecuted;
 
 	static Atomic<uint_fast64_t> CurrentConcurrentChecks;
@@ -219,13 +222,18 @@ public:
 
 protected:
 	void Start(bool runtimeCreated) override;
+	void Stop(bool runtimeRemoved) override;
 	void OnConfigLoaded() override;
 	void OnAllConfigLoaded() override;
 
+	SharedLockState *GetSharedLockState() const override;
+
 private:
+	mutable SharedLockState m_SharedLock; /**< Lets the status readers (CIB, Livestatus) share an ObjectLock. */
 	mutable std::mutex m_CheckableMutex;
 	bool m_CheckRunning{false};
 	long m_SchedulingOffset;
+	CheckSchedulePlanner::Reservation m_PlannedCheck; /**< The next check's reservation with the CheckSchedulePlanner. */
 
 	static std::mutex m_StatsMutex;
 	static int m_PendingChecks;
@@ -4,6 +4,8 @@
 #include "icinga/checkcommand.hpp"
 #include "icinga/checkcommand-ti.cpp"
 #include "base/configtype.hpp"
+#include "base/exception.hpp"
+#include "base/logger.hpp"
 
 using namespace icinga;
 
@@ -22,3 +24,53 @@ void CheckCommand::Execute(const Checkable::Ptr& checkable, const CheckResult::P
 		useResolvedMacros
 	});
 }
+
+void CheckCommand::Start(bool runtimeCreated)
+{
+	ObjectImpl<CheckCommand>::Start(runtimeCreated);
+
+	Value workerCommand = GetWorkerCommand();
+
+	if (workerCommand.IsEmpty())
+		return;
+
+#ifndef _WIN32
+	m_WorkerPool = new ProcessWorkerPool(Process::PrepareCommand(workerCommand), GetWorkerCount());
+	m_WorkerPool->Start();
+
+	Log(LogInformation, "CheckCommand")
+		<< "Started " << GetWorkerCount() << " workers for check command '" << GetName() << "'.";
+#else /* _WIN32 */
+	Log(LogWarning, "CheckCommand")
+		<< "Check command '" << GetName() << "' has a 'worker_command', but workers aren't supported on Windows."
+		<< " Executing the command directly.";
+#endif /* _WIN32 */
+}
+
+void CheckCommand::Stop(bool runtimeRemoved)
+{
+#ifndef _WIN32
+	if (m_WorkerPool)
+		m_WorkerPool->Stop();
+#endif /* _WIN32 */
+
+	ObjectImpl<CheckCommand>::Stop(runtimeRemoved);
+}
+
+#ifndef _WIN32
+/**
+ * Returns the pool of workers which execute this command or nullptr if it's executed directly.
+ */
+ProcessWorkerPool::Ptr CheckCommand::GetWorkerPool() const
+{
+	return m_WorkerPool;
+}
+#endif /* _WIN32 */
+
+void CheckCommand::ValidateWorkerCount(const Lazy<int>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<CheckCommand>::ValidateWorkerCount(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "worker_count" }, "Value must be greater than 0."));
+}
@@ -6,6 +6,7 @@
 
 #include "icinga/checkcommand-ti.hpp"
 #include "icinga/checkable.hpp"
+#include "base/process-worker.hpp"
 
 namespace icinga
 {
@@ -27,6 +28,21 @@ public:
 		const WaitGroup::Ptr& producer,
 		const Dictionary::Ptr& resolvedMacros = nullptr,
 		bool useResolvedMacros = false);
+
+#ifndef _WIN32
+	ProcessWorkerPool::Ptr GetWorkerPool() const;
+#endif /* _WIN32 */
+
+	void ValidateWorkerCount(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
+
+protected:
+	void Start(bool runtimeCreated) override;
+	void Stop(bool runtimeRemoved) override;
+
+private:
+#ifndef _WIN32
+	ProcessWorkerPool::Ptr m_WorkerPool;
+#endif /* _WIN32 */
 };
 
 }
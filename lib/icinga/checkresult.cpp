@@ -4,6 +4,7 @@
 #include "icinga/checkresult.hpp"
 #include "icinga/checkresult-ti.cpp"
 #include "base/scriptglobal.hpp"
+#include <memory>
 
 using namespace icinga;
 
@@ -41,3 +42,25 @@ void CheckResult::SetPerformanceData(const Array::Ptr& value, bool suppress_even
 	}
 	ObjectImpl<CheckResult>::SetPerformanceData(value, suppress_events, cookie);
 }
+
+/**
+ * Parses the performance data once for all consumers, e.g. the perfdata writers.
+ *
+ * @returns The parsed performance data, nullptr if there is none.
+ */
+std::shared_ptr<const PerfdataMetrics> CheckResult::GetPerfdataMetrics() const
+{
+	Array::Ptr perfdata = GetPerformanceData();
+
+	if (!perfdata)
+		return nullptr;
+
+	auto metrics (std::atomic_load(&m_PerfdataMetrics));
+
+	if (!metrics || metrics->GetSource() != perfdata) {
+		metrics = std::make_shared<const PerfdataMetrics>(perfdata);
+		std::atomic_store(&m_PerfdataMetrics, metrics);
+	}
+
+	return metrics;
+}
@@ -6,6 +6,9 @@
 
 #include "icinga/i2-icinga.hpp"
 #include "icinga/checkresult-ti.hpp"
+#include "base/object-pool.hpp"
+#include "base/perfdatavalue.hpp"
+#include <memory>
 
 namespace icinga
 {
@@ -19,10 +22,16 @@ class CheckResult final : public ObjectImpl<CheckResult>
 {
 public:
 	DECLARE_OBJECT(CheckResult);
+	DECLARE_POOLED_ALLOCATION(CheckResult);
 
 	double CalculateExecutionTime() const;
 	double CalculateLatency() const;
 	void SetPerformanceData(const Array::Ptr& value, bool suppress_events = false, const Value& cookie = Empty) override;
+
+	std::shared_ptr<const PerfdataMetrics> GetPerfdataMetrics() const;
+
+private:
+	mutable std::shared_ptr<const PerfdataMetrics> m_PerfdataMetrics;
 };
 
 }
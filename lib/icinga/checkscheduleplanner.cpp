@@ -0,0 +1,283 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/checkscheduleplanner.hpp"
+#include "base/perfdatavalue.hpp"
+#include "base/statsfunction.hpp"
+#include "base/utility.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+using namespace icinga;
+
+REGISTER_STATSFUNCTION(CheckSchedulePlanner, &CheckSchedulePlanner::StatsFunc);
+
+static_assert((CheckSchedulePlanner::Horizon & (CheckSchedulePlanner::Horizon - 1)) == 0, "Horizon must be a power of two");
+
+static std::atomic<size_t> l_NextReservationShard (0);
+
+/**
+ * Assigns the reservation to the next shard, round-robin.
+ */
+CheckSchedulePlanner::Reservation::Reservation()
+	: m_Shard(l_NextReservationShard.fetch_add(1, std::memory_order_relaxed) % ShardCount)
+{
+}
+
+CheckSchedulePlanner::Reservation::Reservation(size_t shard)
+	: m_Shard(shard % ShardCount)
+{
+}
+
+CheckSchedulePlanner::CheckSchedulePlanner()
+{
+	auto origin (static_cast<int64_t>(std::floor(Utility::GetTime())));
+
+	for (auto& shard : m_Shards) {
+		shard.Origin = origin;
+		shard.Tree.assign(Horizon * 2, 0);
+	}
+}
+
+CheckSchedulePlanner& CheckSchedulePlanner::GetInstance()
+{
+	static CheckSchedulePlanner planner;
+	return planner;
+}
+
+/**
+ * Places a check into the least loaded second of a time window and moves the reservation there.
+ *
+ * Of multiple least loaded seconds, the first one after an offset into the window is taken. The offset
+ * differs per shard, otherwise all shards would fill up the beginning of the window first.
+ *
+ * @param reservation The checkable's reservation.
+ * @param from The earliest time for the check.
+ * @param window The length of the window in seconds. Only the part within Horizon is considered.
+ * @returns The time for the check.
+ */
+double CheckSchedulePlanner::Plan(Reservation& reservation, double from, double window)
+{
+	auto& shard (m_Shards[reservation.m_Shard]);
+	std::unique_lock<std::mutex> lock (shard.Mutex);
+
+	shard.Advance();
+	shard.Release(reservation);
+
+	auto fromSecond (static_cast<int64_t>(std::floor(from)));
+	int64_t begin = std::max(fromSecond, shard.Origin);
+	int64_t end = std::min(std::max(static_cast<int64_t>(std::floor(from + window)), begin + 1), shard.Origin + Horizon);
+
+	if (begin >= end) {
+		shard.Reserve(reservation, from);
+		return from;
+	}
+
+	size_t first = begin & (Horizon - 1);
+	size_t length = end - begin;
+	size_t offset = length * reservation.m_Shard / ShardCount;
+	unsigned count = UINT_MAX;
+	size_t index = 0;
+
+	shard.FindLeastLoaded((first + offset) & (Horizon - 1), length - offset, count, index);
+	shard.FindLeastLoaded(first, offset, count, index);
+
+	int64_t second = begin + ((index - first) & (Horizon - 1));
+	double ts = second == fromSecond ? from : second + (from - fromSecond);
+
+	shard.Reserve(reservation, ts);
+
+	return ts;
+}
+
+/**
+ * Moves a reservation to the specified time, e.g. after the next check has been set by other means.
+ * Doesn't lock if it's there already, e.g. because Plan() has just put it there.
+ *
+ * @param reservation The checkable's reservation.
+ * @param ts The time of the next check.
+ */
+void CheckSchedulePlanner::Reserve(Reservation& reservation, double ts)
+{
+	if (reservation.GetTime() == ts)
+		return;
+
+	auto& shard (m_Shards[reservation.m_Shard]);
+	std::unique_lock<std::mutex> lock (shard.Mutex);
+
+	shard.Advance();
+	shard.Release(reservation);
+	shard.Reserve(reservation, ts);
+}
+
+/**
+ * Drops a reservation, e.g. because the checkable has been deactivated.
+ *
+ * @param reservation The checkable's reservation.
+ */
+void CheckSchedulePlanner::Release(Reservation& reservation)
+{
+	auto& shard (m_Shards[reservation.m_Shard]);
+	std::unique_lock<std::mutex> lock (shard.Mutex);
+
+	shard.Advance();
+	shard.Release(reservation);
+}
+
+/**
+ * Returns the number of checks planned for each of the next seconds, starting with the current one.
+ *
+ * @param seconds The number of seconds, at most Horizon.
+ */
+std::vector<unsigned> CheckSchedulePlanner::GetHistogram(size_t seconds)
+{
+	std::vector<unsigned> histogram (std::min<size_t>(seconds, Horizon), 0);
+
+	for (auto& shard : m_Shards) {
+		std::unique_lock<std::mutex> lock (shard.Mutex);
+
+		shard.Advance();
+
+		for (size_t i = 0; i < histogram.size(); i++) {
+			histogram[i] += shard.GetCount(shard.Origin + i);
+		}
+	}
+
+	return histogram;
+}
+
+/**
+ * Forgets the counts of the seconds which have passed, their leaves are reused for the upcoming ones.
+ */
+void CheckSchedulePlanner::Shard::Advance()
+{
+	auto now (static_cast<int64_t>(std::floor(Utility::GetTime())));
+
+	if (now <= Origin)
+		return;
+
+	if (now - Origin >= Horizon) {
+		std::fill(Tree.begin(), Tree.end(), 0);
+	} else {
+		for (int64_t second = Origin; second < now; second++) {
+			SetCount(second, 0);
+		}
+	}
+
+	Origin = now;
+}
+
+void CheckSchedulePlanner::Shard::Reserve(Reservation& reservation, double ts)
+{
+	auto second (static_cast<int64_t>(std::floor(ts)));
+
+	if (second < Origin || second >= Origin + Horizon) {
+		reservation.m_Time.store(-1, std::memory_order_relaxed);
+		return;
+	}
+
+	SetCount(second, GetCount(second) + 1u);
+	reservation.m_Time.store(ts, std::memory_order_relaxed);
+}
+
+void CheckSchedulePlanner::Shard::Release(Reservation& reservation)
+{
+	double ts = reservation.GetTime();
+
+	if (ts < 0)
+		return;
+
+	auto second (static_cast<int64_t>(std::floor(ts)));
+
+	/* Otherwise the second has passed and its count has been reset already. */
+	if (second >= Origin) {
+		unsigned count = GetCount(second);
+
+		if (count > 0)
+			SetCount(second, count - 1u);
+	}
+
+	reservation.m_Time.store(-1, std::memory_order_relaxed);
+}
+
+void CheckSchedulePlanner::Shard::SetCount(int64_t second, unsigned count)
+{
+	size_t node = Horizon + (second & (Horizon - 1));
+
+	Tree[node] = count;
+
+	for (node /= 2u; node > 0; node /= 2u) {
+		Tree[node] = std::min(Tree[node * 2u], Tree[node * 2u + 1u]);
+	}
+}
+
+unsigned CheckSchedulePlanner::Shard::GetCount(int64_t second) const
+{
+	return Tree[Horizon + (second & (Horizon - 1))];
+}
+
+/**
+ * Finds the first leaf of length leaves starting at begin whose count is less than count,
+ * in chronological order, i.e. wrapping around the end of the leaves.
+ */
+void CheckSchedulePlanner::Shard::FindLeastLoaded(size_t begin, size_t length, unsigned& count, size_t& index) const
+{
+	if (!length)
+		return;
+
+	FindLeastLoaded(1, 0, Horizon, begin, std::min<size_t>(begin + length, Horizon), count, index);
+
+	if (begin + length > Horizon)
+		FindLeastLoaded(1, 0, Horizon, 0, begin + length - Horizon, count, index);
+}
+
+/**
+ * Finds the leftmost leaf within [begin, end) whose count is less than count.
+ *
+ * @param node The current node, which covers the leaves [nodeBegin, nodeEnd).
+ * @param count The smallest count found so far, updated if a smaller one is found.
+ * @param index The leaf with the smallest count, updated along with count.
+ */
+void CheckSchedulePlanner::Shard::FindLeastLoaded(size_t node, size_t nodeBegin, size_t nodeEnd, size_t begin, size_t end,
+	unsigned& count, size_t& index) const
+{
+	if (end <= nodeBegin || nodeEnd <= begin || Tree[node] >= count)
+		return;
+
+	if (node >= static_cast<size_t>(Horizon)) {
+		count = Tree[node];
+		index = nodeBegin;
+		return;
+	}
+
+	size_t middle = (nodeBegin + nodeEnd) / 2u;
+
+	FindLeastLoaded(node * 2u, nodeBegin, middle, begin, end, count, index);
+	FindLeastLoaded(node * 2u + 1u, middle, nodeEnd, begin, end, count, index);
+}
+
+void CheckSchedulePlanner::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
+{
+	auto histogram (GetInstance().GetHistogram(HistogramLength));
+	unsigned max = 0;
+	size_t planned = 0;
+	ArrayData values;
+
+	values.reserve(histogram.size());
+
+	for (auto count : histogram) {
+		max = std::max(max, count);
+		planned += count;
+		values.emplace_back(count);
+	}
+
+	status->Set("checkscheduleplanner", new Dictionary({
+		{ "histogram", new Array(std::move(values)) },
+		{ "max_per_second", max },
+		{ "planned", planned }
+	}));
+
+	perfdata->Add(new PerfdataValue("checkscheduleplanner_max_per_second", max));
+	perfdata->Add(new PerfdataValue("checkscheduleplanner_planned", planned));
+}
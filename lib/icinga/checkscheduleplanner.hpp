@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "icinga/i2-icinga.hpp"
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * Keeps track of how many checks are planned for each second of the next Horizon seconds
+ * and places new checks into the least loaded seconds, so that the check load stays flat.
+ *
+ * The counts are split into ShardCount shards with their own mutex, like the checker's queues,
+ * so that the checkables rescheduled concurrently rarely wait for each other. Each shard keeps
+ * its own load flat, so the sum of them is flat, too.
+ *
+ * @ingroup icinga
+ */
+class CheckSchedulePlanner
+{
+public:
+	static constexpr int64_t Horizon = 4096;
+	static constexpr size_t ShardCount = 16;
+	static constexpr size_t HistogramLength = 600;
+
+	/**
+	 * The time a checkable's next check is counted for, -1 if it isn't counted (e.g. because it's
+	 * further ahead than Horizon). It's only modified under the mutex of its shard.
+	 */
+	class Reservation
+	{
+	public:
+		Reservation();
+		explicit Reservation(size_t shard);
+
+		Reservation(const Reservation&) = delete;
+		Reservation& operator=(const Reservation&) = delete;
+
+		double GetTime() const
+		{
+			return m_Time.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<double> m_Time{-1};
+		size_t m_Shard;
+
+		friend class CheckSchedulePlanner;
+	};
+
+	CheckSchedulePlanner();
+
+	CheckSchedulePlanner(const CheckSchedulePlanner&) = delete;
+	CheckSchedulePlanner& operator=(const CheckSchedulePlanner&) = delete;
+
+	static CheckSchedulePlanner& GetInstance();
+
+	double Plan(Reservation& reservation, double from, double window);
+	void Reserve(Reservation& reservation, double ts);
+	void Release(Reservation& reservation);
+
+	std::vector<unsigned> GetHistogram(size_t seconds);
+
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+
+private:
+	struct Shard
+	{
+		std::mutex Mutex;
+		int64_t Origin; /**< The first second which is counted. */
+		std::vector<unsigned> Tree; /**< A segment tree of the minimum count per range, the seconds' counts are its leaves. */
+
+		void Advance();
+		void Reserve(Reservation& reservation, double ts);
+		void Release(Reservation& reservation);
+		void SetCount(int64_t second, unsigned count);
+		unsigned GetCount(int64_t second) const;
+		void FindLeastLoaded(size_t begin, size_t length, unsigned& count, size_t& index) const;
+		void FindLeastLoaded(size_t node, size_t nodeBegin, size_t nodeEnd, size_t begin, size_t end, unsigned& count, size_t& index) const;
+	};
+
+	std::array<Shard, ShardCount> m_Shards;
+};
+
+}
@@ -68,7 +68,7 @@ CheckableCheckStatistics CIB::CalculateHostCheckStats()
 	bool checkresult = false;
 
 	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>()) {
-		ObjectLock olock(host);
+		SharedObjectLock olock(host);
 
 		CheckResult::Ptr cr = host->GetLastCheckResult();
 
@@ -129,7 +129,7 @@ CheckableCheckStatistics CIB::CalculateServiceCheckStats()
 	bool checkresult = false;
 
 	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
-		ObjectLock olock(service);
+		SharedObjectLock olock(service);
 
 		CheckResult::Ptr cr = service->GetLastCheckResult();
 
@@ -186,7 +186,7 @@ ServiceStatistics CIB::CalculateServiceStats()
 	ServiceStatistics ss = {};
 
 	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
-		ObjectLock olock(service);
+		SharedObjectLock olock(service);
 
 		if (service->GetState() == ServiceOK)
 			ss.services_ok++;
@@ -226,7 +226,7 @@ HostStatistics CIB::CalculateHostStats()
 	HostStatistics hs = {};
 
 	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>()) {
-		ObjectLock olock(host);
+		SharedObjectLock olock(host);
 
 		if (host->IsReachable()) {
 			if (host->GetState() == HostUp)
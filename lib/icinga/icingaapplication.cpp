@@ -25,6 +25,7 @@
 using namespace icinga;
 
 static Timer::Ptr l_RetentionTimer;
+static Timer::Ptr l_ModAttrTimer;
 
 REGISTER_TYPE(IcingaApplication);
 /* Ensure that the priority is lower than the basic System namespace initialization in scriptframe.cpp. */
@@ -104,12 +105,18 @@ int IcingaApplication::Main()
 {
 	Log(LogDebug, "IcingaApplication", "In IcingaApplication::Main()");
 
-	/* periodically dump the program state */
+	/* periodically dump the changes to the program state */
 	l_RetentionTimer = Timer::Create();
-	l_RetentionTimer->SetInterval(300);
-	l_RetentionTimer->OnTimerExpired.connect([this](const Timer * const&) { DumpProgramState(); });
+	l_RetentionTimer->SetInterval(60);
+	l_RetentionTimer->OnTimerExpired.connect([](const Timer * const&) { ConfigObject::DumpObjectsDelta(Configuration::StatePath); });
 	l_RetentionTimer->Start();
 
+	/* the modified attributes are rewritten as a whole, so not as often */
+	l_ModAttrTimer = Timer::Create();
+	l_ModAttrTimer->SetInterval(300);
+	l_ModAttrTimer->OnTimerExpired.connect([this](const Timer * const&) { DumpModifiedAttributes(); });
+	l_ModAttrTimer->Start();
+
 	RunEventLoop();
 
 	Log(LogInformation, "IcingaApplication", "Icinga has shut down.");
@@ -122,6 +129,7 @@ void IcingaApplication::OnShutdown()
 	{
 		ObjectLock olock(this);
 		l_RetentionTimer->Stop();
+		l_ModAttrTimer->Stop();
 	}
 
 	DumpProgramState();
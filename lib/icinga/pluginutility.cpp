@@ -75,6 +75,18 @@ void PluginUtility::ExecuteCommand(const Command::Ptr& commandObj,
 	if (resolvedMacros && !useResolvedMacros)
 		return;
 
+#ifndef _WIN32
+	if (auto checkCommand = dynamic_pointer_cast<CheckCommand>(commandObj)) {
+		ProcessWorkerPool::Ptr pool = checkCommand->GetWorkerPool();
+
+		if (pool) {
+			pool->Run(Process::PrepareCommand(command), envMacros, timeout, true,
+				[callback, command](const ProcessResult& pr) { callback(command, pr); });
+			return;
+		}
+	}
+#endif /* _WIN32 */
+
 	Process::Ptr process = new Process(Process::PrepareCommand(command), envMacros);
 
 	process->SetTimeout(timeout);
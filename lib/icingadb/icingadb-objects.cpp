@@ -2810,6 +2810,9 @@ Dictionary::Ptr IcingaDB::SerializeState(const Checkable::Ptr& checkable)
 {
 	Dictionary::Ptr attrs = new Dictionary();
 
+	/* Read the state of one check result, concurrent serializations don't wait for each other. */
+	SharedObjectLock olock (checkable);
+
 	Host::Ptr host;
 	Service::Ptr service;
 
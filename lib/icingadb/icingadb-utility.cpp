@@ -353,7 +353,7 @@ String IcingaDB::HashValue(const Value& value, const std::set<String>& propertie
 
 				while (current != dict->End()) {
 					if (propertiesBlacklist.find(current->first) == propertiesBlacklistEnd) {
-						dict->Remove(current++);
+						current = dict->Remove(current);
 					} else {
 						++current;
 					}
@@ -424,7 +424,7 @@ private:
 	static void PersistEnvironmentId();
 
 	Timer::Ptr m_StatsTimer;
-	WorkQueue m_WorkQueue{0, 1, LogNotice};
+	WorkQueue m_WorkQueue{0, 1, LogNotice, WorkQueueLockFree};
 
 	std::future<void> m_HistoryThread;
 	Bulker<RedisConnection::Query> m_HistoryBulker {4096, std::chrono::milliseconds(250)};
@@ -497,7 +497,7 @@ Value HostsTable::AcknowledgementTypeAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	ObjectLock olock(host);
+	SharedObjectLock olock(host);
 	return host->GetAcknowledgement();
 }
 
@@ -648,7 +648,7 @@ Value HostsTable::AcknowledgedAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	ObjectLock olock(host);
+	SharedObjectLock olock(host);
 	return host->IsAcknowledged();
 }
 
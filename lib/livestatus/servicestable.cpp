@@ -549,7 +549,7 @@ Value ServicesTable::AcknowledgedAccessor(const Value& row)
 	if (!service)
 		return Empty;
 
-	ObjectLock olock(service);
+	SharedObjectLock olock(service);
 	return service->IsAcknowledged();
 }
 
@@ -560,7 +560,7 @@ Value ServicesTable::AcknowledgementTypeAccessor(const Value& row)
 	if (!service)
 		return Empty;
 
-	ObjectLock olock(service);
+	SharedObjectLock olock(service);
 	return service->GetAcknowledgement();
 }
 
@@ -521,8 +521,8 @@ void OTel::SetAttribute(Attribute& attr, Key&& key, AttrVal&& value)
 				attr.mutable_value()->set_double_value(value.template Get<double>());
 				break;
 			case ValueString:
-				if (isRvalReference) {
-					attr.mutable_value()->set_string_value(std::move(value.template Get<String>().GetData()));
+				if constexpr (isRvalReference) {
+					attr.mutable_value()->set_string_value(std::move(value.GetMutableString().GetData()));
 				} else {
 					attr.mutable_value()->set_string_value(value.template Get<String>().GetData());
 				}
@@ -197,29 +197,22 @@ void ElasticsearchWriter::AddCheckResult(const Dictionary::Ptr& fields, const Ch
 	if (!GetEnableSendPerfdata())
 		return;
 
-	Array::Ptr perfdata = cr->GetPerformanceData();
+	auto metrics (cr->GetPerfdataMetrics());
 
 	CheckCommand::Ptr checkCommand = checkable->GetCheckCommand();
 
-	if (perfdata) {
-		for (const Value& val : perfdata) {
-			PerfdataValue::Ptr pdv;
-
-			if (val.IsObjectType<PerfdataValue>())
-				pdv = val;
-			else {
-				try {
-					pdv = PerfdataValue::Parse(val);
-				} catch (const std::exception&) {
-					Log(LogWarning, "ElasticsearchWriter")
-						<< "Ignoring invalid perfdata for checkable '"
-						<< checkable->GetName() << "' and command '"
-						<< checkCommand->GetName() << "' with value: " << val;
-					continue;
-				}
+	if (metrics) {
+		for (size_t i = 0; i < metrics->GetLength(); i++) {
+			if (!metrics->IsValid(i)) {
+				Log(LogWarning, "ElasticsearchWriter")
+					<< "Ignoring invalid perfdata for checkable '"
+					<< checkable->GetName() << "' and command '"
+					<< checkCommand->GetName() << "' with value: " << metrics->GetSource()->Get(i);
+				continue;
 			}
 
-			String escapedKey = pdv->GetLabel();
+			auto label (metrics->GetLabel(i));
+			String escapedKey (label.begin(), label.end());
 			boost::replace_all(escapedKey, " ", "_");
 			boost::replace_all(escapedKey, ".", "_");
 			boost::replace_all(escapedKey, "\\", "_");
@@ -227,19 +220,19 @@ void ElasticsearchWriter::AddCheckResult(const Dictionary::Ptr& fields, const Ch
 
 			String perfdataPrefix = prefix + "perfdata." + escapedKey;
 
-			fields->Set(perfdataPrefix + ".value", pdv->GetValue());
+			fields->Set(perfdataPrefix + ".value", metrics->GetValue(i));
 
-			if (!pdv->GetMin().IsEmpty())
-				fields->Set(perfdataPrefix + ".min", pdv->GetMin());
-			if (!pdv->GetMax().IsEmpty())
-				fields->Set(perfdataPrefix + ".max", pdv->GetMax());
-			if (!pdv->GetWarn().IsEmpty())
-				fields->Set(perfdataPrefix + ".warn", pdv->GetWarn());
-			if (!pdv->GetCrit().IsEmpty())
-				fields->Set(perfdataPrefix + ".crit", pdv->GetCrit());
+			if (Value min = metrics->GetMin(i); !min.IsEmpty())
+				fields->Set(perfdataPrefix + ".min", min);
+			if (Value max = metrics->GetMax(i); !max.IsEmpty())
+				fields->Set(perfdataPrefix + ".max", max);
+			if (Value warn = metrics->GetWarn(i); !warn.IsEmpty())
+				fields->Set(perfdataPrefix + ".warn", warn);
+			if (Value crit = metrics->GetCrit(i); !crit.IsEmpty())
+				fields->Set(perfdataPrefix + ".crit", crit);
 
-			if (!pdv->GetUnit().IsEmpty())
-				fields->Set(perfdataPrefix + ".unit", pdv->GetUnit());
+			if (auto unit (metrics->GetUnit(i)); !unit.empty())
+				fields->Set(perfdataPrefix + ".unit", String(unit.begin(), unit.end()));
 		}
 	}
 }
@@ -35,7 +35,8 @@ protected:
 
 private:
 	WorkQueue m_WorkQueue{10000000, 1};
-	boost::signals2::connection m_HandleCheckResults, m_HandleStateChanges, m_HandleNotifications;
+	SignalConnection m_HandleCheckResults, m_HandleStateChanges;
+	boost::signals2::connection m_HandleNotifications;
 	Timer::Ptr m_FlushTimer;
 	std::atomic_bool m_FlushTimerInQueue{false};
 	std::vector<String> m_DataBuffer;
@@ -195,45 +195,38 @@ void GelfWriter::CheckResultHandler(const Checkable::Ptr& checkable, const Check
 		fields->Set("_check_source", cr->GetCheckSource());
 
 		if (GetEnableSendPerfdata()) {
-			Array::Ptr perfdata = cr->GetPerformanceData();
-
-			if (perfdata) {
-				for (const Value& val : perfdata) {
-					PerfdataValue::Ptr pdv;
-
-					if (val.IsObjectType<PerfdataValue>())
-						pdv = val;
-					else {
-						try {
-							pdv = PerfdataValue::Parse(val);
-						} catch (const std::exception&) {
-							Log(LogWarning, "GelfWriter")
-								<< "Ignoring invalid perfdata for checkable '"
-								<< checkable->GetName() << "' and command '"
-								<< checkable->GetCheckCommand()->GetName() << "' with value: " << val;
-							continue;
-						}
+			auto metrics (cr->GetPerfdataMetrics());
+
+			if (metrics) {
+				for (size_t i = 0; i < metrics->GetLength(); i++) {
+					if (!metrics->IsValid(i)) {
+						Log(LogWarning, "GelfWriter")
+							<< "Ignoring invalid perfdata for checkable '"
+							<< checkable->GetName() << "' and command '"
+							<< checkable->GetCheckCommand()->GetName() << "' with value: " << metrics->GetSource()->Get(i);
+						continue;
 					}
 
-					String escaped_key = pdv->GetLabel();
+					auto label (metrics->GetLabel(i));
+					String escaped_key (label.begin(), label.end());
 					boost::replace_all(escaped_key, " ", "_");
 					boost::replace_all(escaped_key, ".", "_");
 					boost::replace_all(escaped_key, "\\", "_");
 					boost::algorithm::replace_all(escaped_key, "::", ".");
 
-					fields->Set("_" + escaped_key, pdv->GetValue());
+					fields->Set("_" + escaped_key, metrics->GetValue(i));
 
-					if (!pdv->GetMin().IsEmpty())
-						fields->Set("_" + escaped_key + "_min", pdv->GetMin());
-					if (!pdv->GetMax().IsEmpty())
-						fields->Set("_" + escaped_key + "_max", pdv->GetMax());
-					if (!pdv->GetWarn().IsEmpty())
-						fields->Set("_" + escaped_key + "_warn", pdv->GetWarn());
-					if (!pdv->GetCrit().IsEmpty())
-						fields->Set("_" + escaped_key + "_crit", pdv->GetCrit());
+					if (Value min = metrics->GetMin(i); !min.IsEmpty())
+						fields->Set("_" + escaped_key + "_min", min);
+					if (Value max = metrics->GetMax(i); !max.IsEmpty())
+						fields->Set("_" + escaped_key + "_max", max);
+					if (Value warn = metrics->GetWarn(i); !warn.IsEmpty())
+						fields->Set("_" + escaped_key + "_warn", warn);
+					if (Value crit = metrics->GetCrit(i); !crit.IsEmpty())
+						fields->Set("_" + escaped_key + "_crit", crit);
 
-					if (!pdv->GetUnit().IsEmpty())
-						fields->Set("_" + escaped_key + "_unit", pdv->GetUnit());
+					if (auto unit (metrics->GetUnit(i)); !unit.empty())
+						fields->Set("_" + escaped_key + "_unit", String(unit.begin(), unit.end()));
 				}
 			}
 		}
@@ -219,44 +219,37 @@ void GraphiteWriter::SendPerfdata(const Checkable::Ptr& checkable, const String&
 {
 	AssertOnWorkQueue();
 
-	Array::Ptr perfdata = cr->GetPerformanceData();
+	auto metrics (cr->GetPerfdataMetrics());
 
-	if (!perfdata)
+	if (!metrics)
 		return;
 
 	CheckCommand::Ptr checkCommand = checkable->GetCheckCommand();
 
-	for (const Value& val : perfdata) {
-		PerfdataValue::Ptr pdv;
-
-		if (val.IsObjectType<PerfdataValue>())
-			pdv = val;
-		else {
-			try {
-				pdv = PerfdataValue::Parse(val);
-			} catch (const std::exception&) {
-				Log(LogWarning, "GraphiteWriter")
-					<< "Ignoring invalid perfdata for checkable '"
-					<< checkable->GetName() << "' and command '"
-					<< checkCommand->GetName() << "' with value: " << val;
-				continue;
-			}
+	for (size_t i = 0; i < metrics->GetLength(); i++) {
+		if (!metrics->IsValid(i)) {
+			Log(LogWarning, "GraphiteWriter")
+				<< "Ignoring invalid perfdata for checkable '"
+				<< checkable->GetName() << "' and command '"
+				<< checkCommand->GetName() << "' with value: " << metrics->GetSource()->Get(i);
+			continue;
 		}
 
-		String escapedKey = EscapeMetricLabel(pdv->GetLabel());
+		auto label (metrics->GetLabel(i));
+		String escapedKey = EscapeMetricLabel(String(label.begin(), label.end()));
 		double ts = cr->GetExecutionEnd();
 
-		SendMetric(checkable, prefix, escapedKey + ".value", pdv->GetValue(), ts);
+		SendMetric(checkable, prefix, escapedKey + ".value", metrics->GetValue(i), ts);
 
 		if (GetEnableSendThresholds()) {
-			if (!pdv->GetCrit().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".crit", pdv->GetCrit(), ts);
-			if (!pdv->GetWarn().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".warn", pdv->GetWarn(), ts);
-			if (!pdv->GetMin().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".min", pdv->GetMin(), ts);
-			if (!pdv->GetMax().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".max", pdv->GetMax(), ts);
+			if (Value crit = metrics->GetCrit(i); !crit.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".crit", crit, ts);
+			if (Value warn = metrics->GetWarn(i); !warn.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".warn", warn, ts);
+			if (Value min = metrics->GetMin(i); !min.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".min", min, ts);
+			if (Value max = metrics->GetMax(i); !max.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".max", max, ts);
 		}
 	}
 }
@@ -39,7 +39,7 @@ private:
 	Locked<PerfdataWriterConnection::Ptr> m_LockedConnection;
 	WorkQueue m_WorkQueue{10000000, 1};
 
-	boost::signals2::connection m_HandleCheckResults;
+	SignalConnection m_HandleCheckResults;
 
 	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
 	void SendMetric(const Checkable::Ptr& checkable, const String& prefix, const String& name, double value, double ts);
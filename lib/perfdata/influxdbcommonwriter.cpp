@@ -212,42 +212,35 @@ void InfluxdbCommonWriter::CheckResultHandler(const Checkable::Ptr& checkable, c
 
 		double ts = cr->GetExecutionEnd();
 
-		if (Array::Ptr perfdata = cr->GetPerformanceData()) {
-			for (const Value& val : perfdata) {
-				PerfdataValue::Ptr pdv;
-
-				if (val.IsObjectType<PerfdataValue>())
-					pdv = val;
-				else {
-					try {
-						pdv = PerfdataValue::Parse(val);
-					} catch (const std::exception&) {
-						Log(LogWarning, GetReflectionType()->GetName())
-							<< "Ignoring invalid perfdata for checkable '"
-							<< checkable->GetName() << "' and command '"
-							<< checkable->GetCheckCommand()->GetName() << "' with value: " << val;
-						continue;
-					}
+		if (auto metrics (cr->GetPerfdataMetrics()); metrics) {
+			for (size_t i = 0; i < metrics->GetLength(); i++) {
+				if (!metrics->IsValid(i)) {
+					Log(LogWarning, GetReflectionType()->GetName())
+						<< "Ignoring invalid perfdata for checkable '"
+						<< checkable->GetName() << "' and command '"
+						<< checkable->GetCheckCommand()->GetName() << "' with value: " << metrics->GetSource()->Get(i);
+					continue;
 				}
 
 				Dictionary::Ptr fields = new Dictionary();
-				fields->Set("value", pdv->GetValue());
+				fields->Set("value", metrics->GetValue(i));
 
 				if (GetEnableSendThresholds()) {
-					if (!pdv->GetCrit().IsEmpty())
-						fields->Set("crit", pdv->GetCrit());
-					if (!pdv->GetWarn().IsEmpty())
-						fields->Set("warn", pdv->GetWarn());
-					if (!pdv->GetMin().IsEmpty())
-						fields->Set("min", pdv->GetMin());
-					if (!pdv->GetMax().IsEmpty())
-						fields->Set("max", pdv->GetMax());
+					if (Value crit = metrics->GetCrit(i); !crit.IsEmpty())
+						fields->Set("crit", crit);
+					if (Value warn = metrics->GetWarn(i); !warn.IsEmpty())
+						fields->Set("warn", warn);
+					if (Value min = metrics->GetMin(i); !min.IsEmpty())
+						fields->Set("min", min);
+					if (Value max = metrics->GetMax(i); !max.IsEmpty())
+						fields->Set("max", max);
 				}
-				if (!pdv->GetUnit().IsEmpty()) {
-					fields->Set("unit", pdv->GetUnit());
+				if (auto unit (metrics->GetUnit(i)); !unit.empty()) {
+					fields->Set("unit", String(unit.begin(), unit.end()));
 				}
 
-				SendMetric(checkable, tmpl, pdv->GetLabel(), fields, ts);
+				auto label (metrics->GetLabel(i));
+				SendMetric(checkable, tmpl, String(label.begin(), label.end()), fields, ts);
 			}
 		}
 
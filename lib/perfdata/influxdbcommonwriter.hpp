@@ -44,7 +44,7 @@ protected:
 	virtual Url::Ptr AssembleUrl() = 0;
 
 private:
-	boost::signals2::connection m_HandleCheckResults;
+	SignalConnection m_HandleCheckResults;
 	Timer::Ptr m_FlushTimer;
 	std::atomic_bool m_FlushTimerInQueue{false};
 	WorkQueue m_WorkQueue{10000000, 1};
@@ -303,55 +303,48 @@ void OpenTsdbWriter::AddPerfdata(const Checkable::Ptr& checkable, const String&
 {
 	ASSERT(m_WorkQueue.IsWorkerThread());
 
-	Array::Ptr perfdata = cr->GetPerformanceData();
+	auto metrics (cr->GetPerfdataMetrics());
 
-	if (!perfdata)
+	if (!metrics)
 		return;
 
 	CheckCommand::Ptr checkCommand = checkable->GetCheckCommand();
 
-	for (const Value& val : perfdata) {
-		PerfdataValue::Ptr pdv;
-
-		if (val.IsObjectType<PerfdataValue>())
-			pdv = val;
-		else {
-			try {
-				pdv = PerfdataValue::Parse(val);
-			} catch (const std::exception&) {
-				Log(LogWarning, "OpenTsdbWriter")
-					<< "Ignoring invalid perfdata for checkable '"
-					<< checkable->GetName() << "' and command '"
-					<< checkCommand->GetName() << "' with value: " << val;
-				continue;
-			}
+	for (size_t i = 0; i < metrics->GetLength(); i++) {
+		if (!metrics->IsValid(i)) {
+			Log(LogWarning, "OpenTsdbWriter")
+				<< "Ignoring invalid perfdata for checkable '"
+				<< checkable->GetName() << "' and command '"
+				<< checkCommand->GetName() << "' with value: " << metrics->GetSource()->Get(i);
+			continue;
 		}
-		
+
+		auto label (metrics->GetLabel(i));
 		String metric_name;
 		std::map<String, String> tags_new = tags;
 
 		// Do not break original functionality where perfdata labels form
 		// part of the metric name
 		if (!GetEnableGenericMetrics()) {
-			String escaped_key = EscapeMetric(pdv->GetLabel());
+			String escaped_key = EscapeMetric(String(label.begin(), label.end()));
 			boost::algorithm::replace_all(escaped_key, "::", ".");
 			metric_name = metric + "." + escaped_key;
 		} else {
-			String escaped_key = EscapeTag(pdv->GetLabel());
+			String escaped_key = EscapeTag(String(label.begin(), label.end()));
 			metric_name = metric;
 			tags_new["label"] = escaped_key;
 		}
 
-		AddMetric(checkable, metric_name, tags_new, pdv->GetValue(), ts);
+		AddMetric(checkable, metric_name, tags_new, metrics->GetValue(i), ts);
 
-		if (!pdv->GetCrit().IsEmpty())
-			AddMetric(checkable, metric_name + "_crit", tags_new, pdv->GetCrit(), ts);
-		if (!pdv->GetWarn().IsEmpty())
-			AddMetric(checkable, metric_name + "_warn", tags_new, pdv->GetWarn(), ts);
-		if (!pdv->GetMin().IsEmpty())
-			AddMetric(checkable, metric_name + "_min", tags_new, pdv->GetMin(), ts);
-		if (!pdv->GetMax().IsEmpty())
-			AddMetric(checkable, metric_name + "_max", tags_new, pdv->GetMax(), ts);
+		if (Value crit = metrics->GetCrit(i); !crit.IsEmpty())
+			AddMetric(checkable, metric_name + "_crit", tags_new, crit, ts);
+		if (Value warn = metrics->GetWarn(i); !warn.IsEmpty())
+			AddMetric(checkable, metric_name + "_warn", tags_new, warn, ts);
+		if (Value min = metrics->GetMin(i); !min.IsEmpty())
+			AddMetric(checkable, metric_name + "_min", tags_new, min, ts);
+		if (Value max = metrics->GetMax(i); !max.IsEmpty())
+			AddMetric(checkable, metric_name + "_max", tags_new, max, ts);
 	}
 }
 
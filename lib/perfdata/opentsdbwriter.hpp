@@ -39,7 +39,7 @@ private:
 	PerfdataWriterConnection::Ptr m_Connection;
 	Locked<PerfdataWriterConnection::Ptr> m_LockedConnection;
 
-	boost::signals2::connection m_HandleCheckResults;
+	SignalConnection m_HandleCheckResults;
 
 	Dictionary::Ptr m_ServiceConfigTemplate;
 	Dictionary::Ptr m_HostConfigTemplate;
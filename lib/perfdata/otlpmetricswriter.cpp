@@ -180,39 +180,33 @@ void OTLPMetricsWriter::CheckResultHandler(const Checkable::Ptr& checkable, cons
 		auto startTime = cr->GetScheduleStart();
 		auto endTime = cr->GetExecutionEnd();
 
-		Array::Ptr perfdata = cr->GetPerformanceData();
-		for (const Value& val : perfdata) {
-			PerfdataValue::Ptr pdv;
-			if (val.IsObjectType<PerfdataValue>()) {
-				pdv = val;
-			} else {
-				try {
-					pdv = PerfdataValue::Parse(val);
-				} catch (const std::exception&) {
-					Log(LogWarning, "OTLPMetricsWriter")
-						<< "Ignoring invalid perfdata for checkable '" << checkable->GetName() << "' and command '"
-						<< checkable->GetCheckCommand()->GetName() << "' with value: " << val;
-					continue;
-				}
+		auto metrics (cr->GetPerfdataMetrics());
+		for (size_t i = 0; i < metrics->GetLength(); i++) {
+			if (!metrics->IsValid(i)) {
+				Log(LogWarning, "OTLPMetricsWriter")
+					<< "Ignoring invalid perfdata for checkable '" << checkable->GetName() << "' and command '"
+					<< checkable->GetCheckCommand()->GetName() << "' with value: " << metrics->GetSource()->Get(i);
+				continue;
 			}
 
-			OTel::AttrsMap attrs{{"perfdata_label", pdv->GetLabel()}};
-			if (auto unit = pdv->GetUnit(); !unit.IsEmpty()) {
-				attrs.emplace("unit", std::move(unit));
+			String perfdataLabel (metrics->GetLabel(i).begin(), metrics->GetLabel(i).end());
+			OTel::AttrsMap attrs{{"perfdata_label", perfdataLabel}};
+			if (auto unit = metrics->GetUnit(i); !unit.empty()) {
+				attrs.emplace("unit", String(unit.begin(), unit.end()));
 			}
-			AddBytesAndFlushIfNeeded(Record(checkable, cr, l_PerfdataMetric, pdv->GetValue(), startTime, endTime, std::move(attrs)));
+			AddBytesAndFlushIfNeeded(Record(checkable, cr, l_PerfdataMetric, metrics->GetValue(i), startTime, endTime, std::move(attrs)));
 
 			if (GetEnableSendThresholds()) {
 				std::array<std::pair<String, Value>, 4> thresholds{{
-					{"critical", pdv->GetCrit()},
-					{"warning", pdv->GetWarn()},
-					{"min", pdv->GetMin()},
-					{"max", pdv->GetMax()},
+					{"critical", metrics->GetCrit(i)},
+					{"warning", metrics->GetWarn(i)},
+					{"min", metrics->GetMin(i)},
+					{"max", metrics->GetMax(i)},
 				}};
 				for (auto& [label, threshold] : thresholds) {
 					if (!threshold.IsEmpty()) {
 						attrs = {
-							{"perfdata_label", pdv->GetLabel()},
+							{"perfdata_label", perfdataLabel},
 							{"threshold_type", std::move(label)},
 						};
 						AddBytesAndFlushIfNeeded(
@@ -55,8 +55,8 @@ private:
 	// Checkables and their associated OTel ResourceMetrics that are being recorded for the current OTel message.
 	std::unordered_map<Checkable*, std::unique_ptr<opentelemetry::proto::metrics::v1::ResourceMetrics>> m_Metrics;
 
-	WorkQueue m_WorkQueue{10'000'000, 1};
-	boost::signals2::connection m_CheckResultsSlot, m_ActiveChangedSlot;
+	WorkQueue m_WorkQueue{10'000'000, 1, LogInformation, WorkQueueLockFree};
+	SignalConnection m_CheckResultsSlot, m_ActiveChangedSlot;
 	OTel::Ptr m_Exporter;
 	Timer::Ptr m_FlushTimer;
 	std::atomic_bool m_TimerFlushInProgress{false}; // Whether a timer-initiated flush is in progress.
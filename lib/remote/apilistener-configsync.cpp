@@ -414,7 +414,7 @@ void ApiListener::UpdateConfigObject(const ConfigObject::Ptr& object, const Mess
 #endif /* I2_DEBUG */
 
 	if (client)
-		client->SendMessage(message);
+		client->SendMessage(message, MessageLane::Bulk);
 	else {
 		Zone::Ptr target = static_pointer_cast<Zone>(object->GetZone());
 
@@ -516,7 +516,7 @@ void ApiListener::DeleteConfigObject(const ConfigObject::Ptr& object, const Mess
 #endif /* I2_DEBUG */
 
 	if (client)
-		client->SendMessage(message);
+		client->SendMessage(message, MessageLane::Bulk);
 	else {
 		Zone::Ptr target = static_pointer_cast<Zone>(object->GetZone());
 
@@ -581,7 +581,7 @@ void ApiListener::PruneDeletedRuntimeObjects()
 
 	for (auto it = deletedRuntimeObjects->Begin(); it != deletedRuntimeObjects->End();) {
 		if (it->second < cutoff) {
-			deletedRuntimeObjects->Remove(it++);
+			it = deletedRuntimeObjects->Remove(it);
 		} else {
 			++it;
 		}
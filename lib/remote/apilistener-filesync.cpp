@@ -224,7 +224,7 @@ void ApiListener::SendConfigUpdate(const JsonRpcConnection::Ptr& aclient)
 		}) }
 	});
 
-	aclient->SendMessage(message);
+	aclient->SendMessage(message, MessageLane::Bulk);
 }
 
 static bool CompareTimestampsConfigChange(const Dictionary::Ptr& productionConfig, const Dictionary::Ptr& receivedConfig,
@@ -14,12 +14,11 @@
 #include "base/convert.hpp"
 #include "base/defer.hpp"
 #include "base/io-engine.hpp"
-#include "base/netstring.hpp"
 #include "base/json.hpp"
 #include "base/configtype.hpp"
 #include "base/logger.hpp"
 #include "base/objectlock.hpp"
-#include "base/stdiostream.hpp"
+#include "base/stream-compression.hpp"
 #include "base/perfdatavalue.hpp"
 #include "base/application.hpp"
 #include "base/context.hpp"
@@ -32,13 +31,13 @@
 #include <boost/asio/spawn.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/date_time/posix_time/posix_time_duration.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
 #include <boost/system/error_code.hpp>
 #include <boost/thread/locks.hpp>
 #include <climits>
 #include <cstdint>
-#include <fstream>
 #include <memory>
 #include <openssl/ssl.h>
 #include <openssl/tls1.h>
@@ -1198,27 +1197,22 @@ void ApiListener::RelayMessage(const MessageOrigin::Ptr& origin,
 	m_RelayQueue.Enqueue([this, origin, secobj, message, log]() { SyncRelayMessage(origin, secobj, message, log); }, PriorityNormal, true);
 }
 
-void ApiListener::PersistMessage(const Dictionary::Ptr& message, const ConfigObject::Ptr& secobj)
+void ApiListener::PersistMessage(const Dictionary::Ptr& message, const String& encoded, const ConfigObject::Ptr& secobj)
 {
 	double ts = message->Get("ts");
 
 	ASSERT(ts != 0);
 
-	Dictionary::Ptr pmessage = new Dictionary();
-	pmessage->Set("timestamp", ts);
-
-	pmessage->Set("message", JsonEncode(message));
+	String secobjType, secobjName;
 
 	if (secobj) {
-		Dictionary::Ptr secname = new Dictionary();
-		secname->Set("type", secobj->GetReflectionType()->GetName());
-		secname->Set("name", secobj->GetName());
-		pmessage->Set("secobj", secname);
+		secobjType = secobj->GetReflectionType()->GetName();
+		secobjName = secobj->GetName();
 	}
 
 	std::unique_lock<std::mutex> lock(m_LogLock);
 	if (m_LogFile) {
-		NetString::WriteStringToStream(m_LogFile, JsonEncode(pmessage));
+		m_LogFile->Write(ts, encoded, secobjType, secobjName);
 		m_LogMessageCount++;
 		SetLogMessageTimestamp(ts);
 
@@ -1231,6 +1225,20 @@ void ApiListener::PersistMessage(const Dictionary::Ptr& message, const ConfigObj
 }
 
 void ApiListener::SyncSendMessage(const Endpoint::Ptr& endpoint, const Dictionary::Ptr& message)
+{
+	JsonRpc::EncodedMessage encoded;
+
+	SyncSendMessage(endpoint, message, encoded);
+}
+
+/**
+ * Sends a message to an endpoint, JSON-encoding it only once for all of its recipients.
+ *
+ * @param endpoint The endpoint to send the message to
+ * @param message The message, must not be modified until all recipients got it
+ * @param encoded The encodings of the message, each one is set here on first use
+ */
+void ApiListener::SyncSendMessage(const Endpoint::Ptr& endpoint, const Dictionary::Ptr& message, JsonRpc::EncodedMessage& encoded)
 {
 	ObjectLock olock(endpoint);
 
@@ -1250,7 +1258,7 @@ void ApiListener::SyncSendMessage(const Endpoint::Ptr& endpoint, const Dictionar
 				continue;
 
 			try {
-				client->SendMessage(message);
+				client->SendEncodedMessage(encoded.Get(message, client->GetBinaryMessages()));
 			} catch (const std::runtime_error& ex) {
 				Log(LogNotice, "ApiListener")
 					<< "Error while sending message to endpoint '" << endpoint->GetName() << "': " << DiagnosticInformation(ex, false);
@@ -1267,10 +1275,12 @@ void ApiListener::SyncSendMessage(const Endpoint::Ptr& endpoint, const Dictionar
  * @param origin Information about where this message is relayed from (if it was not generated locally)
  * @param message The message to relay
  * @param currentZoneMaster The current master node of the local zone
+ * @param encoded The encodings of the message, shared by all zones it's relayed to
  * @return true if the message has been relayed to all relevant endpoints,
  *         false if it hasn't and must be persisted in the replay log
  */
-bool ApiListener::RelayMessageOne(const Zone::Ptr& targetZone, const MessageOrigin::Ptr& origin, const Dictionary::Ptr& message, const Endpoint::Ptr& currentZoneMaster)
+bool ApiListener::RelayMessageOne(const Zone::Ptr& targetZone, const MessageOrigin::Ptr& origin, const Dictionary::Ptr& message,
+	const Endpoint::Ptr& currentZoneMaster, JsonRpc::EncodedMessage& encoded)
 {
 	ASSERT(targetZone);
 
@@ -1381,7 +1391,7 @@ bool ApiListener::RelayMessageOne(const Zone::Ptr& targetZone, const MessageOrig
 				}
 			}
 
-			SyncSendMessage(targetEndpoint, message);
+			SyncSendMessage(targetEndpoint, message, encoded);
 		}
 
 		if (log_needed && !log_done) {
@@ -1425,15 +1435,20 @@ void ApiListener::SyncRelayMessage(const MessageOrigin::Ptr& origin,
 
 	Endpoint::Ptr master = GetMaster();
 
-	bool need_log = !RelayMessageOne(target_zone, origin, message, master);
+	/* Encoded on first use, once per wire format, then shared by all connections and the replay log. */
+	JsonRpc::EncodedMessage encoded;
+
+	bool need_log = !RelayMessageOne(target_zone, origin, message, master, encoded);
 
 	for (const Zone::Ptr& zone : target_zone->GetAllParentsRaw()) {
-		if (!RelayMessageOne(zone, origin, message, master))
+		if (!RelayMessageOne(zone, origin, message, master, encoded))
 			need_log = true;
 	}
 
-	if (log && need_log)
-		PersistMessage(message, secobj);
+	if (log && need_log) {
+		/* The replay log stays JSON, so that it can be replayed to peers which don't read binary messages. */
+		PersistMessage(message, *encoded.Get(message, false), secobj);
+	}
 }
 
 /* must hold m_LogLock */
@@ -1443,15 +1458,19 @@ void ApiListener::OpenLogFile()
 
 	Utility::MkDirP(Utility::DirName(path), 0750);
 
-	std::unique_ptr<std::fstream> fp = std::make_unique<std::fstream>(path.CStr(), std::fstream::out | std::ofstream::app);
+	// The netstrings written by v2.16 and older can't be appended to, rotate them as they are.
+	if (Utility::PathExists(path) && !ReplayLogFile::IsReplayLog(path) && boost::filesystem::file_size(path.GetData()) > 0) {
+		RotateLogFile();
+	}
 
-	if (!fp->good()) {
+	try {
+		m_LogFile = std::make_unique<ReplayLogWriter>(path);
+	} catch (const std::exception& ex) {
 		Log(LogWarning, "ApiListener")
-			<< "Could not open spool file: " << path;
+			<< "Could not open spool file: " << path << ": " << ex.what();
 		return;
 	}
 
-	m_LogFile = new StdioStream(fp.release(), true);
 	SetLogMessageTimestamp(Utility::GetTime());
 }
 
@@ -1461,7 +1480,13 @@ void ApiListener::CloseLogFile()
 	if (!m_LogFile)
 		return;
 
-	m_LogFile->Close();
+	try {
+		m_LogFile->Seal();
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "ApiListener")
+			<< "Could not write the index of the replay log: " << ex.what();
+	}
+
 	m_LogFile.reset();
 }
 
@@ -1537,19 +1562,20 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 	}
 
 	for (;;) {
-		std::unique_lock<std::mutex> lock(m_LogLock);
-
-		CloseLogFile();
-		Defer reopenLog;
+		MessageLane lane = MessageLane::Bulk;
 
-		if (count == -1 || count > 50000) {
-			OpenLogFile();
-			lock.unlock();
-		} else {
+		if (count != -1 && count <= 50000) {
 			last_sync = true;
-			reopenLog.SetFunc([this]() { OpenLogFile(); });
+
+			/* Live events are sent again once the last pass is done and must not overtake it,
+			 * so it waits for the bulk lane to drain and is queued as events itself.
+			 */
+			client->WaitForSendQueue(MessageLane::Bulk);
+			lane = MessageLane::Events;
 		}
 
+		std::unique_lock<std::mutex> lock(m_LogLock);
+
 		count = 0;
 
 		std::vector<std::uint64_t> files;
@@ -1564,30 +1590,55 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 			}
 		}
 
-		allFiles.emplace_back(static_cast<std::uint64_t>(Utility::GetTime()) + 1, GetApiDir() + "log/current");
+		String currentPath = GetApiDir() + "log/current";
+		std::shared_ptr<const ReplayLogSegment> current;
+
+		/* The current segment is still written to, only read what has been written so far. */
+		try {
+			if (m_LogFile) {
+				current = m_LogFile->Snapshot();
+			} else if (Utility::PathExists(currentPath)) {
+				current = std::make_shared<const ReplayLogSegment>(currentPath);
+			}
+		} catch (const std::exception& ex) {
+			Log(LogWarning, "ApiListener")
+				<< "Cannot read replay log file '" << currentPath << "': " << ex.what();
+		}
+
+		if (current) {
+			allFiles.emplace_back(static_cast<std::uint64_t>(Utility::GetTime()) + 1, currentPath);
+		}
+
+		/* The last pass keeps the log locked, so that no message is persisted without being replayed. */
+		if (!last_sync) {
+			lock.unlock();
+		}
 
 		for (auto& file : allFiles) {
 			Log(LogNotice, "ApiListener")
 				<< "Replaying log: " << file.second;
 
-			auto *fp = new std::fstream(file.second.CStr(), std::fstream::in | std::fstream::binary);
-			StdioStream::Ptr logStream = new StdioStream(fp, true);
-
-			String message;
-			StreamReadContext src;
-			while (true) {
-				Dictionary::Ptr pmessage;
+			std::shared_ptr<const ReplayLogSegment> segment;
 
+			if (file.second == currentPath) {
+				segment = current;
+			} else {
 				try {
-					StreamReadStatus srs = NetString::ReadStringFromStream(logStream, &message, src);
-
-					if (srs == StatusEof)
-						break;
+					segment = ReplayLogSegment::Open(file.second);
+				} catch (const std::exception& ex) {
+					Log(LogWarning, "ApiListener")
+						<< "Cannot read replay log file '" << file.second << "': " << ex.what();
+					continue;
+				}
+			}
 
-					if (srs != StatusNewItem)
-						continue;
+			uint64_t offset = segment->Seek(peer_ts);
+			ReplayLogRecord record;
 
-					pmessage = JsonDecode(message);
+			while (true) {
+				try {
+					if (!segment->ReadNext(offset, peer_ts, record))
+						break;
 				} catch (const std::exception&) {
 					Log(LogWarning, "ApiListener")
 						<< "Unexpected end-of-file for cluster log: " << file.second;
@@ -1596,13 +1647,8 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 					break;
 				}
 
-				if (pmessage->Get("timestamp") <= peer_ts)
-					continue;
-
-				Dictionary::Ptr secname = pmessage->Get("secobj");
-
-				if (secname) {
-					ConfigObject::Ptr secobj = ConfigObject::GetObject(secname->Get("type"), secname->Get("name"));
+				if (!record.SecobjType.IsEmpty()) {
+					ConfigObject::Ptr secobj = ConfigObject::GetObject(record.SecobjType, record.SecobjName);
 
 					if (!secobj)
 						continue;
@@ -1612,7 +1658,7 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 				}
 
 				try  {
-					client->SendRawMessage(pmessage->Get("message"));
+					client->SendRawMessage(record.Message, lane);
 					count++;
 				} catch (const std::exception& ex) {
 					Log(LogWarning, "ApiListener")
@@ -1623,7 +1669,7 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 					return;
 				}
 
-				peer_ts = pmessage->Get("timestamp");
+				peer_ts = record.Timestamp;
 
 				if (file.first > logpos_ts + 10) {
 					logpos_ts = file.first;
@@ -1636,11 +1682,9 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 						}) }
 					});
 
-					client->SendMessage(lmessage);
+					client->SendRawMessage(JsonEncode(lmessage), lane);
 				}
 			}
-
-			logStream->Close();
 		}
 
 		if (count > 0) {
@@ -1861,6 +1905,34 @@ std::set<HttpServerConnection::Ptr> ApiListener::GetHttpClients() const
 	return m_HttpClients;
 }
 
+/**
+ * Picks the compression of the messages sent to a peer: the configured one if the peer can decompress it,
+ * otherwise deflate if the peer at least supports that.
+ *
+ * @param capabilities The peer's capabilities
+ */
+static CompressionAlgorithm NegotiateCompression(uint_fast64_t capabilities)
+{
+	ApiListener::Ptr listener = ApiListener::GetInstance();
+
+	if (!listener)
+		return CompressionAlgorithm::None;
+
+	auto configured (ParseCompressionAlgorithm(listener->GetCompression()));
+
+	if (configured == CompressionAlgorithm::Zstd && (capabilities & (uint_fast64_t)ApiCapabilities::ZstdCompression)
+		&& IsCompressionAvailable(CompressionAlgorithm::Zstd)) {
+		return CompressionAlgorithm::Zstd;
+	}
+
+	if (configured != CompressionAlgorithm::None && (capabilities & (uint_fast64_t)ApiCapabilities::DeflateCompression)
+		&& IsCompressionAvailable(CompressionAlgorithm::Deflate)) {
+		return CompressionAlgorithm::Deflate;
+	}
+
+	return CompressionAlgorithm::None;
+}
+
 static void LogAppVersion(unsigned long version, Log& log)
 {
 	log << version / 100u << "." << version % 100u << ".x";
@@ -1880,6 +1952,12 @@ Value ApiListener::HelloAPIHandler(const MessageOrigin::Ptr& origin, const Dicti
 				endpoint->SetIcingaVersion(nodeVersion);
 				endpoint->SetCapabilities((double)params->Get("capabilities"));
 
+				if (endpoint->GetCapabilities() & (uint_fast64_t)ApiCapabilities::BinaryMessages) {
+					client->EnableBinaryMessages();
+				}
+
+				client->EnableCompression(NegotiateCompression(endpoint->GetCapabilities()));
+
 				if (endpoint->GetZone() == Zone::GetLocalZone()) {
 					UpdateObjectAuthority();
 				}
@@ -2014,6 +2092,39 @@ void ApiListener::ValidateTlsHandshakeTimeout(const Lazy<double>& lvalue, const
 		BOOST_THROW_EXCEPTION(ValidationError(this, { "tls_handshake_timeout" }, "Value must be greater than 0."));
 }
 
+void ApiListener::ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<ApiListener>::ValidateCompression(lvalue, utils);
+
+	try {
+		if (!IsCompressionAvailable(ParseCompressionAlgorithm(lvalue()))) {
+			BOOST_THROW_EXCEPTION(ValidationError(this, { "compression" }, "Compression algorithm '" + lvalue() + "' is not supported by this build."));
+		}
+	} catch (const std::invalid_argument& ex) {
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "compression" }, ex.what()));
+	}
+}
+
+void ApiListener::ValidateSendQueueSize(const Lazy<int>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<ApiListener>::ValidateSendQueueSize(lvalue, utils);
+
+	if (lvalue() <= 0) {
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "send_queue_size" }, "Must be greater than 0."));
+	}
+}
+
+void ApiListener::ValidateSendQueuePolicy(const Lazy<String>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<ApiListener>::ValidateSendQueuePolicy(lvalue, utils);
+
+	try {
+		ParseSendQueuePolicy(lvalue());
+	} catch (const std::invalid_argument& ex) {
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "send_queue_policy" }, ex.what()));
+	}
+}
+
 void ApiListener::ValidateHttpResponseHeaders(const Lazy<Dictionary::Ptr>& lvalue, const ValidationUtils& utils)
 {
 	ObjectImpl::ValidateHttpResponseHeaders(lvalue, utils);
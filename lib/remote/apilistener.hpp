@@ -5,10 +5,12 @@
 #define APILISTENER_H
 
 #include "remote/apilistener-ti.hpp"
+#include "remote/jsonrpc.hpp"
 #include "remote/jsonrpcconnection.hpp"
 #include "remote/httpserverconnection.hpp"
 #include "remote/endpoint.hpp"
 #include "remote/messageorigin.hpp"
+#include "remote/replaylog.hpp"
 #include "base/atomic.hpp"
 #include "base/configobject.hpp"
 #include "base/process.hpp"
@@ -73,8 +75,17 @@ enum class ApiCapabilities : uint_fast64_t
 	ExecuteArbitraryCommand = 1u << 0u,
 	IfwApiCheckCommand = 1u << 1u,
 	HostChildrenInheritObjectAuthority = 1u << 2u,
-
-	MyCapabilities = ExecuteArbitraryCommand | IfwApiCheckCommand | HostChildrenInheritObjectAuthority
+	BinaryMessages = 1u << 3u,
+	DeflateCompression = 1u << 4u,
+	ZstdCompression = 1u << 5u,
+
+	MyCapabilities = ExecuteArbitraryCommand | IfwApiCheckCommand | HostChildrenInheritObjectAuthority | BinaryMessages
+#ifdef HAVE_ZLIB
+		| DeflateCompression
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+		| ZstdCompression
+#endif /* HAVE_ZSTD */
 };
 
 /**
@@ -171,6 +182,9 @@ public:
 protected:
 	void ValidateTlsProtocolmin(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
 	void ValidateTlsHandshakeTimeout(const Lazy<double>& lvalue, const ValidationUtils& utils) override;
+	void ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
+	void ValidateSendQueueSize(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
+	void ValidateSendQueuePolicy(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
 	void ValidateHttpResponseHeaders(const Lazy<Dictionary::Ptr>& lvalue, const ValidationUtils& utils) override;
 
 private:
@@ -223,16 +237,18 @@ private:
 	);
 	void ListenerCoroutineProc(boost::asio::yield_context yc, const Shared<boost::asio::ip::tcp::acceptor>::Ptr& server);
 
-	WorkQueue m_RelayQueue;
+	WorkQueue m_RelayQueue{0, 1, LogInformation, WorkQueueLockFree};
 	WorkQueue m_SyncQueue{0, 4};
 
 	std::mutex m_LogLock;
-	Stream::Ptr m_LogFile;
+	std::unique_ptr<ReplayLogWriter> m_LogFile;
 	size_t m_LogMessageCount{0};
 
-	bool RelayMessageOne(const Zone::Ptr& zone, const MessageOrigin::Ptr& origin, const Dictionary::Ptr& message, const Endpoint::Ptr& currentZoneMaster);
+	void SyncSendMessage(const Endpoint::Ptr& endpoint, const Dictionary::Ptr& message, JsonRpc::EncodedMessage& encoded);
+	bool RelayMessageOne(const Zone::Ptr& zone, const MessageOrigin::Ptr& origin, const Dictionary::Ptr& message,
+		const Endpoint::Ptr& currentZoneMaster, JsonRpc::EncodedMessage& encoded);
 	void SyncRelayMessage(const MessageOrigin::Ptr& origin, const ConfigObject::Ptr& secobj, const Dictionary::Ptr& message, bool log);
-	void PersistMessage(const Dictionary::Ptr& message, const ConfigObject::Ptr& secobj);
+	void PersistMessage(const Dictionary::Ptr& message, const String& encoded, const ConfigObject::Ptr& secobj);
 
 	void OpenLogFile();
 	void RotateLogFile();
@@ -145,6 +145,39 @@ void Endpoint::AddMessageProcessed(const AtomicDuration::Clock::duration& durati
 	m_InputProcessingTime += duration;
 }
 
+/**
+ * Accounts a message sent compressed.
+ *
+ * @param bytes The size of the message
+ * @param compressedBytes The size of the message once compressed
+ * @param duration The time spent compressing it
+ */
+void Endpoint::AddMessageCompressed(size_t bytes, size_t compressedBytes, const AtomicDuration::Clock::duration& duration)
+{
+	m_CompressionBytesSent.fetch_add(bytes, std::memory_order_relaxed);
+	m_CompressedBytesSent.fetch_add(compressedBytes, std::memory_order_relaxed);
+	m_CompressionTime += duration;
+}
+
+/**
+ * Accounts a message received compressed.
+ *
+ * @param bytes The size of the restored message
+ * @param compressedBytes The size of the message as received
+ * @param duration The time spent decompressing it
+ */
+void Endpoint::AddMessageDecompressed(size_t bytes, size_t compressedBytes, const AtomicDuration::Clock::duration& duration)
+{
+	m_CompressionBytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+	m_CompressedBytesReceived.fetch_add(compressedBytes, std::memory_order_relaxed);
+	m_CompressionTime += duration;
+}
+
+void Endpoint::AddMessageShed()
+{
+	m_MessagesShed.fetch_add(1, std::memory_order_relaxed);
+}
+
 double Endpoint::GetMessagesSentPerSecond() const
 {
 	return m_MessagesSent.CalculateRate(Utility::GetTime(), 60);
@@ -183,6 +216,70 @@ double Endpoint::GetSecondsProcessingMessages() const
 	return m_InputProcessingTime;
 }
 
+/**
+ * @return Size of the messages sent compressed divided by their compressed size, 0 if none were compressed
+ */
+double Endpoint::GetCompressionRatioSent() const
+{
+	auto compressed (m_CompressedBytesSent.load(std::memory_order_relaxed));
+
+	return compressed ? double(m_CompressionBytesSent.load(std::memory_order_relaxed)) / compressed : 0;
+}
+
+/**
+ * @return Size of the messages received compressed divided by their compressed size, 0 if none were compressed
+ */
+double Endpoint::GetCompressionRatioReceived() const
+{
+	auto compressed (m_CompressedBytesReceived.load(std::memory_order_relaxed));
+
+	return compressed ? double(m_CompressionBytesReceived.load(std::memory_order_relaxed)) / compressed : 0;
+}
+
+/**
+ * @return Time spent compressing and decompressing messages
+ */
+double Endpoint::GetSecondsCompressingMessages() const
+{
+	return m_CompressionTime;
+}
+
+/**
+ * @return Messages queued for all connections, but not sent yet
+ */
+double Endpoint::GetSendQueueMessages() const
+{
+	double messages = 0;
+
+	for (auto& client : GetClients()) {
+		messages += client->GetSendQueueMessages();
+	}
+
+	return messages;
+}
+
+/**
+ * @return Size of the messages queued for all connections, but not sent yet
+ */
+double Endpoint::GetSendQueueBytes() const
+{
+	double bytes = 0;
+
+	for (auto& client : GetClients()) {
+		bytes += client->GetSendQueueBytes();
+	}
+
+	return bytes;
+}
+
+/**
+ * @return Messages dropped as the send queue was full, see ApiListener#send_queue_policy
+ */
+double Endpoint::GetMessagesShed() const
+{
+	return m_MessagesShed.load(std::memory_order_relaxed);
+}
+
 ssize_t Endpoint::GetMessageReceiveSizeLimit() const
 {
 	// Parent and sibling nodes are trusted
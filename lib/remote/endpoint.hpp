@@ -51,6 +51,9 @@ public:
 	void AddMessageReceived(int bytes);
 	void AddMessageReceived(const intrusive_ptr<ApiFunction>& method);
 	void AddMessageProcessed(const AtomicDuration::Clock::duration& duration);
+	void AddMessageCompressed(size_t bytes, size_t compressedBytes, const AtomicDuration::Clock::duration& duration);
+	void AddMessageDecompressed(size_t bytes, size_t compressedBytes, const AtomicDuration::Clock::duration& duration);
+	void AddMessageShed();
 
 	double GetMessagesSentPerSecond() const override;
 	double GetMessagesReceivedPerSecond() const override;
@@ -62,6 +65,14 @@ public:
 
 	double GetSecondsProcessingMessages() const override;
 
+	double GetCompressionRatioSent() const override;
+	double GetCompressionRatioReceived() const override;
+	double GetSecondsCompressingMessages() const override;
+
+	double GetSendQueueMessages() const override;
+	double GetSendQueueBytes() const override;
+	double GetMessagesShed() const override;
+
 	ssize_t GetMessageReceiveSizeLimit() const;
 
 protected:
@@ -79,6 +90,14 @@ private:
 	mutable RingBuffer m_BytesReceived{60};
 
 	AtomicDuration m_InputProcessingTime;
+
+	Atomic<uint_fast64_t> m_CompressionBytesSent {0};
+	Atomic<uint_fast64_t> m_CompressedBytesSent {0};
+	Atomic<uint_fast64_t> m_CompressionBytesReceived {0};
+	Atomic<uint_fast64_t> m_CompressedBytesReceived {0};
+	AtomicDuration m_CompressionTime;
+
+	Atomic<uint_fast64_t> m_MessagesShed {0};
 };
 
 }
@@ -2,8 +2,10 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "remote/jsonrpc.hpp"
+#include "remote/apilistener.hpp"
 #include "base/netstring.hpp"
 #include "base/json.hpp"
+#include "base/binary-value.hpp"
 #include "base/console.hpp"
 #include "base/scriptglobal.hpp"
 #include "base/convert.hpp"
@@ -44,8 +46,57 @@ static bool GetDebugJsonRpcCached()
 
 	return debugJsonRpc;
 }
+
+/**
+ * @return The message itself or, if it's binary, its JSON representation
+ */
+static String GetDebugString(const String& message)
+{
+	if (JsonRpc::IsCompressedMessage(message))
+		return "<compressed message of " + Convert::ToString(message.GetLength()) + " bytes>";
+
+	if (!message.IsEmpty() && message[0] == JsonRpc::BinaryMessageMarker)
+		return JsonEncode(JsonRpc::DecodeMessage(message));
+
+	return message;
+}
 #endif /* I2_DEBUG */
 
+/**
+ * Encodes a message for sending, falling back to JSON for values the binary encoding doesn't support.
+ *
+ * @param message The message
+ * @param binary Whether the peer accepts binary messages
+ *
+ * @return The encoded message
+ */
+String JsonRpc::EncodeMessage(const Dictionary::Ptr& message, bool binary)
+{
+	if (binary) {
+		std::string buffer (1, BinaryMessageMarker);
+
+		try {
+			BinaryValue::EncodeValue(buffer, message);
+			return std::move(buffer);
+		} catch (const std::invalid_argument&) {
+			/* E.g. a script object, which JsonEncode() knows how to handle. */
+		}
+	}
+
+	return JsonEncode(message);
+}
+
+const Shared<String>::ConstPtr& JsonRpc::EncodedMessage::Get(const Dictionary::Ptr& message, bool binary)
+{
+	auto& encoded (binary ? Binary : Json);
+
+	if (!encoded) {
+		encoded = Shared<String>::Make(EncodeMessage(message, binary));
+	}
+
+	return encoded;
+}
+
 /**
  * Sends a message to the connected peer and returns the bytes sent.
  *
@@ -59,7 +110,7 @@ size_t JsonRpc::SendMessage(const Shared<AsioTlsStream>::Ptr& stream, const Dict
 
 #ifdef I2_DEBUG
 	if (GetDebugJsonRpcCached())
-		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << ">> " << json << ConsoleColorTag(Console_Normal) << "\n";
+		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << ">> " << GetDebugString(json) << ConsoleColorTag(Console_Normal) << "\n";
 #endif /* I2_DEBUG */
 
 	return NetString::WriteStringToStream(stream, json);
@@ -90,7 +141,7 @@ size_t JsonRpc::SendRawMessage(const Shared<AsioTlsStream>::Ptr& stream, const S
 {
 #ifdef I2_DEBUG
 	if (GetDebugJsonRpcCached())
-		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << ">> " << json << ConsoleColorTag(Console_Normal) << "\n";
+		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << ">> " << GetDebugString(json) << ConsoleColorTag(Console_Normal) << "\n";
 #endif /* I2_DEBUG */
 
 	return NetString::WriteStringToStream(stream, json, yc);
@@ -111,7 +162,7 @@ String JsonRpc::ReadMessage(const Shared<AsioTlsStream>::Ptr& stream, ssize_t ma
 
 #ifdef I2_DEBUG
 	if (GetDebugJsonRpcCached())
-		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << "<< " << jsonString << ConsoleColorTag(Console_Normal) << "\n";
+		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << "<< " << GetDebugString(jsonString) << ConsoleColorTag(Console_Normal) << "\n";
 #endif /* I2_DEBUG */
 
 	return jsonString;
@@ -132,7 +183,7 @@ String JsonRpc::ReadMessage(const Shared<AsioTlsStream>::Ptr& stream, boost::asi
 
 #ifdef I2_DEBUG
 	if (GetDebugJsonRpcCached())
-		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << "<< " << jsonString << ConsoleColorTag(Console_Normal) << "\n";
+		std::cerr << ConsoleColorTag(Console_ForegroundBlue) << "<< " << GetDebugString(jsonString) << ConsoleColorTag(Console_Normal) << "\n";
 #endif /* I2_DEBUG */
 
 	return jsonString;
@@ -141,7 +192,7 @@ String JsonRpc::ReadMessage(const Shared<AsioTlsStream>::Ptr& stream, boost::asi
 /**
  * Decode message, enforce a Dictionary
  *
- * @param message JSON string
+ * @param message JSON string or binary message
  *
  * @return Dictionary ptr
  */
@@ -149,7 +200,21 @@ Dictionary::Ptr JsonRpc::DecodeMessage(const String& message)
 {
 	// Use something a bit higher than the default limit to accommodate for data that was accepted by Icinga 2 elsewhere
 	// and gained some additional nesting levels when being wrapped in a JSON-RPC message.
-	Value value = JsonDecode(message, JsonDecodeDefaultDepthLimit + 8);
+	const size_t depthLimit = JsonDecodeDefaultDepthLimit + 8;
+	Value value;
+
+	if (!message.IsEmpty() && message[0] == BinaryMessageMarker) {
+		const char *pos = message.CStr() + 1;
+		const char *end = message.CStr() + message.GetLength();
+
+		value = BinaryValue::DecodeValue(pos, end, depthLimit);
+
+		if (pos != end) {
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Binary JSON-RPC message has trailing data."));
+		}
+	} else {
+		value = JsonDecode(message, depthLimit);
+	}
 
 	if (!value.IsObjectType<Dictionary>()) {
 		BOOST_THROW_EXCEPTION(std::invalid_argument("JSON-RPC"
@@ -158,3 +223,105 @@ Dictionary::Ptr JsonRpc::DecodeMessage(const String& message)
 
 	return value;
 }
+
+/**
+ * The preset dictionary of the compression, i.e. strings likely to occur in the first messages of a
+ * connection. Changing it breaks compatibility with older peers, so that requires new capabilities.
+ *
+ * @return The dictionary, the most frequent strings at its end
+ */
+const String& JsonRpc::GetCompressionDictionary()
+{
+	static const String dictionary (
+		"\"method\":\"config::Update\"\"method\":\"config::UpdateObject\"\"method\":\"config::DeleteObject\""
+		"\"method\":\"event::SetNextCheck\"\"method\":\"event::SetForceNextCheck\"\"method\":\"event::SetAcknowledgement\""
+		"\"method\":\"event::SendNotifications\"\"method\":\"event::NotificationSentToAllUsers\"\"method\":\"event::ExecuteCommand\""
+		"\"method\":\"event::ExecutedCommand\"\"method\":\"event::UpdateExecutions\"\"method\":\"log::SetLogPosition\""
+		"\"method\":\"event::SetLastCheckStarted\"\"method\":\"event::Heartbeat\"\"params\":{\"timeout\":120.0}"
+		"\"check_source\":\"command\":\"exit_status\":\"output\":\"performance_data\":[\"scheduling_source\":"
+		"\"schedule_start\":\"schedule_end\":\"execution_start\":\"execution_end\":\"active\":true"
+		"\"ttl\":0,\"type\":\"CheckResult\"\"vars_before\":{\"attempt\":1.0,\"reachable\":true,\"state\":0.0,\"state_type\":1.0}"
+		"\"vars_after\":{\"attempt\":1.0,\"reachable\":true,\"state\":0.0,\"state_type\":1.0}"
+		"{\"jsonrpc\":\"2.0\",\"method\":\"event::CheckResult\",\"params\":{\"cr\":{\"active\":true,\"check_source\":\""
+		"\"host\":\"\"service\":\"\"ts\":"
+	);
+
+	return dictionary;
+}
+
+/**
+ * Compresses a message as the continuation of the connection's stream.
+ *
+ * The messages compressed by one compressor have to be sent in the order they were compressed
+ * (other, uncompressed ones may be sent in between).
+ *
+ * @param compressor The compressor of the connection
+ * @param message The encoded message
+ *
+ * @return The marker of the algorithm followed by the compressed message
+ */
+String JsonRpc::CompressMessage(StreamCompressor& compressor, const String& message)
+{
+	std::string buffer (1, compressor.GetAlgorithm() == CompressionAlgorithm::Zstd ? ZstdMessageMarker : DeflateMessageMarker);
+
+	compressor.Compress(message.CStr(), message.GetLength(), buffer);
+
+	return std::move(buffer);
+}
+
+bool JsonRpc::IsCompressedMessage(const String& message)
+{
+	return !message.IsEmpty() && (message[0] == DeflateMessageMarker || message[0] == ZstdMessageMarker);
+}
+
+/**
+ * Checks whether a received message is JSON or uses an encoding this side has announced.
+ * Everything else is a protocol error.
+ *
+ * @param message The received message
+ * @param capabilities The ApiCapabilities announced to the peer, 0 if it isn't authenticated
+ *
+ * @return Whether the message may be decompressed or decoded
+ */
+bool JsonRpc::IsEncodingAccepted(const String& message, uint_fast64_t capabilities)
+{
+	if (message.IsEmpty())
+		return true;
+
+	switch (message[0]) {
+		case BinaryMessageMarker:
+			return capabilities & (uint_fast64_t)ApiCapabilities::BinaryMessages;
+		case DeflateMessageMarker:
+			return capabilities & (uint_fast64_t)ApiCapabilities::DeflateCompression;
+		case ZstdMessageMarker:
+			return capabilities & (uint_fast64_t)ApiCapabilities::ZstdCompression;
+		default:
+			return true;
+	}
+}
+
+/**
+ * Restores a message compressed by CompressMessage().
+ *
+ * @param decompressor The decompressor of the connection, created by the first compressed message
+ * @param message The compressed message
+ * @param maxSize The limit of the restored message's size
+ *
+ * @return The encoded message
+ */
+String JsonRpc::DecompressMessage(std::unique_ptr<StreamDecompressor>& decompressor, const String& message, size_t maxSize)
+{
+	auto algorithm (message[0] == ZstdMessageMarker ? CompressionAlgorithm::Zstd : CompressionAlgorithm::Deflate);
+
+	if (!decompressor) {
+		decompressor = StreamDecompressor::Create(algorithm, GetCompressionDictionary());
+	} else if (decompressor->GetAlgorithm() != algorithm) {
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Compression algorithm changed within a JSON-RPC connection."));
+	}
+
+	std::string buffer;
+
+	decompressor->Decompress(message.CStr() + 1, message.GetLength() - 1u, buffer, maxSize);
+
+	return std::move(buffer);
+}
@@ -6,8 +6,11 @@
 
 #include "base/stream.hpp"
 #include "base/dictionary.hpp"
+#include "base/shared.hpp"
+#include "base/stream-compression.hpp"
 #include "base/tlsstream.hpp"
 #include "remote/i2-remote.hpp"
+#include <cstdint>
 #include <memory>
 #include <boost/asio/spawn.hpp>
 
@@ -17,11 +20,36 @@ namespace icinga
 /**
  * A JSON-RPC connection.
  *
+ * Messages are either JSON or, if the peer announced ApiCapabilities::BinaryMessages,
+ * BinaryMessageMarker followed by the message encoded by BinaryValue. A JSON message
+ * always starts with '{', so the receiver tells them apart by their first byte.
+ *
+ * If the peer announced ApiCapabilities::DeflateCompression or ZstdCompression, either encoding may
+ * also be compressed, see CompressMessage(). Such a message starts with DeflateMessageMarker or
+ * ZstdMessageMarker. Receivers only accept these from authenticated peers, see IsEncodingAccepted().
+ *
  * @ingroup remote
  */
 class JsonRpc
 {
 public:
+	static constexpr char BinaryMessageMarker = '\x01';
+	static constexpr char DeflateMessageMarker = '\x02';
+	static constexpr char ZstdMessageMarker = '\x03';
+
+	/**
+	 * A message to be sent to several connections, encoded on first use once per format.
+	 */
+	struct EncodedMessage
+	{
+		Shared<String>::ConstPtr Json;
+		Shared<String>::ConstPtr Binary;
+
+		const Shared<String>::ConstPtr& Get(const Dictionary::Ptr& message, bool binary);
+	};
+
+	static String EncodeMessage(const Dictionary::Ptr& message, bool binary);
+
 	static size_t SendMessage(const Shared<AsioTlsStream>::Ptr& stream, const Dictionary::Ptr& message);
 	static size_t SendMessage(const Shared<AsioTlsStream>::Ptr& stream, const Dictionary::Ptr& message, boost::asio::yield_context yc);
 	static size_t SendRawMessage(const Shared<AsioTlsStream>::Ptr& stream, const String& json, boost::asio::yield_context yc);
@@ -31,6 +59,12 @@ public:
 
 	static Dictionary::Ptr DecodeMessage(const String& message);
 
+	static const String& GetCompressionDictionary();
+	static String CompressMessage(StreamCompressor& compressor, const String& message);
+	static bool IsCompressedMessage(const String& message);
+	static bool IsEncodingAccepted(const String& message, uint_fast64_t capabilities);
+	static String DecompressMessage(std::unique_ptr<StreamDecompressor>& decompressor, const String& message, size_t maxSize);
+
 private:
 	JsonRpc();
 };
@@ -38,7 +38,7 @@ void JsonRpcConnection::HandleAndWriteHeartbeats(boost::asio::yield_context yc)
 			{ "jsonrpc", "2.0" },
 			{ "method", "event::Heartbeat" },
 			{ "params", new Dictionary() }
-		}));
+		}), MessageLane::Heartbeat);
 	}
 }
 
@@ -15,6 +15,8 @@
 #include "base/exception.hpp"
 #include "base/convert.hpp"
 #include "base/tlsstream.hpp"
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <boost/asio/io_context.hpp>
@@ -30,6 +32,20 @@ REGISTER_APIFUNCTION(SetLogPosition, log, &SetLogPositionHandler);
 
 static RingBuffer l_TaskStats (15 * 60);
 
+static size_t GetSendQueueSize()
+{
+	ApiListener::Ptr listener = ApiListener::GetInstance();
+
+	return listener ? listener->GetSendQueueSize() : 64u * 1024u * 1024u;
+}
+
+static SendQueuePolicy GetSendQueuePolicy()
+{
+	ApiListener::Ptr listener = ApiListener::GetInstance();
+
+	return listener ? ParseSendQueuePolicy(listener->GetSendQueuePolicy()) : SendQueuePolicy::Exceed;
+}
+
 JsonRpcConnection::JsonRpcConnection(const WaitGroup::Ptr& waitGroup, const String& identity, bool authenticated,
 	const Shared<AsioTlsStream>::Ptr& stream, ConnectionRole role)
 	: JsonRpcConnection(waitGroup, identity, authenticated, stream, role, IoEngine::Get().GetIoContext())
@@ -40,7 +56,9 @@ JsonRpcConnection::JsonRpcConnection(const WaitGroup::Ptr& waitGroup, const Stri
 	const Shared<AsioTlsStream>::Ptr& stream, ConnectionRole role, boost::asio::io_context& io)
 	: m_Identity(identity), m_Authenticated(authenticated), m_Stream(stream), m_Role(role),
 	m_Timestamp(Utility::GetTime()), m_Seen(Utility::GetTime()), m_IoStrand(io),
-	m_OutgoingMessagesQueued(io), m_WriterDone(io), m_ShuttingDown(false), m_WaitGroup(waitGroup),
+	m_OutgoingMessagesQueue(GetSendQueueSize(), 60s), m_OutgoingMessagesPolicy(GetSendQueuePolicy()),
+	m_OutgoingMessagesQueued(io), m_WriterDone(io), m_ShuttingDown(false), m_BinaryMessages(false),
+	m_Compression(CompressionAlgorithm::None), m_WaitGroup(waitGroup),
 	m_CheckLivenessTimer(io), m_HeartbeatTimer(io)
 {
 	if (authenticated)
@@ -69,6 +87,11 @@ void JsonRpcConnection::HandleIncomingMessages(boost::asio::yield_context yc)
 
 	m_Stream->next_layer().SetSeen(&m_Seen);
 
+	std::unique_ptr<StreamDecompressor> decompressor;
+
+	/* Connections which only exist for certificate requests never get to the binary decoder or the decompressors. */
+	uint_fast64_t capabilities = m_Authenticated ? (uint_fast64_t)ApiCapabilities::MyCapabilities : 0u;
+
 	while (!m_ShuttingDown) {
 		String jsonString;
 
@@ -90,6 +113,41 @@ void JsonRpcConnection::HandleIncomingMessages(boost::asio::yield_context yc)
 			m_Endpoint->AddMessageReceived(jsonString.GetLength());
 		}
 
+		if (!JsonRpc::IsEncodingAccepted(jsonString, capabilities)) {
+			Log(LogWarning, "JsonRpcConnection")
+				<< "Closing connection for identity '" << m_Identity << "' which sent a message in an encoding"
+				<< " that hasn't been announced to it (marker " << int((unsigned char)jsonString[0]) << ").";
+
+			break;
+		}
+
+		if (JsonRpc::IsCompressedMessage(jsonString)) {
+			// Unlike a broken JSON message, a broken compressed one can't be skipped as it
+			// leaves the decompressor in an unknown state for the following messages.
+			try {
+				ssize_t limit = m_Endpoint ? m_Endpoint->GetMessageReceiveSizeLimit() : 1024L * 1024;
+				size_t compressedLength = jsonString.GetLength();
+				auto start (ch::steady_clock::now());
+
+				jsonString = JsonRpc::DecompressMessage(decompressor, jsonString, limit < 0 ? SIZE_MAX : size_t(limit));
+
+				if (m_Endpoint) {
+					m_Endpoint->AddMessageDecompressed(jsonString.GetLength(), compressedLength, ch::steady_clock::now() - start);
+				}
+
+				/* Compressed messages contain JSON or binary messages, but no compressed ones. */
+				if (!JsonRpc::IsEncodingAccepted(jsonString, capabilities & (uint_fast64_t)ApiCapabilities::BinaryMessages)) {
+					BOOST_THROW_EXCEPTION(std::invalid_argument("Compressed message contains a message in an unknown encoding."));
+				}
+			} catch (const std::exception& ex) {
+				Log(m_ShuttingDown ? LogDebug : LogWarning, "JsonRpcConnection")
+					<< "Error while decompressing JSON-RPC message for identity '" << m_Identity
+					<< "': " << DiagnosticInformation(ex);
+
+				break;
+			}
+		}
+
 		String rpcMethod("UNKNOWN");
 		ch::steady_clock::duration cpuBoundDuration(0);
 		auto start (ch::steady_clock::now());
@@ -161,24 +219,38 @@ void JsonRpcConnection::HandleIncomingMessages(boost::asio::yield_context yc)
 
 void JsonRpcConnection::WriteOutgoingMessages(boost::asio::yield_context yc)
 {
+	namespace ch = std::chrono;
+
 	Defer signalWriterDone ([this]() { m_WriterDone.Set(); });
 
+	std::unique_ptr<StreamCompressor> compressor;
+
 	do {
 		m_OutgoingMessagesQueued.Wait(yc);
-
-		auto queue (std::move(m_OutgoingMessagesQueue));
-
-		m_OutgoingMessagesQueue.clear();
 		m_OutgoingMessagesQueued.Clear();
 
-		if (!queue.empty()) {
+		// Messages queued while one is being written are picked up right away, by priority.
+		if (auto message (m_OutgoingMessagesQueue.Pop()); message) {
 			try {
-				for (auto& message : queue) {
-					if (m_ShuttingDown) {
-						break;
-					}
+				for (; message && !m_ShuttingDown; message = m_OutgoingMessagesQueue.Pop()) {
+					size_t bytesSent;
+
+					if (auto compression (m_Compression.load()); compression != CompressionAlgorithm::None) {
+						if (!compressor) {
+							compressor = StreamCompressor::Create(compression, JsonRpc::GetCompressionDictionary());
+						}
 
-					size_t bytesSent = JsonRpc::SendRawMessage(m_Stream, message, yc);
+						auto start (ch::steady_clock::now());
+						String compressed = JsonRpc::CompressMessage(*compressor, *message);
+
+						if (m_Endpoint) {
+							m_Endpoint->AddMessageCompressed(message->GetLength(), compressed.GetLength(), ch::steady_clock::now() - start);
+						}
+
+						bytesSent = JsonRpc::SendRawMessage(m_Stream, compressed, yc);
+					} else {
+						bytesSent = JsonRpc::SendRawMessage(m_Stream, *message, yc);
+					}
 
 					if (m_Endpoint) {
 						m_Endpoint->AddMessageSent(bytesSent);
@@ -229,43 +301,142 @@ ConnectionRole JsonRpcConnection::GetRole() const
 	return m_Role;
 }
 
-void JsonRpcConnection::SendMessage(const Dictionary::Ptr& message)
+/**
+ * Switches the messages sent from now on to the binary encoding, once the peer announced it can read it.
+ * Incoming messages may be in either encoding anyway.
+ */
+void JsonRpcConnection::EnableBinaryMessages()
+{
+	m_BinaryMessages.store(true);
+}
+
+bool JsonRpcConnection::GetBinaryMessages() const
+{
+	return m_BinaryMessages.load();
+}
+
+/**
+ * Compresses the messages sent from now on, once the peer announced it can decompress them.
+ * Compressed incoming messages are decompressed anyway.
+ */
+void JsonRpcConnection::EnableCompression(CompressionAlgorithm algorithm)
+{
+	m_Compression.store(algorithm);
+}
+
+void JsonRpcConnection::SendMessage(const Dictionary::Ptr& message, MessageLane lane)
 {
 	if (m_ShuttingDown) {
 		BOOST_THROW_EXCEPTION(std::runtime_error("Cannot send message to already disconnected API client '" + GetIdentity() + "'!"));
 	}
 
-	Ptr keepAlive (this);
+	SendEncodedMessage(Shared<String>::Make(JsonRpc::EncodeMessage(message, m_BinaryMessages.load())), lane);
+}
 
-	boost::asio::post(m_IoStrand, [this, keepAlive, message] { SendMessageInternal(message); });
+/**
+ * Queues a message of the replay log. Unlike live events, these are never dropped. The last pass of a replay
+ * runs under the replay log's lock and queues its (at most 50000) messages as events without waiting.
+ */
+void JsonRpcConnection::SendRawMessage(const String& message, MessageLane lane)
+{
+	if (m_ShuttingDown) {
+		BOOST_THROW_EXCEPTION(std::runtime_error("Cannot send message to already disconnected API client '" + GetIdentity() + "'!"));
+	}
+
+	SendQueuePolicy policy = lane == MessageLane::Bulk && !IoEngine::IsRunningOnIoThread() ? SendQueuePolicy::Block : SendQueuePolicy::Exceed;
+
+	if (QueueMessage(Shared<String>::Make(message), lane, policy) == SendQueue::Closed) {
+		BOOST_THROW_EXCEPTION(std::runtime_error("Cannot send message to already disconnected API client '" + GetIdentity() + "'!"));
+	}
 }
 
-void JsonRpcConnection::SendRawMessage(const String& message)
+/**
+ * Queues an already JSON-encoded message. The buffer isn't copied, so one encoding
+ * can be shared by all connections a message is relayed to.
+ *
+ * Events are relayed to all endpoints by one thread and sent by the checker threads, so they never wait
+ * for a full lane. They exceed its limit or are dropped, as the ApiListener's send_queue_policy says.
+ * Bulk data waits until the peer has caught up, except on I/O threads, but at most 60 seconds before the peer is disconnected.
+ *
+ * @param message The encoded message, must not be modified anymore.
+ */
+void JsonRpcConnection::SendEncodedMessage(const Shared<String>::ConstPtr& message, MessageLane lane)
 {
 	if (m_ShuttingDown) {
 		BOOST_THROW_EXCEPTION(std::runtime_error("Cannot send message to already disconnected API client '" + GetIdentity() + "'!"));
 	}
 
-	Ptr keepAlive (this);
+	SendQueuePolicy policy = lane == MessageLane::Events ? m_OutgoingMessagesPolicy : SendQueuePolicy::Block;
 
-	boost::asio::post(m_IoStrand, [this, keepAlive, message] {
-		if (m_ShuttingDown) {
-			return;
-		}
+	if (policy == SendQueuePolicy::Block && IoEngine::IsRunningOnIoThread()) {
+		policy = SendQueuePolicy::Exceed;
+	}
 
-		m_OutgoingMessagesQueue.emplace_back(message);
-		m_OutgoingMessagesQueued.Set();
-	});
+	if (QueueMessage(message, lane, policy) == SendQueue::Closed) {
+		BOOST_THROW_EXCEPTION(std::runtime_error("Cannot send message to already disconnected API client '" + GetIdentity() + "'!"));
+	}
+}
+
+/**
+ * Waits until all messages of a lane have been sent, see SendQueue::WaitUntilEmpty().
+ * Disconnects the peer if it doesn't read them in time.
+ */
+void JsonRpcConnection::WaitForSendQueue(MessageLane lane)
+{
+	if (!m_OutgoingMessagesQueue.WaitUntilEmpty(lane)) {
+		Log(LogWarning, "JsonRpcConnection")
+			<< "Identity '" << m_Identity << "' hasn't read its queued messages in the last 60 seconds, disconnecting.";
+
+		Disconnect();
+	}
+}
+
+size_t JsonRpcConnection::GetSendQueueMessages() const
+{
+	return m_OutgoingMessagesQueue.GetMessages();
 }
 
-void JsonRpcConnection::SendMessageInternal(const Dictionary::Ptr& message)
+size_t JsonRpcConnection::GetSendQueueBytes() const
+{
+	return m_OutgoingMessagesQueue.GetBytes();
+}
+
+void JsonRpcConnection::SendMessageInternal(const Dictionary::Ptr& message, MessageLane lane)
 {
 	if (m_ShuttingDown) {
 		return;
 	}
 
-	m_OutgoingMessagesQueue.emplace_back(JsonEncode(message));
-	m_OutgoingMessagesQueued.Set();
+	QueueMessage(Shared<String>::Make(JsonRpc::EncodeMessage(message, m_BinaryMessages.load())), lane, SendQueuePolicy::Exceed);
+}
+
+SendQueue::PushResult JsonRpcConnection::QueueMessage(const Shared<String>::ConstPtr& message, MessageLane lane, SendQueuePolicy policy)
+{
+	auto result (m_OutgoingMessagesQueue.Push(lane, message, policy));
+
+	if (result == SendQueue::Queued) {
+		Ptr keepAlive (this);
+
+		boost::asio::post(m_IoStrand, [this, keepAlive] { m_OutgoingMessagesQueued.Set(); });
+	} else if (result == SendQueue::TimedOut) {
+		Log(LogWarning, "JsonRpcConnection")
+			<< "Send queue for identity '" << m_Identity << "' has been full for 60 seconds, disconnecting.";
+
+		Disconnect();
+		result = SendQueue::Closed;
+	} else if (result == SendQueue::Shed) {
+		if (m_Endpoint) {
+			m_Endpoint->AddMessageShed();
+		}
+
+		if (m_OutgoingMessagesQueue.GetMessagesShed() == 1u) {
+			Log(LogWarning, "JsonRpcConnection")
+				<< "Send queue for identity '" << m_Identity << "' is full (" << m_OutgoingMessagesQueue.GetLimit()
+				<< " bytes per lane), dropping messages.";
+		}
+	}
+
+	return result;
 }
 
 void JsonRpcConnection::Disconnect()
@@ -275,6 +446,8 @@ void JsonRpcConnection::Disconnect()
 	if (!m_ShuttingDown.exchange(true)) {
 		JsonRpcConnection::Ptr keepAlive (this);
 
+		m_OutgoingMessagesQueue.Close();
+
 		Log(LogNotice, "JsonRpcConnection")
 			<< "Disconnecting API client for identity '" << m_Identity << "'";
 
@@ -403,7 +576,7 @@ void JsonRpcConnection::MessageHandler(const Dictionary::Ptr& message)
 		resultMessage->Set("jsonrpc", "2.0");
 		resultMessage->Set("id", message->Get("id"));
 
-		SendMessageInternal(resultMessage);
+		SendMessageInternal(resultMessage, MessageLane::Control);
 	}
 }
 
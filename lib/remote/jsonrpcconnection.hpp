@@ -6,8 +6,11 @@
 
 #include "remote/i2-remote.hpp"
 #include "remote/endpoint.hpp"
+#include "remote/sendqueue.hpp"
 #include "base/atomic.hpp"
 #include "base/io-engine.hpp"
+#include "base/shared.hpp"
+#include "base/stream-compression.hpp"
 #include "base/tlsstream.hpp"
 #include "base/wait-group.hpp"
 #include "base/timer.hpp"
@@ -57,10 +60,19 @@ public:
 	Shared<AsioTlsStream>::Ptr GetStream() const;
 	ConnectionRole GetRole() const;
 
+	void EnableBinaryMessages();
+	bool GetBinaryMessages() const;
+	void EnableCompression(CompressionAlgorithm algorithm);
+
 	void Disconnect();
 
-	void SendMessage(const Dictionary::Ptr& request);
-	void SendRawMessage(const String& request);
+	void SendMessage(const Dictionary::Ptr& request, MessageLane lane = MessageLane::Control);
+	void SendRawMessage(const String& request, MessageLane lane = MessageLane::Bulk);
+	void SendEncodedMessage(const Shared<String>::ConstPtr& request, MessageLane lane = MessageLane::Events);
+	void WaitForSendQueue(MessageLane lane);
+
+	size_t GetSendQueueMessages() const;
+	size_t GetSendQueueBytes() const;
 
 	static Value HeartbeatAPIHandler(const intrusive_ptr<MessageOrigin>& origin, const Dictionary::Ptr& params);
 
@@ -77,10 +89,13 @@ private:
 	double m_Timestamp;
 	double m_Seen;
 	boost::asio::io_context::strand m_IoStrand;
-	std::vector<String> m_OutgoingMessagesQueue;
+	SendQueue m_OutgoingMessagesQueue;
+	SendQueuePolicy m_OutgoingMessagesPolicy;
 	AsioEvent m_OutgoingMessagesQueued;
 	AsioEvent m_WriterDone;
 	Atomic<bool> m_ShuttingDown;
+	Atomic<bool> m_BinaryMessages;
+	Atomic<CompressionAlgorithm> m_Compression;
 	WaitGroup::Ptr m_WaitGroup;
 	boost::asio::steady_timer m_CheckLivenessTimer, m_HeartbeatTimer;
 
@@ -98,7 +113,8 @@ private:
 
 	void CertificateRequestResponseHandler(const Dictionary::Ptr& message);
 
-	void SendMessageInternal(const Dictionary::Ptr& request);
+	void SendMessageInternal(const Dictionary::Ptr& request, MessageLane lane);
+	SendQueue::PushResult QueueMessage(const Shared<String>::ConstPtr& message, MessageLane lane, SendQueuePolicy policy);
 };
 
 }
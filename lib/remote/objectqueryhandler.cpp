@@ -72,6 +72,15 @@ Dictionary::Ptr ObjectQueryHandler::SerializeObjectAttrs(const Object::Ptr& obje
 	DictionaryData resultAttrs;
 	resultAttrs.reserve(fids.size());
 
+	/* A check result updates many attributes of a checkable at once, read them all from the same one.
+	 * Other objects aren't locked, a SharedObjectLock would lock them exclusively.
+	 */
+	SharedObjectLock olock (object, std::defer_lock);
+
+	if (SharedObjectLock::IsShareable(object)) {
+		olock.Lock();
+	}
+
 	for (int fid : fids) {
 		Field field = type->GetFieldInfo(fid);
 
@@ -0,0 +1,515 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "remote/replaylog.hpp"
+#include "base/binary-value.hpp"
+#include "base/dictionary.hpp"
+#include "base/exception.hpp"
+#include "base/json.hpp"
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <utility>
+
+using namespace icinga;
+
+/* Distance between two index entries, i.e. how much a replay reads at most before the first message it sends. */
+static const uint64_t l_ReplayLogIndexInterval = 64 * 1024;
+
+static void EncodeUInt64(std::string& buffer, uint64_t value)
+{
+	for (int i = 0; i < 8; i++) {
+		buffer += char((value >> (i * 8)) & 0xffu);
+	}
+}
+
+static uint64_t DecodeUInt64(const char *pos)
+{
+	uint64_t value = 0;
+
+	for (int i = 0; i < 8; i++) {
+		value |= uint64_t(static_cast<unsigned char>(pos[i])) << (i * 8);
+	}
+
+	return value;
+}
+
+static void EncodeDouble(std::string& buffer, double value)
+{
+	uint64_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	EncodeUInt64(buffer, bits);
+}
+
+static double DecodeDouble(const char *pos)
+{
+	uint64_t bits = DecodeUInt64(pos);
+	double value;
+
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+/**
+ * Whether the file starts like a replay log segment. Segments of v2.16 and older start with a digit.
+ */
+bool ReplayLogFile::IsReplayLog(const String& path)
+{
+	std::ifstream fp (path.CStr(), std::ios_base::in | std::ios_base::binary);
+	char magic[sizeof(Magic)];
+
+	return fp.read(magic, sizeof(magic)) && memcmp(magic, Magic, sizeof(magic)) == 0;
+}
+
+/**
+ * Maps a rotated segment, or returns the mapping another replay already uses.
+ */
+std::shared_ptr<const ReplayLogSegment> ReplayLogSegment::Open(const String& path)
+{
+	static std::mutex mutex;
+	static std::map<String, std::weak_ptr<const ReplayLogSegment>> segments;
+
+	auto size (boost::filesystem::file_size(path.GetData()));
+	std::unique_lock<std::mutex> lock (mutex);
+
+	for (auto it (segments.begin()); it != segments.end();) {
+		if (it->second.expired()) {
+			it = segments.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	auto& cached (segments[path]);
+	auto segment (cached.lock());
+
+	/* The file may have been replaced since, e.g. rotated again after a restart within the same second. */
+	if (!segment || segment->m_Size != size) {
+		segment = std::make_shared<const ReplayLogSegment>(path);
+		cached = segment;
+	}
+
+	return segment;
+}
+
+ReplayLogSegment::ReplayLogSegment(const String& path)
+	: m_Data(nullptr), m_Size(0), m_RecordsBegin(0), m_RecordsEnd(0), m_Legacy(true), m_NewestTimestamp(0)
+{
+	Map(path, boost::filesystem::file_size(path.GetData()));
+
+	if (!m_Legacy && !ReadIndex()) {
+		BuildIndex();
+	}
+}
+
+/**
+ * Maps the first size bytes of the current segment, with the index kept by its writer.
+ */
+ReplayLogSegment::ReplayLogSegment(const String& path, uint64_t size, std::vector<ReplayLogIndexEntry> index, double newestTimestamp)
+	: m_Data(nullptr), m_Size(0), m_RecordsBegin(0), m_RecordsEnd(0), m_Legacy(true), m_NewestTimestamp(newestTimestamp),
+	m_Index(std::move(index))
+{
+	Map(path, size);
+}
+
+void ReplayLogSegment::Map(const String& path, uint64_t size)
+{
+	m_Size = size;
+
+	if (size) {
+		m_File.open(path.GetData(), size);
+		m_Data = m_File.data();
+	}
+
+	m_Legacy = size < ReplayLogFile::HeaderSize || memcmp(m_Data, ReplayLogFile::Magic, sizeof(ReplayLogFile::Magic)) != 0;
+	m_RecordsEnd = size;
+
+	if (m_Legacy)
+		return;
+
+	uint32_t version = 0;
+
+	for (int i = 0; i < 4; i++) {
+		version |= uint32_t(static_cast<unsigned char>(m_Data[sizeof(ReplayLogFile::Magic) + i])) << (i * 8);
+	}
+
+	if (version > ReplayLogFile::Version) {
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Unsupported version " + std::to_string(version) + " of replay log '" + path + "'"));
+	}
+
+	m_RecordsBegin = ReplayLogFile::HeaderSize;
+}
+
+/**
+ * Reads the index appended by ReplayLogWriter::Seal().
+ *
+ * @returns false if the segment has no (valid) index.
+ */
+bool ReplayLogSegment::ReadIndex()
+{
+	const size_t trailerSize = 8u + sizeof(ReplayLogFile::IndexMagic);
+
+	if (m_Size < ReplayLogFile::HeaderSize + trailerSize
+		|| memcmp(m_Data + m_Size - sizeof(ReplayLogFile::IndexMagic), ReplayLogFile::IndexMagic, sizeof(ReplayLogFile::IndexMagic)) != 0) {
+		return false;
+	}
+
+	uint64_t indexBegin = DecodeUInt64(m_Data + m_Size - trailerSize);
+
+	if (indexBegin < m_RecordsBegin || indexBegin > m_Size - trailerSize)
+		return false;
+
+	const char *pos = m_Data + indexBegin;
+	const char *end = m_Data + m_Size - trailerSize;
+	std::vector<ReplayLogIndexEntry> index;
+	double newestTimestamp;
+
+	try {
+		if (BinaryValue::DecodeVarint(pos, end) != 0u || end - pos < 8)
+			return false;
+
+		newestTimestamp = DecodeDouble(pos);
+		pos += 8;
+
+		uint64_t count = BinaryValue::DecodeVarint(pos, end);
+
+		/* Every entry takes at least 9 bytes. */
+		if (count > uint64_t(end - pos) / 9u)
+			return false;
+
+		index.reserve(count);
+
+		for (uint64_t i = 0; i < count; i++) {
+			if (end - pos < 8)
+				return false;
+
+			double timestamp = DecodeDouble(pos);
+			pos += 8;
+
+			uint64_t offset = BinaryValue::DecodeVarint(pos, end);
+
+			if (offset < m_RecordsBegin || offset > indexBegin)
+				return false;
+
+			index.emplace_back(ReplayLogIndexEntry{timestamp, offset});
+		}
+	} catch (const std::invalid_argument&) {
+		return false;
+	}
+
+	if (pos != end)
+		return false;
+
+	m_Index = std::move(index);
+	m_NewestTimestamp = newestTimestamp;
+	m_RecordsEnd = indexBegin;
+
+	return true;
+}
+
+/**
+ * Indexes a segment which wasn't sealed, e.g. the current one after a crash. An incomplete last
+ * message is cut off.
+ */
+void ReplayLogSegment::BuildIndex()
+{
+	uint64_t offset = m_RecordsBegin;
+
+	m_Index.clear();
+	m_Index.emplace_back(ReplayLogIndexEntry{0, offset});
+	m_NewestTimestamp = 0;
+
+	for (;;) {
+		const char *pos = m_Data + offset;
+		const char *end = m_Data + m_RecordsEnd;
+		uint64_t length;
+
+		try {
+			length = BinaryValue::DecodeVarint(pos, end);
+		} catch (const std::invalid_argument&) {
+			break;
+		}
+
+		if (length < 8u || length > uint64_t(end - pos))
+			break;
+
+		if (offset - m_Index.back().Offset >= l_ReplayLogIndexInterval) {
+			m_Index.emplace_back(ReplayLogIndexEntry{m_NewestTimestamp, offset});
+		}
+
+		m_NewestTimestamp = std::max(m_NewestTimestamp, DecodeDouble(pos));
+		offset = pos + length - m_Data;
+	}
+
+	m_RecordsEnd = offset;
+}
+
+bool ReplayLogSegment::IsLegacy() const
+{
+	return m_Legacy;
+}
+
+/**
+ * @returns The end of the last complete message, where the index or further messages start.
+ */
+uint64_t ReplayLogSegment::GetRecordsEnd() const
+{
+	return m_RecordsEnd;
+}
+
+double ReplayLogSegment::GetNewestTimestamp() const
+{
+	return m_NewestTimestamp;
+}
+
+const std::vector<ReplayLogIndexEntry>& ReplayLogSegment::GetIndex() const
+{
+	return m_Index;
+}
+
+/**
+ * Finds where to start reading the messages newer than timestamp. All messages before that are older.
+ *
+ * @returns The offset to pass to ReadNext().
+ */
+uint64_t ReplayLogSegment::Seek(double timestamp) const
+{
+	auto next (std::upper_bound(m_Index.begin(), m_Index.end(), timestamp,
+		[](double ts, const ReplayLogIndexEntry& entry) { return ts < entry.Timestamp; }));
+
+	if (m_Legacy || next == m_Index.begin())
+		return m_RecordsBegin;
+
+	return std::prev(next)->Offset;
+}
+
+/**
+ * Reads the next message newer than after.
+ *
+ * @returns false at the end of the segment, or if the rest of it is incomplete or corrupt.
+ */
+bool ReplayLogSegment::ReadNext(uint64_t& offset, double after, ReplayLogRecord& record) const
+{
+	if (m_Legacy)
+		return ReadLegacy(offset, after, record);
+
+	for (;;) {
+		if (offset >= m_RecordsEnd)
+			return false;
+
+		const char *pos = m_Data + offset;
+		const char *end = m_Data + m_RecordsEnd;
+		uint64_t length;
+
+		try {
+			length = BinaryValue::DecodeVarint(pos, end);
+		} catch (const std::invalid_argument&) {
+			return false;
+		}
+
+		if (length < 8u || length > uint64_t(end - pos))
+			return false;
+
+		end = pos + length;
+		offset = end - m_Data;
+
+		double timestamp = DecodeDouble(pos);
+
+		if (timestamp <= after)
+			continue;
+
+		pos += 8;
+
+		try {
+			record.SecobjType = BinaryValue::DecodeString(pos, end);
+			record.SecobjName = BinaryValue::DecodeString(pos, end);
+		} catch (const std::invalid_argument&) {
+			return false;
+		}
+
+		record.Timestamp = timestamp;
+		record.Message = String(pos, end);
+
+		return true;
+	}
+}
+
+/**
+ * Reads the netstrings of v2.16 and older, each a JSON dictionary with the keys timestamp, message and secobj.
+ */
+bool ReplayLogSegment::ReadLegacy(uint64_t& offset, double after, ReplayLogRecord& record) const
+{
+	for (;;) {
+		if (offset >= m_RecordsEnd)
+			return false;
+
+		const char *begin = m_Data + offset;
+		const char *pos = begin;
+		const char *end = m_Data + m_RecordsEnd;
+		uint64_t length = 0;
+
+		while (pos < end && pos - begin < 19 && *pos >= '0' && *pos <= '9') {
+			length = length * 10u + (*pos++ - '0');
+		}
+
+		if (pos == begin || pos == end || *pos != ':')
+			return false;
+
+		pos++;
+
+		if (length >= uint64_t(end - pos) || pos[length] != ',')
+			return false;
+
+		offset = pos + length + 1 - m_Data;
+
+		Dictionary::Ptr pmessage;
+
+		try {
+			pmessage = JsonDecode(String(pos, pos + length));
+		} catch (const std::exception&) {
+			return false;
+		}
+
+		if (!pmessage)
+			return false;
+
+		double timestamp = pmessage->Get("timestamp");
+
+		if (timestamp <= after)
+			continue;
+
+		Dictionary::Ptr secname = pmessage->Get("secobj");
+
+		record.Timestamp = timestamp;
+		record.Message = pmessage->Get("message");
+
+		if (secname) {
+			record.SecobjType = secname->Get("type");
+			record.SecobjName = secname->Get("name");
+		} else {
+			record.SecobjType = String();
+			record.SecobjName = String();
+		}
+
+		return true;
+	}
+}
+
+/**
+ * Opens the current segment for appending, or creates it.
+ *
+ * The index of a segment which has been sealed and not rotated (e.g. as rotating failed) is cut off again,
+ * just like an incomplete last message after a crash.
+ */
+ReplayLogWriter::ReplayLogWriter(const String& path)
+	: m_Path(path), m_Size(0), m_NewestTimestamp(0)
+{
+	boost::system::error_code ec;
+	uint64_t size = boost::filesystem::file_size(path.GetData(), ec);
+
+	if (!ec && size) {
+		{
+			ReplayLogSegment segment (path);
+
+			if (segment.IsLegacy())
+				BOOST_THROW_EXCEPTION(std::invalid_argument("'" + path + "' is not a replay log segment"));
+
+			m_Index = segment.GetIndex();
+			m_NewestTimestamp = segment.GetNewestTimestamp();
+			m_Size = segment.GetRecordsEnd();
+		}
+
+		if (m_Size != size)
+			boost::filesystem::resize_file(path.GetData(), m_Size);
+
+		m_Stream.open(path.CStr(), std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+	} else {
+		m_Stream.open(path.CStr(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+
+		m_Frame.assign(ReplayLogFile::Magic, sizeof(ReplayLogFile::Magic));
+
+		for (int i = 0; i < 4; i++) {
+			m_Frame += char((ReplayLogFile::Version >> (i * 8)) & 0xffu);
+		}
+
+		m_Stream.write(m_Frame.data(), m_Frame.size());
+		m_Size = m_Frame.size();
+	}
+
+	if (m_Index.empty())
+		m_Index.emplace_back(ReplayLogIndexEntry{0, ReplayLogFile::HeaderSize});
+
+	if (!m_Stream)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not open replay log '" + path + "'"));
+}
+
+void ReplayLogWriter::Write(double timestamp, const String& message, const String& secobjType, const String& secobjName)
+{
+	m_Record.clear();
+	EncodeDouble(m_Record, timestamp);
+	BinaryValue::EncodeString(m_Record, secobjType);
+	BinaryValue::EncodeString(m_Record, secobjName);
+	m_Record.append(message.CStr(), message.GetLength());
+
+	m_Frame.clear();
+	BinaryValue::EncodeVarint(m_Frame, m_Record.size());
+
+	if (m_Size - m_Index.back().Offset >= l_ReplayLogIndexInterval) {
+		m_Index.emplace_back(ReplayLogIndexEntry{m_NewestTimestamp, m_Size});
+	}
+
+	m_Stream.write(m_Frame.data(), m_Frame.size());
+	m_Stream.write(m_Record.data(), m_Record.size());
+
+	if (!m_Stream)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Failed to write replay log '" + m_Path + "'"));
+
+	m_Size += m_Frame.size() + m_Record.size();
+	m_NewestTimestamp = std::max(m_NewestTimestamp, timestamp);
+}
+
+/**
+ * @returns The messages written so far. They can be read while further ones are appended.
+ */
+std::shared_ptr<const ReplayLogSegment> ReplayLogWriter::Snapshot()
+{
+	Flush();
+
+	return std::make_shared<const ReplayLogSegment>(m_Path, m_Size, m_Index, m_NewestTimestamp);
+}
+
+/**
+ * Appends the index and closes the segment before it's rotated.
+ */
+void ReplayLogWriter::Seal()
+{
+	m_Frame.clear();
+	BinaryValue::EncodeVarint(m_Frame, 0);
+	EncodeDouble(m_Frame, m_NewestTimestamp);
+	BinaryValue::EncodeVarint(m_Frame, m_Index.size());
+
+	for (auto& entry : m_Index) {
+		EncodeDouble(m_Frame, entry.Timestamp);
+		BinaryValue::EncodeVarint(m_Frame, entry.Offset);
+	}
+
+	EncodeUInt64(m_Frame, m_Size);
+	m_Frame.append(ReplayLogFile::IndexMagic, sizeof(ReplayLogFile::IndexMagic));
+
+	m_Stream.write(m_Frame.data(), m_Frame.size());
+	Flush();
+	m_Stream.close();
+}
+
+void ReplayLogWriter::Flush()
+{
+	m_Stream.flush();
+
+	if (!m_Stream)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Failed to write replay log '" + m_Path + "'"));
+}
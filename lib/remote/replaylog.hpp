@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "remote/i2-remote.hpp"
+#include "base/string.hpp"
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * A position in a replay log segment.
+ *
+ * @ingroup remote
+ */
+struct ReplayLogIndexEntry
+{
+	double Timestamp; /**< The newest timestamp of all messages before Offset. */
+	uint64_t Offset;
+};
+
+/**
+ * A message of the replay log.
+ *
+ * @ingroup remote
+ */
+struct ReplayLogRecord
+{
+	double Timestamp;
+	String SecobjType; /**< Empty if the message isn't restricted to an object. */
+	String SecobjName;
+	String Message; /**< The JSON-RPC message, JSON encoded. */
+};
+
+/**
+ * Constants of the replay log segments (api/log/current and the rotated ones named by their timestamp).
+ *
+ * Segment layout, all integers are little-endian, "varint" means LEB128:
+ *
+ *   magic "i2replay", uint32 version
+ *   per message: varint record length, double timestamp, string secobj type, string secobj name, message
+ *
+ * Strings are encoded by BinaryValue, the message takes the rest of the record. Once a segment is
+ * rotated, its sparse index is appended, so that a replay can seek to the peer's log position
+ * instead of reading all messages before it:
+ *
+ *   varint 0, double newest timestamp, varint entry count, per entry: double timestamp, varint offset
+ *   uint64 offset of the index, magic "i2rindex"
+ *
+ * An index entry is added every 64 KiB of messages. Segments of v2.16 and older are netstrings of
+ * JSON dictionaries and are still read, but not indexed.
+ *
+ * @ingroup remote
+ */
+class ReplayLogFile
+{
+public:
+	static constexpr char Magic[8] = { 'i', '2', 'r', 'e', 'p', 'l', 'a', 'y' };
+	static constexpr char IndexMagic[8] = { 'i', '2', 'r', 'i', 'n', 'd', 'e', 'x' };
+	static constexpr uint32_t Version = 1;
+	static constexpr size_t HeaderSize = sizeof(Magic) + 4u;
+
+	static bool IsReplayLog(const String& path);
+};
+
+/**
+ * A read-only mapping of a replay log segment, or of the part of the current one written so far.
+ *
+ * Rotated segments are shared by all replays which read them at the same time, see Open().
+ *
+ * @ingroup remote
+ */
+class ReplayLogSegment
+{
+public:
+	static std::shared_ptr<const ReplayLogSegment> Open(const String& path);
+
+	explicit ReplayLogSegment(const String& path);
+	ReplayLogSegment(const String& path, uint64_t size, std::vector<ReplayLogIndexEntry> index, double newestTimestamp);
+
+	ReplayLogSegment(const ReplayLogSegment&) = delete;
+	ReplayLogSegment& operator=(const ReplayLogSegment&) = delete;
+
+	bool IsLegacy() const;
+	uint64_t GetRecordsEnd() const;
+	double GetNewestTimestamp() const;
+	const std::vector<ReplayLogIndexEntry>& GetIndex() const;
+
+	uint64_t Seek(double timestamp) const;
+	bool ReadNext(uint64_t& offset, double after, ReplayLogRecord& record) const;
+
+private:
+	boost::iostreams::mapped_file_source m_File;
+	const char *m_Data;
+	uint64_t m_Size;
+	uint64_t m_RecordsBegin;
+	uint64_t m_RecordsEnd;
+	bool m_Legacy;
+	double m_NewestTimestamp;
+	std::vector<ReplayLogIndexEntry> m_Index;
+
+	void Map(const String& path, uint64_t size);
+	bool ReadIndex();
+	void BuildIndex();
+	bool ReadLegacy(uint64_t& offset, double after, ReplayLogRecord& record) const;
+};
+
+/**
+ * Appends messages to the current replay log segment and keeps its index.
+ *
+ * @ingroup remote
+ */
+class ReplayLogWriter
+{
+public:
+	explicit ReplayLogWriter(const String& path);
+
+	ReplayLogWriter(const ReplayLogWriter&) = delete;
+	ReplayLogWriter& operator=(const ReplayLogWriter&) = delete;
+
+	void Write(double timestamp, const String& message, const String& secobjType, const String& secobjName);
+	std::shared_ptr<const ReplayLogSegment> Snapshot();
+	void Seal();
+
+private:
+	String m_Path;
+	std::ofstream m_Stream;
+	std::string m_Record;
+	std::string m_Frame;
+	uint64_t m_Size;
+	double m_NewestTimestamp;
+	std::vector<ReplayLogIndexEntry> m_Index;
+
+	void Flush();
+};
+
+}
@@ -0,0 +1,188 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "remote/sendqueue.hpp"
+#include "base/exception.hpp"
+#include <stdexcept>
+
+using namespace icinga;
+
+SendQueuePolicy icinga::ParseSendQueuePolicy(const String& name)
+{
+	if (name == "queue") {
+		return SendQueuePolicy::Exceed;
+	}
+
+	if (name == "shed") {
+		return SendQueuePolicy::Shed;
+	}
+
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Unknown send queue policy '" + name + "', expected 'queue' or 'shed'."));
+}
+
+/**
+ * @param limit How many bytes the Events and Bulk lanes may hold each
+ * @param blockTimeout How long Push() and WaitUntilEmpty() wait for the writer at most, zero for no limit
+ */
+SendQueue::SendQueue(size_t limit, std::chrono::steady_clock::duration blockTimeout)
+	: m_Limit(limit), m_BlockTimeout(blockTimeout), m_Messages(0), m_Bytes(0), m_MessagesShed(0), m_Closed(false)
+{
+}
+
+/**
+ * Waits for the predicate to become true, but at most for the block timeout.
+ *
+ * @returns The predicate's last result.
+ */
+template<class Predicate>
+bool SendQueue::Wait(std::unique_lock<std::mutex>& lock, Predicate predicate)
+{
+	if (m_BlockTimeout == std::chrono::steady_clock::duration::zero()) {
+		m_CreditsReturned.wait(lock, predicate);
+		return true;
+	}
+
+	return m_CreditsReturned.wait_for(lock, m_BlockTimeout, predicate);
+}
+
+bool SendQueue::IsBounded(MessageLane lane)
+{
+	return lane == MessageLane::Events || lane == MessageLane::Bulk;
+}
+
+/**
+ * Queues a message. A message larger than the limit is queued once the lane is empty.
+ *
+ * @param policy What to do if the lane is full
+ *
+ * @returns Closed once Close() has been called, also if it's called while waiting.
+ *          TimedOut if the writer hasn't taken enough messages out of the lane within the block timeout.
+ */
+SendQueue::PushResult SendQueue::Push(MessageLane lane, const Shared<String>::ConstPtr& message, SendQueuePolicy policy)
+{
+	auto& queue (m_Lanes[size_t(lane)]);
+	size_t bytes = message->GetLength();
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	auto hasCredits ([this, &queue, bytes, lane]() {
+		return !IsBounded(lane) || queue.Messages.empty() || queue.Bytes + bytes <= m_Limit;
+	});
+
+	if (!m_Closed && !hasCredits()) {
+		switch (policy) {
+			case SendQueuePolicy::Block:
+				if (!Wait(lock, [this, &hasCredits]() { return m_Closed || hasCredits(); })) {
+					return TimedOut;
+				}
+
+				break;
+			case SendQueuePolicy::Shed:
+				m_MessagesShed++;
+				return Shed;
+			case SendQueuePolicy::Exceed:
+				break;
+		}
+	}
+
+	if (m_Closed) {
+		return Closed;
+	}
+
+	queue.Messages.emplace_back(message);
+	queue.Bytes += bytes;
+	m_Messages++;
+	m_Bytes += bytes;
+
+	return Queued;
+}
+
+/**
+ * Takes the next message out of the first non-empty lane and returns its credits.
+ *
+ * @returns nullptr if all lanes are empty.
+ */
+Shared<String>::ConstPtr SendQueue::Pop()
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	for (auto& queue : m_Lanes) {
+		if (!queue.Messages.empty()) {
+			auto message (std::move(queue.Messages.front()));
+			size_t bytes = message->GetLength();
+
+			queue.Messages.pop_front();
+			queue.Bytes -= bytes;
+			m_Messages--;
+			m_Bytes -= bytes;
+
+			lock.unlock();
+			m_CreditsReturned.notify_all();
+
+			return message;
+		}
+	}
+
+	return nullptr;
+}
+
+/**
+ * Waits until the writer has taken all messages out of a lane, e.g. so that the messages
+ * queued after that in another lane can't overtake them.
+ *
+ * @returns false if the lane is still not empty after the block timeout.
+ */
+bool SendQueue::WaitUntilEmpty(MessageLane lane)
+{
+	auto& queue (m_Lanes[size_t(lane)]);
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return Wait(lock, [this, &queue]() { return m_Closed || queue.Messages.empty(); });
+}
+
+/**
+ * Drops all messages and wakes all producers which are waiting, e.g. on disconnect.
+ */
+void SendQueue::Close()
+{
+	{
+		std::unique_lock<std::mutex> lock (m_Mutex);
+
+		m_Closed = true;
+
+		for (auto& queue : m_Lanes) {
+			queue.Messages.clear();
+			queue.Bytes = 0;
+		}
+
+		m_Messages = 0;
+		m_Bytes = 0;
+	}
+
+	m_CreditsReturned.notify_all();
+}
+
+size_t SendQueue::GetLimit() const
+{
+	return m_Limit;
+}
+
+size_t SendQueue::GetMessages() const
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return m_Messages;
+}
+
+size_t SendQueue::GetBytes() const
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return m_Bytes;
+}
+
+uint_fast64_t SendQueue::GetMessagesShed() const
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return m_MessagesShed;
+}
@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "remote/i2-remote.hpp"
+#include "base/shared.hpp"
+#include "base/string.hpp"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace icinga
+{
+
+/**
+ * The lanes of a SendQueue, in the order they're sent.
+ *
+ * @ingroup remote
+ */
+enum class MessageLane
+{
+	Control, /**< Responses, certificate requests, periodic log positions */
+	Heartbeat,
+	Events, /**< Check results and the other live cluster events */
+	Bulk /**< Config sync and replay log, including its log positions */
+};
+
+/**
+ * What to do with a message for a full lane.
+ *
+ * @ingroup remote
+ */
+enum class SendQueuePolicy
+{
+	Block, /**< Wait until the writer has taken enough messages out of the lane, only for the sync threads. */
+	Shed, /**< Drop the message. */
+	Exceed /**< Queue it anyway, for threads which must not block (e.g. I/O threads, relaying). */
+};
+
+SendQueuePolicy ParseSendQueuePolicy(const String& name);
+
+/**
+ * The outgoing messages of a JsonRpcConnection, one FIFO per MessageLane.
+ *
+ * The Events and Bulk lanes may only hold a limited number of bytes. Producers take that many
+ * credits for each message they queue and the writer returns them as it takes the message out,
+ * so a slow peer pushes back on the sync threads instead of queueing up all of a replay log.
+ * The writer always takes the message of the first non-empty lane, so that heartbeats and
+ * check results don't wait for bulk data. Messages of different lanes may overtake each other.
+ * Producers wait at most for the block timeout, so a peer which doesn't read at all can't hold them forever.
+ *
+ * @ingroup remote
+ */
+class SendQueue
+{
+public:
+	static constexpr size_t LaneCount = 4;
+
+	enum PushResult
+	{
+		Queued,
+		Shed,
+		Closed,
+		TimedOut
+	};
+
+	explicit SendQueue(size_t limit, std::chrono::steady_clock::duration blockTimeout = std::chrono::steady_clock::duration::zero());
+
+	SendQueue(const SendQueue&) = delete;
+	SendQueue& operator=(const SendQueue&) = delete;
+
+	PushResult Push(MessageLane lane, const Shared<String>::ConstPtr& message, SendQueuePolicy policy);
+	Shared<String>::ConstPtr Pop();
+
+	bool WaitUntilEmpty(MessageLane lane);
+	void Close();
+
+	size_t GetLimit() const;
+	size_t GetMessages() const;
+	size_t GetBytes() const;
+	uint_fast64_t GetMessagesShed() const;
+
+private:
+	struct Lane
+	{
+		std::deque<Shared<String>::ConstPtr> Messages;
+		size_t Bytes = 0;
+	};
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_CreditsReturned;
+	std::array<Lane, LaneCount> m_Lanes;
+	size_t m_Limit;
+	std::chrono::steady_clock::duration m_BlockTimeout;
+	size_t m_Messages;
+	size_t m_Bytes;
+	uint_fast64_t m_MessagesShed;
+	bool m_Closed;
+
+	static bool IsBounded(MessageLane lane);
+
+	template<class Predicate>
+	bool Wait(std::unique_lock<std::mutex>& lock, Predicate predicate);
+};
+
+}
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/atom.hpp"
+#include <BoostTestTargetConfig.h>
+#include <thread>
+#include <vector>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_atom)
+
+BOOST_AUTO_TEST_CASE(equality)
+{
+	String name ("a-rather-long-host-name.example.com");
+	Atom a (name);
+	Atom b (String("a-rather-long-host-name.example.com"));
+	Atom c ("another-rather-long-host-name.example.com");
+
+	BOOST_CHECK(a == b);
+	BOOST_CHECK(a != c);
+	BOOST_CHECK_EQUAL(&a.GetString(), &b.GetString());
+	BOOST_CHECK_EQUAL(a.GetString(), name);
+	BOOST_CHECK_EQUAL(a.GetHash(), std::hash<String>()(name));
+
+	Atom d (a);
+	BOOST_CHECK(d == a);
+
+	c = std::move(d);
+	BOOST_CHECK(c == a);
+	BOOST_CHECK(d.IsEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+	Atom a;
+	Atom b ("");
+
+	BOOST_CHECK(a == b);
+	BOOST_CHECK(a.IsEmpty());
+	BOOST_CHECK_EQUAL(a.GetString(), "");
+
+	String str = a;
+	BOOST_CHECK(str.IsEmpty());
+}
+
+static double GetStat(const char *key)
+{
+	return Atom::GetStats()->Get(key);
+}
+
+BOOST_AUTO_TEST_CASE(stats)
+{
+	String name ("atom-stats-test-with-a-name-too-long-for-sso");
+	double entries = GetStat("entries");
+	double references = GetStat("references");
+	double bytesSaved = GetStat("bytes_saved");
+
+	std::vector<Atom> atoms (10, Atom(name));
+
+	BOOST_CHECK_EQUAL(GetStat("entries"), entries + 1);
+	BOOST_CHECK_EQUAL(GetStat("references"), references + 10);
+	BOOST_CHECK(GetStat("bytes_saved") >= bytesSaved + 9 * name.GetLength());
+
+	atoms.clear();
+
+	BOOST_CHECK_EQUAL(GetStat("entries"), entries);
+	BOOST_CHECK_EQUAL(GetStat("references"), references);
+}
+
+BOOST_AUTO_TEST_CASE(concurrency)
+{
+	double entries = GetStat("entries");
+	std::vector<std::thread> threads;
+
+	for (int i = 0; i < 4; i++) {
+		threads.emplace_back([]() {
+			for (int j = 0; j < 10000; j++) {
+				Atom a ("atom-concurrency-test-" + String(std::to_string(j % 10)));
+				Atom b (a);
+			}
+		});
+	}
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	/* All atoms are gone, so are their entries. */
+	BOOST_CHECK_EQUAL(GetStat("entries"), entries);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/binary-value.hpp"
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include "base/json.hpp"
+#include <BoostTestTargetConfig.h>
+#include <string>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_binary_value)
+
+BOOST_AUTO_TEST_CASE(encode_decode)
+{
+	std::string buffer;
+
+	Value values[] = {
+		Empty, true, false, 0, -1, 42, 1760000000, 1760000000.123, -0.5, "", "hello",
+		new Array({ 1, "two", new Array({ 3.5 }) }),
+		new Dictionary({ { "a", 1 }, { "b", new Dictionary({ { "c", Empty } }) } })
+	};
+
+	for (auto& value : values) {
+		BinaryValue::EncodeValue(buffer, value);
+	}
+
+	const char *pos = buffer.data();
+	const char *end = buffer.data() + buffer.size();
+
+	for (size_t i = 0; i < 10; i++) {
+		BOOST_CHECK_EQUAL(BinaryValue::DecodeValue(pos, end), values[i]);
+	}
+
+	BOOST_CHECK_EQUAL(BinaryValue::DecodeValue(pos, end).Get<String>(), "hello");
+	BOOST_CHECK_EQUAL(JsonEncode(BinaryValue::DecodeValue(pos, end)), JsonEncode(values[11]));
+
+	const char *skipped = pos;
+	BinaryValue::SkipValue(skipped, end);
+	BOOST_CHECK_EQUAL(JsonEncode(BinaryValue::DecodeValue(pos, end)), JsonEncode(values[12]));
+	BOOST_CHECK(skipped == pos);
+	BOOST_CHECK(pos == end);
+
+	pos = buffer.data();
+	end = buffer.data() + buffer.size() - 1u;
+
+	BOOST_CHECK_THROW(for (;;) BinaryValue::SkipValue(pos, end), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(depth_limit)
+{
+	std::string buffer;
+	BinaryValue::EncodeValue(buffer, new Array({ new Array({ new Dictionary({ { "a", 1 } }) }) }));
+
+	const char *pos = buffer.data();
+	BOOST_CHECK_THROW(BinaryValue::DecodeValue(pos, buffer.data() + buffer.size(), 2), std::invalid_argument);
+
+	pos = buffer.data();
+	BOOST_CHECK_THROW(BinaryValue::SkipValue(pos, buffer.data() + buffer.size(), 2), std::invalid_argument);
+
+	pos = buffer.data();
+	BOOST_CHECK_NO_THROW(BinaryValue::DecodeValue(pos, buffer.data() + buffer.size(), 3));
+	BOOST_CHECK(pos == buffer.data() + buffer.size());
+
+	pos = buffer.data();
+	BOOST_CHECK_NO_THROW(BinaryValue::SkipValue(pos, buffer.data() + buffer.size(), 3));
+	BOOST_CHECK(pos == buffer.data() + buffer.size());
+
+	/* A corrupt count must not be trusted. */
+	buffer.clear();
+	BinaryValue::EncodeValue(buffer, new Array({ 1 }));
+	buffer[1] = char(0x7f);
+
+	pos = buffer.data();
+	BOOST_CHECK_THROW(BinaryValue::SkipValue(pos, buffer.data() + buffer.size()), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
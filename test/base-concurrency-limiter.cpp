@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/concurrency-limiter.hpp"
+#include <BoostTestTargetConfig.h>
+#include <cstdint>
+
+using namespace icinga;
+
+/**
+ * Adds one sample per key, key i taking base * (i + 1) seconds, so that the keys' latencies differ a lot.
+ */
+static void AddSamples(ConcurrencyLimiter& limiter, int keys, double base)
+{
+	for (int i = 0; i < keys; i++) {
+		limiter.AddSample(reinterpret_cast<const void *>(uintptr_t(i + 1)), base * (i + 1));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(base_concurrency_limiter)
+
+BOOST_AUTO_TEST_CASE(latency)
+{
+	ConcurrencyLimiter limiter (10, 100);
+
+	BOOST_CHECK_EQUAL(limiter.GetLimit(), 100);
+
+	/* The first sample of each key is only remembered. */
+	AddSamples(limiter, 10, 1);
+	BOOST_CHECK_EQUAL(limiter.Update(100), 100);
+	BOOST_CHECK_EQUAL(limiter.GetLatencyRatio(), -1);
+
+	/* Four times slower than before, the backoff is capped at 0.5. */
+	AddSamples(limiter, 10, 4);
+	BOOST_CHECK_EQUAL(limiter.Update(100), 50);
+	BOOST_CHECK_EQUAL(limiter.GetLatencyRatio(), 4);
+
+	/* Twice as slow again. */
+	AddSamples(limiter, 10, 8);
+	BOOST_CHECK_EQUAL(limiter.Update(100), 37);
+
+	/* Staying slow isn't a reason to shrink any further. */
+	AddSamples(limiter, 10, 8);
+	BOOST_CHECK_EQUAL(limiter.Update(10), 37);
+	BOOST_CHECK_EQUAL(limiter.GetLatencyRatio(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(median)
+{
+	ConcurrencyLimiter limiter (10, 100);
+
+	AddSamples(limiter, 10, 1);
+	limiter.Update(100);
+
+	/* A few checks which got a lot slower don't matter, most of them didn't. */
+	AddSamples(limiter, 3, 100);
+	AddSamples(limiter, 10, 1);
+	BOOST_CHECK_EQUAL(limiter.Update(100), 100);
+
+	/* Mixing fast and slow checks doesn't look like overload either. */
+	limiter.AddSample(&limiter, 100);
+	limiter.AddSample(&limiter, 100);
+	AddSamples(limiter, 10, 1);
+	BOOST_CHECK_EQUAL(limiter.Update(100), 100);
+	BOOST_CHECK_EQUAL(limiter.GetLatencyRatio(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(recovery)
+{
+	ConcurrencyLimiter limiter (10, 100);
+
+	AddSamples(limiter, 10, 1);
+	limiter.Update(0);
+	AddSamples(limiter, 10, 4);
+	BOOST_CHECK_EQUAL(limiter.Update(100), 50);
+
+	/* Not grown while unused. */
+	AddSamples(limiter, 10, 4);
+	BOOST_CHECK_EQUAL(limiter.Update(10), 50);
+
+	/* Nor without samples. */
+	BOOST_CHECK_EQUAL(limiter.Update(50), 50);
+
+	AddSamples(limiter, 10, 2);
+	BOOST_CHECK_EQUAL(limiter.Update(50), 57);
+
+	for (int i = 0; i < 20; i++) {
+		AddSamples(limiter, 10, 2);
+		limiter.Update(100);
+	}
+
+	BOOST_CHECK_EQUAL(limiter.GetLimit(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(forget)
+{
+	ConcurrencyLimiter limiter (10, 100);
+
+	AddSamples(limiter, 1, 1);
+	limiter.Forget(reinterpret_cast<const void *>(uintptr_t(1)));
+
+	/* A new object at the same address isn't compared to the old one. */
+	AddSamples(limiter, 1, 100);
+	BOOST_CHECK_EQUAL(limiter.Update(100), 100);
+	BOOST_CHECK_EQUAL(limiter.GetLatencyRatio(), -1);
+}
+
+BOOST_AUTO_TEST_CASE(bounds)
+{
+	ConcurrencyLimiter limiter (0, 100);
+
+	for (int i = 0; i < 100; i++) {
+		AddSamples(limiter, 1, 1 << (i % 30));
+		limiter.Update(100);
+	}
+
+	BOOST_CHECK_EQUAL(limiter.GetLimit(), 1);
+
+	limiter.SetBounds(20, 50);
+	BOOST_CHECK_EQUAL(limiter.GetLimit(), 20);
+
+	limiter.SetBounds(20, 10);
+	BOOST_CHECK_EQUAL(limiter.GetLimit(), 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
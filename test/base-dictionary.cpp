@@ -7,6 +7,14 @@
 #include "base/string.hpp"
 #include "base/utility.hpp"
 #include <BoostTestTargetConfig.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+
+#ifdef __GLIBC__
+#	include <malloc.h>
+#endif /* __GLIBC__ */
 
 using namespace icinga;
 
@@ -198,4 +206,213 @@ BOOST_AUTO_TEST_CASE(keys_ordered)
 	BOOST_CHECK(std::is_sorted(keys.begin(), keys.end()));
 }
 
+BOOST_AUTO_TEST_CASE(duplicates)
+{
+	Dictionary::Ptr dictionary = new Dictionary({ { "b", 1 }, { "a", 2 }, { "b", 3 } });
+
+	BOOST_CHECK_EQUAL(dictionary->GetLength(), 2);
+	BOOST_CHECK(dictionary->Get("a") == 2);
+	BOOST_CHECK(dictionary->Get("b") == 1);
+	BOOST_CHECK(dictionary->GetKeys() == std::vector<String>({ "a", "b" }));
+}
+
+BOOST_AUTO_TEST_CASE(remove_iterator)
+{
+	Dictionary::Ptr dictionary = new Dictionary();
+
+	for (int i = 0; i < 10; i++) {
+		dictionary->Set(std::to_string(i), i);
+	}
+
+	{
+		ObjectLock olock(dictionary);
+
+		for (auto it = dictionary->Begin(); it != dictionary->End();) {
+			if (it->second.Get<double>() < 5)
+				it = dictionary->Remove(it);
+			else
+				++it;
+		}
+	}
+
+	BOOST_CHECK(dictionary->GetKeys() == std::vector<String>({ "5", "6", "7", "8", "9" }));
+}
+
+BOOST_AUTO_TEST_CASE(large)
+{
+	Dictionary::Ptr dictionary = new Dictionary();
+	std::map<String, int> expected;
+	std::mt19937 rng (42);
+
+	/* Well beyond IndexThreshold, in random order. */
+	for (int i = 0; i < 2000; i++) {
+		auto key (std::to_string(rng() % 1000));
+
+		dictionary->Set(key, i);
+		expected[key] = i;
+
+		if (i % 3 == 0) {
+			auto victim (std::to_string(rng() % 1000));
+
+			dictionary->Remove(victim);
+			expected.erase(victim);
+		}
+	}
+
+	BOOST_CHECK_EQUAL(dictionary->GetLength(), expected.size());
+
+	for (int i = 0; i < 1000; i++) {
+		auto key (std::to_string(i));
+		auto it (expected.find(key));
+
+		if (it == expected.end()) {
+			BOOST_CHECK(!dictionary->Contains(key));
+		} else {
+			BOOST_CHECK(dictionary->Get(key) == it->second);
+		}
+	}
+
+	std::vector<String> keys;
+
+	for (auto& kv : expected) {
+		keys.emplace_back(kv.first);
+	}
+
+	BOOST_CHECK(dictionary->GetKeys() == keys);
+}
+
+BOOST_AUTO_TEST_CASE(large_remove)
+{
+	Dictionary::Ptr dictionary = new Dictionary();
+
+	for (int i = 0; i < 500; i++) {
+		dictionary->Set(std::to_string(i), i);
+	}
+
+	/* Removing elements and inserting them in the middle again moves the following ones. */
+	{
+		ObjectLock olock (dictionary);
+
+		for (auto it (dictionary->Begin()); it != dictionary->End();) {
+			if (int(it->second) % 2) {
+				it = dictionary->Remove(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	for (int i = 1; i < 500; i += 4) {
+		dictionary->Set(std::to_string(i), i);
+	}
+
+	for (int i = 0; i < 500; i++) {
+		BOOST_CHECK_EQUAL(dictionary->Contains(std::to_string(i)), i % 2 == 0 || i % 4 == 1);
+	}
+
+	/* Shrink it below IndexThreshold. */
+	for (int i = 10; i < 500; i++) {
+		dictionary->Remove(std::to_string(i));
+	}
+
+	BOOST_CHECK_EQUAL(dictionary->GetLength(), 8u);
+
+	for (int i = 0; i < 500; i++) {
+		BOOST_CHECK(dictionary->Get(std::to_string(i)) == (i < 10 && (i % 2 == 0 || i % 4 == 1) ? Value(i) : Empty));
+	}
+}
+
+#ifdef __GLIBC__
+static size_t GetAllocatedBytes()
+{
+#	if __GLIBC__ > 2 || __GLIBC_MINOR__ >= 33
+	return mallinfo2().uordblks;
+#	else /* __GLIBC__ > 2 || __GLIBC_MINOR__ >= 33 */
+	return mallinfo().uordblks;
+#	endif /* __GLIBC__ > 2 || __GLIBC_MINOR__ >= 33 */
+}
+#endif /* __GLIBC__ */
+
+/**
+ * Compares the memory usage and lookup speed of Dictionary with std::map, which it used before,
+ * for a custom vars-like workload of many small dictionaries and for a few large ones.
+ *
+ * testbase --run_test=base_dictionary/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	for (auto shape : { std::make_pair(100000, 20), std::make_pair(10, 100000) }) {
+		int count = shape.first;
+		int size = shape.second;
+
+		std::vector<String> keys;
+
+		for (int i = 0; i < size; i++) {
+			keys.emplace_back("var_" + std::to_string(i * 7919 % size));
+		}
+
+#ifdef __GLIBC__
+		size_t before = GetAllocatedBytes();
+#endif /* __GLIBC__ */
+
+		std::vector<std::map<String, Value>> maps (count);
+
+		for (auto& map : maps) {
+			for (auto& key : keys) {
+				map.emplace(key, 42);
+			}
+		}
+
+#ifdef __GLIBC__
+		size_t mapBytes = GetAllocatedBytes() - before;
+		before = GetAllocatedBytes();
+#endif /* __GLIBC__ */
+
+		std::vector<Dictionary::Ptr> dicts;
+
+		for (int i = 0; i < count; i++) {
+			Dictionary::Ptr dict = new Dictionary();
+
+			for (auto& key : keys) {
+				dict->Set(key, 42);
+			}
+
+			dict->Freeze();
+			dicts.emplace_back(std::move(dict));
+		}
+
+#ifdef __GLIBC__
+		size_t dictBytes = GetAllocatedBytes() - before;
+
+		BOOST_TEST_MESSAGE(count << " x " << size << " elements: std::map " << mapBytes / count << " bytes, Dictionary "
+			<< dictBytes / count << " bytes per container");
+#endif /* __GLIBC__ */
+
+		const int lookups = 10000000;
+		double sum = 0;
+		auto begin (ch::steady_clock::now());
+
+		for (int i = 0; i < lookups; i++) {
+			sum += maps[i % count].find(keys[i % size])->second.Get<double>();
+		}
+
+		auto middle (ch::steady_clock::now());
+
+		for (int i = 0; i < lookups; i++) {
+			sum += dicts[i % count]->Get(keys[i % size]).Get<double>();
+		}
+
+		auto end (ch::steady_clock::now());
+
+		double mapNanos = ch::duration<double, std::nano>(middle - begin).count() / lookups;
+		double dictNanos = ch::duration<double, std::nano>(end - middle).count() / lookups;
+
+		BOOST_CHECK_EQUAL(sum, 2.0 * lookups * 42);
+		BOOST_TEST_MESSAGE(count << " x " << size << " elements: std::map " << mapNanos << "ns, Dictionary "
+			<< dictNanos << "ns per lookup");
+	}
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/object-pool.hpp"
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include <BoostTestTargetConfig.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_object_pool)
+
+BOOST_AUTO_TEST_CASE(reuse)
+{
+	Array::Ptr array = new Array({ 1, 2, 3 });
+	Array *address = array.get();
+
+	array.reset();
+
+	auto before (ObjectPool<Array>::GetStats());
+	array = new Array();
+	auto after (ObjectPool<Array>::GetStats());
+
+	BOOST_CHECK(array.get() == address);
+	BOOST_CHECK_EQUAL(after.Allocations - before.Allocations, 1);
+	BOOST_CHECK_EQUAL(after.HeapAllocations - before.HeapAllocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE(other_thread)
+{
+	Dictionary::Ptr dict = new Dictionary({ { "key", "value" } });
+
+	/* Freed on another thread, so it ends up in that thread's free list. */
+	std::thread([&dict]() {
+		dict.reset();
+
+		auto before (ObjectPool<Dictionary>::GetStats());
+		Dictionary::Ptr other = new Dictionary();
+		auto after (ObjectPool<Dictionary>::GetStats());
+
+		BOOST_CHECK_EQUAL(after.HeapAllocations - before.HeapAllocations, 0);
+	}).join();
+
+	dict = new Dictionary({ { "key", "value" } });
+	BOOST_CHECK_EQUAL(dict->Get("key"), "value");
+}
+
+/**
+ * Creates count Arrays on the calling thread and frees them on another one.
+ *
+ * @returns The counters of the calling thread for creating them.
+ */
+static ObjectPoolStats CreateAndFreeElsewhere(size_t count)
+{
+	std::vector<Array::Ptr> arrays;
+	auto before (ObjectPool<Array>::GetStats());
+
+	for (size_t i = 0; i < count; i++) {
+		arrays.emplace_back(new Array());
+	}
+
+	auto after (ObjectPool<Array>::GetStats());
+
+	std::thread([&arrays]() {
+		arrays.clear();
+	}).join();
+
+	return { after.Allocations - before.Allocations, after.HeapAllocations - before.HeapAllocations, after.BatchesTaken - before.BatchesTaken };
+}
+
+BOOST_AUTO_TEST_CASE(depot)
+{
+	using Pool = ObjectPool<Array>;
+
+	/* The other thread's free list overflows, so it gives batches to the depot, also once it exits. */
+	CreateAndFreeElsewhere(Pool::BatchSize * 4u);
+
+	auto stats (CreateAndFreeElsewhere(Pool::BatchSize * 4u));
+
+	BOOST_CHECK_EQUAL(stats.Allocations, Pool::BatchSize * 4u);
+	BOOST_CHECK(stats.BatchesTaken > 0u);
+	BOOST_CHECK(stats.HeapAllocations < Pool::BatchSize * 4u);
+}
+
+/**
+ * Measures a producer thread which allocates Dictionaries that a consumer thread frees,
+ * like the checker and the threads processing check results.
+ *
+ * testbase --run_test=base_object_pool/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	const size_t count = 2000000;
+	const size_t chunk = 1000;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::vector<std::vector<Dictionary::Ptr>> chunks;
+	bool done = false;
+
+	std::thread consumer ([&]() {
+		for (;;) {
+			std::vector<std::vector<Dictionary::Ptr>> taken;
+
+			{
+				std::unique_lock<std::mutex> lock (mutex);
+				cv.wait(lock, [&]() { return done || !chunks.empty(); });
+
+				if (chunks.empty()) {
+					return;
+				}
+
+				taken.swap(chunks);
+			}
+		}
+	});
+
+	auto before (ObjectPool<Dictionary>::GetStats());
+	auto begin (ch::steady_clock::now());
+
+	for (size_t i = 0; i < count; i += chunk) {
+		std::vector<Dictionary::Ptr> dicts;
+		dicts.reserve(chunk);
+
+		for (size_t j = 0; j < chunk; j++) {
+			dicts.emplace_back(new Dictionary());
+		}
+
+		{
+			std::unique_lock<std::mutex> lock (mutex);
+			chunks.emplace_back(std::move(dicts));
+		}
+
+		cv.notify_one();
+	}
+
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		done = true;
+	}
+
+	cv.notify_one();
+	consumer.join();
+
+	double seconds = ch::duration<double>(ch::steady_clock::now() - begin).count();
+	auto after (ObjectPool<Dictionary>::GetStats());
+
+	BOOST_TEST_MESSAGE(count / seconds << " Dictionaries per second created on one thread and freed on another, "
+		<< double(after.HeapAllocations - before.HeapAllocations) / count * 100 << "% of them from the heap, "
+		<< after.BatchesTaken - before.BatchesTaken << " batches taken from the depot");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/objectlock.hpp"
+#include <BoostTestTargetConfig.h>
+#include <thread>
+
+using namespace icinga;
+
+class SharedLockableObject : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(SharedLockableObject);
+
+protected:
+	SharedLockState *GetSharedLockState() const override
+	{
+		return &m_SharedLock;
+	}
+
+private:
+	mutable SharedLockState m_SharedLock;
+};
+
+/**
+ * Whether another thread could take an ObjectLock on the object right now.
+ */
+static bool IsLockableByOthers(const Object::Ptr& object)
+{
+	bool locked = false;
+
+	std::thread([&object, &locked]() {
+		ObjectLock lock (object, std::defer_lock);
+		locked = lock.TryLock();
+	}).join();
+
+	return locked;
+}
+
+BOOST_AUTO_TEST_SUITE(base_objectlock)
+
+BOOST_AUTO_TEST_CASE(exclusive)
+{
+	Object::Ptr object = new Object();
+
+	{
+		ObjectLock lock (object);
+		ObjectLock nested (object);
+
+		BOOST_CHECK(lock);
+		BOOST_CHECK(nested);
+		BOOST_CHECK(!IsLockableByOthers(object));
+	}
+
+	BOOST_CHECK(IsLockableByOthers(object));
+}
+
+BOOST_AUTO_TEST_CASE(shared)
+{
+	Object::Ptr object = new SharedLockableObject();
+	SharedObjectLock lock (object);
+	SharedObjectLock nested (object);
+	bool sharedByOthers = false;
+
+	std::thread([&object, &sharedByOthers]() {
+		SharedObjectLock lock (object);
+		sharedByOthers = lock;
+	}).join();
+
+	BOOST_CHECK(sharedByOthers);
+	BOOST_CHECK(!IsLockableByOthers(object));
+
+	nested.Unlock();
+	BOOST_CHECK(!IsLockableByOthers(object));
+
+	lock.Unlock();
+	BOOST_CHECK(IsLockableByOthers(object));
+}
+
+BOOST_AUTO_TEST_CASE(shared_within_exclusive)
+{
+	for (const Object::Ptr& object : { Object::Ptr(new Object()), Object::Ptr(new SharedLockableObject()) }) {
+		ObjectLock lock (object);
+
+		{
+			SharedObjectLock shared (object);
+			BOOST_CHECK(shared);
+		}
+
+		BOOST_CHECK(!IsLockableByOthers(object));
+
+		lock.Unlock();
+		BOOST_CHECK(IsLockableByOthers(object));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(shared_without_state)
+{
+	/* Objects without a SharedLockState don't pay for a shared mutex, so readers exclude each other. */
+	Object::Ptr object = new Object();
+	SharedObjectLock lock (object);
+	bool sharedByOthers = true;
+
+	std::thread([&object, &sharedByOthers]() {
+		ObjectLock lock (object, std::defer_lock);
+		sharedByOthers = lock.TryLock();
+	}).join();
+
+	BOOST_CHECK(!sharedByOthers);
+
+	lock.Unlock();
+	BOOST_CHECK(IsLockableByOthers(object));
+}
+
+BOOST_AUTO_TEST_CASE(shareable)
+{
+	Object::Ptr plain = new Object();
+	Object::Ptr shareable = new SharedLockableObject();
+
+	BOOST_CHECK(!SharedObjectLock::IsShareable(plain));
+	BOOST_CHECK(SharedObjectLock::IsShareable(shareable));
+
+	SharedObjectLock lock (shareable, std::defer_lock);
+	BOOST_CHECK(!lock);
+	BOOST_CHECK(IsLockableByOthers(shareable));
+
+	lock.Lock();
+	BOOST_CHECK(lock);
+	BOOST_CHECK(!IsLockableByOthers(shareable));
+}
+
+BOOST_AUTO_TEST_CASE(upgrade)
+{
+	Object::Ptr object = new SharedLockableObject();
+	SharedObjectLock shared (object);
+
+	{
+		ObjectLock tryLock (object, std::defer_lock);
+		BOOST_CHECK(!tryLock.TryLock());
+	}
+
+	{
+		ObjectLock lock (object);
+		BOOST_CHECK(!IsLockableByOthers(object));
+	}
+
+	/* The shared lock is held again. */
+	BOOST_CHECK(!IsLockableByOthers(object));
+
+	shared.Unlock();
+	BOOST_CHECK(IsLockableByOthers(object));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,271 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/process-worker.hpp"
+#include "base/convert.hpp"
+#include "base/json.hpp"
+#include <BoostTestTargetConfig.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#	include <signal.h>
+#	include <unistd.h>
+#endif /* _WIN32 */
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_process_worker)
+
+#ifndef _WIN32
+/**
+ * Collects the results of requests which are executed in parallel.
+ */
+struct ResultCollector
+{
+	std::mutex Mutex;
+	std::condition_variable CV;
+	std::vector<ProcessResult> Results;
+
+	void Run(const ProcessWorkerPool::Ptr& pool, double timeout)
+	{
+		pool->Run({ "check_dummy", "0", "OK" }, new Dictionary({ { "FOO", "bar" } }), timeout, false,
+			[this](const ProcessResult& pr) {
+				std::unique_lock<std::mutex> lock (Mutex);
+				Results.emplace_back(pr);
+				CV.notify_all();
+			});
+	}
+
+	bool WaitFor(size_t count, double timeout)
+	{
+		std::unique_lock<std::mutex> lock (Mutex);
+
+		return CV.wait_for(lock, std::chrono::duration<double>(timeout), [this, count]() { return Results.size() >= count; });
+	}
+};
+
+static ProcessResult RunWithPool(const ProcessWorkerPool::Ptr& pool, double timeout)
+{
+	ResultCollector collector;
+
+	collector.Run(pool, timeout);
+	collector.WaitFor(1, 3600);
+
+	return collector.Results.at(0);
+}
+
+static void WriteNetString(int fd, const String& message)
+{
+	String frame = Convert::ToString(message.GetLength()) + ":" + message + ",";
+
+	BOOST_REQUIRE_EQUAL(write(fd, frame.CStr(), frame.GetLength()), ssize_t(frame.GetLength()));
+}
+
+BOOST_AUTO_TEST_CASE(response)
+{
+	/* Replies once without looking at the request, that's enough for a single check. */
+	ProcessWorkerPool::Ptr pool = new ProcessWorkerPool({ "sh", "-c",
+		"printf '%s' '41:{\"exit_status\":2,\"output\":\"CRITICAL|a=1\"},'; exec sleep 10" }, 1);
+
+	pool->Start();
+
+	auto pr (RunWithPool(pool, 5));
+
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 2);
+	BOOST_CHECK_EQUAL(pr.Output, "CRITICAL|a=1");
+	BOOST_CHECK(pr.PID > 0);
+
+	pool->Stop();
+}
+
+BOOST_AUTO_TEST_CASE(timeout)
+{
+	ProcessWorkerPool::Ptr pool = new ProcessWorkerPool({ "sleep", "10" }, 1);
+
+	pool->Start();
+
+	auto pr (RunWithPool(pool, 0.5));
+
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+	BOOST_CHECK_EQUAL(pr.Output, "<Timeout exceeded.>");
+	BOOST_CHECK(pr.ExecutionEnd - pr.ExecutionStart < 5);
+
+	pool->Stop();
+}
+
+BOOST_AUTO_TEST_CASE(worker_exits)
+{
+	ProcessWorkerPool::Ptr pool = new ProcessWorkerPool({ "true" }, 1);
+
+	pool->Start();
+
+	for (int i = 0; i < 2; i++) {
+		auto pr (RunWithPool(pool, 5));
+
+		BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+		BOOST_CHECK(pr.Output.Contains("<Worker failed:"));
+	}
+
+	pool->Stop();
+}
+
+BOOST_AUTO_TEST_CASE(queued_timeout)
+{
+	ProcessWorkerPool::Ptr pool = new ProcessWorkerPool({ "sleep", "10" }, 1);
+	ResultCollector collector;
+
+	pool->Start();
+
+	/* The second request waits for the first one to time out and has no time left after that. */
+	collector.Run(pool, 1);
+	collector.Run(pool, 0.5);
+
+	BOOST_REQUIRE(collector.WaitFor(2, 5));
+
+	for (auto& pr : collector.Results) {
+		BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+		BOOST_CHECK_EQUAL(pr.Output, "<Timeout exceeded.>");
+	}
+
+	auto& queued (collector.Results.at(0).PID == -1 ? collector.Results.at(0) : collector.Results.at(1));
+
+	BOOST_CHECK_EQUAL(queued.PID, -1);
+	BOOST_CHECK(queued.ExecutionEnd - queued.ExecutionStart >= 0.5);
+
+	pool->Stop();
+}
+
+BOOST_AUTO_TEST_CASE(queue_full)
+{
+	ProcessWorkerPool::Ptr pool = new ProcessWorkerPool({ "sleep", "10" }, 1);
+	ResultCollector collector;
+	size_t count = ProcessWorkerPool::MaxQueuedPerWorker + 2;
+
+	pool->Start();
+
+	for (size_t i = 0; i < count; i++) {
+		collector.Run(pool, 60);
+	}
+
+	/* At most one request is being executed, the others don't fit into the queue. */
+	BOOST_REQUIRE(collector.WaitFor(1, 5));
+	BOOST_CHECK_EQUAL(collector.Results.at(0).Output, "<Worker pool queue full.>");
+
+	pool->Stop();
+
+	BOOST_REQUIRE(collector.WaitFor(count, 5));
+
+	size_t full = 0;
+
+	for (auto& pr : collector.Results) {
+		if (pr.Output == "<Worker pool queue full.>")
+			full++;
+		else
+			BOOST_CHECK_EQUAL(pr.Output, "<Worker pool stopped.>");
+	}
+
+	BOOST_CHECK(full >= 1 && full <= 2);
+}
+
+BOOST_AUTO_TEST_CASE(serve)
+{
+	int in[2], out[2];
+
+	BOOST_REQUIRE(pipe(in) == 0);
+	BOOST_REQUIRE(pipe(out) == 0);
+
+	WriteNetString(in[1], R"({"command":["sh","-c","printf '%s' \"$FOO\"; exit 2"],"env":{"FOO":"bar"},"timeout":5,"adjust_priority":true})");
+	WriteNetString(in[1], R"({"command":["sh","-c","echo $$; exec sleep 10"],"env":{},"timeout":0.5,"adjust_priority":false})");
+	(void)close(in[1]);
+
+	int rc = -1;
+	auto begin (std::chrono::steady_clock::now());
+	std::thread worker ([&rc, &in, &out]() { rc = ProcessWorkerPool::Serve(in[0], out[1]); });
+	worker.join();
+
+	/* The worker has killed the timed out plugin before the pool would have killed the worker. */
+	BOOST_CHECK(std::chrono::steady_clock::now() - begin
+		< std::chrono::duration<double>(0.5 + ProcessWorkerPool::GetGracePeriod(0.5)));
+
+	(void)close(in[0]);
+	(void)close(out[1]);
+
+	BOOST_CHECK_EQUAL(rc, 0);
+
+	std::string output;
+	char buffer[4096];
+	ssize_t length;
+
+	while ((length = read(out[0], buffer, sizeof(buffer))) > 0) {
+		output.append(buffer, length);
+	}
+
+	(void)close(out[0]);
+
+	String expected = R"({"exit_status":2,"output":"bar"})";
+
+	BOOST_REQUIRE_EQUAL(output.substr(0, expected.GetLength() + 4), "32:" + expected + ",");
+
+	output.erase(0, expected.GetLength() + 4);
+	output.erase(0, output.find(':') + 1);
+	output.pop_back();
+
+	Dictionary::Ptr timedOut = JsonDecode(output);
+
+	String timedOutOutput = timedOut->Get("output");
+
+	BOOST_CHECK(timedOut->Get("exit_status") == 128);
+	BOOST_CHECK(timedOutOutput.Contains("<Timeout exceeded.>"));
+
+	/* The plugin is gone, rather than left behind in its own session. */
+	pid_t plugin = std::stoi(timedOutOutput.GetData());
+
+	BOOST_CHECK(plugin > 0);
+	BOOST_CHECK(kill(plugin, 0) < 0 && errno == ESRCH);
+}
+
+BOOST_AUTO_TEST_CASE(grace_period)
+{
+	/* Responds after the timeout, like a worker which has just killed a plugin. */
+	ProcessWorkerPool::Ptr pool = new ProcessWorkerPool({ "sh", "-c",
+		"sleep 1; printf '%s' '50:{\"exit_status\":128,\"output\":\"<Timeout exceeded.>\"},'; exec sleep 10" }, 1);
+
+	pool->Start();
+
+	auto pr (RunWithPool(pool, 0.5));
+
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+	BOOST_CHECK_EQUAL(pr.Output, "<Timeout exceeded.>");
+	BOOST_CHECK(pr.PID > 0);
+
+	/* The worker has been kept, but doesn't respond again and is killed after the grace period. */
+	auto killed (RunWithPool(pool, 0.5));
+
+	BOOST_CHECK_EQUAL(killed.PID, pr.PID);
+	BOOST_CHECK_EQUAL(killed.Output, "<Timeout exceeded.>");
+	BOOST_CHECK(killed.ExecutionEnd - killed.ExecutionStart >= 0.5 + ProcessWorkerPool::GetGracePeriod(0.5) - 0.1);
+
+	pool->Stop();
+}
+
+BOOST_AUTO_TEST_CASE(stopped)
+{
+	ProcessWorkerPool::Ptr pool = new ProcessWorkerPool({ "sleep", "10" }, 1);
+
+	pool->Start();
+	pool->Stop();
+
+	auto pr (RunWithPool(pool, 5));
+
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+	BOOST_CHECK_EQUAL(pr.Output, "<Worker pool stopped.>");
+}
+#endif /* _WIN32 */
+
+BOOST_AUTO_TEST_SUITE_END()
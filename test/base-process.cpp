@@ -0,0 +1,274 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/process.hpp"
+#include "base/configuration.hpp"
+#include "base/utility.hpp"
+#include <BoostTestTargetConfig.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#	include <sys/resource.h>
+#endif /* _WIN32 */
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_process)
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(output_and_exit_status)
+{
+	Process::Ptr process = new Process({ "sh", "-c", "echo foo; echo bar >&2; exit 3" });
+	process->Run();
+
+	auto& pr (process->WaitForResult());
+
+	BOOST_CHECK_EQUAL(pr.Output, "foo\nbar\n");
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 3);
+	BOOST_CHECK_EQUAL(pr.PID, process->GetPID());
+}
+
+BOOST_AUTO_TEST_CASE(environment)
+{
+	Process::Ptr process = new Process({ "sh", "-c", "printf '%s %s' \"$FOO\" \"$LC_NUMERIC\"" }, new Dictionary({
+		{ "FOO", "bar" }
+	}));
+
+	process->Run();
+
+	BOOST_CHECK_EQUAL(process->WaitForResult().Output, "bar C");
+}
+
+BOOST_AUTO_TEST_CASE(not_found)
+{
+	Process::Ptr process = new Process({ "/nonexistent/check_foo" });
+	process->Run();
+
+	auto& pr (process->WaitForResult());
+
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+	BOOST_CHECK(pr.Output.Contains("/nonexistent/check_foo"));
+}
+
+BOOST_AUTO_TEST_CASE(timeout)
+{
+	Process::Ptr process = new Process({ "sh", "-c", "echo foo; exec sleep 10" });
+	process->SetTimeout(0.5);
+	process->Run();
+
+	auto& pr (process->WaitForResult());
+
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+	BOOST_CHECK(pr.Output.Contains("foo"));
+	BOOST_CHECK(pr.Output.Contains("<Timeout exceeded.>"));
+	BOOST_CHECK(pr.ExecutionEnd - pr.ExecutionStart < 5);
+}
+
+BOOST_AUTO_TEST_CASE(grandchild_keeps_output_open)
+{
+	/* The result must not be available before the last writer has closed the output. */
+	Process::Ptr process = new Process({ "sh", "-c", "(sleep 1; echo late) & echo early" });
+	process->Run();
+
+	auto& pr (process->WaitForResult());
+
+	BOOST_CHECK_EQUAL(pr.Output, "early\nlate\n");
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 0);
+}
+
+BOOST_AUTO_TEST_CASE(io_uring)
+{
+	/* The event engine is picked by the first Run(), so the test case runs itself again in a
+	 * process of its own. It covers io_uring if the kernel supports it. */
+	if (!getenv("ICINGA2_TEST_IO_URING")) {
+		auto& suite (boost::unit_test::framework::master_test_suite());
+
+		Process::Ptr self = new Process({ suite.argv[0], "--run_test=base_process/io_uring" }, new Dictionary({
+			{ "ICINGA2_TEST_IO_URING", "1" }
+		}));
+
+		self->SetTimeout(120);
+		self->Run();
+
+		auto& pr (self->WaitForResult());
+
+		BOOST_CHECK_MESSAGE(pr.ExitStatus == 0, pr.Output);
+		return;
+	}
+
+	Configuration::ProcessEventEngine = "io_uring";
+
+	Process::Ptr output = new Process({ "sh", "-c", "echo foo; echo bar >&2; exit 3" });
+	Process::Ptr large = new Process({ "sh", "-c", "head -c 100000 /dev/zero | tr '\\0' x" });
+	Process::Ptr grandchild = new Process({ "sh", "-c", "(sleep 1; echo late) & echo early" });
+	Process::Ptr timeout = new Process({ "sh", "-c", "echo foo; exec sleep 10" });
+
+	timeout->SetTimeout(0.5);
+
+	for (auto& process : { output, large, grandchild, timeout }) {
+		process->Run();
+	}
+
+	BOOST_CHECK_EQUAL(output->WaitForResult().Output, "foo\nbar\n");
+	BOOST_CHECK_EQUAL(output->WaitForResult().ExitStatus, 3);
+
+	BOOST_CHECK_EQUAL(large->WaitForResult().Output, String(100000, 'x'));
+	BOOST_CHECK_EQUAL(large->WaitForResult().ExitStatus, 0);
+
+	BOOST_CHECK_EQUAL(grandchild->WaitForResult().Output, "early\nlate\n");
+
+	auto& pr (timeout->WaitForResult());
+
+	BOOST_CHECK_EQUAL(pr.ExitStatus, 128);
+	BOOST_CHECK(pr.Output.Contains("<Timeout exceeded.>"));
+	BOOST_CHECK(pr.ExecutionEnd - pr.ExecutionStart < 5);
+}
+
+/**
+ * Spawns short-lived processes with a fixed number of them in flight and reports
+ * the throughput and the latency from Run() until the result callback fired.
+ *
+ * Run it with: testbase --run_test=base_process/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	const size_t total = 10000;
+	const size_t concurrency = 64;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t started = 0;
+	size_t finished = 0;
+	std::vector<double> latencies;
+
+	latencies.reserve(total);
+
+	auto begin (ch::steady_clock::now());
+
+	std::unique_lock<std::mutex> lock (mutex);
+
+	while (finished < total) {
+		while (started < total && started - finished < concurrency) {
+			auto spawned (ch::steady_clock::now());
+			Process::Ptr process = new Process({ "true" });
+
+			started++;
+			lock.unlock();
+
+			process->Run([&mutex, &cv, &finished, &latencies, spawned](const ProcessResult&) {
+				auto latency (ch::duration<double>(ch::steady_clock::now() - spawned).count());
+
+				std::unique_lock<std::mutex> lock (mutex);
+				latencies.push_back(latency);
+				finished++;
+				cv.notify_all();
+			});
+
+			lock.lock();
+		}
+
+		cv.wait(lock, [&finished, &started]() {
+			return finished == total || (started < total && started - finished < concurrency);
+		});
+	}
+
+	auto seconds (ch::duration<double>(ch::steady_clock::now() - begin).count());
+
+	BOOST_REQUIRE_EQUAL(latencies.size(), total);
+
+	std::sort(latencies.begin(), latencies.end());
+
+	BOOST_TEST_MESSAGE(total << " processes in " << seconds << "s (" << total / seconds << "/s), "
+		<< concurrency << " in flight");
+	BOOST_TEST_MESSAGE("spawn to result: p50 " << latencies[latencies.size() / 2] * 1000 << "ms, p99 "
+		<< latencies[latencies.size() * 99 / 100] * 1000 << "ms, max " << latencies.back() * 1000 << "ms");
+}
+
+/**
+ * Starts thousands of plugins at once which sleep for a second before they print their
+ * output, like the sleep check command does, and reports how late their results are
+ * available and how much CPU time collecting them took.
+ */
+static void BenchmarkSleepingPlugins(const String& engine)
+{
+	namespace ch = std::chrono;
+
+	const size_t total = 4000;
+
+	/* Every plugin needs a pipe and a pidfd. */
+	rlimit rl;
+	getrlimit(RLIMIT_NOFILE, &rl);
+	rl.rlim_cur = rl.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &rl);
+
+	Configuration::ProcessEventEngine = engine;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::vector<double> latencies;
+
+	latencies.reserve(total);
+
+	rusage before, after;
+	getrusage(RUSAGE_SELF, &before);
+
+	auto begin (ch::steady_clock::now());
+
+	for (size_t i = 0; i < total; i++) {
+		auto due (ch::steady_clock::now() + ch::seconds(1));
+		Process::Ptr process = new Process({ "sh", "-c", "sleep 1; echo 'OK - Slept for 1 second.'" });
+
+		process->Run([&mutex, &cv, &latencies, due](const ProcessResult&) {
+			auto latency (ch::duration<double>(ch::steady_clock::now() - due).count());
+
+			std::unique_lock<std::mutex> lock (mutex);
+			latencies.push_back(latency);
+			cv.notify_all();
+		});
+	}
+
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		cv.wait(lock, [&latencies, total]() { return latencies.size() == total; });
+	}
+
+	auto seconds (ch::duration<double>(ch::steady_clock::now() - begin).count());
+
+	getrusage(RUSAGE_SELF, &after);
+
+	auto cpu ([](const timeval& tv) { return tv.tv_sec + tv.tv_usec / 1e6; });
+	double cpuSeconds = cpu(after.ru_utime) - cpu(before.ru_utime) + cpu(after.ru_stime) - cpu(before.ru_stime);
+
+	Configuration::ProcessEventEngine = "";
+
+	std::sort(latencies.begin(), latencies.end());
+
+	BOOST_TEST_MESSAGE(engine << ": " << total << " sleeping plugins in " << seconds << "s, "
+		<< cpuSeconds << "s CPU time");
+	BOOST_TEST_MESSAGE("wake-up to result: p50 " << latencies[latencies.size() / 2] * 1000 << "ms, p99 "
+		<< latencies[latencies.size() * 99 / 100] * 1000 << "ms, max " << latencies.back() * 1000 << "ms");
+}
+
+/**
+ * The event engine is picked by the first Run(), so run these one at a time, e.g.:
+ * testbase --run_test=base_process/benchmark_sleep_io_uring --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark_sleep_epoll, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	BenchmarkSleepingPlugins("epoll");
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_sleep_io_uring, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	BenchmarkSleepingPlugins("io_uring");
+}
+#endif /* _WIN32 */
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/signal.hpp"
+#include "base/object.hpp"
+#include <BoostTestTargetConfig.h>
+#include <boost/signals2.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_signal)
+
+BOOST_AUTO_TEST_CASE(emit)
+{
+	Signal<void (int, const String&)> signal;
+	std::vector<int> calls;
+
+	BOOST_CHECK(signal.empty());
+	signal(1, "nobody listens");
+
+	auto first (signal.connect([&calls](int i, const String&) { calls.emplace_back(i); }));
+	auto second (signal.connect([&calls](int i, const String& str) { calls.emplace_back(i * 10 + str.GetLength()); }));
+
+	BOOST_CHECK(!signal.empty());
+	BOOST_CHECK(first.connected());
+
+	signal(2, "x");
+
+	BOOST_CHECK_EQUAL(calls.size(), 2);
+	BOOST_CHECK_EQUAL(calls[0], 2);
+	BOOST_CHECK_EQUAL(calls[1], 21);
+
+	first.disconnect();
+	BOOST_CHECK(!first.connected());
+
+	signal(3, "");
+
+	BOOST_CHECK_EQUAL(calls.size(), 3);
+	BOOST_CHECK_EQUAL(calls[2], 30);
+
+	second.disconnect();
+	BOOST_CHECK(signal.empty());
+
+	/* Disconnected slots are dropped by the next connect(). */
+	signal.connect([&calls](int i, const String&) { calls.emplace_back(-i); });
+	signal(4, "");
+
+	BOOST_CHECK_EQUAL(calls.size(), 4);
+	BOOST_CHECK_EQUAL(calls[3], -4);
+}
+
+BOOST_AUTO_TEST_CASE(connect_while_emitting)
+{
+	Signal<void ()> signal;
+	std::atomic<int> calls (0);
+	std::atomic<bool> stop (false);
+
+	signal.connect([&calls]() { calls++; });
+
+	std::thread emitter ([&signal, &stop]() {
+		while (!stop) {
+			signal();
+		}
+	});
+
+	std::vector<SignalConnection> connections;
+
+	for (int i = 0; i < 100; i++) {
+		connections.emplace_back(signal.connect([&calls]() { calls++; }));
+	}
+
+	for (auto& connection : connections) {
+		connection.disconnect();
+	}
+
+	stop = true;
+	emitter.join();
+
+	calls = 0;
+	signal();
+
+	BOOST_CHECK_EQUAL(calls, 1);
+}
+
+/**
+ * Compares the cost of emitting a signal with the one of boost::signals2, for one and for five slots.
+ *
+ * testbase --run_test=base_signal/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	const int emissions = 10000000;
+	Object::Ptr object = new Object();
+
+	for (int slots : { 1, 5 }) {
+		Signal<void (const Object::Ptr&, double)> signal;
+		boost::signals2::signal<void (const Object::Ptr&, double)> signals2;
+		double sum = 0;
+
+		for (int i = 0; i < slots; i++) {
+			signal.connect([&sum](const Object::Ptr&, double value) { sum += value; });
+			signals2.connect([&sum](const Object::Ptr&, double value) { sum += value; });
+		}
+
+		auto begin (ch::steady_clock::now());
+
+		for (int i = 0; i < emissions; i++) {
+			signal(object, 1);
+		}
+
+		auto middle (ch::steady_clock::now());
+
+		for (int i = 0; i < emissions; i++) {
+			signals2(object, 1);
+		}
+
+		auto end (ch::steady_clock::now());
+
+		double signalNanos = ch::duration<double, std::nano>(middle - begin).count() / emissions;
+		double signals2Nanos = ch::duration<double, std::nano>(end - middle).count() / emissions;
+
+		BOOST_CHECK_EQUAL(sum, 2.0 * emissions * slots);
+		BOOST_TEST_MESSAGE(slots << " slot(s): Signal " << signalNanos << "ns, boost::signals2 " << signals2Nanos << "ns per emission");
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
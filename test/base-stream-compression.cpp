@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/stream-compression.hpp"
+#include <BoostTestTargetConfig.h>
+#include <string>
+#include <vector>
+
+using namespace icinga;
+
+static void CheckRoundTrip(CompressionAlgorithm algorithm)
+{
+	String dictionary = "\"host\":\"\"service\":\"";
+	auto compressor (StreamCompressor::Create(algorithm, dictionary));
+	auto decompressor (StreamDecompressor::Create(algorithm, dictionary));
+
+	BOOST_REQUIRE(compressor);
+	BOOST_REQUIRE(decompressor);
+	BOOST_CHECK(compressor->GetAlgorithm() == algorithm);
+
+	std::vector<std::string> compressed;
+
+	for (int i = 0; i < 100; i++) {
+		std::string message = i == 3 ? "" : "{\"host\":\"host-" + std::to_string(i % 10) + ".example.com\",\"service\":\"disk\"}";
+		std::string output;
+
+		compressor->Compress(message.data(), message.size(), output);
+
+		/* Every message can be restored right away. */
+		std::string restored;
+		decompressor->Decompress(output.data(), output.size(), restored, 1024);
+		BOOST_CHECK_EQUAL(restored, message);
+
+		compressed.emplace_back(std::move(output));
+	}
+
+	/* Later messages only refer to earlier ones. */
+	BOOST_CHECK(compressed.back().size() < compressed.front().size());
+	BOOST_CHECK(compressed.back().size() < 16u);
+
+	/* Limit */
+	std::string large (100000, 'x');
+	std::string output, restored;
+
+	compressor->Compress(large.data(), large.size(), output);
+	BOOST_CHECK(output.size() < 1024u);
+	BOOST_CHECK_THROW(decompressor->Decompress(output.data(), output.size(), restored, 1024), std::invalid_argument);
+
+	/* Another stream without the preceding messages can't restore a message. */
+	auto other (StreamDecompressor::Create(algorithm));
+	restored.clear();
+	BOOST_CHECK_THROW(other->Decompress(compressed.back().data(), compressed.back().size(), restored, 1024), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE(base_stream_compression)
+
+BOOST_AUTO_TEST_CASE(parse)
+{
+	BOOST_CHECK(ParseCompressionAlgorithm("none") == CompressionAlgorithm::None);
+	BOOST_CHECK(ParseCompressionAlgorithm("deflate") == CompressionAlgorithm::Deflate);
+	BOOST_CHECK(ParseCompressionAlgorithm("zstd") == CompressionAlgorithm::Zstd);
+	BOOST_CHECK_THROW(ParseCompressionAlgorithm("gzip"), std::invalid_argument);
+
+	BOOST_CHECK(IsCompressionAvailable(CompressionAlgorithm::None));
+	BOOST_CHECK(!StreamCompressor::Create(CompressionAlgorithm::None));
+}
+
+BOOST_AUTO_TEST_CASE(deflate)
+{
+	if (!IsCompressionAvailable(CompressionAlgorithm::Deflate)) {
+		BOOST_TEST_MESSAGE("Built without zlib");
+		return;
+	}
+
+	CheckRoundTrip(CompressionAlgorithm::Deflate);
+}
+
+BOOST_AUTO_TEST_CASE(zstd)
+{
+	if (!IsCompressionAvailable(CompressionAlgorithm::Zstd)) {
+		BOOST_TEST_MESSAGE("Built without zstd");
+		return;
+	}
+
+	CheckRoundTrip(CompressionAlgorithm::Zstd);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/threadpool.hpp"
+#include <BoostTestTargetConfig.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_threadpool)
+
+BOOST_AUTO_TEST_CASE(task)
+{
+	auto counter (std::make_shared<int>(0));
+
+	ThreadPool::Task small ([counter]() { ++*counter; });
+	ThreadPool::Task moved (std::move(small));
+
+	BOOST_CHECK(!small);
+	BOOST_CHECK(moved);
+
+	moved();
+	BOOST_CHECK_EQUAL(*counter, 1);
+
+	/* Doesn't fit into the inline storage. */
+	std::array<char, ThreadPool::Task::InlineSize * 2> padding{};
+	ThreadPool::Task large ([counter, padding]() { *counter += padding.size(); });
+
+	moved = std::move(large);
+	moved();
+	BOOST_CHECK_EQUAL(*counter, 1 + static_cast<int>(padding.size()));
+
+	moved = ThreadPool::Task();
+	BOOST_CHECK_EQUAL(counter.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(post_and_stop)
+{
+	ThreadPool tp;
+	std::atomic<int> done (0);
+
+	for (int i = 0; i < 1000; i++) {
+		BOOST_CHECK(tp.Post([&tp, &done]() {
+			/* Posted from a worker thread, so this goes to the worker's own queue. */
+			tp.Post([&done]() { done.fetch_add(1); }, DefaultScheduler);
+			done.fetch_add(1);
+		}, i % 10 ? DefaultScheduler : LowLatencyScheduler));
+	}
+
+	/* Waits for all work items, including the ones posted meanwhile. */
+	tp.Stop();
+
+	BOOST_CHECK_EQUAL(done.load(), 2000);
+	BOOST_CHECK_EQUAL(tp.GetPending(), 0);
+	BOOST_CHECK(!tp.Post([]() {}, DefaultScheduler));
+
+	tp.Start();
+	BOOST_CHECK(tp.Post([&done]() { done.fetch_add(1); }, DefaultScheduler));
+	tp.Stop();
+
+	BOOST_CHECK_EQUAL(done.load(), 2001);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
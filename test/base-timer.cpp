@@ -4,7 +4,10 @@
 #include "base/timer.hpp"
 #include "base/utility.hpp"
 #include "base/application.hpp"
+#include "base/objectlock.hpp"
 #include <BoostTestTargetConfig.h>
+#include <atomic>
+#include <vector>
 
 using namespace icinga;
 
@@ -59,4 +62,85 @@ BOOST_AUTO_TEST_CASE(scope)
 	BOOST_CHECK_EQUAL(5, counter);
 }
 
+BOOST_AUTO_TEST_CASE(restart)
+{
+	std::atomic<int> counter (0);
+
+	Timer::Ptr timer = Timer::Create();
+	timer->OnTimerExpired.connect([&counter](const Timer* const&) { counter++; });
+	timer->SetInterval(0.1);
+
+	// The shard's thread keeps waiting for timers while there are none.
+	for (int i = 0; i < 3; i++) {
+		int fired = counter.load();
+
+		timer->Start();
+
+		double start = Utility::GetTime();
+
+		while (counter.load() == fired && Utility::GetTime() - start < 10) {
+			Utility::Sleep(0.01);
+		}
+
+		timer->Stop(true);
+
+		BOOST_CHECK(counter.load() > fired);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(many)
+{
+	std::atomic<int> counter (0);
+	std::vector<Timer::Ptr> timers;
+
+	// Enough timers to occupy every shard.
+	for (int i = 0; i < 64; i++) {
+		Timer::Ptr timer = Timer::Create();
+		timer->OnTimerExpired.connect([&counter](const Timer* const&) { counter++; });
+		timer->SetInterval(1);
+		timer->Start();
+
+		timers.push_back(std::move(timer));
+	}
+
+	// Wait for two rounds, but don't rely on the timer threads being scheduled in time.
+	double start = Utility::GetTime();
+
+	while (counter.load() < 64 * 2 && Utility::GetTime() - start < 10) {
+		Utility::Sleep(0.01);
+	}
+
+	for (auto& timer : timers) {
+		timer->Stop(true);
+	}
+
+	double elapsed = Utility::GetTime() - start;
+
+	BOOST_CHECK(counter.load() >= 64 * 2);
+
+	// None of them has fired more often than its interval allows.
+	BOOST_CHECK(counter.load() <= 64 * (int(elapsed) + 1));
+
+	Dictionary::Ptr status = new Dictionary();
+	Array::Ptr perfdata = new Array();
+
+	Timer::StatsFunc(status, perfdata);
+
+	Dictionary::Ptr stats = status->Get("timer");
+	BOOST_REQUIRE(stats);
+	BOOST_CHECK(stats->Get("shards") >= 1);
+
+	Dictionary::Ptr lateness = stats->Get("lateness");
+	BOOST_REQUIRE(lateness);
+
+	double fired = 0;
+	ObjectLock olock(lateness);
+
+	for (auto& kv : lateness) {
+		fired += kv.second;
+	}
+
+	BOOST_CHECK(fired >= 64 * 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
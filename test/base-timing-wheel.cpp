@@ -0,0 +1,239 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/timing-wheel.hpp"
+#include <BoostTestTargetConfig.h>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_timing_wheel)
+
+BOOST_AUTO_TEST_CASE(insert_erase)
+{
+	TimingWheel<int> wheel (0.01, 1000);
+
+	BOOST_CHECK(wheel.IsEmpty());
+
+	wheel.Insert(1, 1010);
+	wheel.Insert(2, 1020);
+	wheel.Insert(1, 1030);
+
+	BOOST_CHECK_EQUAL(wheel.GetLength(), 2);
+	BOOST_CHECK(wheel.Contains(1));
+	BOOST_CHECK(wheel.Erase(1));
+	BOOST_CHECK(!wheel.Erase(1));
+	BOOST_CHECK(!wheel.Contains(1));
+	BOOST_CHECK_EQUAL(wheel.GetLength(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(expire_in_order)
+{
+	TimingWheel<int> wheel (0.01, 1000);
+	std::mt19937 rng (42);
+	std::uniform_real_distribution<double> dist (1000, 1000 + 86400 * 30);
+
+	for (int i = 0; i < 10000; i++) {
+		wheel.Insert(i, dist(rng));
+	}
+
+	/* Items which are overdue must be expired right away. */
+	wheel.Insert(-1, 10);
+
+	double now = 1000;
+	double last = 0;
+	int count = 0;
+
+	while (!wheel.IsEmpty()) {
+		double next = wheel.GetNextExpiry();
+
+		/* Overdue items are due right away, everything else must be in the future. */
+		if (!wheel.HasDue())
+			BOOST_REQUIRE(next > now);
+
+		now = std::max(now, next);
+		wheel.Advance(now);
+
+		while (wheel.HasDue()) {
+			double when = wheel.GetFirstDueTime();
+
+			BOOST_REQUIRE(when < now + 0.01);
+			BOOST_REQUIRE(when > last - 0.01);
+
+			last = when;
+			wheel.PopDue();
+			count++;
+		}
+	}
+
+	BOOST_CHECK_EQUAL(count, 10001);
+}
+
+BOOST_AUTO_TEST_CASE(reschedule)
+{
+	TimingWheel<int> wheel (0.01, 1000);
+
+	wheel.Insert(1, 5000);
+	wheel.Insert(2, 1005);
+	wheel.Insert(1, 1002);
+
+	wheel.Advance(1003);
+	BOOST_REQUIRE(wheel.HasDue());
+	BOOST_CHECK_EQUAL(wheel.PopDue(), 1);
+	BOOST_CHECK(!wheel.HasDue());
+
+	/* The next expiry is a lower bound, i.e. the beginning of the slot the item is currently in. */
+	BOOST_CHECK(wheel.GetNextExpiry() > 1003);
+	BOOST_CHECK(wheel.GetNextExpiry() <= 1005);
+
+	wheel.Erase(2);
+	wheel.Advance(1006);
+	BOOST_CHECK(!wheel.HasDue());
+	BOOST_CHECK(wheel.IsEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(rebase)
+{
+	TimingWheel<int> wheel (0.01, 1000);
+
+	wheel.Insert(1, 1500);
+	wheel.Advance(2000);
+
+	/* The clock went back by 1000s. Without rebasing, everything before 2000 would be due right away. */
+	wheel.Insert(2, 1100);
+	wheel.Insert(3, 1050);
+	wheel.Insert(4, 1900);
+	BOOST_CHECK(wheel.HasDue());
+
+	wheel.Rebase(1000);
+	BOOST_CHECK(!wheel.HasDue());
+	BOOST_CHECK(wheel.GetNextExpiry() > 1000);
+	BOOST_CHECK(wheel.GetNextExpiry() <= 1050);
+
+	wheel.Advance(1060);
+	BOOST_REQUIRE(wheel.HasDue());
+	BOOST_CHECK_EQUAL(wheel.PopDue(), 3);
+	BOOST_CHECK(!wheel.HasDue());
+
+	/* Items which are overdue after rebasing are due in order. */
+	wheel.Rebase(1950);
+	BOOST_REQUIRE(wheel.HasDue());
+
+	for (int expected : { 2, 1, 4 }) {
+		BOOST_REQUIRE(wheel.HasDue());
+		BOOST_CHECK_EQUAL(wheel.GetFirstDue(), expected);
+		wheel.PopDue();
+	}
+
+	BOOST_CHECK(wheel.IsEmpty());
+}
+
+/**
+ * Replays a reschedule workload with one million checkables against the timing wheel
+ * and the ordered set the check scheduler used to use exclusively.
+ *
+ * Run it with: testbase --run_test=base_timing_wheel/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	const int checkables = 1000000;
+	const double intervals[] = { 10, 60, 300 };
+	const double start = 1700000000;
+
+	std::mt19937 rng (42);
+	std::vector<double> interval (checkables);
+	std::vector<double> first (checkables);
+
+	for (int i = 0; i < checkables; i++) {
+		interval[i] = intervals[rng() % 3];
+		first[i] = start + std::uniform_real_distribution<double>(0, interval[i])(rng);
+	}
+
+	struct Entry
+	{
+		int Id;
+		double When;
+	};
+
+	typedef boost::multi_index_container<
+		Entry,
+		boost::multi_index::indexed_by<
+			boost::multi_index::ordered_unique<boost::multi_index::member<Entry, int, &Entry::Id>>,
+			boost::multi_index::ordered_non_unique<boost::multi_index::member<Entry, double, &Entry::When>>
+		>
+	> OrderedSet;
+
+	auto now = [] { return ch::steady_clock::now(); };
+	auto seconds = [](ch::steady_clock::duration d) { return ch::duration<double>(d).count(); };
+
+	/* Simulate 2 minutes of scheduling in 100ms steps. */
+	const double duration = 120;
+	const double step = 0.1;
+
+	size_t orderedReschedules = 0;
+	auto orderedBegin (now());
+
+	{
+		OrderedSet set;
+
+		for (int i = 0; i < checkables; i++) {
+			set.insert(Entry{i, first[i]});
+		}
+
+		auto& byTime (set.get<1>());
+
+		for (double t = start; t < start + duration; t += step) {
+			while (!byTime.empty() && byTime.begin()->When <= t) {
+				Entry e = *byTime.begin();
+
+				byTime.erase(byTime.begin());
+				set.insert(Entry{e.Id, e.When + interval[e.Id]});
+				orderedReschedules++;
+			}
+		}
+	}
+
+	auto orderedTime (seconds(now() - orderedBegin));
+
+	size_t wheelReschedules = 0;
+	auto wheelBegin (now());
+
+	{
+		TimingWheel<int> wheel (0.01, start);
+
+		for (int i = 0; i < checkables; i++) {
+			wheel.Insert(i, first[i]);
+		}
+
+		for (double t = start; t < start + duration; t += step) {
+			wheel.Advance(t);
+
+			while (wheel.HasDue()) {
+				double when = wheel.GetFirstDueTime();
+				int id = wheel.PopDue();
+
+				wheel.Insert(id, when + interval[id]);
+				wheelReschedules++;
+			}
+		}
+	}
+
+	auto wheelTime (seconds(now() - wheelBegin));
+
+	BOOST_TEST_MESSAGE("ordered set:  " << orderedReschedules << " reschedules in " << orderedTime << "s ("
+		<< orderedReschedules / orderedTime << "/s)");
+	BOOST_TEST_MESSAGE("timing wheel: " << wheelReschedules << " reschedules in " << wheelTime << "s ("
+		<< wheelReschedules / wheelTime << "/s)");
+
+	/* The wheel expires everything up to the end of the current tick, so it may be a few reschedules ahead. */
+	BOOST_CHECK(wheelReschedules >= orderedReschedules);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,11 @@
 
 #include "base/value.hpp"
 #include <BoostTestTargetConfig.h>
+#include <boost/variant/get.hpp>
+#include <boost/variant/variant.hpp>
+#include <chrono>
+#include <typeinfo>
+#include <vector>
 
 using namespace icinga;
 
@@ -51,4 +56,106 @@ BOOST_AUTO_TEST_CASE(format)
 	BOOST_CHECK_MESSAGE(v == "3", "v should be '3' (is '" << v << "')");
 }
 
+BOOST_AUTO_TEST_CASE(string_sharing)
+{
+	const Value v = "a string long enough to be allocated on the heap";
+	Value copy = v;
+
+	/* Copies share the string... */
+	BOOST_CHECK_EQUAL(&v.Get<String>(), &static_cast<const Value&>(copy).Get<String>());
+
+	/* ... also if it's read via a non-const value... */
+	BOOST_CHECK_EQUAL(&v.Get<String>(), &copy.Get<String>());
+
+	/* ... until one of them is modified. */
+	copy.GetMutableString() += "!";
+	BOOST_CHECK_EQUAL(v.Get<String>(), "a string long enough to be allocated on the heap");
+	BOOST_CHECK_EQUAL(static_cast<const Value&>(copy).Get<String>(), "a string long enough to be allocated on the heap!");
+
+	Value moved = std::move(copy);
+	BOOST_CHECK(copy.GetType() == ValueEmpty);
+	BOOST_CHECK(moved.IsString());
+
+	moved = moved;
+	BOOST_CHECK(moved == "a string long enough to be allocated on the heap!");
+
+	moved = 42;
+	BOOST_CHECK(moved.IsNumber());
+}
+
+BOOST_AUTO_TEST_CASE(get)
+{
+	Value v = 42;
+
+	BOOST_CHECK_EQUAL(v.Get<double>(), 42);
+	BOOST_CHECK_THROW(v.Get<String>(), std::bad_cast);
+	BOOST_CHECK_THROW(v.Get<bool>(), std::bad_cast);
+	BOOST_CHECK_THROW(v.Get<Object::Ptr>(), std::bad_cast);
+
+	v.Get<double>() = 23;
+	BOOST_CHECK(v == 23);
+
+	Value w;
+	w.Swap(v);
+	BOOST_CHECK(w == 23);
+	BOOST_CHECK(v.IsEmpty());
+}
+
+template<class F>
+static double MeasureNanos(int iterations, F func)
+{
+	namespace ch = std::chrono;
+
+	auto begin (ch::steady_clock::now());
+
+	for (int i = 0; i < iterations; i++) {
+		func(i);
+	}
+
+	return ch::duration<double, std::nano>(ch::steady_clock::now() - begin).count() / iterations;
+}
+
+/**
+ * Measures copying and comparing values, compared with the boost::variant Value used to wrap,
+ * and the arithmetic operators.
+ *
+ * testbase --run_test=base_value/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	typedef boost::variant<boost::blank, double, bool, String, Object::Ptr> Variant;
+
+	const int iterations = 10000000;
+	const String str ("check_command_with_a_long_name");
+	std::vector<Value> values { 42, true, str, Empty };
+	std::vector<Variant> variants { 42.0, true, str, boost::blank() };
+	std::vector<Value> valueCopies (values.size());
+	std::vector<Variant> variantCopies (variants.size());
+
+	BOOST_TEST_MESSAGE("sizeof: Value " << sizeof(Value) << " bytes, boost::variant " << sizeof(Variant) << " bytes");
+
+	double valueCopy = MeasureNanos(iterations, [&](int i) { valueCopies[i % 4] = values[i % 4]; });
+	double variantCopy = MeasureNanos(iterations, [&](int i) { variantCopies[i % 4] = variants[i % 4]; });
+
+	BOOST_TEST_MESSAGE("copy: Value " << valueCopy << "ns, boost::variant " << variantCopy << "ns");
+
+	size_t equal = 0;
+	double valueCompare = MeasureNanos(iterations, [&](int i) { equal += values[i % 4] == valueCopies[(i + i / 4) % 4]; });
+	double variantCompare = MeasureNanos(iterations, [&](int i) { equal += variants[i % 4] == variantCopies[(i + i / 4) % 4]; });
+
+	BOOST_CHECK_EQUAL(equal, iterations / 2);
+	BOOST_TEST_MESSAGE("compare: Value " << valueCompare << "ns, boost::variant " << variantCompare << "ns");
+
+	Value sum = 0;
+	Value factor = 1.5;
+
+	double add = MeasureNanos(iterations, [&](int i) { sum = sum + values[0]; });
+	double multiply = MeasureNanos(iterations, [&](int i) { sum = sum * factor / factor; });
+	double less = MeasureNanos(iterations, [&](int i) { equal += values[0] < sum; });
+	double concat = MeasureNanos(iterations / 10, [&](int i) { Value s = values[2] + values[0]; });
+
+	BOOST_CHECK(sum > 0);
+	BOOST_TEST_MESSAGE("operators: + " << add << "ns, * and / " << multiply << "ns, < " << less << "ns, String + Number " << concat << "ns");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
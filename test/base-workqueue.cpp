@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/mpmc-ring.hpp"
+#include "base/workqueue.hpp"
+#include <BoostTestTargetConfig.h>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_workqueue)
+
+BOOST_AUTO_TEST_CASE(mpmc_ring)
+{
+	MpmcRing<int> ring (3);
+
+	BOOST_CHECK_EQUAL(ring.GetCapacity(), 4);
+
+	for (int i = 0; i < 4; i++) {
+		BOOST_CHECK(ring.TryPush(int(i)));
+	}
+
+	BOOST_CHECK(!ring.TryPush(4));
+
+	std::vector<int> items;
+
+	BOOST_CHECK_EQUAL(ring.TryPopBatch(std::back_inserter(items), 3), 3);
+	BOOST_CHECK(ring.TryPush(4));
+	BOOST_CHECK_EQUAL(ring.TryPopBatch(std::back_inserter(items), 3), 2);
+	BOOST_CHECK_EQUAL(ring.TryPopBatch(std::back_inserter(items), 3), 0);
+
+	BOOST_CHECK(items == std::vector<int>({ 0, 1, 2, 3, 4 }));
+}
+
+BOOST_AUTO_TEST_CASE(lockfree_order)
+{
+	WorkQueue wq (0, 1, LogInformation, WorkQueueLockFree);
+	wq.SetName("Test");
+
+	std::mutex mutex;
+	std::vector<int> order;
+
+	/* Keep the worker busy until all tasks are enqueued. */
+	std::unique_lock<std::mutex> lock (mutex);
+	wq.Enqueue([&mutex]() { std::unique_lock<std::mutex> lock (mutex); });
+
+	/* More than fit into the ring, the rest spills over. */
+	for (int i = 0; i < 10000; i++) {
+		wq.Enqueue([&order, i]() { order.push_back(i); }, PriorityLow);
+	}
+
+	wq.Enqueue([&order]() { order.push_back(-1); }, PriorityHigh);
+
+	lock.unlock();
+	wq.Join();
+
+	BOOST_REQUIRE_EQUAL(order.size(), 10001);
+	BOOST_CHECK_EQUAL(order[0], -1);
+
+	for (int i = 0; i < 10000; i++) {
+		BOOST_CHECK_EQUAL(order[i + 1], i);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(lockfree_bounded)
+{
+	WorkQueue wq (16, 4, LogInformation, WorkQueueLockFree);
+	wq.SetName("Test");
+
+	std::atomic<int> done (0);
+	std::vector<std::thread> producers;
+
+	for (int i = 0; i < 4; i++) {
+		producers.emplace_back([&wq, &done]() {
+			for (int j = 0; j < 1000; j++) {
+				wq.Enqueue([&done]() { done.fetch_add(1); });
+			}
+		});
+	}
+
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	wq.Join();
+
+	BOOST_CHECK_EQUAL(done.load(), 4000);
+	BOOST_CHECK_EQUAL(wq.GetLength(), 0);
+}
+
+/**
+ * Enqueues tasks from 1 to 64 producer threads at once and reports the throughput of both backends.
+ *
+ * testbase --run_test=base_workqueue/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	const int tasks = 1000000;
+
+	for (auto backend : { WorkQueueMutex, WorkQueueLockFree }) {
+		for (int producers = 1; producers <= 64; producers *= 2) {
+			WorkQueue wq (0, 1, LogInformation, backend);
+			wq.SetName("Benchmark");
+
+			std::atomic<int> done (0);
+			std::vector<std::thread> threads;
+			auto begin (ch::steady_clock::now());
+
+			for (int i = 0; i < producers; i++) {
+				threads.emplace_back([&wq, &done, producers]() {
+					for (int j = 0; j < tasks / producers; j++) {
+						wq.Enqueue([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+					}
+				});
+			}
+
+			for (auto& thread : threads) {
+				thread.join();
+			}
+
+			auto enqueued (ch::steady_clock::now());
+
+			wq.Join();
+
+			auto end (ch::steady_clock::now());
+
+			BOOST_TEST_MESSAGE((backend == WorkQueueMutex ? "mutex" : "lock-free") << ", " << producers << " producers: "
+				<< done.load() / ch::duration<double>(end - begin).count() << " tasks/s, enqueueing took "
+				<< ch::duration<double>(enqueued - begin).count() * 1000 << "ms");
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,236 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <BoostTestTargetConfig.h>
+#include "base/convert.hpp"
+#include "base/perfdatavalue.hpp"
+#include "base/scriptglobal.hpp"
+#include "checker/checkercomponent.hpp"
+#include "config/configcompiler.hpp"
+#include "icinga/host.hpp"
+#include "remote/apilistener.hpp"
+#include <mutex>
+#include <set>
+
+using namespace icinga;
+
+namespace {
+
+/**
+ * Gets access to the private shards of a CheckerComponent by using Friend-Injection,
+ * see the NotificationComponent tests for how this works.
+ */
+template<auto shardsMember, auto getShardFn>
+struct ShardAccessImpl
+{
+	friend size_t GetShardIndex(const CheckerComponent::Ptr& checker, const Checkable::Ptr& checkable)
+	{
+		return ((*checker).*getShardFn)(checkable).Index;
+	}
+
+	friend bool IsIdleInShard(const CheckerComponent::Ptr& checker, size_t shard, const Checkable::Ptr& checkable)
+	{
+		std::unique_lock<std::mutex> lock (((*checker).*shardsMember)[shard]->Mutex);
+
+		return ((*checker).*shardsMember)[shard]->IdleCheckables->Contains(checkable);
+	}
+};
+size_t GetShardIndex(const CheckerComponent::Ptr& checker, const Checkable::Ptr& checkable);
+bool IsIdleInShard(const CheckerComponent::Ptr& checker, size_t shard, const Checkable::Ptr& checkable);
+
+template struct ShardAccessImpl<&CheckerComponent::m_Shards, &CheckerComponent::GetShard>;
+
+} // namespace
+
+class CheckerComponentFixture
+{
+public:
+	static constexpr size_t NumShards = 4;
+	static constexpr size_t NumHosts = 32;
+
+	CheckerComponentFixture()
+	{
+		/* Keep the scheduler threads from executing any checks, so that all checkables stay idle. */
+		m_MaxConcurrentChecks = ScriptGlobal::Get("MaxConcurrentChecks");
+		ScriptGlobal::Set("MaxConcurrentChecks", 0);
+
+		auto createObjects = []() {
+			String config = R"CONFIG(
+object CheckCommand "dummy" {
+	command = "/bin/true"
+}
+object CheckerComponent "checker" {
+	scheduler_shards = )CONFIG" + Convert::ToString(NumShards) + R"CONFIG(
+}
+)CONFIG";
+
+			for (size_t i = 0; i < NumHosts; i++) {
+				config += "object Host \"h" + Convert::ToString(i) + "\" { check_command = \"dummy\" }\n";
+			}
+
+			std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", config);
+			expr->Evaluate(*ScriptFrame::GetCurrentFrame());
+		};
+
+		auto ret = ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", createObjects));
+		BOOST_REQUIRE(ret);
+
+		m_Checker = CheckerComponent::GetByName("checker");
+		BOOST_REQUIRE(m_Checker);
+		BOOST_REQUIRE_EQUAL(m_Checker->GetShardCount(), NumShards);
+
+		for (size_t i = 0; i < NumHosts; i++) {
+			Host::Ptr host = Host::GetByName("h" + Convert::ToString(i));
+			BOOST_REQUIRE(host);
+			m_Hosts.emplace_back(std::move(host));
+		}
+
+		/* Unpauses the hosts, which hands them over to the checker. */
+		ApiListener::UpdateObjectAuthority();
+		BOOST_REQUIRE(ApiListener::UpdatedObjectAuthority());
+	}
+
+	~CheckerComponentFixture()
+	{
+		m_Checker->Deactivate();
+		ScriptGlobal::Set("MaxConcurrentChecks", m_MaxConcurrentChecks);
+	}
+
+	/**
+	 * Checks that every host is idle in the shard it belongs to and in no other one.
+	 */
+	void RequireIdleInOwnShardOnly()
+	{
+		for (auto& host : m_Hosts) {
+			size_t index = GetShardIndex(m_Checker, host);
+			BOOST_REQUIRE_LT(index, NumShards);
+
+			for (size_t i = 0; i < NumShards; i++) {
+				BOOST_REQUIRE_EQUAL(IsIdleInShard(m_Checker, i, host), i == index);
+			}
+		}
+	}
+
+	unsigned long GetIdleCheckablesInShards()
+	{
+		unsigned long idle = 0;
+
+		for (size_t i = 0; i < NumShards; i++) {
+			idle += m_Checker->GetIdleCheckables(i);
+			BOOST_REQUIRE_EQUAL(m_Checker->GetPendingCheckables(i), 0u);
+		}
+
+		return idle;
+	}
+
+protected:
+	CheckerComponent::Ptr m_Checker;
+	std::vector<Host::Ptr> m_Hosts;
+
+private:
+	Value m_MaxConcurrentChecks;
+};
+
+BOOST_FIXTURE_TEST_SUITE(checkercomponent, CheckerComponentFixture,
+	*boost::unit_test::label("checker"));
+
+BOOST_AUTO_TEST_CASE(shards_partition_checkables)
+{
+	RequireIdleInOwnShardOnly();
+	BOOST_CHECK_EQUAL(GetIdleCheckablesInShards(), NumHosts);
+	BOOST_CHECK_EQUAL(m_Checker->GetIdleCheckables(), NumHosts);
+
+	std::set<size_t> used;
+
+	for (auto& host : m_Hosts) {
+		used.insert(GetShardIndex(m_Checker, host));
+	}
+
+	BOOST_CHECK_GT(used.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(shards_next_check_changed)
+{
+	std::vector<unsigned long> idle;
+
+	for (size_t i = 0; i < NumShards; i++) {
+		idle.emplace_back(m_Checker->GetIdleCheckables(i));
+	}
+
+	double now = Utility::GetTime();
+
+	for (size_t i = 0; i < NumHosts; i++) {
+		m_Hosts[i]->SetNextCheck(now + 3600 + i);
+	}
+
+	RequireIdleInOwnShardOnly();
+
+	for (size_t i = 0; i < NumShards; i++) {
+		BOOST_CHECK_EQUAL(m_Checker->GetIdleCheckables(i), idle[i]);
+	}
+
+	/* A checkable which isn't idle must not be re-added to its shard. */
+	m_Hosts[0]->SetPaused(true);
+	BOOST_CHECK_EQUAL(GetIdleCheckablesInShards(), NumHosts - 1);
+
+	m_Hosts[0]->SetNextCheck(now + 60);
+
+	for (size_t i = 0; i < NumShards; i++) {
+		BOOST_CHECK(!IsIdleInShard(m_Checker, i, m_Hosts[0]));
+	}
+
+	BOOST_CHECK_EQUAL(GetIdleCheckablesInShards(), NumHosts - 1);
+}
+
+BOOST_AUTO_TEST_CASE(shards_stats)
+{
+	Dictionary::Ptr status = new Dictionary();
+	Array::Ptr perfdata = new Array();
+
+	CheckerComponent::StatsFunc(status, perfdata);
+
+	Dictionary::Ptr nodes = status->Get("checkercomponent");
+	BOOST_REQUIRE(nodes);
+
+	Dictionary::Ptr node = nodes->Get("checker");
+	BOOST_REQUIRE(node);
+
+	Array::Ptr shards = node->Get("shards");
+	BOOST_REQUIRE(shards);
+	BOOST_REQUIRE_EQUAL(shards->GetLength(), NumShards);
+
+	unsigned long idle = 0;
+
+	for (size_t i = 0; i < NumShards; i++) {
+		Dictionary::Ptr shard = shards->Get(i);
+		BOOST_REQUIRE(shard);
+
+		unsigned long shardIdle = Convert::ToLong(shard->Get("idle"));
+
+		BOOST_CHECK_EQUAL(shardIdle, m_Checker->GetIdleCheckables(i));
+		BOOST_CHECK_EQUAL(Convert::ToLong(shard->Get("pending")), 0);
+
+		idle += shardIdle;
+	}
+
+	BOOST_CHECK_EQUAL(idle, NumHosts);
+	BOOST_CHECK_EQUAL(Convert::ToLong(node->Get("idle")), static_cast<long>(NumHosts));
+	BOOST_CHECK_EQUAL(Convert::ToLong(node->Get("pending")), 0);
+
+	std::set<String> labels;
+
+	for (size_t i = 0; i < perfdata->GetLength(); i++) {
+		PerfdataValue::Ptr pdv = perfdata->Get(i);
+		labels.insert(pdv->GetLabel());
+	}
+
+	for (size_t i = 0; i < NumShards; i++) {
+		String prefix = "checkercomponent_checker_shard" + Convert::ToString(i) + "_";
+		BOOST_CHECK(labels.find(prefix + "idle") != labels.end());
+		BOOST_CHECK(labels.find(prefix + "pending") != labels.end());
+	}
+
+	BOOST_CHECK_EQUAL(perfdata->GetLength(), NumShards * 2 + 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
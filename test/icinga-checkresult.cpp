@@ -1,10 +1,12 @@
 // SPDX-FileCopyrightText: 2012 Icinga GmbH <https://icinga.com>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include "base/object-pool.hpp"
 #include "icinga/downtime.hpp"
 #include "icinga/host.hpp"
 #include "icinga/service.hpp"
 #include <BoostTestTargetConfig.h>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <utility>
@@ -1033,4 +1035,66 @@ BOOST_AUTO_TEST_CASE(suppressed_notification)
 	}
 }
 
+/**
+ * Measures the throughput of Checkable::ProcessCheckResult(), which emits several of the signals
+ * generated by mkclass as well as Checkable::OnNewCheckResult and Checkable::OnStateChange per call,
+ * and counts the allocations of the pooled types per check result, including creating the check result
+ * before the timed loop.
+ * Run it on two builds to compare them.
+ *
+ * testbase --run_test=icinga_checkresult/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	Host::Ptr host = new Host();
+	host->SetActive(true);
+	host->SetMaxCheckAttempts(1);
+	host->Activate();
+	host->SetAuthority(true);
+
+	const int checkResults = 200000;
+	int states = 0;
+
+	auto connection (Checkable::OnStateChange.connect([&states](const Checkable::Ptr&, const CheckResult::Ptr&, StateType, const MessageOrigin::Ptr&) {
+		states++;
+	}));
+
+	auto stats ([]() {
+		ObjectPoolStats result {};
+
+		for (auto& pool : { ObjectPool<CheckResult>::GetStats(), ObjectPool<Array>::GetStats(), ObjectPool<Dictionary>::GetStats() }) {
+			result.Allocations += pool.Allocations;
+			result.HeapAllocations += pool.HeapAllocations;
+		}
+
+		return result;
+	});
+
+	auto before (stats());
+	std::vector<CheckResult::Ptr> crs;
+
+	for (int i = 0; i < checkResults; i++) {
+		crs.emplace_back(MakeCheckResult(i % 100 ? ServiceOK : ServiceCritical));
+	}
+
+	WaitGroup::Ptr producer = new StoppableWaitGroup();
+	auto begin (ch::steady_clock::now());
+
+	for (auto& cr : crs) {
+		host->ProcessCheckResult(cr, producer);
+	}
+
+	double seconds = ch::duration<double>(ch::steady_clock::now() - begin).count();
+	auto after (stats());
+
+	connection.disconnect();
+
+	BOOST_CHECK(states > 0);
+	BOOST_TEST_MESSAGE(checkResults / seconds << " check results per second");
+	BOOST_TEST_MESSAGE(double(after.Allocations - before.Allocations) / checkResults << " allocations of CheckResult, Array and Dictionary per check result, "
+		<< double(after.HeapAllocations - before.HeapAllocations) / checkResults << " of them from the heap");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
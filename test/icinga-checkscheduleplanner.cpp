@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/checkscheduleplanner.hpp"
+#include "base/utility.hpp"
+#include <BoostTestTargetConfig.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(icinga_checkscheduleplanner)
+
+BOOST_AUTO_TEST_CASE(flat)
+{
+	CheckSchedulePlanner planner;
+	double from = std::floor(Utility::GetTime()) + 10;
+	std::vector<CheckSchedulePlanner::Reservation> reservations (1000);
+
+	for (auto& reservation : reservations) {
+		double ts = planner.Plan(reservation, from, 100);
+
+		BOOST_CHECK(ts >= from && ts < from + 100);
+		BOOST_CHECK_EQUAL(reservation.GetTime(), ts);
+	}
+
+	auto histogram (planner.GetHistogram(120));
+
+	/* Every second in the window has got about 10 checks, although each shard only knows its own ones. */
+	BOOST_CHECK_LE(*std::max_element(histogram.begin() + 20, histogram.begin() + 100), 11);
+	BOOST_CHECK_GE(*std::min_element(histogram.begin() + 20, histogram.begin() + 100), 9);
+	BOOST_CHECK_EQUAL(*std::max_element(histogram.begin() + 115, histogram.end()), 0);
+}
+
+BOOST_AUTO_TEST_CASE(least_loaded)
+{
+	CheckSchedulePlanner planner;
+	double from = std::floor(Utility::GetTime()) + 10.5;
+	CheckSchedulePlanner::Reservation a (0), b (0), c (0);
+
+	planner.Reserve(a, from);
+	planner.Reserve(b, from + 1);
+
+	/* The earliest free second keeps the fraction. */
+	BOOST_CHECK_EQUAL(planner.Plan(c, from, 3), from + 2);
+
+	planner.Release(a);
+	BOOST_CHECK_EQUAL(a.GetTime(), -1);
+
+	BOOST_CHECK_EQUAL(planner.Plan(c, from, 3), from);
+}
+
+BOOST_AUTO_TEST_CASE(horizon)
+{
+	CheckSchedulePlanner planner;
+	double from = std::floor(Utility::GetTime()) + CheckSchedulePlanner::Horizon + 10;
+	CheckSchedulePlanner::Reservation reservation;
+
+	/* Beyond the horizon, nothing is planned. */
+	BOOST_CHECK_EQUAL(planner.Plan(reservation, from, 100), from);
+	BOOST_CHECK_EQUAL(reservation.GetTime(), -1);
+
+	/* The window is cut off at the horizon, the leaves wrap around. */
+	from = std::floor(Utility::GetTime()) + CheckSchedulePlanner::Horizon - 20;
+
+	std::vector<CheckSchedulePlanner::Reservation> reservations (30);
+
+	for (auto& planned : reservations) {
+		double ts = planner.Plan(planned, from, 100);
+
+		BOOST_CHECK(ts < std::floor(Utility::GetTime()) + CheckSchedulePlanner::Horizon + 1);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
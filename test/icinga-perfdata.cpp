@@ -436,4 +436,47 @@ BOOST_AUTO_TEST_CASE(parse_edgecases)
 	BOOST_CHECK_EQUAL(pv->GetUnit(), "bytes");
 }
 
+BOOST_AUTO_TEST_CASE(metrics)
+{
+	Array::Ptr pd = PluginUtility::SplitPerfdata("'disk free'=2GB;1;0.5;0;4 time=5s invalid=1,5 count=7c");
+	pd->Add(new PerfdataValue("object", 42, false, "bytes", Empty, 50));
+	pd->Freeze();
+
+	PerfdataMetrics metrics (pd);
+	BOOST_CHECK(metrics.GetSource() == pd);
+	BOOST_REQUIRE_EQUAL(metrics.GetLength(), 5);
+
+	BOOST_CHECK(metrics.IsValid(0));
+	BOOST_CHECK(metrics.GetLabel(0) == "disk free");
+	BOOST_CHECK_EQUAL(metrics.GetValue(0), 2e9);
+	BOOST_CHECK(metrics.GetUnit(0) == "bytes");
+	BOOST_CHECK_EQUAL(metrics.GetWarn(0), 1e9);
+	BOOST_CHECK_EQUAL(metrics.GetCrit(0), 0.5e9);
+	BOOST_CHECK_EQUAL(metrics.GetMin(0), 0);
+	BOOST_CHECK_EQUAL(metrics.GetMax(0), 4e9);
+
+	/* The label isn't copied. */
+	const String& source = pd->Get(0).Get<String>();
+	BOOST_CHECK(metrics.GetLabel(0).data() > source.CStr() && metrics.GetLabel(0).data() < source.CStr() + source.GetLength());
+
+	BOOST_CHECK_EQUAL(metrics.GetValue(1), 5);
+	BOOST_CHECK(metrics.GetUnit(1) == "seconds");
+	BOOST_CHECK_EQUAL(metrics.GetWarn(1), Empty);
+	BOOST_CHECK_EQUAL(metrics.GetMax(1), Empty);
+
+	BOOST_CHECK(!metrics.IsValid(2));
+
+	BOOST_CHECK(metrics.GetCounter(3));
+	BOOST_CHECK(!metrics.GetCounter(4));
+
+	BOOST_CHECK(metrics.GetLabel(4) == "object");
+	BOOST_CHECK_EQUAL(metrics.GetCrit(4), 50);
+	BOOST_CHECK_EQUAL(metrics.GetWarn(4), Empty);
+
+	PerfdataValue::Ptr pdv = metrics.GetPerfdataValue(0);
+	BOOST_CHECK_EQUAL(pdv->GetLabel(), "disk free");
+	BOOST_CHECK_EQUAL(pdv->GetUnit(), "bytes");
+	BOOST_CHECK_EQUAL(pdv->GetMax(), 4e9);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
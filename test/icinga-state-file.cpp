@@ -0,0 +1,322 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/atomic-file.hpp"
+#include "base/json.hpp"
+#include "base/netstring.hpp"
+#include "base/serializer.hpp"
+#include "base/state-file.hpp"
+#include "base/stdiostream.hpp"
+#include "base/utility.hpp"
+#include "icinga/host.hpp"
+#include <BoostTestTargetConfig.h>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+using namespace icinga;
+
+/**
+ * Writes the objects in the netstring format of v2.16 and older.
+ */
+static void DumpNetStringFile(const String& filename, const std::vector<Host::Ptr>& hosts)
+{
+	std::fstream fp (filename.CStr(), std::ios_base::out | std::ios_base::trunc);
+	StdioStream::Ptr sfp = new StdioStream(&fp, false);
+
+	for (auto& host : hosts) {
+		Dictionary::Ptr persistentObject = new Dictionary({
+			{ "type", "Host" },
+			{ "name", host->GetName() },
+			{ "update", Serialize(host, FAState) }
+		});
+
+		NetString::WriteStringToStream(sfp, JsonEncode(persistentObject));
+	}
+
+	sfp->Close();
+}
+
+static std::string ReadFile(const String& filename)
+{
+	std::ifstream fp (filename.CStr(), std::ios_base::in | std::ios_base::binary);
+
+	return std::string(std::istreambuf_iterator<char>(fp), std::istreambuf_iterator<char>());
+}
+
+static CheckResult::Ptr MakeCheckResult(ServiceState state, const String& output)
+{
+	CheckResult::Ptr cr = new CheckResult();
+
+	cr->SetState(state);
+	cr->SetOutput(output);
+	cr->SetPerformanceData(new Array({ "time=0.123s;1;5;0", "size=123456B;;;0" }));
+	cr->SetExecutionStart(1760000000.25);
+	cr->SetExecutionEnd(1760000000.5);
+
+	return cr;
+}
+
+struct StateFileFixture
+{
+	String Filename;
+	std::vector<Host::Ptr> Hosts;
+
+	StateFileFixture(size_t count = 3)
+		: Filename((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("icinga2-%%%%-%%%%.state")).string())
+	{
+		for (size_t i = 0; i < count; i++) {
+			Host::Ptr host = new Host();
+			host->SetName("state-file-" + std::to_string(i), true);
+			host->Register();
+
+			host->SetCheckAttempt(2, true);
+			host->SetFlappingCurrent(12.5, true);
+			host->SetForceNextCheck(true, true);
+			host->SetLastCheckResult(MakeCheckResult(ServiceCritical, "host " + std::to_string(i) + " is down"), true);
+
+			Hosts.emplace_back(std::move(host));
+		}
+	}
+
+	~StateFileFixture()
+	{
+		for (auto& host : Hosts) {
+			host->Unregister();
+		}
+
+		boost::filesystem::remove(Filename.GetData());
+	}
+
+	void ResetState()
+	{
+		for (auto& host : Hosts) {
+			host->SetCheckAttempt(1, true);
+			host->SetFlappingCurrent(0, true);
+			host->SetForceNextCheck(false, true);
+			host->SetLastCheckResult(nullptr, true);
+			host->SetStateLoaded(false, true);
+		}
+	}
+
+	void CheckState()
+	{
+		for (size_t i = 0; i < Hosts.size(); i++) {
+			auto& host (Hosts[i]);
+
+			BOOST_CHECK(host->GetStateLoaded());
+			BOOST_CHECK_EQUAL(host->GetCheckAttempt(), 2);
+			BOOST_CHECK_EQUAL(host->GetFlappingCurrent(), 12.5);
+			BOOST_CHECK(host->GetForceNextCheck());
+
+			CheckResult::Ptr cr = host->GetLastCheckResult();
+			BOOST_REQUIRE(cr);
+			BOOST_CHECK_EQUAL(cr->GetState(), ServiceCritical);
+			BOOST_CHECK_EQUAL(cr->GetOutput(), String("host " + std::to_string(i) + " is down"));
+			BOOST_CHECK_EQUAL(cr->GetExecutionStart(), 1760000000.25);
+			BOOST_CHECK_EQUAL(cr->GetPerformanceData()->GetLength(), 2);
+		}
+	}
+};
+
+BOOST_AUTO_TEST_SUITE(icinga_state_file)
+
+BOOST_AUTO_TEST_CASE(dump_restore)
+{
+	/* More objects than fit into one chunk of the restore. */
+	StateFileFixture fixture (1500);
+
+	ConfigObject::DumpObjects(fixture.Filename);
+	BOOST_CHECK(StateFileReader::IsStateFile(fixture.Filename));
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+	fixture.CheckState();
+}
+
+BOOST_AUTO_TEST_CASE(convert)
+{
+	StateFileFixture fixture;
+
+	DumpNetStringFile(fixture.Filename, fixture.Hosts);
+	BOOST_CHECK(!StateFileReader::IsStateFile(fixture.Filename));
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+	fixture.CheckState();
+
+	ConfigObject::DumpObjects(fixture.Filename);
+	BOOST_CHECK(StateFileReader::IsStateFile(fixture.Filename));
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+	fixture.CheckState();
+}
+
+BOOST_AUTO_TEST_CASE(truncated)
+{
+	StateFileFixture fixture;
+
+	ConfigObject::DumpObjects(fixture.Filename);
+	boost::filesystem::resize_file(fixture.Filename.GetData(), boost::filesystem::file_size(fixture.Filename.GetData()) - 1u);
+
+	BOOST_CHECK_THROW(ConfigObject::RestoreObjects(fixture.Filename), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(delta)
+{
+	StateFileFixture fixture;
+	String deltaFilename = fixture.Filename + ".delta";
+
+	ConfigObject::DumpObjects(fixture.Filename);
+
+	/* Nothing has changed. */
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+	BOOST_CHECK(!Utility::PathExists(deltaFilename));
+
+	fixture.Hosts[0]->SetCheckAttempt(3, true);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+	fixture.Hosts[1]->SetCheckAttempt(4, true);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+	fixture.Hosts[0]->SetCheckAttempt(5, true);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+
+	BOOST_REQUIRE(Utility::PathExists(deltaFilename));
+	BOOST_CHECK(StateFileReader(deltaFilename).IsDelta());
+
+	/* A batch which was cut off by a crash. */
+	{
+		std::ofstream fp (deltaFilename.CStr(), std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+		fp << char(100) << "T";
+	}
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+
+	BOOST_CHECK_EQUAL(fixture.Hosts[0]->GetCheckAttempt(), 5);
+	BOOST_CHECK_EQUAL(fixture.Hosts[1]->GetCheckAttempt(), 4);
+	BOOST_CHECK_EQUAL(fixture.Hosts[2]->GetCheckAttempt(), 2);
+	BOOST_CHECK(fixture.Hosts[0]->GetLastCheckResult());
+
+	/* Restoring doesn't count as a change. */
+	std::string delta = ReadFile(deltaFilename);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+	BOOST_CHECK(ReadFile(deltaFilename) == delta);
+
+	/* A new snapshot replaces the delta log, a stale one is ignored. */
+	ConfigObject::DumpObjects(fixture.Filename);
+	BOOST_CHECK(!Utility::PathExists(deltaFilename));
+
+	fixture.Hosts[2]->SetCheckAttempt(6, true);
+	AtomicFile::Write(deltaFilename, 0600, delta);
+
+	ConfigObject::RestoreObjects(fixture.Filename);
+	BOOST_CHECK_EQUAL(fixture.Hosts[0]->GetCheckAttempt(), 5);
+	BOOST_CHECK_EQUAL(fixture.Hosts[2]->GetCheckAttempt(), 2);
+
+	boost::filesystem::remove(deltaFilename.GetData());
+}
+
+BOOST_AUTO_TEST_CASE(delta_torn_tail)
+{
+	StateFileFixture fixture;
+	String deltaFilename = fixture.Filename + ".delta";
+
+	ConfigObject::DumpObjects(fixture.Filename);
+
+	fixture.Hosts[0]->SetCheckAttempt(3, true);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+	fixture.Hosts[1]->SetCheckAttempt(4, true);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+
+	/* The last batch has only been written partially. */
+	boost::filesystem::resize_file(deltaFilename.GetData(), boost::filesystem::file_size(deltaFilename.GetData()) - 5u);
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+
+	BOOST_CHECK_EQUAL(fixture.Hosts[0]->GetCheckAttempt(), 3);
+	BOOST_CHECK_EQUAL(fixture.Hosts[1]->GetCheckAttempt(), 2);
+
+	/* The next batch doesn't end up behind the torn one. */
+	fixture.Hosts[2]->SetCheckAttempt(5, true);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+
+	BOOST_CHECK_EQUAL(fixture.Hosts[0]->GetCheckAttempt(), 3);
+	BOOST_CHECK_EQUAL(fixture.Hosts[1]->GetCheckAttempt(), 2);
+	BOOST_CHECK_EQUAL(fixture.Hosts[2]->GetCheckAttempt(), 5);
+
+	/* A complete length, but garbage in place of the batch. */
+	{
+		std::ofstream fp (deltaFilename.CStr(), std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+		fp << char(3) << "Xyz";
+	}
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+	BOOST_CHECK_EQUAL(fixture.Hosts[2]->GetCheckAttempt(), 5);
+
+	fixture.Hosts[1]->SetCheckAttempt(6, true);
+	ConfigObject::DumpObjectsDelta(fixture.Filename);
+
+	fixture.ResetState();
+	ConfigObject::RestoreObjects(fixture.Filename);
+
+	BOOST_CHECK_EQUAL(fixture.Hosts[0]->GetCheckAttempt(), 3);
+	BOOST_CHECK_EQUAL(fixture.Hosts[1]->GetCheckAttempt(), 6);
+	BOOST_CHECK_EQUAL(fixture.Hosts[2]->GetCheckAttempt(), 5);
+
+	boost::filesystem::remove(deltaFilename.GetData());
+}
+
+/**
+ * Compares dump and restore of the netstring format of v2.16 and older with the binary state file,
+ * and the dump of a delta.
+ *
+ * testbase --run_test=icinga_state_file/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	StateFileFixture fixture (100000);
+
+	auto measure ([](const std::function<void()>& func) {
+		auto begin (ch::steady_clock::now());
+		func();
+		return ch::duration<double>(ch::steady_clock::now() - begin).count();
+	});
+
+	double netStringDump = measure([&fixture]() { DumpNetStringFile(fixture.Filename, fixture.Hosts); });
+	auto netStringSize (boost::filesystem::file_size(fixture.Filename.GetData()));
+	fixture.ResetState();
+	double netStringRestore = measure([&fixture]() { ConfigObject::RestoreObjects(fixture.Filename); });
+	fixture.CheckState();
+
+	double binaryDump = measure([&fixture]() { ConfigObject::DumpObjects(fixture.Filename); });
+	auto binarySize (boost::filesystem::file_size(fixture.Filename.GetData()));
+	fixture.ResetState();
+	double binaryRestore = measure([&fixture]() { ConfigObject::RestoreObjects(fixture.Filename); });
+	fixture.CheckState();
+
+	for (size_t i = 0; i < fixture.Hosts.size(); i += 100) {
+		fixture.Hosts[i]->SetLastCheckResult(MakeCheckResult(ServiceOK, "host is up again"), true);
+	}
+
+	double deltaDump = measure([&fixture]() { ConfigObject::DumpObjectsDelta(fixture.Filename); });
+	auto deltaSize (boost::filesystem::file_size((fixture.Filename + ".delta").GetData()));
+	boost::filesystem::remove((fixture.Filename + ".delta").GetData());
+
+	BOOST_TEST_MESSAGE(fixture.Hosts.size() << " hosts:");
+	BOOST_TEST_MESSAGE("netstring: dump " << netStringDump << "s, restore " << netStringRestore << "s, " << netStringSize << " bytes");
+	BOOST_TEST_MESSAGE("binary:    dump " << binaryDump << "s, restore " << binaryRestore << "s, " << binarySize << " bytes");
+	BOOST_TEST_MESSAGE("delta of 1% of the hosts: dump " << deltaDump << "s, " << deltaSize << " bytes");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
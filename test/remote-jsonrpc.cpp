@@ -0,0 +1,230 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/json.hpp"
+#include "base/stream-compression.hpp"
+#include "remote/apilistener.hpp"
+#include "remote/jsonrpc.hpp"
+#include "remote/replaylog.hpp"
+#include <BoostTestTargetConfig.h>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace icinga;
+
+static Dictionary::Ptr MakeCheckResultMessage(int i)
+{
+	return new Dictionary({
+		{ "jsonrpc", "2.0" },
+		{ "method", "event::CheckResult" },
+		{ "ts", 1760000000.123 + i },
+		{ "params", new Dictionary({
+			{ "host", String("host-" + std::to_string(i % 1000) + ".example.com") },
+			{ "service", "disk" },
+			{ "cr", new Dictionary({
+				{ "type", "CheckResult" },
+				{ "state", i % 10 ? 0 : 2 },
+				{ "exit_status", i % 10 ? 0 : 2 },
+				{ "output", "DISK OK - free space: / 12345 MiB (45.6% inode=78%);" },
+				{ "performance_data", new Array({
+					"/=14567MiB;24000;27000;0;30000",
+					"/boot=123MiB;400;450;0;500",
+					"'/var/lib/icinga2'=4567MiB;8000;9000;0;10000"
+				}) },
+				{ "schedule_start", 1760000000.0 + i },
+				{ "schedule_end", 1760000000.5 + i },
+				{ "execution_start", 1760000000.01 + i },
+				{ "execution_end", 1760000000.49 + i },
+				{ "active", true },
+				{ "check_source", "satellite-1.example.com" },
+				{ "ttl", 0 },
+				{ "vars_before", new Dictionary({ { "attempt", 1 }, { "reachable", true }, { "state", 0 }, { "state_type", 1 } }) },
+				{ "vars_after", new Dictionary({ { "attempt", 1 }, { "reachable", true }, { "state", 0 }, { "state_type", 1 } }) }
+			}) }
+		}) }
+	});
+}
+
+BOOST_AUTO_TEST_SUITE(remote_jsonrpc)
+
+BOOST_AUTO_TEST_CASE(binary_messages)
+{
+	Dictionary::Ptr message = MakeCheckResultMessage(42);
+
+	String json = JsonRpc::EncodeMessage(message, false);
+	String binary = JsonRpc::EncodeMessage(message, true);
+
+	BOOST_CHECK_EQUAL(json[0], '{');
+	BOOST_CHECK_EQUAL(binary[0], JsonRpc::BinaryMessageMarker);
+	BOOST_CHECK(binary.GetLength() < json.GetLength());
+
+	BOOST_CHECK_EQUAL(JsonEncode(JsonRpc::DecodeMessage(binary)), json);
+
+	BOOST_CHECK_THROW(JsonRpc::DecodeMessage(binary.SubStr(0, binary.GetLength() - 1)), std::invalid_argument);
+	BOOST_CHECK_THROW(JsonRpc::DecodeMessage(binary + "x"), std::invalid_argument);
+
+	/* A string rather than a dictionary. */
+	BOOST_CHECK_THROW(JsonRpc::DecodeMessage("\x01\x05\x01x"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(accepted_encodings)
+{
+	String json = JsonRpc::EncodeMessage(MakeCheckResultMessage(1), false);
+	String binary = JsonRpc::EncodeMessage(MakeCheckResultMessage(1), true);
+	auto binaryOnly ((uint_fast64_t)ApiCapabilities::BinaryMessages);
+	auto all ((uint_fast64_t)ApiCapabilities::BinaryMessages | (uint_fast64_t)ApiCapabilities::DeflateCompression
+		| (uint_fast64_t)ApiCapabilities::ZstdCompression);
+
+	/* Unauthenticated peers, e.g. certificate requests, may only send JSON. */
+	BOOST_CHECK(JsonRpc::IsEncodingAccepted(json, 0));
+	BOOST_CHECK(!JsonRpc::IsEncodingAccepted(binary, 0));
+	BOOST_CHECK(!JsonRpc::IsEncodingAccepted(String("\x02x"), 0));
+	BOOST_CHECK(!JsonRpc::IsEncodingAccepted(String("\x03x"), 0));
+
+	BOOST_CHECK(JsonRpc::IsEncodingAccepted(binary, binaryOnly));
+	BOOST_CHECK(!JsonRpc::IsEncodingAccepted(String("\x02x"), binaryOnly));
+	BOOST_CHECK(!JsonRpc::IsEncodingAccepted(String("\x03x"), binaryOnly));
+
+	BOOST_CHECK(JsonRpc::IsEncodingAccepted(String("\x02x"), all));
+	BOOST_CHECK(JsonRpc::IsEncodingAccepted(String("\x03x"), all));
+}
+
+BOOST_AUTO_TEST_CASE(encoded_message)
+{
+	Dictionary::Ptr message = MakeCheckResultMessage(1);
+	JsonRpc::EncodedMessage encoded;
+
+	auto binary (encoded.Get(message, true));
+	BOOST_CHECK(encoded.Get(message, true) == binary);
+	BOOST_CHECK(!encoded.Json);
+
+	auto json (encoded.Get(message, false));
+	BOOST_CHECK(encoded.Get(message, false) == json);
+	BOOST_CHECK_EQUAL((*json)[0], '{');
+}
+
+BOOST_AUTO_TEST_CASE(compressed_messages)
+{
+	if (!IsCompressionAvailable(CompressionAlgorithm::Deflate)) {
+		BOOST_TEST_MESSAGE("Built without zlib");
+		return;
+	}
+
+	auto compressor (StreamCompressor::Create(CompressionAlgorithm::Deflate, JsonRpc::GetCompressionDictionary()));
+	std::unique_ptr<StreamDecompressor> decompressor;
+
+	for (int i = 0; i < 10; i++) {
+		String binary = JsonRpc::EncodeMessage(MakeCheckResultMessage(i), true);
+		String compressed = JsonRpc::CompressMessage(*compressor, binary);
+
+		BOOST_CHECK_EQUAL(compressed[0], JsonRpc::DeflateMessageMarker);
+		BOOST_CHECK(JsonRpc::IsCompressedMessage(compressed));
+		BOOST_CHECK(!JsonRpc::IsCompressedMessage(binary));
+		BOOST_CHECK(compressed.GetLength() < binary.GetLength());
+
+		BOOST_CHECK(JsonRpc::DecompressMessage(decompressor, compressed, 1024 * 1024) == binary);
+	}
+
+	BOOST_REQUIRE(decompressor);
+	BOOST_CHECK(decompressor->GetAlgorithm() == CompressionAlgorithm::Deflate);
+
+	/* The algorithm of a connection can't change. */
+	BOOST_CHECK_THROW(JsonRpc::DecompressMessage(decompressor, String("\x03x"), 1024), std::invalid_argument);
+}
+
+/**
+ * Compares encoding and decoding cluster messages as JSON and binary, and compressing them as one stream.
+ *
+ * Set ICINGA2_BENCHMARK_REPLAY_LOG to a replay log file (e.g. /var/lib/icinga2/api/log/current)
+ * to use recorded cluster traffic, otherwise check result messages are generated.
+ *
+ * testbase --run_test=remote_jsonrpc/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	std::vector<Dictionary::Ptr> messages;
+
+	if (const char *path = getenv("ICINGA2_BENCHMARK_REPLAY_LOG")) {
+		ReplayLogSegment segment (path);
+		uint64_t offset = segment.Seek(0);
+		ReplayLogRecord record;
+
+		while (segment.ReadNext(offset, 0, record)) {
+			messages.emplace_back(JsonRpc::DecodeMessage(record.Message));
+		}
+	} else {
+		for (int i = 0; i < 100000; i++) {
+			messages.emplace_back(MakeCheckResultMessage(i));
+		}
+	}
+
+	BOOST_REQUIRE(!messages.empty());
+
+	auto measure ([&messages](bool binary) {
+		std::vector<String> encoded;
+		encoded.reserve(messages.size());
+		size_t bytes = 0;
+
+		auto begin (ch::steady_clock::now());
+
+		for (auto& message : messages) {
+			encoded.emplace_back(JsonRpc::EncodeMessage(message, binary));
+			bytes += encoded.back().GetLength();
+		}
+
+		auto encodeDone (ch::steady_clock::now());
+
+		for (auto& message : encoded) {
+			JsonRpc::DecodeMessage(message);
+		}
+
+		double encodeSeconds = ch::duration<double>(encodeDone - begin).count();
+		double decodeSeconds = ch::duration<double>(ch::steady_clock::now() - encodeDone).count();
+
+		BOOST_TEST_MESSAGE((binary ? "binary: " : "JSON:   ") << bytes << " bytes, encode "
+			<< messages.size() / encodeSeconds << " messages/s (" << bytes / encodeSeconds / 1024 / 1024 << " MiB/s), decode "
+			<< messages.size() / decodeSeconds << " messages/s (" << bytes / decodeSeconds / 1024 / 1024 << " MiB/s)");
+
+		for (auto algorithm : { CompressionAlgorithm::Deflate, CompressionAlgorithm::Zstd }) {
+			if (!IsCompressionAvailable(algorithm)) {
+				continue;
+			}
+
+			auto compressor (StreamCompressor::Create(algorithm, JsonRpc::GetCompressionDictionary()));
+			std::unique_ptr<StreamDecompressor> decompressor;
+			std::vector<String> compressed;
+			compressed.reserve(encoded.size());
+			size_t compressedBytes = 0;
+
+			begin = ch::steady_clock::now();
+
+			for (auto& message : encoded) {
+				compressed.emplace_back(JsonRpc::CompressMessage(*compressor, message));
+				compressedBytes += compressed.back().GetLength();
+			}
+
+			auto compressDone (ch::steady_clock::now());
+
+			for (auto& message : compressed) {
+				JsonRpc::DecompressMessage(decompressor, message, bytes);
+			}
+
+			double compressSeconds = ch::duration<double>(compressDone - begin).count();
+			double decompressSeconds = ch::duration<double>(ch::steady_clock::now() - compressDone).count();
+
+			BOOST_TEST_MESSAGE("  " << (algorithm == CompressionAlgorithm::Zstd ? "zstd:    " : "deflate: ") << compressedBytes
+				<< " bytes (ratio " << double(bytes) / compressedBytes << "), compress " << bytes / compressSeconds / 1024 / 1024
+				<< " MiB/s, decompress " << bytes / decompressSeconds / 1024 / 1024 << " MiB/s");
+		}
+	});
+
+	BOOST_TEST_MESSAGE(messages.size() << " messages:");
+	measure(false);
+	measure(true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,283 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "remote/replaylog.hpp"
+#include "base/dictionary.hpp"
+#include "base/json.hpp"
+#include <BoostTestTargetConfig.h>
+#include <boost/filesystem/operations.hpp>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+using namespace icinga;
+
+struct ReplayLogFixture
+{
+	String Filename;
+
+	ReplayLogFixture()
+		: Filename((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("icinga2-%%%%-%%%%.replaylog")).string())
+	{
+	}
+
+	~ReplayLogFixture()
+	{
+		boost::filesystem::remove(Filename.GetData());
+	}
+};
+
+static String MakeMessage(int i)
+{
+	return "{\"jsonrpc\":\"2.0\",\"method\":\"event::CheckResult\",\"params\":{\"host\":\"host-"
+		+ std::to_string(i) + "\",\"output\":\"" + std::string(200, 'x') + "\"}}";
+}
+
+static void WriteMessages(ReplayLogWriter& writer, int begin, int end)
+{
+	for (int i = begin; i < end; i++) {
+		if (i % 2) {
+			writer.Write(1000 + i, MakeMessage(i), "Host", "host-" + std::to_string(i));
+		} else {
+			writer.Write(1000 + i, MakeMessage(i), "", "");
+		}
+	}
+}
+
+static std::vector<ReplayLogRecord> ReadAll(const ReplayLogSegment& segment, double after)
+{
+	std::vector<ReplayLogRecord> records;
+	uint64_t offset = segment.Seek(after);
+	ReplayLogRecord record;
+
+	while (segment.ReadNext(offset, after, record)) {
+		records.emplace_back(record);
+	}
+
+	return records;
+}
+
+static void CheckRecords(const std::vector<ReplayLogRecord>& records, int begin, int end)
+{
+	BOOST_REQUIRE_EQUAL(records.size(), size_t(end - begin));
+
+	for (int i = begin; i < end; i++) {
+		auto& record (records[i - begin]);
+
+		BOOST_CHECK_EQUAL(record.Timestamp, 1000 + i);
+		BOOST_CHECK_EQUAL(record.Message, MakeMessage(i));
+
+		if (i % 2) {
+			BOOST_CHECK_EQUAL(record.SecobjType, "Host");
+			BOOST_CHECK_EQUAL(record.SecobjName, "host-" + std::to_string(i));
+		} else {
+			BOOST_CHECK(record.SecobjType.IsEmpty());
+		}
+	}
+}
+
+BOOST_FIXTURE_TEST_SUITE(remote_replaylog, ReplayLogFixture)
+
+BOOST_AUTO_TEST_CASE(write_read)
+{
+	ReplayLogWriter writer (Filename);
+	WriteMessages(writer, 0, 1000);
+
+	auto snapshot (writer.Snapshot());
+
+	/* Messages written after the snapshot aren't part of it. */
+	WriteMessages(writer, 1000, 1100);
+
+	BOOST_CHECK(!snapshot->IsLegacy());
+	BOOST_CHECK_EQUAL(snapshot->GetNewestTimestamp(), 1999);
+	CheckRecords(ReadAll(*snapshot, 0), 0, 1000);
+	CheckRecords(ReadAll(*snapshot, 1499.5), 500, 1000);
+	CheckRecords(ReadAll(*writer.Snapshot(), 0), 0, 1100);
+
+	BOOST_CHECK(ReplayLogFile::IsReplayLog(Filename));
+}
+
+BOOST_AUTO_TEST_CASE(seek)
+{
+	ReplayLogWriter writer (Filename);
+	WriteMessages(writer, 0, 1000);
+	writer.Seal();
+
+	ReplayLogSegment segment (Filename);
+	auto& index (segment.GetIndex());
+
+	BOOST_REQUIRE(index.size() > 2u);
+
+	/* Seeking skips the blocks which only hold older messages. */
+	BOOST_CHECK_EQUAL(segment.Seek(0), ReplayLogFile::HeaderSize);
+	BOOST_CHECK(segment.Seek(1500) > ReplayLogFile::HeaderSize);
+	BOOST_CHECK(segment.Seek(1500) < segment.GetRecordsEnd());
+	BOOST_CHECK_EQUAL(segment.Seek(5000), index.back().Offset);
+
+	CheckRecords(ReadAll(segment, 1500), 501, 1000);
+	CheckRecords(ReadAll(segment, 5000), 0, 0);
+}
+
+BOOST_AUTO_TEST_CASE(out_of_order)
+{
+	ReplayLogWriter writer (Filename);
+	WriteMessages(writer, 0, 1000);
+
+	/* A message older than the ones before it must not be skipped by seeking past it. */
+	writer.Write(1100.5, MakeMessage(-1), "", "");
+	WriteMessages(writer, 1000, 1100);
+	writer.Seal();
+
+	ReplayLogSegment segment (Filename);
+	auto records (ReadAll(segment, 1100));
+
+	BOOST_REQUIRE_EQUAL(records.size(), 899u + 1u + 100u);
+	BOOST_CHECK_EQUAL(records[899].Timestamp, 1100.5);
+	BOOST_CHECK_EQUAL(records[899].Message, MakeMessage(-1));
+}
+
+BOOST_AUTO_TEST_CASE(reopen)
+{
+	{
+		ReplayLogWriter writer (Filename);
+		WriteMessages(writer, 0, 500);
+		writer.Seal();
+	}
+
+	auto sealedSize (boost::filesystem::file_size(Filename.GetData()));
+
+	{
+		/* The index is cut off again and rebuilt once the segment is sealed again. */
+		ReplayLogWriter writer (Filename);
+		WriteMessages(writer, 500, 1000);
+		writer.Seal();
+	}
+
+	BOOST_CHECK(boost::filesystem::file_size(Filename.GetData()) > sealedSize);
+
+	auto segment (ReplayLogSegment::Open(Filename));
+	CheckRecords(ReadAll(*segment, 0), 0, 1000);
+
+	/* Concurrent replays share the mapping. */
+	BOOST_CHECK(segment == ReplayLogSegment::Open(Filename));
+}
+
+BOOST_AUTO_TEST_CASE(torn_tail)
+{
+	{
+		ReplayLogWriter writer (Filename);
+		WriteMessages(writer, 0, 100);
+		writer.Snapshot();
+	}
+
+	/* The last message has only been written partially, e.g. before a crash. */
+	auto size (boost::filesystem::file_size(Filename.GetData()));
+	boost::filesystem::resize_file(Filename.GetData(), size - 10);
+
+	CheckRecords(ReadAll(ReplayLogSegment(Filename), 0), 0, 99);
+
+	{
+		ReplayLogWriter writer (Filename);
+		WriteMessages(writer, 100, 200);
+		writer.Seal();
+	}
+
+	auto records (ReadAll(ReplayLogSegment(Filename), 0));
+
+	BOOST_REQUIRE_EQUAL(records.size(), 199u);
+	BOOST_CHECK_EQUAL(records[98].Timestamp, 1098);
+	BOOST_CHECK_EQUAL(records[99].Timestamp, 1100);
+}
+
+BOOST_AUTO_TEST_CASE(legacy)
+{
+	{
+		std::ofstream fp (Filename.CStr(), std::ios_base::out | std::ios_base::binary);
+
+		for (int i = 0; i < 100; i++) {
+			Dictionary::Ptr pmessage = new Dictionary({
+				{ "timestamp", 1000 + i },
+				{ "message", MakeMessage(i) }
+			});
+
+			if (i % 2) {
+				pmessage->Set("secobj", new Dictionary({
+					{ "type", "Host" },
+					{ "name", String("host-" + std::to_string(i)) }
+				}));
+			}
+
+			String json = JsonEncode(pmessage);
+			fp << json.GetLength() << ":" << json << ",";
+		}
+
+		/* Incomplete */
+		fp << "1000:{";
+	}
+
+	BOOST_CHECK(!ReplayLogFile::IsReplayLog(Filename));
+
+	ReplayLogSegment segment (Filename);
+
+	BOOST_CHECK(segment.IsLegacy());
+	CheckRecords(ReadAll(segment, 0), 0, 100);
+	CheckRecords(ReadAll(segment, 1049), 50, 100);
+
+	BOOST_CHECK_THROW(ReplayLogWriter writer (Filename), std::invalid_argument);
+}
+
+/**
+ * Compares replaying the newest messages of a segment by seeking to them with reading all
+ * messages of a segment written by v2.16 and older.
+ *
+ * testbase --run_test=remote_replaylog/benchmark --log_level=message
+ */
+BOOST_AUTO_TEST_CASE(benchmark, *boost::unit_test::disabled() * boost::unit_test::label("benchmark"))
+{
+	namespace ch = std::chrono;
+
+	const int count = 50000;
+	String legacyFilename = Filename + ".legacy";
+
+	{
+		ReplayLogWriter writer (Filename);
+		std::ofstream fp (legacyFilename.CStr(), std::ios_base::out | std::ios_base::binary);
+
+		for (int i = 0; i < count; i++) {
+			writer.Write(1000 + i, MakeMessage(i), "Host", "host-" + std::to_string(i));
+
+			String json = JsonEncode(new Dictionary({
+				{ "timestamp", 1000 + i },
+				{ "message", MakeMessage(i) },
+				{ "secobj", new Dictionary({
+					{ "type", "Host" },
+					{ "name", String("host-" + std::to_string(i)) }
+				}) }
+			}));
+
+			fp << json.GetLength() << ":" << json << ",";
+		}
+
+		writer.Seal();
+	}
+
+	auto measure ([count](const String& path) {
+		auto begin (ch::steady_clock::now());
+		ReplayLogSegment segment (path);
+		auto records (ReadAll(segment, 1000 + count - 100));
+
+		BOOST_CHECK_EQUAL(records.size(), 99u);
+
+		return ch::duration<double>(ch::steady_clock::now() - begin).count();
+	});
+
+	double seconds = measure(Filename);
+	double legacySeconds = measure(legacyFilename);
+
+	boost::filesystem::remove(legacyFilename.GetData());
+
+	BOOST_TEST_MESSAGE("Replaying the newest 99 of " << count << " messages: "
+		<< seconds * 1000 << "ms indexed, " << legacySeconds * 1000 << "ms legacy netstrings");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
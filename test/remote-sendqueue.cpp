@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "remote/sendqueue.hpp"
+#include <BoostTestTargetConfig.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace icinga;
+
+static Shared<String>::ConstPtr MakeMessage(const String& text)
+{
+	return Shared<String>::Make(text);
+}
+
+BOOST_AUTO_TEST_SUITE(remote_sendqueue)
+
+BOOST_AUTO_TEST_CASE(parse)
+{
+	BOOST_CHECK(ParseSendQueuePolicy("queue") == SendQueuePolicy::Exceed);
+	BOOST_CHECK(ParseSendQueuePolicy("shed") == SendQueuePolicy::Shed);
+	BOOST_CHECK_THROW(ParseSendQueuePolicy("block"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(priority)
+{
+	SendQueue queue (1024);
+
+	BOOST_CHECK(!queue.Pop());
+
+	queue.Push(MessageLane::Bulk, MakeMessage("bulk1"), SendQueuePolicy::Block);
+	queue.Push(MessageLane::Events, MakeMessage("event1"), SendQueuePolicy::Block);
+	queue.Push(MessageLane::Bulk, MakeMessage("bulk2"), SendQueuePolicy::Block);
+	queue.Push(MessageLane::Heartbeat, MakeMessage("heartbeat"), SendQueuePolicy::Block);
+	queue.Push(MessageLane::Events, MakeMessage("event2"), SendQueuePolicy::Block);
+	queue.Push(MessageLane::Control, MakeMessage("control"), SendQueuePolicy::Block);
+
+	BOOST_CHECK_EQUAL(queue.GetMessages(), 6u);
+	BOOST_CHECK_EQUAL(queue.GetBytes(), 5u + 6u + 5u + 9u + 6u + 7u);
+
+	for (auto expected : { "control", "heartbeat", "event1", "event2", "bulk1", "bulk2" }) {
+		auto message (queue.Pop());
+
+		BOOST_REQUIRE(message);
+		BOOST_CHECK_EQUAL(*message, expected);
+	}
+
+	BOOST_CHECK(!queue.Pop());
+	BOOST_CHECK_EQUAL(queue.GetMessages(), 0u);
+	BOOST_CHECK_EQUAL(queue.GetBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(limit)
+{
+	SendQueue queue (10);
+
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Events, MakeMessage("12345678"), SendQueuePolicy::Shed), SendQueue::Queued);
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Events, MakeMessage("123"), SendQueuePolicy::Shed), SendQueue::Shed);
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Events, MakeMessage("12"), SendQueuePolicy::Shed), SendQueue::Queued);
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Events, MakeMessage("1"), SendQueuePolicy::Exceed), SendQueue::Queued);
+	BOOST_CHECK_EQUAL(queue.GetMessagesShed(), 1u);
+
+	/* Each lane has its own credits, control messages and heartbeats have no limit. */
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Bulk, MakeMessage("1234567890"), SendQueuePolicy::Shed), SendQueue::Queued);
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Control, MakeMessage(String(100, 'x')), SendQueuePolicy::Shed), SendQueue::Queued);
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Heartbeat, MakeMessage(String(100, 'x')), SendQueuePolicy::Shed), SendQueue::Queued);
+
+	while (queue.Pop()) {
+	}
+
+	/* A message larger than the limit fits into an empty lane. */
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Bulk, MakeMessage(String(100, 'x')), SendQueuePolicy::Shed), SendQueue::Queued);
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Bulk, MakeMessage("1"), SendQueuePolicy::Shed), SendQueue::Shed);
+}
+
+BOOST_AUTO_TEST_CASE(block)
+{
+	SendQueue queue (10);
+	std::atomic<int> queued (0);
+
+	queue.Push(MessageLane::Bulk, MakeMessage("1234567890"), SendQueuePolicy::Block);
+
+	std::thread producer ([&queue, &queued]() {
+		for (int i = 0; i < 100; i++) {
+			if (queue.Push(MessageLane::Bulk, MakeMessage("12345"), SendQueuePolicy::Block) == SendQueue::Queued) {
+				queued++;
+			}
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	BOOST_CHECK_EQUAL(queued.load(), 0);
+
+	/* Taking a message out returns its credits to the producer. */
+	size_t maxBytes = 0;
+
+	for (int i = 0; i <= 100; i++) {
+		for (;;) {
+			maxBytes = std::max(maxBytes, queue.GetBytes());
+
+			if (queue.Pop()) {
+				break;
+			}
+
+			std::this_thread::yield();
+		}
+	}
+
+	producer.join();
+
+	BOOST_CHECK_EQUAL(queued.load(), 100);
+	BOOST_CHECK_EQUAL(maxBytes, 10u);
+	BOOST_CHECK_EQUAL(queue.GetMessages(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(disconnect)
+{
+	SendQueue queue (10);
+	std::atomic<bool> closed (false);
+
+	queue.Push(MessageLane::Bulk, MakeMessage("1234567890"), SendQueuePolicy::Block);
+
+	std::thread producer ([&queue, &closed]() {
+		closed = queue.Push(MessageLane::Bulk, MakeMessage("1"), SendQueuePolicy::Block) == SendQueue::Closed;
+	});
+
+	std::thread waiter ([&queue]() {
+		queue.WaitUntilEmpty(MessageLane::Bulk);
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	queue.Close();
+
+	producer.join();
+	waiter.join();
+
+	BOOST_CHECK(closed);
+	BOOST_CHECK_EQUAL(queue.GetMessages(), 0u);
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Control, MakeMessage("1"), SendQueuePolicy::Block), SendQueue::Closed);
+	BOOST_CHECK(!queue.Pop());
+}
+
+BOOST_AUTO_TEST_CASE(block_timeout)
+{
+	/* The liveness check doesn't disconnect syncing peers, so a peer which reads nothing must not block forever. */
+	SendQueue queue (10, std::chrono::milliseconds(100));
+
+	queue.Push(MessageLane::Bulk, MakeMessage("1234567890"), SendQueuePolicy::Block);
+
+	auto begin (std::chrono::steady_clock::now());
+
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Bulk, MakeMessage("1"), SendQueuePolicy::Block), SendQueue::TimedOut);
+	BOOST_CHECK(!queue.WaitUntilEmpty(MessageLane::Bulk));
+	BOOST_CHECK(std::chrono::steady_clock::now() - begin >= std::chrono::milliseconds(200));
+	BOOST_CHECK_EQUAL(queue.GetMessages(), 1u);
+
+	BOOST_CHECK(queue.Pop());
+	BOOST_CHECK(queue.WaitUntilEmpty(MessageLane::Bulk));
+	BOOST_CHECK_EQUAL(queue.Push(MessageLane::Bulk, MakeMessage("1"), SendQueuePolicy::Block), SendQueue::Queued);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -858,6 +858,9 @@ void ClassCompiler::HandleClass(const Klass& klass, const ClassDebugInfo&)
 				else
 					m_Impl << field.SetAccessor << std::endl << std::endl;
 
+				if (field.Attributes & FAState)
+					m_Impl << "\t" << "MarkStateDirty();" << std::endl;
+
 				if (field.Type.IsName || !field.TrackAccessor.empty()) {
 					if (field.Name != "active") {
 						m_Impl << "\t" << "if (!dobj || dobj->IsActive())" << std::endl
@@ -1069,21 +1072,25 @@ void ClassCompiler::HandleClass(const Klass& klass, const ClassDebugInfo&)
 			if (field.Attributes & FANoStorage)
 				continue;
 
-			m_Header << "\tAtomicOrLocked<" << field.Type.GetRealType() << "> m_" << field.GetFriendlyName() << ";" << std::endl;
+			/* Object names are referenced by many other objects, all of them share an interned copy. */
+			if ((field.Attributes & FAInterned || field.Type.IsName) && field.Type.ArrayRank == 0)
+				m_Header << "\tAtomicOrLocked<Atom> m_" << field.GetFriendlyName() << ";" << std::endl;
+			else
+				m_Header << "\tAtomicOrLocked<" << field.Type.GetRealType() << "> m_" << field.GetFriendlyName() << ";" << std::endl;
 		}
 		
 		/* signal */
 		m_Header << "public:" << std::endl;
 		
 		for (const Field& field : klass.Fields) {
-			m_Header << "\t" << "static boost::signals2::signal<void (const intrusive_ptr<" << klass.Name << ">&, const Value&)> On" << field.GetFriendlyName() << "Changed;" << std::endl;
-			m_Impl << std::endl << "boost::signals2::signal<void (const intrusive_ptr<" << klass.Name << ">&, const Value&)> ObjectImpl<" << klass.Name << ">::On" << field.GetFriendlyName() << "Changed;" << std::endl << std::endl;
+			m_Header << "\t" << "static Signal<void (const intrusive_ptr<" << klass.Name << ">&, const Value&)> On" << field.GetFriendlyName() << "Changed;" << std::endl;
+			m_Impl << std::endl << "Signal<void (const intrusive_ptr<" << klass.Name << ">&, const Value&)> ObjectImpl<" << klass.Name << ">::On" << field.GetFriendlyName() << "Changed;" << std::endl << std::endl;
 
 			if (field.Attributes & FASignalWithOldValue) {
-				m_Header << "\t" << "static boost::signals2::signal<void (const intrusive_ptr<" << klass.Name
+				m_Header << "\t" << "static Signal<void (const intrusive_ptr<" << klass.Name
 					<< ">&, const Value&, const Value&)> On" << field.GetFriendlyName() << "ChangedWithOldValue;"
 					<< std::endl;
-				m_Impl << std::endl << "boost::signals2::signal<void (const intrusive_ptr<" << klass.Name
+				m_Impl << std::endl << "Signal<void (const intrusive_ptr<" << klass.Name
 					<< ">&, const Value&, const Value&)> ObjectImpl<" << klass.Name << ">::On"
 					<< field.GetFriendlyName() << "ChangedWithOldValue;" << std::endl << std::endl;
 			}
@@ -1465,8 +1472,10 @@ void ClassCompiler::CompileStream(const std::string& path, std::istream& input,
 		<< "#include \"base/type.hpp\"" << std::endl
 		<< "#include \"base/value.hpp\"" << std::endl
 		<< "#include \"base/array.hpp\"" << std::endl
+		<< "#include \"base/atom.hpp\"" << std::endl
 		<< "#include \"base/atomic.hpp\"" << std::endl
 		<< "#include \"base/dictionary.hpp\"" << std::endl
+		<< "#include \"base/signal.hpp\"" << std::endl
 		<< "#include <boost/signals2.hpp>" << std::endl << std::endl;
 
 	oimpl << "#include \"base/exception.hpp\"" << std::endl
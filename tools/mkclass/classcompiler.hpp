@@ -63,6 +63,7 @@ enum FieldAttribute
 	FASetVirtual = 16384,
 	FAActivationPriority = 32768,
 	FASignalWithOldValue = 65536,
+	FAInterned = 131072,
 };
 
 struct FieldType
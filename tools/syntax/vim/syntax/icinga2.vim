@@ -77,7 +77,7 @@ syn match		icinga2ApplyDef		"apply[ \t]\+\(Service\|Dependency\|Notification\|Sc
 syn keyword		icinga2ObjAttr		contained	accept_commands accept_config access_control_allow_origin action_url address address6 arguments author bind_host
 syn keyword		icinga2ObjAttr		contained	bind_port ca_path categories cert_path check_command check_interval
 syn keyword		icinga2ObjAttr		contained	check_period check_timeout child_host_name child_options child_service_name cipher_list
-syn keyword		icinga2ObjAttr		contained	cleanup client_cn command command_endpoint command_path
+syn keyword		icinga2ObjAttr		contained	cleanup client_cn command command_endpoint command_path compression
 syn keyword		icinga2ObjAttr		contained	comment compat_log_path concurrent_checks crl_path database disable_checks disable_notifications
 syn keyword		icinga2ObjAttr		contained	display_name duration email enable_active_checks enable_event_handlers enable_event_handler
 syn keyword		icinga2ObjAttr		contained	enable_flapping enable_ha enable_host_checks enable_notifications enable_passive_checks enable_perfdata
@@ -90,7 +90,7 @@ syn keyword		icinga2ObjAttr		contained	log_duration max_anonymous_clients max_ch
 syn keyword		icinga2ObjAttr		contained	pager parent parent_host_name parent_service_name password path period permissions
 syn keyword		icinga2ObjAttr		contained	port prefer_includes ranges retry_interval rotation_interval rotation_method
 syn keyword		icinga2ObjAttr		contained	service_format_template service_name service_name_template service_perfdata_path service_temp_path service_template
-syn keyword		icinga2ObjAttr		contained	severity socket_path socket_type source spool_dir
+syn keyword		icinga2ObjAttr		contained	send_queue_policy send_queue_size severity socket_path socket_type source spool_dir
 syn keyword		icinga2ObjAttr		contained	ssl_ca ssl_capath ssl_ca_cert ssl_cert ssl_cipher ssl_enable ssl_mode ssl_key
 syn keyword		icinga2ObjAttr		contained	states status_path table_prefix ticket_salt
 syn keyword		icinga2ObjAttr		contained	timeout times tls_handshake_timeout tls_protocolmin
@@ -266,7 +266,7 @@ syn keyword	icinga2PathConstant	ObjectsPath PidPath PkgDataDir PrefixDir Program
 syn keyword 	icinga2PathConstant	VarsPath ZonesDir
 
 " Global constants
-syn keyword 	icinga2GlobalConstant	NodeName Environment RunAsUser RunAsGroup MaxConcurrentChecks ApiBindHost ApiBindPort EventEngine AttachDebugger
+syn keyword 	icinga2GlobalConstant	NodeName Environment RunAsUser RunAsGroup MaxConcurrentChecks ApiBindHost ApiBindPort EventEngine ProcessEventEngine AttachDebugger
 
 " Application runtime constants
 syn keyword	icinga2GlobalConstant	PlatformName PlatformVersion PlatformKernel PlatformKernelVersion BuildCompilerName BuildCompilerVersion BuildHostName